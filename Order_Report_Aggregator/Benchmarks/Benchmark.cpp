@@ -0,0 +1,1146 @@
+/** @file Benchmark.cpp
+ *  @brief Benchmarks the stages of the Order Report Aggregator
+ *
+ *  Times each stage of producing an Order Report on its own, against an input file such as one
+ *  written by the Feed Generator:
+ *    - InputFileHandler::ReadInputFile           - Reading the input file & splitting it into lines, with no processing.
+ *    - InputFileHandler::ReadInputFile[AsyncRead] - The same, reading with io_uring (or pread) rather than a memory mapping.
+ *    - InputFileHandler::ReadInputFile[Stream]   - The same, reading with std::getline as for a pipe. The baseline the memory
+ *                                                  mapping replaced for regular files.
+ *    - OrderReportFileHandler::ReadInputData     - Classifying, parsing & aggregating lines already held in memory.
+ *    - OrderReportFileHandler::ReadInputData[Activity] - The same, also tracking live Orders through their Deletes, Modifies & Executes.
+ *    - OrderMessageParser::ParseOrderAdd         - Parsing the Order Adds alone.
+ *    - OrderMessageParser::ParseOrderAdd[Substr] - The same, copying each value into a std::string & converting it with
+ *                                                  std::stoi or std::stoll. The baseline the non-allocating parser replaced.
+ *                                                  It's first checked to give the same Order Data as ParseOrderAdd.
+ *    - JsonLineParser::ExtractFields[Scalar/SSE2/AVX2] - Finding the fields of the same Order Adds with the JSON Line Parser,
+ *                                                  as for lines in another field order, for each SIMD level the CPU supports.
+ *    - OrderReport::AddOrderData                 - Aggregating Order Adds that have already been parsed & looked up.
+ *    - OrderReportCollection::FindAddOrderData   - The same Order Adds by Security ID, looking up each Security's slot first.
+ *    - OrderReportCollection::FindAddOrderData[unordered_map] - The same, with each Order Report held in a std::unordered_map
+ *                                                  by Security ID, beside its ISIN & currency. The baseline the flat
+ *                                                  collection replaced.
+ *    - OrderReportCollection::AddOrderData[Quantiles] - The same, also adding each order to its Security's quantile sketches.
+ *    - OrderReportCollection::AddOrderBatch[Scalar/SSE2/AVX2] - The same Order Adds by Security ID, a batch at a time: grouped by
+ *                                                  Security, looked up once per batch & summed with each SIMD level the CPU supports.
+ *                                                  Each level is first checked to give the same Order Reports as AddOrderData.
+ *    - IntervalReport::AddOrderData              - Adding the same Order Adds to the interval report's buckets.
+ *    - IntervalReport::AddOrderData[1m]          - The same in 1 minute intervals, including writing each interval out.
+ *    - OrderStore::Insert                        - Inserting --live-orders Orders into an empty Order Store, with the memory it then uses.
+ *    - OrderStore::FindRemove                    - Finding & removing each of them again, in a random order.
+ *    - OrderReportFileHandler::ReadInputData[Published] - Reading lines while publishing a snapshot every --publish-messages lines.
+ *    - QueryServer::LoadTest                     - The same, while a client queries the query server over its socket as
+ *                                                  fast as it's answered. The latency percentiles of each query are recorded.
+ *    - OrderReportFileHandler::ReadInputData[Shard of N] - Reading lines held in memory as shard 0 of N, for 1 shard up to
+ *                                                  --max-shards, doubling each time. The work of each worker of a sharded read.
+ *    - ShardRunner::Run[N shards]                - Reading the input file in N worker processes, as shards, and merging their
+ *                                                  partial Order Reports, for 1 shard up to --max-shards, doubling each time.
+ *    - OrderReportFileHandler::WriteOutputFile   - Writing the report of every Security.
+ *    - RollupReport::Build                       - Building the totals per ISIN country & currency from the Order Report of every Security.
+ *
+ *  Given a gzip or zstd compressed input file, two ways of producing the report from it are also compared:
+ *    - CompressedInput::Pipelined          - Reading the compressed file directly, decompressing alongside parsing.
+ *    - CompressedInput::DecompressThenRead - Decompressing the whole file to disk first, then reading it.
+ *
+ *  Each benchmark is run several times and the results are written as JSON, so they can be kept
+ *  and compared between builds to catch regressions. Times are wall clock; the minimum is usually
+ *  the most stable figure to compare.
+ *
+ *  Usage: Order_Report_Benchmark [--input FILE] [--compressed-input FILE] [--iterations N] [--filter TEXT]
+ *                                [--report FILE] [--live-orders N] [--publish-messages N] [--max-shards N] [--output FILE]
+ *    --input FILE      - Input File Name/Path. Defaults to pretrade_current.txt.
+ *    --compressed-input FILE - Compressed Input File Name/Path for the CompressedInput benchmarks. Off by default.
+ *    --iterations N    - Times to run each benchmark. Defaults to 5.
+ *    --filter TEXT     - Only run benchmarks whose name contains TEXT.
+ *    --report FILE     - Order Report File written by the WriteOutputFile benchmark. Defaults to benchmark_report.txt.
+ *    --live-orders N   - Orders held at once by the OrderStore benchmarks. Defaults to 10,000,000.
+ *    --publish-messages N - Lines read between the snapshots published by the query benchmarks. Defaults to 100,000.
+ *    --max-shards N    - Most shards the sharded benchmarks are run with. Defaults to 8.
+ *    --output FILE     - Where to write the JSON results. Defaults to standard output.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "CompressedInputReader.h"
+#include "CpuFeatures.h"
+#include "JsonLineParser.h"
+#include "MappedFile.h"
+#include "MessageClassifier.h"
+#include "OrderBatch.h"
+#include "OrderReportFileHandler.h"
+#include "QueryServer.h"
+#include "ReportRow.h"
+#include "ReportSchema.h"
+#include "RollupReport.h"
+#include "ShardRunner.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define BENCHMARK_QUERIES_SUPPORTED
+#endif
+
+struct QueryLatencies
+{
+    std::string query;
+    std::vector<double> seconds;  // Time from sending each query to receiving the end of its answer
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    size_t items;                 // Items processed by each iteration
+    size_t bytes;                 // Bytes processed by each iteration
+    std::vector<double> seconds;  // Time taken by each iteration
+    size_t memoryBytes = 0;       // Memory held once an iteration is done, where it's measured
+    std::vector<QueryLatencies> queryLatencies = {};
+};
+
+/** @brief An Order Report as it was held in a std::unordered_map, with its ISIN & currency beside its totals
+ */
+struct MapOrderReport
+{
+    std::string ISIN;
+    std::string currency;
+    OrderReport ordRpt;
+};
+
+/** @brief Reads the input file without processing any of the lines
+ */
+class LineCountingFileHandler : public InputFileHandler
+{
+private:
+    size_t numLines;
+    size_t numBytes;
+
+protected:
+    void ReadInputData(std::string_view inputLine) override
+    {
+        ++numLines;
+        numBytes += inputLine.size() + 1;
+    }
+
+public:
+    LineCountingFileHandler(const std::string& inputFile_) : InputFileHandler(inputFile_), numLines(0), numBytes(0) {}
+    size_t GetNumLines() const { return numLines; }
+    size_t GetNumBytes() const { return numBytes; }
+};
+
+/** @brief Lets the benchmark pass lines straight to the Order Report File Handler
+ */
+class BenchmarkOrderReportFileHandler : public OrderReportFileHandler
+{
+public:
+    using OrderReportFileHandler::OrderReportFileHandler;
+    using OrderReportFileHandler::ReadInputData;
+};
+
+
+/** @brief Times each iteration of a benchmark
+ * 
+ *  @param result     - Result to record the time of each iteration in
+ *  @param iterations - Times to run the benchmark
+ *  @param setup      - Called before each iteration, and not timed
+ *  @param run        - The benchmark itself
+ *  @return void
+ */
+static void TimeBenchmark( BenchmarkResult&             result,
+                           const size_t                 iterations,
+                           const std::function<void()>& setup,
+                           const std::function<void()>& run )
+{
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        if (setup)
+            setup();
+
+        auto startTime = std::chrono::steady_clock::now();
+        run();
+        auto endTime = std::chrono::steady_clock::now();
+
+        result.seconds.push_back(std::chrono::duration<double>(endTime - startTime).count());
+    }
+}
+
+
+#ifdef BENCHMARK_QUERIES_SUPPORTED
+/** @brief Connects to the query server
+ * 
+ *  @param socketPath - Socket File Name/Path the server listens on
+ *  @return Socket of the connection, or -1 if it couldn't connect
+ */
+static int ConnectToQueryServer(const std::string& socketPath)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    socketPath.copy(address.sun_path, sizeof(address.sun_path) - 1);
+
+    int clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (clientSocket >= 0 && connect(clientSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(clientSocket);
+        clientSocket = -1;
+    }
+    return clientSocket;
+}
+
+
+/** @brief Sends a query to the query server and waits for the whole answer
+ * 
+ *  @param clientSocket - Socket connected to the server
+ *  @param query        - Query, ending in a new line
+ *  @param answer       - Buffer to receive the answer into
+ *  @return true if the whole answer was received
+ */
+static bool RunQuery(const int clientSocket, const std::string& query, std::string& answer)
+{
+    if (send(clientSocket, query.data(), query.size(), 0) != static_cast<ssize_t>(query.size()))
+        return false;
+
+    char buffer[65536];
+    answer.clear();
+    while (answer.size() < 2 || answer.compare(answer.size() - 2, 2, "\n\n") != 0)
+    {
+        ssize_t received = recv(clientSocket, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            return false;
+        answer.append(buffer, static_cast<size_t>(received));
+    }
+    return true;
+}
+#endif
+
+
+/** @brief Gets a percentile of some latencies
+ * 
+ *  @param sorted   - Latencies, in ascending order
+ *  @param fraction - Percentile, from 0 to 1
+ *  @return The latency at that percentile, in microseconds
+ */
+static double PercentileMicros(const std::vector<double>& sorted, const double fraction)
+{
+    size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[rank] * 1e6;
+}
+
+
+/** @brief Escapes a string for JSON output
+ * 
+ *  @param text - Text to escape
+ *  @return Escaped text, in quotes
+ */
+static std::string JsonString(const std::string& text)
+{
+    std::string escaped = "\"";
+    for (char character : text)
+    {
+        if (character == '"' || character == '\\')
+            escaped += '\\';
+        escaped += character;
+    }
+    return escaped + "\"";
+}
+
+
+/** @brief Parses an Order Add the way every line was parsed before OrderMessageParser
+ * 
+ *  Each heading is searched for from the end of the value before it, and its value runs to the
+ *  next ','. Each value is copied into a std::string and converted with std::stoi or std::stoll.
+ *
+ *  @param inputLine  - Line from the input file that contains the Order Add record (msgType_ = 12)
+ *  @param securityId - Security ID of the Order
+ *  @param ordData    - Order Data
+ *  @return void
+ */
+static void ParseOrderAddWithSubstr(std::string_view inputLine, int& securityId, OrderAddData& ordData)
+{
+    size_t valPos = 0;
+    size_t valLength = 0;
+    auto findValue = [&inputLine, &valPos, &valLength](std::string_view heading)
+    {
+        size_t headingStartPos = inputLine.find(heading, valPos + valLength);
+        valPos = 0;
+        valLength = 0;
+        if (headingStartPos != std::string_view::npos)
+        {
+            valPos = headingStartPos + heading.size();
+            valLength = inputLine.find(',', headingStartPos) - valPos;
+        }
+        return std::string(inputLine.substr(valPos, valLength));
+    };
+
+    securityId = std::stoi(findValue("securityId_\":"));
+    ordData.side = (findValue("side_\":") == "BUY") ? Side::Buy : Side::Sell;
+    ordData.quantity = std::stoll(findValue("quantity_\":"));
+    ordData.price = std::stoll(findValue("price_\":"));
+}
+
+
+/** @brief Checks that parsing each Order Add with substr gives the same Order Data as OrderMessageParser
+ * 
+ *  @param orderAddLines - Lines that contain an Order Add
+ *  @return true if every line gave the same Security ID, side, quantity & price
+ */
+static bool SubstrParsesMatch(const std::vector<std::string_view>& orderAddLines)
+{
+    for (std::string_view inputLine : orderAddLines)
+    {
+        int securityId = 0;
+        int substrSecurityId = 0;
+        OrderAddData ordData;
+        OrderAddData substrData;
+        if (!OrderMessageParser::ParseOrderAdd(inputLine, securityId, ordData))
+            return false;
+
+        try
+        {
+            ParseOrderAddWithSubstr(inputLine, substrSecurityId, substrData);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+
+        if ( substrSecurityId != securityId || substrData.side != ordData.side ||
+             substrData.quantity != ordData.quantity || substrData.price != ordData.price )
+            return false;
+    }
+    return true;
+}
+
+
+/** @brief Adds Order Adds to a collection a batch at a time
+ * 
+ *  @param ordRptColl  - Collection to add the Order Adds to
+ *  @param batch       - Batch to fill. Left empty.
+ *  @param orderAdds   - Order Adds, with the slot of their Security
+ *  @param securityIds - Security ID of each Order Add
+ *  @return void
+ */
+static void AddOrderBatches( OrderReportCollection&                              ordRptColl,
+                             OrderBatch&                                         batch,
+                             const std::vector<std::pair<size_t, OrderAddData>>& orderAdds,
+                             const std::vector<int>&                             securityIds )
+{
+    for (size_t i = 0; i < orderAdds.size(); ++i)
+    {
+        batch.Add(securityIds[i], orderAdds[i].second);
+        if (batch.Full())
+        {
+            ordRptColl.AddOrderBatch(batch);
+            batch.Clear();
+        }
+    }
+    ordRptColl.AddOrderBatch(batch);
+    batch.Clear();
+}
+
+
+/** @brief Checks that adding Order Adds a batch at a time gives the same Order Reports as adding them one at a time
+ * 
+ *  Every column of every Security is compared, quantiles included. The Order Adds are checked as they
+ *  are, and again with their prices scaled up past 32 bits, so the batch's 128 bit products and Totals
+ *  Spent past 64 bits are checked too.
+ *
+ *  @param securities  - Collection holding the Securities, with no Orders
+ *  @param orderAdds   - Order Adds, with the slot of their Security
+ *  @param securityIds - Security ID of each Order Add
+ *  @return true if both give the same Order Reports
+ */
+static bool OrderBatchesMatch( const OrderReportCollection&                        securities,
+                               const std::vector<std::pair<size_t, OrderAddData>>& orderAdds,
+                               const std::vector<int>&                             securityIds )
+{
+    constexpr size_t WIDE_PRICE_SCALE = size_t(1) << 24;
+
+    for (size_t priceScale : { size_t(1), WIDE_PRICE_SCALE })
+    {
+        std::vector<std::pair<size_t, OrderAddData>> scaledOrderAdds = orderAdds;
+        for (auto& orderAdd : scaledOrderAdds)
+            orderAdd.second.price *= priceScale;
+
+        OrderReportCollection addedColl = securities;
+        addedColl.EnableSketches(true);
+        for (const auto& orderAdd : scaledOrderAdds)
+            addedColl.AddOrderData(orderAdd.first, orderAdd.second);
+
+        OrderReportCollection batchedColl = securities;
+        OrderBatch batch;
+        batchedColl.EnableSketches(true);
+        AddOrderBatches(batchedColl, batch, scaledOrderAdds, securityIds);
+
+        if (batchedColl.Size() != addedColl.Size())
+            return false;
+
+        ReportRow row;
+        std::string addedRow, batchedRow;
+        for (size_t slot = 0; slot < addedColl.Size(); ++slot)
+        {
+            addedRow.clear();
+            batchedRow.clear();
+            QuantileReportSchema::FORMAT.formatRow(row, addedColl, slot);
+            row.AppendTo(addedRow, '\t');
+            QuantileReportSchema::FORMAT.formatRow(row, batchedColl, slot);
+            row.AppendTo(batchedRow, '\t');
+            if (batchedRow != addedRow)
+                return false;
+        }
+    }
+    return true;
+}
+
+
+/** @brief Writes the results as JSON
+ * 
+ *  @param output     - Stream to write to
+ *  @param inputFile  - Input File Name/Path the benchmarks were run against
+ *  @param inputLines - Lines in the input file
+ *  @param inputBytes - Size of the input file
+ *  @param results    - Result of each benchmark
+ *  @return void
+ */
+static void WriteResults( std::ostream&                       output,
+                          const std::string&                  inputFile,
+                          const size_t                        inputLines,
+                          const size_t                        inputBytes,
+                          const std::vector<BenchmarkResult>& results )
+{
+    static const char* const SIMD_LEVEL_NAMES[] = { "scalar", "sse2", "avx2" };
+
+    output << "{\n";
+    output << "  \"timestamp\": " << std::time(nullptr) << ",\n";
+#ifdef __VERSION__
+    output << "  \"compiler\": " << JsonString(__VERSION__) << ",\n";
+#endif
+    output << "  \"simd_level\": \"" << SIMD_LEVEL_NAMES[static_cast<int>(MessageClassifier::GetSimdLevel())] << "\",\n";
+    output << "  \"input_file\": " << JsonString(inputFile) << ",\n";
+    output << "  \"input_lines\": " << inputLines << ",\n";
+    output << "  \"input_bytes\": " << inputBytes << ",\n";
+    output << "  \"order_report_bytes\": " << sizeof(OrderReport) << ",\n";
+    output << "  \"security_info_bytes\": " << sizeof(SecurityInfo) << ",\n";
+    output << "  \"live_order_bytes\": " << sizeof(LiveOrder) << ",\n";
+    output << "  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& result = results[i];
+        std::vector<double> sorted = result.seconds;
+        std::sort(sorted.begin(), sorted.end());
+
+        double minSeconds = sorted.front();
+        double medianSeconds = sorted[sorted.size() / 2];
+        double meanSeconds = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+
+        output << (i > 0 ? ",\n" : "\n");
+        output << "    {\n";
+        output << "      \"name\": " << JsonString(result.name) << ",\n";
+        output << "      \"iterations\": " << sorted.size() << ",\n";
+        output << "      \"items\": " << result.items << ",\n";
+        output << "      \"bytes\": " << result.bytes << ",\n";
+        output << "      \"min_seconds\": " << minSeconds << ",\n";
+        output << "      \"median_seconds\": " << medianSeconds << ",\n";
+        output << "      \"mean_seconds\": " << meanSeconds << ",\n";
+        output << "      \"max_seconds\": " << sorted.back() << ",\n";
+        if (result.memoryBytes > 0)
+        {
+            output << "      \"memory_bytes\": " << result.memoryBytes << ",\n";
+            output << "      \"memory_bytes_per_item\": " << (result.items > 0 ? static_cast<double>(result.memoryBytes) / result.items : 0.0) << ",\n";
+        }
+        if (!result.queryLatencies.empty())
+        {
+            output << "      \"query_latencies\": [";
+            for (size_t j = 0; j < result.queryLatencies.size(); ++j)
+            {
+                std::vector<double> latencies = result.queryLatencies[j].seconds;
+                std::sort(latencies.begin(), latencies.end());
+
+                output << (j > 0 ? ",\n" : "\n");
+                output << "        { \"query\": " << JsonString(result.queryLatencies[j].query) << ", \"count\": " << latencies.size();
+                if (!latencies.empty())
+                {
+                    output << ", \"p50_us\": " << PercentileMicros(latencies, 0.50)
+                           << ", \"p90_us\": " << PercentileMicros(latencies, 0.90)
+                           << ", \"p99_us\": " << PercentileMicros(latencies, 0.99)
+                           << ", \"p999_us\": " << PercentileMicros(latencies, 0.999)
+                           << ", \"max_us\": " << latencies.back() * 1e6;
+                }
+                output << " }";
+            }
+            output << "\n      ],\n";
+        }
+        output << "      \"ns_per_item\": " << (result.items > 0 ? minSeconds * 1e9 / result.items : 0.0) << ",\n";
+        output << "      \"items_per_second\": " << (minSeconds > 0 ? result.items / minSeconds : 0.0) << ",\n";
+        output << "      \"mb_per_second\": " << (minSeconds > 0 ? result.bytes / minSeconds / 1e6 : 0.0) << "\n";
+        output << "    }";
+    }
+
+    output << "\n  ]\n}\n";
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::string inputFile = "pretrade_current.txt";
+    std::string compressedInputFile;
+    std::string reportFile = "benchmark_report.txt";
+    std::string resultsFile;
+    std::string filter;
+    size_t iterations = 5;
+    size_t numLiveOrders = 10000000;
+    size_t publishLines = 100000;
+    size_t maxShards = 8;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc)
+            inputFile = argv[++i];
+        else if (arg == "--compressed-input" && i + 1 < argc)
+            compressedInputFile = argv[++i];
+        else if (arg == "--iterations" && i + 1 < argc)
+            iterations = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--report" && i + 1 < argc)
+            reportFile = argv[++i];
+        else if (arg == "--live-orders" && i + 1 < argc)
+            numLiveOrders = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--publish-messages" && i + 1 < argc)
+            publishLines = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--max-shards" && i + 1 < argc)
+            maxShards = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--output" && i + 1 < argc)
+            resultsFile = argv[++i];
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    MappedFile mappedFile;
+    if (!mappedFile.Open(inputFile))
+    {
+        std::cerr << "Unable to map " << inputFile << std::endl;
+        return 1;
+    }
+
+    std::string_view inputData = mappedFile.GetData();
+    std::vector<std::string_view> inputLines;
+    for (size_t lineStart = 0; lineStart < inputData.size(); )
+    {
+        size_t lineEnd = inputData.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos)
+            lineEnd = inputData.size();
+        inputLines.push_back(inputData.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+    }
+
+    auto selected = [&filter](const std::string& name) { return filter.empty() || name.find(filter) != std::string::npos; };
+    std::vector<BenchmarkResult> results;
+
+    // Reading the input file
+    //
+    if (selected("InputFileHandler::ReadInputFile"))
+    {
+        BenchmarkResult result = { "InputFileHandler::ReadInputFile", inputLines.size(), inputData.size(), {} };
+        TimeBenchmark(result, iterations, nullptr, [&inputFile]
+        {
+            LineCountingFileHandler lineCounter(inputFile);
+            lineCounter.ReadInputFile();
+        });
+        results.push_back(result);
+    }
+
+    if (selected("InputFileHandler::ReadInputFile[AsyncRead]"))
+    {
+        BenchmarkResult result = { "InputFileHandler::ReadInputFile[AsyncRead]", inputLines.size(), inputData.size(), {} };
+        TimeBenchmark(result, iterations, nullptr, [&inputFile]
+        {
+            LineCountingFileHandler lineCounter(inputFile);
+            lineCounter.SetInputReadMethod(InputReadMethod::AsyncRead);
+            lineCounter.ReadInputFile();
+        });
+        results.push_back(result);
+    }
+
+    if (selected("InputFileHandler::ReadInputFile[Stream]"))
+    {
+        BenchmarkResult result = { "InputFileHandler::ReadInputFile[Stream]", inputLines.size(), inputData.size(), {} };
+        TimeBenchmark(result, iterations, nullptr, [&inputFile]
+        {
+            LineCountingFileHandler lineCounter(inputFile);
+            lineCounter.SetInputReadMethod(InputReadMethod::Stream);
+            lineCounter.ReadInputFile();
+        });
+        results.push_back(result);
+    }
+
+    // Processing lines already in memory
+    //
+    std::shared_ptr<OrderReportCollection> ordRptColl;
+    BenchmarkOrderReportFileHandler ordRptFH(inputFile, reportFile, nullptr, '\t', false);
+    auto readAllLines = [&ordRptFH, &inputLines]
+    {
+        for (std::string_view inputLine : inputLines)
+            ordRptFH.ReadInputData(inputLine);
+    };
+
+    if (selected("OrderReportFileHandler::ReadInputData"))
+    {
+        BenchmarkResult result = { "OrderReportFileHandler::ReadInputData", inputLines.size(), inputData.size(), {} };
+        TimeBenchmark(result, iterations, [&ordRptFH, &ordRptColl, &inputFile, &reportFile]
+        {
+            ordRptColl = std::make_shared<OrderReportCollection>();
+            ordRptFH.~BenchmarkOrderReportFileHandler();
+            new (&ordRptFH) BenchmarkOrderReportFileHandler(inputFile, reportFile, ordRptColl, '\t', false);
+        }, readAllLines);
+        results.push_back(result);
+    }
+
+    if (selected("OrderReportFileHandler::ReadInputData[Activity]"))
+    {
+        BenchmarkResult result = { "OrderReportFileHandler::ReadInputData[Activity]", inputLines.size(), inputData.size(), {} };
+        TimeBenchmark(result, iterations, [&ordRptFH, &ordRptColl, &inputFile, &reportFile]
+        {
+            ordRptColl = std::make_shared<OrderReportCollection>();
+            ordRptFH.~BenchmarkOrderReportFileHandler();
+            new (&ordRptFH) BenchmarkOrderReportFileHandler(inputFile, reportFile, ordRptColl, '\t', false);
+            ordRptFH.SetOrderTracking(true);
+        }, readAllLines);
+        result.memoryBytes = ordRptFH.GetLiveOrders().GetMemoryUsed();
+        results.push_back(result);
+    }
+
+    // Parsing the Order Adds alone, and finding their fields with the JSON Line Parser's block scan of
+    // each SIMD level the CPU supports, as for lines whose fields aren't in the order the feed writes them
+    //
+    if (selected("OrderMessageParser::ParseOrderAdd") || selected("JsonLineParser::ExtractFields"))
+    {
+        static const char* const PARSE_LEVEL_NAMES[] = { "Scalar", "SSE2", "AVX2" };
+        static constexpr std::string_view ORDER_ADD_KEYS[] = { "securityId_", "side_", "quantity_", "price_" };
+        static const JsonKeySet ORDER_ADD_KEY_SET(ORDER_ADD_KEYS);
+        constexpr int MSG_TYPE_ORDER_ADD = 12;
+        std::vector<std::string_view> orderAddLines;
+        size_t orderAddBytes = 0;
+        for (std::string_view inputLine : inputLines)
+        {
+            if (MessageClassifier::Classify(inputLine) == MSG_TYPE_ORDER_ADD)
+            {
+                orderAddLines.push_back(inputLine);
+                orderAddBytes += inputLine.size();
+            }
+        }
+
+        if (selected("OrderMessageParser::ParseOrderAdd"))
+        {
+            BenchmarkResult result = { "OrderMessageParser::ParseOrderAdd", orderAddLines.size(), orderAddBytes, {} };
+            TimeBenchmark(result, iterations, nullptr, [&orderAddLines]
+            {
+                int securityId = 0;
+                OrderAddData ordData;
+                for (std::string_view inputLine : orderAddLines)
+                    OrderMessageParser::ParseOrderAdd(inputLine, securityId, ordData);
+            });
+            results.push_back(result);
+        }
+
+        if (selected("OrderMessageParser::ParseOrderAdd[Substr]"))
+        {
+            if (!SubstrParsesMatch(orderAddLines))
+            {
+                std::cerr << "OrderMessageParser::ParseOrderAdd[Substr] doesn't give the same Order Data as ParseOrderAdd" << std::endl;
+                return 1;
+            }
+
+            BenchmarkResult result = { "OrderMessageParser::ParseOrderAdd[Substr]", orderAddLines.size(), orderAddBytes, {} };
+            TimeBenchmark(result, iterations, nullptr, [&orderAddLines]
+            {
+                int securityId = 0;
+                OrderAddData ordData;
+                for (std::string_view inputLine : orderAddLines)
+                    ParseOrderAddWithSubstr(inputLine, securityId, ordData);
+            });
+            results.push_back(result);
+        }
+
+        const SimdLevel supportedLevel = DetectSimdLevel();
+        for (int level = 0; level <= static_cast<int>(supportedLevel); ++level)
+        {
+            const std::string name = std::string("JsonLineParser::ExtractFields[") + PARSE_LEVEL_NAMES[level] + "]";
+            if (!selected(name))
+                continue;
+
+            JsonLineParser::SetSimdLevel(static_cast<SimdLevel>(level));
+            BenchmarkResult result = { name, orderAddLines.size(), orderAddBytes, {} };
+            TimeBenchmark(result, iterations, nullptr, [&orderAddLines]
+            {
+                std::string_view values[JsonKeySet::MAX_KEYS];
+                for (std::string_view inputLine : orderAddLines)
+                    JsonLineParser::ExtractFields(inputLine, ORDER_ADD_KEY_SET, values);
+            });
+            results.push_back(result);
+        }
+        JsonLineParser::SetSimdLevel(supportedLevel);
+    }
+
+    // Publishing snapshots as the lines are read, with no one reading them, and then while a client
+    // queries the server as fast as it can. A query is picked in turn from lookups by ISIN & by
+    // Security ID of the Securities in the input file, the top 10 Securities and, every 64th
+    // query, a dump of every Security.
+    //
+    if (selected("OrderReportFileHandler::ReadInputData[Published]") || selected("QueryServer::LoadTest"))
+    {
+        SnapshotPublisher publisher;
+        auto resetPublishing = [&ordRptFH, &ordRptColl, &inputFile, &reportFile, &publisher, publishLines]
+        {
+            ordRptColl = std::make_shared<OrderReportCollection>();
+            ordRptFH.~BenchmarkOrderReportFileHandler();
+            new (&ordRptFH) BenchmarkOrderReportFileHandler(inputFile, reportFile, ordRptColl, '\t', false);
+            ordRptFH.SetSnapshotPublisher(&publisher, publishLines);
+            ordRptFH.PublishSnapshot();
+        };
+
+        if (selected("OrderReportFileHandler::ReadInputData[Published]"))
+        {
+            BenchmarkResult result = { "OrderReportFileHandler::ReadInputData[Published]", inputLines.size(), inputData.size(), {} };
+            TimeBenchmark(result, iterations, resetPublishing, readAllLines);
+            results.push_back(result);
+        }
+
+#ifdef BENCHMARK_QUERIES_SUPPORTED
+        if (selected("QueryServer::LoadTest"))
+        {
+            std::vector<std::string> isinQueries;
+            std::vector<std::string> securityQueries;
+            for (std::string_view inputLine : inputLines)
+            {
+                SecurityRefData refData;
+                if (OrderMessageParser::ParseSecurityRef(inputLine, refData))
+                {
+                    isinQueries.push_back("ISIN " + std::string(refData.ISIN) + "\n");
+                    securityQueries.push_back("SECURITY " + std::to_string(refData.securityId) + "\n");
+                }
+            }
+            if (isinQueries.empty())
+            {
+                isinQueries.push_back("ISIN none\n");
+                securityQueries.push_back("SECURITY 0\n");
+            }
+
+            const std::string socketPath = reportFile + ".sock";
+            QueryServer queryServer(publisher, &OrderReportSchema::FORMAT, '\t');
+            if (!queryServer.Start(socketPath))
+            {
+                std::cerr << "Unable to listen for queries on " << socketPath << std::endl;
+                return 1;
+            }
+
+            BenchmarkResult result = { "QueryServer::LoadTest", inputLines.size(), inputData.size(), {} };
+            result.queryLatencies = { { "ISIN", {} }, { "SECURITY", {} }, { "TOP 10", {} }, { "DUMP", {} } };
+            std::atomic<bool> reading(false);
+
+            TimeBenchmark(result, iterations, resetPublishing, [&]
+            {
+                reading.store(true);
+                std::thread client([&]
+                {
+                    int clientSocket = ConnectToQueryServer(socketPath);
+                    std::string answer;
+                    for (size_t i = 0; clientSocket >= 0 && reading.load(); ++i)
+                    {
+                        size_t queryType = (i % 64 == 63) ? 3 : (i % 3);
+                        const std::string& query = (queryType == 0) ? isinQueries[(i / 3) % isinQueries.size()] :
+                                                   (queryType == 1) ? securityQueries[(i / 3) % securityQueries.size()] :
+                                                   (queryType == 2) ? std::string("TOP 10\n") : std::string("DUMP\n");
+
+                        auto start = std::chrono::steady_clock::now();
+                        if (!RunQuery(clientSocket, query, answer))
+                            break;
+                        result.queryLatencies[queryType].seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                    }
+                    if (clientSocket >= 0)
+                        close(clientSocket);
+                });
+
+                readAllLines();
+                reading.store(false);
+                client.join();
+            });
+            queryServer.Stop();
+            results.push_back(result);
+        }
+#endif
+        ordRptFH.SetSnapshotPublisher(nullptr, 0);
+    }
+
+    // Aggregating Order Adds that have already been parsed, against the Securities in the input file.
+    // With quantiles, each Order Add is also added to its Security's sketches. Order Adds found by
+    // Security ID, and batches, include looking each Security up. The interval report adds each Order Add
+    // to the bucket of its minute.
+    //
+    if ( selected("OrderReport::AddOrderData") ||
+         selected("OrderReportCollection::FindAddOrderData") ||
+         selected("OrderReportCollection::AddOrderData[Quantiles]") ||
+         selected("OrderReportCollection::AddOrderBatch") ||
+         selected("IntervalReport::AddOrderData") )
+    {
+        OrderReportCollection securities;
+        std::vector<std::pair<size_t, OrderAddData>> orderAdds;
+        std::vector<int> orderAddSecurityIds;
+        for (std::string_view inputLine : inputLines)
+        {
+            SecurityRefData refData;
+            int securityId = 0;
+            OrderAddData ordData;
+            if (OrderMessageParser::ParseSecurityRef(inputLine, refData))
+                securities.Insert(refData.securityId, refData.ISIN, refData.currency);
+            else if (OrderMessageParser::ParseOrderAdd(inputLine, securityId, ordData, OrderMessageParser::PARSE_TIMESTAMP))
+            {
+                size_t slot = securities.Find(securityId);
+                if (slot != OrderReportCollection::NOT_FOUND)
+                {
+                    orderAdds.emplace_back(slot, ordData);
+                    orderAddSecurityIds.push_back(securityId);
+                }
+            }
+        }
+
+        if (selected("OrderReport::AddOrderData"))
+        {
+            std::vector<OrderReport> ordRpts;
+            BenchmarkResult result = { "OrderReport::AddOrderData", orderAdds.size(), orderAdds.size() * sizeof(OrderAddData), {} };
+            TimeBenchmark(result, iterations, [&ordRpts, &securities]
+            {
+                ordRpts.assign(securities.Size(), OrderReport());
+            }, [&ordRpts, &orderAdds]
+            {
+                for (const auto& orderAdd : orderAdds)
+                    ordRpts[orderAdd.first].AddOrderData(orderAdd.second);
+            });
+            results.push_back(result);
+        }
+
+        if (selected("OrderReportCollection::FindAddOrderData"))
+        {
+            OrderReportCollection foundColl;
+            BenchmarkResult result = { "OrderReportCollection::FindAddOrderData", orderAdds.size(), orderAdds.size() * sizeof(OrderAddData), {} };
+            TimeBenchmark(result, iterations, [&foundColl, &securities]
+            {
+                foundColl = securities;
+            }, [&foundColl, &orderAdds, &orderAddSecurityIds]
+            {
+                for (size_t i = 0; i < orderAdds.size(); ++i)
+                {
+                    size_t slot = foundColl.Find(orderAddSecurityIds[i]);
+                    if (slot != OrderReportCollection::NOT_FOUND)
+                        foundColl.AddOrderData(slot, orderAdds[i].second);
+                }
+            });
+            results.push_back(result);
+        }
+
+        if (selected("OrderReportCollection::FindAddOrderData[unordered_map]"))
+        {
+            std::unordered_map<int, MapOrderReport> mapColl;
+            BenchmarkResult result = { "OrderReportCollection::FindAddOrderData[unordered_map]", orderAdds.size(), orderAdds.size() * sizeof(OrderAddData), {} };
+            TimeBenchmark(result, iterations, [&mapColl, &securities]
+            {
+                mapColl.clear();
+                for (size_t slot = 0; slot < securities.Size(); ++slot)
+                {
+                    const SecurityInfo& secInfo = securities.GetSecurityInfo(slot);
+                    int securityId = securities.GetOrderReport(slot).GetSecurityId();
+                    MapOrderReport& mapOrdRpt = mapColl[securityId];
+                    mapOrdRpt.ISIN = std::string(secInfo.ISIN.View());
+                    mapOrdRpt.currency = std::string(secInfo.currency.View());
+                    mapOrdRpt.ordRpt.SetSecurityId(securityId);
+                }
+            }, [&mapColl, &orderAdds, &orderAddSecurityIds]
+            {
+                for (size_t i = 0; i < orderAdds.size(); ++i)
+                {
+                    auto find = mapColl.find(orderAddSecurityIds[i]);
+                    if (find != mapColl.end())
+                        find->second.ordRpt.AddOrderData(orderAdds[i].second);
+                }
+            });
+            results.push_back(result);
+        }
+
+        if (selected("OrderReportCollection::AddOrderData[Quantiles]"))
+        {
+            OrderReportCollection sketchedColl;
+            BenchmarkResult result = { "OrderReportCollection::AddOrderData[Quantiles]", orderAdds.size(), orderAdds.size() * sizeof(OrderAddData), {} };
+            TimeBenchmark(result, iterations, [&sketchedColl, &securities]
+            {
+                sketchedColl = securities;
+                sketchedColl.EnableSketches(true);
+            }, [&sketchedColl, &orderAdds]
+            {
+                for (const auto& orderAdd : orderAdds)
+                    sketchedColl.AddOrderData(orderAdd.first, orderAdd.second);
+            });
+            results.push_back(result);
+        }
+
+        const SimdLevel supportedLevel = DetectSimdLevel();
+        for (int level = 0; level <= static_cast<int>(supportedLevel); ++level)
+        {
+            static const char* const BATCH_LEVEL_NAMES[] = { "Scalar", "SSE2", "AVX2" };
+            const std::string name = std::string("OrderReportCollection::AddOrderBatch[") + BATCH_LEVEL_NAMES[level] + "]";
+            if (!selected(name))
+                continue;
+
+            OrderBatch::SetSimdLevel(static_cast<SimdLevel>(level));
+            if (!OrderBatchesMatch(securities, orderAdds, orderAddSecurityIds))
+            {
+                std::cerr << name << " doesn't give the same Order Reports as adding each Order with AddOrderData" << std::endl;
+                return 1;
+            }
+
+            OrderReportCollection batchedColl;
+            OrderBatch batch;
+            BenchmarkResult result = { name, orderAdds.size(), orderAdds.size() * sizeof(OrderAddData), {} };
+            TimeBenchmark(result, iterations, [&batchedColl, &securities]
+            {
+                batchedColl = securities;
+            }, [&batchedColl, &batch, &orderAdds, &orderAddSecurityIds]
+            {
+                AddOrderBatches(batchedColl, batch, orderAdds, orderAddSecurityIds);
+            });
+            results.push_back(result);
+        }
+        OrderBatch::SetSimdLevel(supportedLevel);
+
+        // A whole day in one interval times just the bucket updates; 1 minute intervals also write each minute out
+        //
+        const std::pair<const char*, std::chrono::nanoseconds> intervalBenchmarks[] = { { "IntervalReport::AddOrderData", std::chrono::hours(24) },
+                                                                                        { "IntervalReport::AddOrderData[1m]", std::chrono::minutes(1) } };
+        for (const auto& intervalBenchmark : intervalBenchmarks)
+        {
+            if (!selected(intervalBenchmark.first))
+                continue;
+
+            IntervalReport intervalReport;
+            std::chrono::nanoseconds interval = intervalBenchmark.second;
+            BenchmarkResult result = { intervalBenchmark.first, orderAdds.size(), orderAdds.size() * sizeof(OrderAddData), {} };
+            TimeBenchmark(result, iterations, [&intervalReport, &securities, &reportFile, interval]
+            {
+                intervalReport.Open(reportFile + ".intervals", interval, &securities, '\t');
+            }, [&intervalReport, &orderAdds]
+            {
+                for (const auto& orderAdd : orderAdds)
+                    intervalReport.AddOrderData(orderAdd.first, orderAdd.second);
+            });
+            intervalReport.Close();
+            std::remove((reportFile + ".intervals").c_str());
+            results.push_back(result);
+        }
+    }
+
+    // Holding many live Orders at once. Order IDs arrive in sequence, as they do in the feed, and are
+    // removed in a random order, as they would be by the Deletes & Executes of a busy book.
+    //
+    if (selected("OrderStore::Insert") || selected("OrderStore::FindRemove"))
+    {
+        std::vector<uint64_t> removeIds(numLiveOrders);
+        std::iota(removeIds.begin(), removeIds.end(), 1);
+        std::shuffle(removeIds.begin(), removeIds.end(), std::mt19937_64(1));
+
+        OrderStore liveOrders;
+        auto insertAll = [&liveOrders, numLiveOrders]
+        {
+            for (uint64_t orderId = 1; orderId <= numLiveOrders; ++orderId)
+            {
+                LiveOrder& order = liveOrders.Insert(orderId);
+                order.quantity = 100;
+                order.price = 1000000 + orderId;
+                order.slot = static_cast<uint32_t>(orderId & 1023);
+                order.side = (orderId & 1) ? Side::Buy : Side::Sell;
+            }
+        };
+
+        if (selected("OrderStore::Insert"))
+        {
+            BenchmarkResult result = { "OrderStore::Insert", numLiveOrders, numLiveOrders * sizeof(LiveOrder), {} };
+            TimeBenchmark(result, iterations, [&liveOrders] { liveOrders.Clear(); }, insertAll);
+            result.memoryBytes = liveOrders.GetMemoryUsed();
+            results.push_back(result);
+        }
+
+        if (selected("OrderStore::FindRemove"))
+        {
+            BenchmarkResult result = { "OrderStore::FindRemove", numLiveOrders, numLiveOrders * sizeof(LiveOrder), {} };
+            TimeBenchmark(result, iterations, [&liveOrders, &insertAll]
+            {
+                liveOrders.Clear();
+                insertAll();
+            }, [&liveOrders, &removeIds]
+            {
+                for (uint64_t orderId : removeIds)
+                {
+                    if (liveOrders.Find(orderId) != nullptr)
+                        liveOrders.Remove(orderId);
+                }
+            });
+            results.push_back(result);
+        }
+    }
+
+    // Sharded reads, first the lines a single worker reads in memory and then the whole aggregation in worker
+    // processes. On a machine with at least as many cores as shards the workers run side by side, so the
+    // aggregation takes about as long as its slowest worker plus the merge.
+    //
+    for (size_t numShards = 1; numShards <= maxShards; numShards *= 2)
+    {
+        std::string shardName = "OrderReportFileHandler::ReadInputData[Shard of " + std::to_string(numShards) + "]";
+        if (selected(shardName))
+        {
+            BenchmarkResult result = { shardName, inputLines.size(), inputData.size(), {} };
+            TimeBenchmark(result, iterations, [&ordRptFH, &ordRptColl, &inputFile, &reportFile, numShards]
+            {
+                ordRptColl = std::make_shared<OrderReportCollection>();
+                ordRptFH.~BenchmarkOrderReportFileHandler();
+                new (&ordRptFH) BenchmarkOrderReportFileHandler(inputFile, reportFile, ordRptColl, '\t', false);
+                ordRptFH.SetPartition(0, numShards);
+            }, readAllLines);
+            results.push_back(result);
+        }
+
+        std::string runName = "ShardRunner::Run[" + std::to_string(numShards) + " shards]";
+        if (selected(runName) && ShardRunner::IsSupported())
+        {
+            BenchmarkResult result = { runName, inputLines.size(), inputData.size(), {} };
+            TimeBenchmark(result, iterations, nullptr, [&inputFile, &reportFile, numShards]
+            {
+                auto readShard = [&inputFile, numShards](const size_t shard, OutputBuffer& outBuffer)
+                {
+                    OrderReportFileHandler shardFH(inputFile, "", nullptr, '\t', false);
+                    shardFH.SetPartition(shard, numShards);
+                    shardFH.ReadInputFile();
+                    return shardFH.WriteShardPartial(outBuffer);
+                };
+
+                std::vector<std::string> shardResults;
+                std::vector<ShardPartial> partials(numShards);
+                ShardRunner::Run(numShards, readShard, shardResults);
+                for (size_t shard = 0; shard < numShards; ++shard)
+                    OrderReportShard::Read(shardResults[shard], partials[shard]);
+
+                OrderReportFileHandler mergedFH("", reportFile, nullptr, '\t', false);
+                mergedFH.MergeShardPartials(partials);
+            });
+            results.push_back(result);
+        }
+    }
+
+    // Writing the report, from a collection with every line of the input file read into it
+    //
+    if (selected("OrderReportFileHandler::WriteOutputFile"))
+    {
+        ordRptColl = std::make_shared<OrderReportCollection>();
+        ordRptFH.~BenchmarkOrderReportFileHandler();
+        new (&ordRptFH) BenchmarkOrderReportFileHandler(inputFile, reportFile, ordRptColl, '\t', true);
+        readAllLines();
+
+        BenchmarkResult result = { "OrderReportFileHandler::WriteOutputFile", ordRptColl->Size(), 0, {} };
+        TimeBenchmark(result, iterations, nullptr, [&ordRptFH] { ordRptFH.WriteOutputFile(); });
+
+        std::ifstream report(reportFile, std::ios::binary | std::ios::ate);
+        result.bytes = report ? static_cast<size_t>(report.tellg()) : 0;
+        results.push_back(result);
+    }
+
+    // Building a rollup, from a collection with every line of the input file read into it and every Security mapped
+    //
+    if (selected("RollupReport::Build"))
+    {
+        ordRptColl = std::make_shared<OrderReportCollection>();
+        ordRptFH.~BenchmarkOrderReportFileHandler();
+        new (&ordRptFH) BenchmarkOrderReportFileHandler(inputFile, reportFile, ordRptColl, '\t', true);
+        readAllLines();
+
+        RollupReport rollup(RollupDimension::CountryCurrency, reportFile, nullptr);
+        rollup.MapSecurities(*ordRptColl);
+
+        BenchmarkResult result = { "RollupReport::Build", ordRptColl->Size(), 0, {} };
+        TimeBenchmark(result, iterations, nullptr, [&rollup, &ordRptColl] { rollup.Build(*ordRptColl); });
+        results.push_back(result);
+    }
+
+    // Producing the report from a compressed input file, with and without decompressing it to disk first
+    //
+    if (!compressedInputFile.empty() && (selected("CompressedInput::Pipelined") || selected("CompressedInput::DecompressThenRead")))
+    {
+        CompressionFormat format = CompressedInputReader::DetectFormat(compressedInputFile);
+        if (format == CompressionFormat::None || !CompressedInputReader::IsSupported(format))
+        {
+            std::cerr << compressedInputFile << " isn't compressed in a format this build can read" << std::endl;
+            return 1;
+        }
+
+        LineCountingFileHandler lineCounter(compressedInputFile);
+        lineCounter.ReadInputFile();
+
+        auto readReport = [&reportFile](const std::string& readFile)
+        {
+            OrderReportFileHandler compressedFH(readFile, reportFile, nullptr, '\t', false);
+            compressedFH.ReadInputFile();
+        };
+
+        if (selected("CompressedInput::Pipelined"))
+        {
+            BenchmarkResult result = { "CompressedInput::Pipelined", lineCounter.GetNumLines(), lineCounter.GetNumBytes(), {} };
+            TimeBenchmark(result, iterations, nullptr, [&readReport, &compressedInputFile] { readReport(compressedInputFile); });
+            results.push_back(result);
+        }
+
+        if (selected("CompressedInput::DecompressThenRead"))
+        {
+            std::string decompressedFile = reportFile + ".decompressed";
+            BenchmarkResult result = { "CompressedInput::DecompressThenRead", lineCounter.GetNumLines(), lineCounter.GetNumBytes(), {} };
+            TimeBenchmark(result, iterations, nullptr, [&readReport, &compressedInputFile, &decompressedFile]
+            {
+                CompressedInputReader reader;
+                OutputBuffer decompressed;
+                std::string_view block;
+                reader.Open(compressedInputFile);
+                decompressed.Open(decompressedFile);
+                while (reader.NextBlock(block))
+                    decompressed.Append(block);
+                decompressed.Close();
+
+                readReport(decompressedFile);
+            });
+            std::remove(decompressedFile.c_str());
+            results.push_back(result);
+        }
+    }
+
+    if (resultsFile.empty())
+        WriteResults(std::cout, inputFile, inputLines.size(), inputData.size(), results);
+    else
+    {
+        std::ofstream resultsStream(resultsFile);
+        WriteResults(resultsStream, inputFile, inputLines.size(), inputData.size(), results);
+    }
+
+    return 0;
+}
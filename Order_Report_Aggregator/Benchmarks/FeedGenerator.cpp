@@ -0,0 +1,356 @@
+/** @file FeedGenerator.cpp
+ *  @brief Generates a synthetic pretrade feed to benchmark the Order Report Aggregator with
+ *
+ *  Writes a file in the same format as pretrade_current.txt, one JSON message per line. Each line is
+ *  one of:
+ *    - Security Reference Data ("msgType_":8). The first reference to each Security introduces it,
+ *      later ones repeat a Security that has already been seen.
+ *    - Order Add ("msgType_":12) against a Security that has already been referenced. A small share
+ *      are against Securities that are never referenced, so the aggregator has to discard them.
+ *    - Order Delete ("msgType_":13), Order Modify ("msgType_":14) or Order Execute ("msgType_":15)
+ *      of an Order that is still live. Only generated when asked for, as the live Orders have to be
+ *      held in memory to pick from.
+ *    - Any other message type from the mix, which the aggregator should ignore.
+ *
+ *  The file is streamed through an Output Buffer, so any number of lines can be generated without
+ *  holding the feed in memory. The same seed always produces the same file.
+ *
+ *  Usage: Feed_Generator [--lines N] [--securities N] [--reference-ratio R] [--order-ratio R] [--update-ratio R]
+ *                        [--unknown-ratio R] [--message-mix T:W,T:W,...] [--seed N] [--output FILE]
+ *    --lines N            - Lines to generate. Defaults to 1,000,000.
+ *    --securities N       - Distinct Securities. Defaults to 2,000.
+ *    --reference-ratio R  - Share of lines that are Security Reference Data. Defaults to 0.05.
+ *    --order-ratio R      - Share of lines that are Order Adds. Defaults to 0.70.
+ *    --update-ratio R     - Share of lines that are Order Deletes, Modifies & Executes, 2:1:2. Defaults to 0.
+ *    --unknown-ratio R    - Share of Order Adds against Securities that are never referenced. Defaults to 0.02.
+ *    --message-mix T:W,.. - Other message types and their relative weights, making up the rest of the lines.
+ *                           Defaults to 1:1,2:1,4:1,9:1,10:1,11:1,20:1.
+ *    --seed N             - Random seed. Defaults to 1.
+ *    --output FILE        - Output File Name/Path. Defaults to pretrade_current.txt.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "OutputBuffer.h"
+
+struct FeedSettings
+{
+    uint64_t lines;
+    uint32_t securities;
+    double referenceRatio;
+    double orderRatio;
+    double updateRatio;
+    double unknownRatio;
+    std::vector<std::pair<int, double>> messageMix;
+    uint64_t seed;
+    std::string outputFile;
+};
+
+/** @brief Small, fast random number generator (xorshift64*)
+ *
+ *  Quality is more than good enough for test data, and it is cheap enough not to
+ *  be the bottleneck when generating a billion lines.
+ */
+class FeedRandom
+{
+private:
+    uint64_t state;
+
+public:
+    FeedRandom(const uint64_t seed) : state(seed != 0 ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+    uint64_t Next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    uint64_t Range(const uint64_t low, const uint64_t high)
+    {
+        return low + (Next() % (high - low + 1));
+    }
+
+    double Unit()
+    {
+        return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+
+/** @brief Parses the message mix option
+ * 
+ *  @param mixStr     - Comma separated list of message type:weight pairs. A missing weight counts as 1.
+ *  @param messageMix - Parsed message types & weights
+ *  @return true if every entry could be parsed
+ */
+static bool ParseMessageMix(const std::string& mixStr, std::vector<std::pair<int, double>>& messageMix)
+{
+    messageMix.clear();
+
+    std::stringstream mixStream(mixStr);
+    std::string entry;
+    while (std::getline(mixStream, entry, ','))
+    {
+        try
+        {
+            size_t sepPos = entry.find(':');
+            int msgType = std::stoi(entry.substr(0, sepPos));
+            double weight = (sepPos == std::string::npos) ? 1.0 : std::stod(entry.substr(sepPos + 1));
+            if ((msgType >= 12 && msgType <= 15) || msgType == 8 || weight < 0)
+                return false;
+            messageMix.emplace_back(msgType, weight);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/** @brief Writes the message header that starts every line
+ * 
+ *  @param outBuffer - The buffer for the feed file
+ *  @param msgType   - Message type of the line
+ *  @param seqNo     - Sequence number of the line
+ *  @param timestamp - Timestamp of the line, in nanoseconds
+ *  @return void
+ */
+static void WriteHeader(OutputBuffer& outBuffer, const int msgType, const uint64_t seqNo, const uint64_t timestamp)
+{
+    outBuffer.Append("{\"header_\":{\"msgType_\":");
+    outBuffer.AppendNumber(msgType);
+    outBuffer.Append(",\"seqNo_\":");
+    outBuffer.AppendNumber(seqNo);
+    outBuffer.Append(",\"timestamp_\":");
+    outBuffer.AppendNumber(timestamp);
+    outBuffer.Append('}');
+}
+
+
+/** @brief Generates the feed file
+ * 
+ *  @param settings - What to generate
+ *  @return true if the feed file was written
+ */
+static bool GenerateFeed(const FeedSettings& settings)
+{
+    static const char* const ISIN_COUNTRIES[] = { "GB", "IE", "NL", "ES", "DE", "FR", "US" };
+    static const char* const CURRENCIES[] = { "GBX", "EUR", "USD" };
+
+    OutputBuffer outBuffer;
+    if (!outBuffer.Open(settings.outputFile))
+        return false;
+
+    FeedRandom random(settings.seed);
+
+    // Securities are introduced in a random order, with IDs starting well above the unknown ones
+    //
+    const int FIRST_SECURITY_ID = 1000;
+    std::vector<int> securityIds(settings.securities);
+    for (uint32_t i = 0; i < settings.securities; ++i)
+        securityIds[i] = FIRST_SECURITY_ID + static_cast<int>(i);
+    for (size_t i = securityIds.size(); i > 1; --i)
+        std::swap(securityIds[i - 1], securityIds[random.Range(0, i - 1)]);
+    size_t numReferenced = 0;
+
+    // Orders that can still be deleted, modified or executed
+    //
+    struct GeneratedOrder
+    {
+        uint64_t orderId;
+        int securityId;
+        uint64_t quantity;
+        uint64_t price;
+    };
+    std::vector<GeneratedOrder> liveOrders;
+
+    double totalMixWeight = 0;
+    for (const auto& mixEntry : settings.messageMix)
+        totalMixWeight += mixEntry.second;
+
+    uint64_t timestamp = 1602576000000000000ULL;
+    for (uint64_t seqNo = 1; seqNo <= settings.lines; ++seqNo)
+    {
+        timestamp += random.Range(1, 50000000);
+        double lineKind = random.Unit();
+
+        if (lineKind < settings.referenceRatio || numReferenced == 0)
+        {
+            int securityId = (numReferenced < securityIds.size()) ? securityIds[numReferenced++]
+                                                                  : securityIds[random.Range(0, numReferenced - 1)];
+            WriteHeader(outBuffer, 8, seqNo, timestamp);
+            outBuffer.Append(",\"securityId_\":");
+            outBuffer.AppendNumber(securityId);
+            outBuffer.Append(",\"isin_\":\"");
+            outBuffer.Append(ISIN_COUNTRIES[securityId % std::size(ISIN_COUNTRIES)]);
+            outBuffer.AppendNumber(1000000000ULL + static_cast<uint64_t>(securityId));
+            outBuffer.Append("\",\"currency_\":\"");
+            outBuffer.Append(CURRENCIES[(securityId / 7) % std::size(CURRENCIES)]);
+            outBuffer.Append("\",\"lotSize_\":1,\"tickTable_\":3}\n");
+        }
+        else if (lineKind < settings.referenceRatio + settings.updateRatio && !liveOrders.empty())
+        {
+            // Deletes & full executes take the Order off the book, so it's swapped out of the live Orders
+            //
+            size_t orderPos = random.Range(0, liveOrders.size() - 1);
+            GeneratedOrder& order = liveOrders[orderPos];
+            uint64_t updateKind = random.Range(0, 4);
+            int msgType = (updateKind < 2) ? 13 : (updateKind < 3) ? 14 : 15;
+
+            WriteHeader(outBuffer, msgType, seqNo, timestamp);
+            outBuffer.Append(",\"orderId_\":");
+            outBuffer.AppendNumber(order.orderId);
+            outBuffer.Append(",\"securityId_\":");
+            outBuffer.AppendNumber(order.securityId);
+
+            bool removed = (msgType == 13);
+            if (msgType != 13)
+            {
+                uint64_t quantity = (msgType == 14) ? random.Range(1, 5000) : random.Range(1, order.quantity);
+                outBuffer.Append(",\"quantity_\":");
+                outBuffer.AppendNumber(quantity);
+                outBuffer.Append(",\"price_\":");
+                outBuffer.AppendNumber(order.price);
+
+                order.quantity = (msgType == 14) ? quantity : order.quantity - quantity;
+                removed = (order.quantity == 0);
+            }
+            outBuffer.Append("}\n");
+
+            if (removed)
+            {
+                order = liveOrders.back();
+                liveOrders.pop_back();
+            }
+        }
+        else if (lineKind < settings.referenceRatio + settings.updateRatio + settings.orderRatio || totalMixWeight <= 0)
+        {
+            bool unknown = random.Unit() < settings.unknownRatio;
+            int securityId = unknown ? static_cast<int>(random.Range(1, FIRST_SECURITY_ID - 1))
+                                     : securityIds[random.Range(0, numReferenced - 1)];
+            bool buy = (random.Next() & 1) != 0;
+            uint64_t quantity = random.Range(1, 5000);
+            uint64_t price = random.Range(1000000, 900000000);
+            WriteHeader(outBuffer, 12, seqNo, timestamp);
+            outBuffer.Append(",\"orderId_\":");
+            outBuffer.AppendNumber(seqNo);
+            outBuffer.Append(",\"securityId_\":");
+            outBuffer.AppendNumber(securityId);
+            outBuffer.Append(buy ? ",\"side_\":BUY" : ",\"side_\":SELL");
+            outBuffer.Append(",\"quantity_\":");
+            outBuffer.AppendNumber(quantity);
+            outBuffer.Append(",\"price_\":");
+            outBuffer.AppendNumber(price);
+            outBuffer.Append(",\"flags_\":0}\n");
+
+            if (settings.updateRatio > 0 && !unknown)
+                liveOrders.push_back(GeneratedOrder{ seqNo, securityId, quantity, price });
+        }
+        else
+        {
+            double pick = random.Unit() * totalMixWeight;
+            int msgType = settings.messageMix.back().first;
+            for (const auto& mixEntry : settings.messageMix)
+            {
+                if (pick < mixEntry.second)
+                {
+                    msgType = mixEntry.first;
+                    break;
+                }
+                pick -= mixEntry.second;
+            }
+
+            WriteHeader(outBuffer, msgType, seqNo, timestamp);
+            outBuffer.Append(",\"securityId_\":");
+            outBuffer.AppendNumber(securityIds[random.Range(0, numReferenced - 1)]);
+            outBuffer.Append(",\"payload_\":\"xxxxxxxxxxxxxxxx\"}\n");
+        }
+    }
+
+    return outBuffer.Sync();
+}
+
+
+int main(int argc, char* argv[])
+{
+    FeedSettings settings = { 1000000,                // Lines
+                              2000,                   // Securities
+                              0.05,                   // Reference Ratio
+                              0.70,                   // Order Ratio
+                              0.0,                    // Update Ratio
+                              0.02,                   // Unknown Ratio
+                              {},                     // Message Mix
+                              1,                      // Seed
+                              "pretrade_current.txt" };
+    ParseMessageMix("1,2,4,9,10,11,20", settings.messageMix);
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--lines" && i + 1 < argc)
+                settings.lines = std::stoull(argv[++i]);
+            else if (arg == "--securities" && i + 1 < argc)
+                settings.securities = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--reference-ratio" && i + 1 < argc)
+                settings.referenceRatio = std::stod(argv[++i]);
+            else if (arg == "--order-ratio" && i + 1 < argc)
+                settings.orderRatio = std::stod(argv[++i]);
+            else if (arg == "--update-ratio" && i + 1 < argc)
+                settings.updateRatio = std::stod(argv[++i]);
+            else if (arg == "--unknown-ratio" && i + 1 < argc)
+                settings.unknownRatio = std::stod(argv[++i]);
+            else if (arg == "--message-mix" && i + 1 < argc)
+            {
+                if (!ParseMessageMix(argv[++i], settings.messageMix))
+                {
+                    std::cerr << "Invalid message mix: " << argv[i] << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg == "--seed" && i + 1 < argc)
+                settings.seed = std::stoull(argv[++i]);
+            else if (arg == "--output" && i + 1 < argc)
+                settings.outputFile = argv[++i];
+            else
+            {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid option value" << std::endl;
+        return 1;
+    }
+
+    if (settings.securities == 0 || settings.referenceRatio < 0 || settings.orderRatio < 0 || settings.updateRatio < 0 ||
+        settings.referenceRatio + settings.orderRatio + settings.updateRatio > 1)
+    {
+        std::cerr << "Need at least one Security, and the reference, order & update ratios must add up to no more than 1" << std::endl;
+        return 1;
+    }
+
+    if (!GenerateFeed(settings))
+    {
+        std::cerr << "Unable to write " << settings.outputFile << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,378 @@
+/** @file AsyncInputReader.cpp
+ *  @brief Reads an input file with several large reads kept in flight
+ *
+ *  Reads a file in order, in large blocks, into a small pool of fixed buffers. While the caller
+ *  works on one block, reads for the following blocks are already queued with io_uring, so the
+ *  device is kept busy rather than sitting idle between synchronous reads.
+ *
+ *  io_uring is used through its system calls directly, so no extra library is needed. If the
+ *  kernel doesn't support it, or it isn't allowed (e.g. by a seccomp filter), each block is
+ *  read with pread instead, one at a time.
+ *
+ *  Blocks are handed out whole, so a line may start in one block and end in the next.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include "AsyncInputReader.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ASYNCINPUTREADER_SUPPORTED
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define IO_URING_SUPPORTED
+#endif
+#endif
+
+AsyncInputReader::AsyncInputReader()
+    : fileDescriptor(-1),
+      fileSize(0),
+      nextReadOffset(0),
+      blocksQueued(0),
+      blocksRead(0),
+      holdingBlock(false),
+      ring()
+{
+    ring.ringDescriptor = -1;
+    for (auto& buffer : buffers)
+        buffer.inFlight = false;
+}
+
+AsyncInputReader::~AsyncInputReader()
+{
+    Close();
+}
+
+
+/** @brief Opens a file and queues the first reads
+ *
+ *  @param fileName    - File Name/Path
+ *  @param startOffset - Offset in the file to start reading from
+ *  @return true if the file was opened, false if it isn't a regular file or can't be opened
+ */
+bool AsyncInputReader::Open(const std::string& fileName, const size_t startOffset)
+{
+    Close();
+
+#ifdef ASYNCINPUTREADER_SUPPORTED
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        close(fd);
+        return false;
+    }
+
+    fileDescriptor = fd;
+    fileSize = static_cast<size_t>(fileStat.st_size);
+    nextReadOffset = std::min(startOffset, fileSize);
+    blocksQueued = 0;
+    blocksRead = 0;
+    holdingBlock = false;
+
+    for (auto& buffer : buffers)
+    {
+        if (buffer.data == nullptr)
+            buffer.data.reset(new char[BUFFER_SIZE]);
+        buffer.inFlight = false;
+    }
+
+    SetUpIoUring();
+    while (blocksQueued < NUM_BUFFERS && nextReadOffset < fileSize)
+        QueueRead();
+
+    return true;
+#else
+    (void)fileName;
+    (void)startOffset;
+    return false;
+#endif
+}
+
+
+/** @brief Gets the next block of the file
+ *
+ *  The buffer of the block handed out by the last call is reused for the next read, so
+ *  that block is only valid until the next call.
+ *
+ *  @param block - View of the next block of the file
+ *  @return true if there was another block, false once the end of the file has been reached
+ */
+bool AsyncInputReader::NextBlock(std::string_view& block)
+{
+    if (holdingBlock)
+    {
+        holdingBlock = false;
+        if (nextReadOffset < fileSize)
+            QueueRead();
+    }
+
+    if (blocksRead == blocksQueued)
+        return false;
+
+    Buffer& buffer = buffers[blocksRead % NUM_BUFFERS];
+    WaitForRead(buffer);
+    ++blocksRead;
+    holdingBlock = true;
+
+    block = std::string_view(buffer.data.get(), (buffer.result > 0) ? static_cast<size_t>(buffer.result) : 0);
+    return true;
+}
+
+
+/** @brief Closes the file
+ *
+ *  Waits for any reads still in flight, as they are writing into the buffers.
+ *
+ *  @return void
+ */
+void AsyncInputReader::Close()
+{
+    for (auto& buffer : buffers)
+    {
+        while (buffer.inFlight)
+            ReapCompletion();
+    }
+    TearDownIoUring();
+
+#ifdef ASYNCINPUTREADER_SUPPORTED
+    if (fileDescriptor >= 0)
+        close(fileDescriptor);
+#endif
+    fileDescriptor = -1;
+    fileSize = 0;
+    nextReadOffset = 0;
+    blocksQueued = 0;
+    blocksRead = 0;
+    holdingBlock = false;
+}
+
+
+/** @brief Checks whether reads are being queued with io_uring
+ *
+ *  @return true if io_uring is in use, false if blocks are being read with pread
+ */
+bool AsyncInputReader::UsingIoUring() const
+{
+    return ring.ringDescriptor >= 0;
+}
+
+
+/** @brief Queues the read of the next block of the file
+ *
+ *  The block is read into the buffer after the last one queued. Without io_uring nothing is
+ *  read until the block is waited for.
+ *
+ *  @return void
+ */
+void AsyncInputReader::QueueRead()
+{
+    size_t bufferIndex = blocksQueued % NUM_BUFFERS;
+    Buffer& buffer = buffers[bufferIndex];
+    buffer.offset = nextReadOffset;
+    buffer.length = std::min(BUFFER_SIZE, fileSize - nextReadOffset);
+    buffer.result = 0;
+    buffer.inFlight = false;
+    nextReadOffset += buffer.length;
+    ++blocksQueued;
+
+#ifdef IO_URING_SUPPORTED
+    if (ring.ringDescriptor < 0)
+        return;
+
+    unsigned tail = *ring.sqTail;
+    unsigned index = tail & *ring.sqMask;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(ring.sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fileDescriptor;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer.data.get());
+    sqe->len = static_cast<uint32_t>(buffer.length);
+    sqe->off = buffer.offset;
+    sqe->user_data = bufferIndex;
+    ring.sqArray[index] = index;
+    __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    long submitted;
+    do
+        submitted = syscall(__NR_io_uring_enter, ring.ringDescriptor, 1, 0, 0, nullptr, 0);
+    while (submitted < 0 && (errno == EINTR || errno == EAGAIN));
+
+    // The kernel only looks at the submission queue while we are in io_uring_enter, so the
+    // entry can be taken back and the block left to pread
+    //
+    if (submitted == 1)
+        buffer.inFlight = true;
+    else
+        __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+#endif
+}
+
+
+/** @brief Waits until a buffer holds its whole block
+ *
+ *  Anything a queued read didn't manage to read, including everything if it failed or was
+ *  never queued, is read with pread.
+ *
+ *  @param buffer - Buffer to wait for
+ *  @return void
+ */
+void AsyncInputReader::WaitForRead(Buffer& buffer)
+{
+    while (buffer.inFlight)
+        ReapCompletion();
+
+    if (buffer.result < 0)
+        buffer.result = 0;
+    if (static_cast<size_t>(buffer.result) < buffer.length)
+        ReadRemainder(buffer);
+}
+
+
+/** @brief Takes a completed read off the completion queue
+ *
+ *  Waits for a read to complete if none has yet.
+ *
+ *  @return void
+ */
+void AsyncInputReader::ReapCompletion()
+{
+#ifdef IO_URING_SUPPORTED
+    unsigned head = *ring.cqHead;
+    while (head == __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE))
+    {
+        if (syscall(__NR_io_uring_enter, ring.ringDescriptor, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+        {
+            // Nothing more will complete, so stop waiting and let pread read the blocks instead
+            //
+            for (auto& buffer : buffers)
+                buffer.inFlight = false;
+            return;
+        }
+    }
+
+    const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(ring.cqes) + (head & *ring.cqMask);
+    Buffer& buffer = buffers[cqe->user_data];
+    buffer.result = cqe->res;
+    buffer.inFlight = false;
+    __atomic_store_n(ring.cqHead, head + 1, __ATOMIC_RELEASE);
+#endif
+}
+
+
+/** @brief Reads the rest of a buffer's block with pread
+ *
+ *  Stops early if the file turns out to be shorter than it was when it was opened.
+ *
+ *  @param buffer - Buffer to finish reading
+ *  @return void
+ */
+void AsyncInputReader::ReadRemainder(Buffer& buffer)
+{
+#ifdef ASYNCINPUTREADER_SUPPORTED
+    while (static_cast<size_t>(buffer.result) < buffer.length)
+    {
+        ssize_t bytesRead = pread( fileDescriptor,
+                                   buffer.data.get() + buffer.result,
+                                   buffer.length - buffer.result,
+                                   static_cast<off_t>(buffer.offset + buffer.result) );
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead <= 0)
+            break;
+        buffer.result += bytesRead;
+    }
+#else
+    (void)buffer;
+#endif
+}
+
+
+/** @brief Sets up an io_uring with room for a read into every buffer
+ *
+ *  @return true if io_uring can be used
+ */
+bool AsyncInputReader::SetUpIoUring()
+{
+#ifdef IO_URING_SUPPORTED
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ringDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, NUM_BUFFERS, &params));
+    if (ringDescriptor < 0)
+        return false;
+
+    ring.ringDescriptor = ringDescriptor;
+    ring.sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+    ring.cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+    ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    // Newer kernels map both rings in one go
+    //
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+        ring.sqRingSize = ring.cqRingSize = std::max(ring.sqRingSize, ring.cqRingSize);
+
+    ring.sqRing = mmap(nullptr, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQ_RING);
+    ring.cqRing = singleMap ? ring.sqRing
+                            : mmap(nullptr, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_CQ_RING);
+    ring.sqes = mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES);
+    if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED)
+    {
+        TearDownIoUring();
+        return false;
+    }
+
+    char* sqRing = static_cast<char*>(ring.sqRing);
+    char* cqRing = static_cast<char*>(ring.cqRing);
+    ring.sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+    ring.sqMask = reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+    ring.sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+    ring.cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+    ring.cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+    ring.cqMask = reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+    ring.cqes = cqRing + params.cq_off.cqes;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/** @brief Unmaps the io_uring and closes it
+ *
+ *  Safe to call on a partly set up io_uring.
+ *
+ *  @return void
+ */
+void AsyncInputReader::TearDownIoUring()
+{
+#ifdef IO_URING_SUPPORTED
+    if (ring.ringDescriptor < 0)
+        return;
+
+    if (ring.sqes != nullptr && ring.sqes != MAP_FAILED)
+        munmap(ring.sqes, ring.sqesSize);
+    if (ring.cqRing != nullptr && ring.cqRing != MAP_FAILED && ring.cqRing != ring.sqRing)
+        munmap(ring.cqRing, ring.cqRingSize);
+    if (ring.sqRing != nullptr && ring.sqRing != MAP_FAILED)
+        munmap(ring.sqRing, ring.sqRingSize);
+    close(ring.ringDescriptor);
+#endif
+    ring = IoUring();
+    ring.ringDescriptor = -1;
+}
@@ -0,0 +1,390 @@
+/** @file CompressedInputReader.cpp
+ *  @brief Decompresses a gzip or zstd input file on its own thread
+ *
+ *  Reads a compressed input file and hands the decompressed data out in large blocks. The
+ *  decompression runs on a background thread which fills a small ring of blocks ahead of the
+ *  reader, so decompressing the next block overlaps with processing the current one.
+ *
+ *  The format is detected from the first bytes of the file rather than its name. Support for
+ *  each format is optional, as it needs an extra library to be linked:
+ *    gzip - Build with -DORA_ZLIB and link with -lz
+ *    zstd - Build with -DORA_ZSTD and link with -lzstd
+ *  Concatenated gzip members and zstd frames are read one after another, as gzip -d & zstd -d do.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include "CompressedInputReader.h"
+#include "PipelineStats.h"
+
+#ifdef ORA_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef ORA_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+    constexpr unsigned char GZIP_MAGIC[] = { 0x1F, 0x8B };
+    constexpr unsigned char ZSTD_MAGIC[] = { 0x28, 0xB5, 0x2F, 0xFD };
+}
+
+CompressedInputReader::CompressedInputReader()
+    : file(nullptr),
+      format(CompressionFormat::None),
+      readPos(0),
+      writePos(0),
+      filledBlocks(0),
+      holdingBlock(false),
+      finished(false),
+      failed(false),
+      stopping(false)
+{
+}
+
+CompressedInputReader::~CompressedInputReader()
+{
+    Close();
+}
+
+
+/** @brief Detects whether a file is compressed, and how
+ *
+ *  @param fileName - File Name/Path
+ *  @return Compression format of the file, or None if it isn't compressed or can't be opened
+ */
+CompressionFormat CompressedInputReader::DetectFormat(const std::string& fileName)
+{
+    std::FILE* detectFile = std::fopen(fileName.c_str(), "rb");
+    if (detectFile == nullptr)
+        return CompressionFormat::None;
+
+    unsigned char magic[sizeof(ZSTD_MAGIC)] = {};
+    size_t magicSize = std::fread(magic, 1, sizeof(magic), detectFile);
+    std::fclose(detectFile);
+
+    if (magicSize >= sizeof(GZIP_MAGIC) && magic[0] == GZIP_MAGIC[0] && magic[1] == GZIP_MAGIC[1])
+        return CompressionFormat::Gzip;
+    if (magicSize >= sizeof(ZSTD_MAGIC) && std::equal(std::begin(ZSTD_MAGIC), std::end(ZSTD_MAGIC), magic))
+        return CompressionFormat::Zstd;
+
+    return CompressionFormat::None;
+}
+
+
+/** @brief Checks whether this build can decompress a format
+ *
+ *  @param format_ - Compression format
+ *  @return true if files in the format can be read
+ */
+bool CompressedInputReader::IsSupported(const CompressionFormat format_)
+{
+    switch (format_)
+    {
+#ifdef ORA_ZLIB
+        case CompressionFormat::Gzip:
+            return true;
+#endif
+#ifdef ORA_ZSTD
+        case CompressionFormat::Zstd:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+
+/** @brief Opens a compressed file and starts decompressing it
+ *
+ *  @param fileName - File Name/Path
+ *  @return true if the file was opened, false if it can't be opened or isn't in a supported format
+ */
+bool CompressedInputReader::Open(const std::string& fileName)
+{
+    Close();
+
+    format = DetectFormat(fileName);
+    if (!IsSupported(format))
+        return false;
+
+    file = std::fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    for (auto& block : blocks)
+    {
+        if (block.data == nullptr)
+            block.data.reset(new char[BLOCK_SIZE]);
+        block.size = 0;
+    }
+
+    readPos = 0;
+    writePos = 0;
+    filledBlocks = 0;
+    holdingBlock = false;
+    finished = false;
+    failed = false;
+    stopping = false;
+    decompressor = std::thread(&CompressedInputReader::RunDecompressor, this);
+    return true;
+}
+
+
+/** @brief Gets the next block of decompressed data
+ *
+ *  Waits until the decompressor has filled the next block. The block handed out by the last
+ *  call is released back to the decompressor, so it is only valid until the next call.
+ *
+ *  @param block - View of the next block of decompressed data
+ *  @return true if there was another block, false once every block has been read
+ */
+bool CompressedInputReader::NextBlock(std::string_view& block)
+{
+    std::unique_lock<std::mutex> lock(blocksMutex);
+
+    if (holdingBlock)
+    {
+        readPos = (readPos + 1) % NUM_BLOCKS;
+        --filledBlocks;
+        holdingBlock = false;
+        blockReleased.notify_one();
+    }
+
+    blockFilled.wait(lock, [this] { return filledBlocks > 0 || finished; });
+    if (filledBlocks == 0)
+        return false;
+
+    block = std::string_view(blocks[readPos].data.get(), blocks[readPos].size);
+    holdingBlock = true;
+    return true;
+}
+
+
+/** @brief Stops decompressing and closes the file
+ *
+ *  @return void
+ */
+void CompressedInputReader::Close()
+{
+    if (decompressor.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(blocksMutex);
+            stopping = true;
+        }
+        blockReleased.notify_one();
+        decompressor.join();
+    }
+
+    if (file != nullptr)
+    {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+
+/** @brief Checks whether decompression stopped on an error
+ *
+ *  Only meaningful once NextBlock has returned false. A corrupt or truncated file fails,
+ *  after every block decompressed before the error has been handed out.
+ *
+ *  @return true if the file couldn't be fully decompressed
+ */
+bool CompressedInputReader::Failed()
+{
+    std::lock_guard<std::mutex> lock(blocksMutex);
+    return failed;
+}
+
+
+/** @brief Decompresses the file on the decompressor thread
+ *
+ *  @return void
+ */
+void CompressedInputReader::RunDecompressor()
+{
+    bool decompressed = false;
+    {
+        ScopedStatTimer decompressTimer(StatTimer::Decompress);
+        decompressed = (format == CompressionFormat::Gzip) ? DecompressGzip() : DecompressZstd();
+    }
+
+    std::lock_guard<std::mutex> lock(blocksMutex);
+    finished = true;
+    failed = !decompressed && !stopping;
+    blockFilled.notify_one();
+}
+
+
+/** @brief Waits until the decompressor has a free block to fill
+ *
+ *  @return The block to fill, or nullptr if the reader is being closed
+ */
+char* CompressedInputReader::WaitForFreeBlock()
+{
+    std::unique_lock<std::mutex> lock(blocksMutex);
+    blockReleased.wait(lock, [this] { return filledBlocks < NUM_BLOCKS || stopping; });
+    return stopping ? nullptr : blocks[writePos].data.get();
+}
+
+
+/** @brief Hands the block just filled to the reader
+ *
+ *  @param size - Bytes of decompressed data in the block
+ *  @return void
+ */
+void CompressedInputReader::PublishBlock(const size_t size)
+{
+    std::lock_guard<std::mutex> lock(blocksMutex);
+    blocks[writePos].size = size;
+    writePos = (writePos + 1) % NUM_BLOCKS;
+    ++filledBlocks;
+    blockFilled.notify_one();
+}
+
+
+/** @brief Decompresses a gzip file into the blocks
+ *
+ *  @return true if every gzip member was decompressed to its end
+ */
+bool CompressedInputReader::DecompressGzip()
+{
+#ifdef ORA_ZLIB
+    z_stream stream = {};
+    if (inflateInit2(&stream, 15 + 16) != Z_OK)  // Max window size, expecting a gzip header
+        return false;
+
+    std::unique_ptr<unsigned char[]> input(new unsigned char[BLOCK_SIZE]);
+    char* output = nullptr;
+    size_t outputUsed = 0;
+    bool endOfFile = false;
+    int result = Z_OK;
+
+    while (true)
+    {
+        if (stream.avail_in == 0 && !endOfFile)
+        {
+            stream.next_in = input.get();
+            stream.avail_in = static_cast<uInt>(std::fread(input.get(), 1, BLOCK_SIZE, file));
+            endOfFile = (stream.avail_in == 0);
+        }
+
+        // Another gzip member may follow the end of the last one
+        //
+        if (result == Z_STREAM_END)
+        {
+            if (stream.avail_in == 0)
+                break;
+            inflateReset(&stream);
+        }
+
+        if (output == nullptr)
+        {
+            output = WaitForFreeBlock();
+            outputUsed = 0;
+            if (output == nullptr)
+                break;
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*>(output + outputUsed);
+        stream.avail_out = static_cast<uInt>(BLOCK_SIZE - outputUsed);
+        result = inflate(&stream, Z_NO_FLUSH);
+        outputUsed = BLOCK_SIZE - stream.avail_out;
+
+        if (result != Z_OK && result != Z_STREAM_END)
+            break;
+
+        if (outputUsed == BLOCK_SIZE)
+        {
+            PublishBlock(outputUsed);
+            output = nullptr;
+        }
+    }
+
+    if (output != nullptr && outputUsed > 0)
+        PublishBlock(outputUsed);
+
+    inflateEnd(&stream);
+    return result == Z_STREAM_END;
+#else
+    return false;
+#endif
+}
+
+
+/** @brief Decompresses a zstd file into the blocks
+ *
+ *  @return true if every zstd frame was decompressed to its end
+ */
+bool CompressedInputReader::DecompressZstd()
+{
+#ifdef ORA_ZSTD
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (context == nullptr)
+        return false;
+
+    size_t inputCapacity = ZSTD_DStreamInSize();
+    std::unique_ptr<char[]> input(new char[inputCapacity]);
+    ZSTD_inBuffer inBuffer = { input.get(), 0, 0 };
+    char* output = nullptr;
+    size_t outputUsed = 0;
+    bool endOfFile = false;
+    size_t result = 0;
+
+    while (true)
+    {
+        if (inBuffer.pos == inBuffer.size && !endOfFile)
+        {
+            inBuffer.size = std::fread(input.get(), 1, inputCapacity, file);
+            inBuffer.pos = 0;
+            endOfFile = (inBuffer.size == 0);
+        }
+
+        // A result of 0 means the last frame has been fully decoded & output
+        //
+        if (endOfFile && result == 0)
+            break;
+
+        if (output == nullptr)
+        {
+            output = WaitForFreeBlock();
+            outputUsed = 0;
+            if (output == nullptr)
+                break;
+        }
+
+        // Once the whole file has been read, carry on until the last of the data held by zstd has been output
+        //
+        ZSTD_outBuffer outBuffer = { output, BLOCK_SIZE, outputUsed };
+        result = ZSTD_decompressStream(context, &outBuffer, &inBuffer);
+        if (ZSTD_isError(result))
+            break;
+
+        bool madeProgress = (outBuffer.pos > outputUsed);
+        outputUsed = outBuffer.pos;
+        if (outputUsed == BLOCK_SIZE)
+        {
+            PublishBlock(outputUsed);
+            output = nullptr;
+        }
+
+        if (endOfFile && !madeProgress)
+            break;
+    }
+
+    if (output != nullptr && outputUsed > 0)
+        PublishBlock(outputUsed);
+
+    ZSTD_freeDCtx(context);
+    return result == 0;
+#else
+    return false;
+#endif
+}
@@ -4,21 +4,92 @@
  *  Base class for reading in an input file. Will read in the input file line by line,
  *  sending sending each line to the ReadInputData virtual function. This function
  *  should be overridden in the derived class so that each line can be processed.
+ *
+ *  Regular files are memory mapped and each line is passed as a view straight out of the
+ *  mapped region. Anything that can't be mapped (pipes, devices etc.) falls back to
+ *  reading the file through a stream with std::getline.
+ *
+ *  Regular files can also be read into a pool of large buffers with io_uring, keeping several
+ *  reads in flight while the lines already read are processed (or with pread, where io_uring
+ *  isn't available).
+ *
+ *  gzip & zstd compressed files are detected from their first bytes and decompressed on a
+ *  separate thread while the lines already decompressed are being read. Offsets in a
+ *  compressed file are offsets into its decompressed data.
+ *
+ *  The input file can also be followed as it grows, like tail -f. New lines are read as
+ *  they are appended, and the OnInputSnapshot virtual function is called every so often
+ *  so the derived class can output what it has read so far.
+ *
+ *  Reading can start part way through the input file, e.g. to carry on from where a previous
+ *  run got to. The offset just past the last line read is tracked so it can be recorded. When
+ *  only complete lines are read, a final line without a newline is left unread, as it may still
+ *  be being written, so the offset recorded is never part way through a line. The part of the input
+ *  file up to an offset can be fingerprinted, so a later run can tell whether it is still the same file.
+ *  
+ *  Each line read is counted in the Pipeline Stats, and timed when latency histograms are enabled.
  *  
- *  Also contains helper function(s) that may be useful when manipulating the input data.
+ *  Also contains helpers for splitting the input data into lines, and into chunks at line
+ *  boundaries so they can be read in parallel.
  *
  *  @author Sean Griffin
  *  @bug No known bugs.
  */
 
+#include <algorithm>
+#include <filesystem>
+#include <thread>
 #include "InputFileHandler.h"
+#include "AsyncInputReader.h"
+#include "CompressedInputReader.h"
+#include "MappedFile.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr size_t FINGERPRINT_BLOCK_SIZE = 4096;
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ULL;
+    constexpr uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+    /** @brief Adds a block of a file to an FNV-1a hash
+     *
+     *  @param inFile - File to read the block from
+     *  @param start  - Offset of the block
+     *  @param size   - Size of the block, up to FINGERPRINT_BLOCK_SIZE
+     *  @param hash   - Hash to add the block to
+     *  @return Bytes hashed, which is less than size if the file ends first
+     */
+    size_t HashFileBlock(std::ifstream& inFile, const size_t start, const size_t size, uint64_t& hash)
+    {
+        if (size == 0)
+            return 0;
+
+        char block[FINGERPRINT_BLOCK_SIZE];
+        inFile.clear();
+        inFile.seekg(start);
+        inFile.read(block, size);
+        size_t bytesRead = static_cast<size_t>(inFile.gcount());
+        for (size_t i = 0; i < bytesRead; ++i)
+            hash = (hash ^ static_cast<unsigned char>(block[i])) * FNV_PRIME;
+        return bytesRead;
+    }
+}
 
 /** @brief Input File Handler Constructor
  *
  *  @param inputFile_ - Input File Name/Path
  */
 InputFileHandler::InputFileHandler(const std::string& inputFile_)
-    : inputFile(inputFile_)
+    : inputFile(inputFile_),
+      inputReadMethod(InputReadMethod::Auto),
+      inputStartOffset(0),
+      inputOffset(0),
+      completeLinesOnly(false)
 {
 }
 
@@ -38,51 +109,517 @@ void InputFileHandler::SetInputFile(const std::string& inputFile_)
 }
 
 
+/** @brief Sets the method used to read the Input File
+ * 
+ *  Auto will memory map the Input File if it is a regular file, and fall back to
+ *  streaming it otherwise. Stream will always read the Input File with std::getline.
+ *  AsyncRead will read a regular file in large blocks with several reads in flight, through
+ *  io_uring where the kernel allows it, and fall back to streaming it otherwise.
+ * 
+ *  @param readMethod - Input Read Method
+ *  @return void
+ */
+void InputFileHandler::SetInputReadMethod(const InputReadMethod readMethod)
+{
+    inputReadMethod = readMethod;
+}
+
+
+/** @brief Sets the offset in the Input File to start reading from
+ * 
+ *  Must be the start of a line, such as an offset previously returned by GetInputOffset.
+ * 
+ *  @param startOffset - Offset in bytes from the start of the Input File
+ *  @return void
+ */
+void InputFileHandler::SetInputStartOffset(const size_t startOffset)
+{
+    inputStartOffset = startOffset;
+}
+
+
+/** @brief Sets whether only lines ending in a newline are read
+ * 
+ *  Like std::getline, a final line without a newline is normally still read. When the offset
+ *  reached is recorded, e.g. in a checkpoint, that line may be one still being written, so it can
+ *  be left unread instead, to be read once its newline has been written.
+ * 
+ *  @param enable - Whether to leave a final line without a newline unread
+ *  @return void
+ */
+void InputFileHandler::SetCompleteLinesOnly(const bool enable)
+{
+    completeLinesOnly = enable;
+}
+
+
+/** @brief Gets the offset in the Input File just past the last line read
+ * 
+ *  While a line is being passed to ReadInputData this is the offset just past that line.
+ * 
+ *  @return Offset in bytes from the start of the Input File
+ */
+size_t InputFileHandler::GetInputOffset() const
+{
+    return inputOffset;
+}
+
+
+/** @brief Fingerprints the part of the Input File up to an offset
+ * 
+ *  Hashes the first block of the Input File and the block just before the offset, so a file that has
+ *  been replaced or rewritten can be told apart from one that has only been appended to. Offsets in a
+ *  compressed file are offsets into its decompressed data, so only its first block, which holds its
+ *  headers, is hashed and its length isn't checked. Anything other than a regular file, e.g. a pipe,
+ *  can't be read twice, so it isn't read and every one has the same fingerprint.
+ * 
+ *  @param endOffset   - Offset in bytes from the start of the Input File that the fingerprint covers up to
+ *  @param fingerprint - Set to the fingerprint
+ *  @return false if the Input File can't be read or is shorter than endOffset
+ */
+bool InputFileHandler::FingerprintInput(const size_t endOffset, uint64_t& fingerprint) const
+{
+    fingerprint = FNV_OFFSET_BASIS;
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(inputFile, error))
+        return std::filesystem::exists(inputFile, error);
+
+    std::ifstream inFile(inputFile, std::ios::binary);
+    if (!inFile.is_open())
+        return false;
+
+    if (CompressedInputReader::DetectFormat(inputFile) != CompressionFormat::None)
+    {
+        HashFileBlock(inFile, 0, FINGERPRINT_BLOCK_SIZE, fingerprint);
+        return true;
+    }
+
+    // The blocks never overlap, so the bytes of a short file are only hashed once
+    //
+    size_t tailStart = std::max(endOffset, 2 * FINGERPRINT_BLOCK_SIZE) - FINGERPRINT_BLOCK_SIZE;
+    size_t headSize = std::min(endOffset, FINGERPRINT_BLOCK_SIZE);
+    size_t tailSize = (endOffset > tailStart) ? endOffset - tailStart : 0;
+    return HashFileBlock(inFile, 0, headSize, fingerprint) == headSize &&
+           HashFileBlock(inFile, tailStart, tailSize, fingerprint) == tailSize;
+}
+
+
 /** @brief Reads in the Input File
  * 
- *  Will read in the Input File line by line, sending each line to the
- *  ReadInputData virtual function.
+ *  Will read in the Input File line by line, starting from the Input Start Offset,
+ *  sending each line to the ReadInputData virtual function. A compressed Input File
+ *  is only read if this build supports its format.
  * 
  *  @return void
  */
 void InputFileHandler::ReadInputFile()
+{
+    ScopedStatTimer readTimer(StatTimer::ReadInput);
+
+    if (inputReadMethod == InputReadMethod::Auto)
+    {
+        if (CompressedInputReader::DetectFormat(inputFile) != CompressionFormat::None)
+        {
+            ReadCompressedInputFile();
+            return;
+        }
+
+        if (ReadMappedInputFile())
+            return;
+    }
+    else if (inputReadMethod == InputReadMethod::AsyncRead && ReadAsyncInputFile())
+        return;
+
+    ReadStreamedInputFile();
+}
+
+
+/** @brief Reads in the Input File through a memory mapping
+ * 
+ *  Each line is passed to ReadInputData as a view into the mapped file, so no line
+ *  is ever copied.
+ * 
+ *  @return true if the Input File was mapped and read, false if it couldn't be mapped
+ */
+bool InputFileHandler::ReadMappedInputFile()
+{
+    MappedFile mappedFile;
+    if (!mappedFile.Open(inputFile))
+        return false;
+
+    std::string_view fileData = CompleteLines(mappedFile.GetData());
+    const char* fileStart = fileData.data();
+    size_t fileSize = fileData.size();
+
+    inputOffset = std::min(inputStartOffset, fileSize);
+    ForEachInputLine(fileData.substr(inputOffset), [this, fileStart, fileSize](std::string_view line)
+    {
+        inputOffset = std::min(static_cast<size_t>(line.data() - fileStart) + line.size() + 1, fileSize);
+        ReadInputLine(line);
+    });
+
+    return true;
+}
+
+
+/** @brief Reads in the Input File with several reads in flight
+ * 
+ *  The Input File is read in large blocks into a pool of buffers. While the lines of one block
+ *  are being read, the reads of the next blocks are already queued. Lines that run from one
+ *  block into the next are joined before being passed to ReadInputData.
+ * 
+ *  @return true if the Input File was read, false if it isn't a regular file
+ */
+bool InputFileHandler::ReadAsyncInputFile()
+{
+    AsyncInputReader reader;
+    if (!reader.Open(inputFile, inputStartOffset))
+        return false;
+
+    std::string partialLine;
+    std::string_view block;
+    size_t blockOffset = inputStartOffset;
+
+    inputOffset = inputStartOffset;
+    while (reader.NextBlock(block))
+    {
+        ReadInputBlock(block, blockOffset, partialLine);
+        blockOffset += block.size();
+    }
+
+    // Like std::getline, a final line without a newline is still read, unless only complete lines are
+    //
+    if (!partialLine.empty() && !completeLinesOnly)
+    {
+        inputOffset = blockOffset;
+        ReadInputLine(partialLine);
+    }
+
+    return true;
+}
+
+
+/** @brief Reads in a compressed Input File
+ * 
+ *  The Input File is decompressed into blocks on a separate thread. Each block is split into
+ *  lines here as soon as it is ready, while the decompressor carries on with the next blocks.
+ *  Decompressed data before the Input Start Offset is skipped. If the Input File is corrupt or
+ *  truncated, every line before the fault is still read and the fault is reported on stderr, as is
+ *  an Input File that ends before the Input Start Offset.
+ * 
+ *  @return void
+ */
+void InputFileHandler::ReadCompressedInputFile()
+{
+    CompressedInputReader reader;
+    if (!reader.Open(inputFile))
+        return;
+
+    std::string partialLine;
+    std::string_view block;
+    size_t streamOffset = 0;
+
+    inputOffset = inputStartOffset;
+    while (reader.NextBlock(block))
+    {
+        size_t blockOffset = streamOffset;
+        streamOffset += block.size();
+        if (streamOffset <= inputStartOffset)
+            continue;
+
+        if (blockOffset < inputStartOffset)
+        {
+            block.remove_prefix(inputStartOffset - blockOffset);
+            blockOffset = inputStartOffset;
+        }
+        ReadInputBlock(block, blockOffset, partialLine);
+    }
+
+    // Like std::getline, a final line without a newline is still read, unless only complete lines are
+    //
+    if (!partialLine.empty() && !completeLinesOnly)
+    {
+        inputOffset = streamOffset;
+        ReadInputLine(partialLine);
+    }
+
+    if (reader.Failed())
+        std::cerr << "Unable to decompress all of " << inputFile << ", it may be corrupt or truncated" << std::endl;
+    else if (streamOffset < inputStartOffset)
+        std::cerr << inputFile << " ends before the offset it was to be read from, so none of it was read" << std::endl;
+}
+
+
+/** @brief Reads in the Input File through a stream
+ * 
+ *  Fallback for Input Files that can't be memory mapped, such as pipes.
+ * 
+ *  @return void
+ */
+void InputFileHandler::ReadStreamedInputFile()
 {
     std::ifstream stream(inputFile);
     std::string line;
 
+    inputOffset = inputStartOffset;
+    if (inputStartOffset > 0)
+        stream.seekg(inputStartOffset);
+
+    // std::getline only reaches the end of the stream on a final line without a newline
+    //
     while(std::getline(stream, line))
-        ReadInputData(line);
+    {
+        if (stream.eof() && completeLinesOnly)
+            break;
+        inputOffset += line.size() + (stream.eof() ? 0 : 1);
+        ReadInputLine(line);
+    }
 
     stream.close();
 }
 
 
-/** @brief Calculate the position of a string value, associated with a heading, from an input string
+/** @brief Follows the Input File as it grows
  * 
- *  @param searchStr - String containing the value that needs to be extracted
- *  @param heading   - Heading in the searchStr for the value that needs to be extracted
- *  @param valPos    - Position of the string value that needs to be extracted
- *  @param valLength - Length of the string value that needs to be extracted
- *  @param searchPos - Position to start searching the searchStr from. 0 by default.
+ *  Reads the Input File from the Input Start Offset, then keeps reading any new data appended to it until
+ *  settings.stopFollowing is set. Only complete lines are passed to ReadInputData; a line that
+ *  is still being written is held back until its newline arrives. If the Input File shrinks it
+ *  is assumed to have been truncated and is read again from the start.
+ * 
+ *  OnInputSnapshot is called whenever settings.snapshotInterval has passed or settings.snapshotLines
+ *  lines have been read since the last snapshot, and once more when following stops.
+ * 
+ *  New data is waited for with inotify where it is available, otherwise the Input File is polled
+ *  every settings.pollInterval.
+ * 
+ *  @param settings - How often to take snapshots & when to stop following
  *  @return void
  */
-void InputFileHandler::CalcStrValPosFromStr( const std::string& searchStr,
-                                             const std::string& heading,
-                                             size_t&            valPos,
-                                             size_t&            valLength,
-                                             const size_t       searchPos ) const
+void InputFileHandler::FollowInputFile(const FollowSettings& settings)
 {
-    size_t headingStartPos = 0;
-    size_t valEndPos = 0;
-    valPos = 0;
-    valLength = 0;
+    constexpr size_t BLOCK_SIZE = 1 << 20;
+    std::vector<char> block(BLOCK_SIZE);
+    std::string partialLine;
+    std::ifstream stream(inputFile, std::ios::binary);
+    size_t fileOffset = inputStartOffset;
+    size_t linesSinceSnapshot = 0;
+    auto lastSnapshot = std::chrono::steady_clock::now();
+
+    int watchDescriptor = -1;
+#ifdef __linux__
+    watchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchDescriptor >= 0 && inotify_add_watch(watchDescriptor, inputFile.c_str(), IN_MODIFY | IN_ATTRIB) < 0)
+    {
+        close(watchDescriptor);
+        watchDescriptor = -1;
+    }
+#endif
 
-    headingStartPos = searchStr.find(heading, searchPos);
-    if (headingStartPos != std::string::npos)
+    if (fileOffset > 0)
+        stream.seekg(fileOffset);
+
+    while (settings.stopFollowing == nullptr || !settings.stopFollowing->load(std::memory_order_relaxed))
     {
-        valEndPos = searchStr.find(',', headingStartPos);
-        int headingLen = heading.size();
-        valPos = headingStartPos + headingLen;
-        valLength = valEndPos - valPos;
+        stream.read(block.data(), block.size());
+        size_t bytesRead = static_cast<size_t>(stream.gcount());
+        if (bytesRead > 0)
+        {
+            ScopedStatTimer readTimer(StatTimer::ReadInput);
+            linesSinceSnapshot += ReadInputBlock(std::string_view(block.data(), bytesRead), fileOffset, partialLine);
+            fileOffset += bytesRead;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        bool snapshotDue = (settings.snapshotLines > 0 && linesSinceSnapshot >= settings.snapshotLines) ||
+                           (settings.snapshotInterval.count() > 0 && now - lastSnapshot >= settings.snapshotInterval);
+        if (snapshotDue)
+        {
+            inputOffset = fileOffset - partialLine.size();
+            OnInputSnapshot();
+            linesSinceSnapshot = 0;
+            lastSnapshot = now;
+        }
+
+        if (bytesRead == block.size())
+            continue;
+
+        // Reached the end of the Input File, so wait for more to be written to it
+        //
+        stream.clear();
+        if (!stream.is_open())
+            stream.open(inputFile, std::ios::binary);
+
+        std::error_code errorCode;
+        size_t fileSize = static_cast<size_t>(std::filesystem::file_size(inputFile, errorCode));
+        if (!errorCode && fileSize < fileOffset)
+        {
+            stream.close();
+            stream.open(inputFile, std::ios::binary);
+            fileOffset = 0;
+            partialLine.clear();
+            continue;
+        }
+
+        std::chrono::milliseconds timeout = settings.pollInterval;
+        if (settings.snapshotInterval.count() > 0)
+        {
+            auto untilSnapshot = std::chrono::duration_cast<std::chrono::milliseconds>(lastSnapshot + settings.snapshotInterval - now);
+            if (untilSnapshot < timeout)
+                timeout = (untilSnapshot.count() > 0) ? untilSnapshot : std::chrono::milliseconds(0);
+        }
+        WaitForInput(watchDescriptor, timeout);
     }
+
+#ifdef __linux__
+    if (watchDescriptor >= 0)
+        close(watchDescriptor);
+#endif
+
+    inputOffset = fileOffset - partialLine.size();
+    OnInputSnapshot();
+}
+
+
+/** @brief Waits for more data to be written to the Input File
+ * 
+ *  Returns as soon as inotify reports the Input File has changed, or once the timeout
+ *  has passed. Without an inotify watch it just sleeps for the timeout.
+ * 
+ *  @param watchDescriptor - inotify descriptor watching the Input File, or -1 if there isn't one
+ *  @param timeout         - Longest time to wait
+ *  @return void
+ */
+void InputFileHandler::WaitForInput(const int watchDescriptor, const std::chrono::milliseconds timeout) const
+{
+#ifdef __linux__
+    if (watchDescriptor >= 0)
+    {
+        pollfd pollDescriptor = { watchDescriptor, POLLIN, 0 };
+        if (poll(&pollDescriptor, 1, static_cast<int>(timeout.count())) > 0)
+        {
+            char events[4096];
+            while (read(watchDescriptor, events, sizeof(events)) > 0)
+                ;
+        }
+        return;
+    }
+#else
+    (void)watchDescriptor;
+#endif
+
+    std::this_thread::sleep_for(timeout);
+}
+
+
+/** @brief Called when a snapshot is due while following the Input File
+ * 
+ *  Does nothing by default. Override it to output what has been read so far.
+ * 
+ *  @return void
+ */
+void InputFileHandler::OnInputSnapshot()
+{
+}
+
+
+/** @brief Reads a block of input data that may start or end part way through a line
+ * 
+ *  Every complete line in the block is passed to ReadInputData. A line that runs off the end
+ *  of the block is kept in partialLine, and completed by the start of the next block.
+ * 
+ *  @param inputBlock  - Block of input data
+ *  @param blockOffset - Offset in the Input File of the start of the block
+ *  @param partialLine - Incomplete line carried over between blocks
+ *  @return Number of lines passed to ReadInputData
+ */
+size_t InputFileHandler::ReadInputBlock(std::string_view inputBlock, size_t blockOffset, std::string& partialLine)
+{
+    size_t linesRead = 0;
+
+    if (!partialLine.empty())
+    {
+        size_t newLinePos = inputBlock.find('\n');
+        if (newLinePos == std::string_view::npos)
+        {
+            partialLine.append(inputBlock);
+            return 0;
+        }
+
+        partialLine.append(inputBlock.substr(0, newLinePos));
+        inputOffset = blockOffset + newLinePos + 1;
+        ReadInputLine(partialLine);
+        partialLine.clear();
+        inputBlock.remove_prefix(newLinePos + 1);
+        blockOffset += newLinePos + 1;
+        ++linesRead;
+    }
+
+    size_t lastNewLinePos = inputBlock.rfind('\n');
+    if (lastNewLinePos == std::string_view::npos)
+    {
+        partialLine.assign(inputBlock);
+        return linesRead;
+    }
+
+    const char* blockStart = inputBlock.data();
+    ForEachInputLine(inputBlock.substr(0, lastNewLinePos + 1), [this, &linesRead, blockStart, blockOffset](std::string_view line)
+    {
+        inputOffset = blockOffset + static_cast<size_t>(line.data() - blockStart) + line.size() + 1;
+        ReadInputLine(line);
+        ++linesRead;
+    });
+    partialLine.assign(inputBlock.substr(lastNewLinePos + 1));
+
+    return linesRead;
+}
+
+
+/** @brief Gets the part of the input data that will be read
+ * 
+ *  @param inputData - Input data
+ *  @return The whole input data, or only up to its last newline if only complete lines are read
+ */
+std::string_view InputFileHandler::CompleteLines(std::string_view inputData) const
+{
+    if (!completeLinesOnly)
+        return inputData;
+
+    size_t lastNewLinePos = inputData.rfind('\n');
+    return inputData.substr(0, (lastNewLinePos != std::string_view::npos) ? lastNewLinePos + 1 : 0);
+}
+
+
+/** @brief Splits the input data into chunks at line boundaries
+ * 
+ *  Each chunk is roughly the same size, and ends just after a '\n' (apart from the last
+ *  chunk, which ends with the input data). No line is ever split across two chunks, so
+ *  each chunk can be read independently. Fewer chunks than requested are returned if the
+ *  input data doesn't have enough lines.
+ * 
+ *  @param inputData - Input data to split
+ *  @param numChunks - Number of chunks to split the input data into
+ *  @return Views of each chunk, in the same order as the input data
+ */
+std::vector<std::string_view> InputFileHandler::SplitInputData(std::string_view inputData, const size_t numChunks)
+{
+    std::vector<std::string_view> chunks;
+    size_t chunkSize = inputData.size() / ((numChunks > 0) ? numChunks : 1);
+    size_t chunkStart = 0;
+
+    while (chunkStart < inputData.size())
+    {
+        size_t chunkEnd = inputData.size();
+        if (chunks.size() + 1 < numChunks && chunkStart + chunkSize < inputData.size())
+        {
+            size_t newLinePos = inputData.find('\n', chunkStart + chunkSize);
+            if (newLinePos != std::string_view::npos)
+                chunkEnd = newLinePos + 1;
+        }
+
+        chunks.push_back(inputData.substr(chunkStart, chunkEnd - chunkStart));
+        chunkStart = chunkEnd;
+    }
+
+    return chunks;
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+/** @file MappedFile.cpp
+ *  @brief Read-only memory mapping of an input file
+ *
+ *  Maps a regular file into memory so that its contents can be read in place,
+ *  without copying each line into a std::string first. Only regular files can be
+ *  mapped; pipes, character devices etc. will fail to open and the caller should
+ *  fall back to reading the file through a stream.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_SUPPORTED
+#endif
+
+MappedFile::MappedFile()
+    : fileDescriptor(-1),
+      data(nullptr),
+      size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+
+/** @brief Maps a file into memory
+ *
+ *  The mapping is advised as sequential, so the kernel can read ahead aggressively
+ *  and drop pages behind us. An empty regular file opens successfully with no data.
+ *
+ *  @param fileName - File Name/Path
+ *  @return true if the file was mapped, false if it is not a regular file or could not be mapped
+ */
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+#ifdef MAPPEDFILE_SUPPORTED
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    if (fileSize > 0)
+    {
+        void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        madvise(mapped, fileSize, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+
+    fileDescriptor = fd;
+    size = fileSize;
+    return true;
+#else
+    (void)fileName;
+    return false;
+#endif
+}
+
+
+/** @brief Unmaps the file, if one is mapped
+ *
+ *  @return void
+ */
+void MappedFile::Close()
+{
+#ifdef MAPPEDFILE_SUPPORTED
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), size);
+    if (fileDescriptor >= 0)
+        close(fileDescriptor);
+#endif
+    fileDescriptor = -1;
+    data = nullptr;
+    size = 0;
+}
+
+
+/** @brief Checks whether a file is currently mapped
+ *
+ *  @return true if a file is mapped
+ */
+bool MappedFile::IsOpen() const
+{
+    return fileDescriptor >= 0;
+}
+
+
+/** @brief Gets the mapped contents of the file
+ *
+ *  @return View over the whole file. Only valid while the file remains mapped.
+ */
+std::string_view MappedFile::GetData() const
+{
+    return std::string_view(data, size);
+}
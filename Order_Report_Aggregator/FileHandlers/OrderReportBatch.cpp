@@ -0,0 +1,307 @@
+/** @file OrderReportBatch.cpp
+ *  @brief Produces Order Reports for a batch of input files
+ *
+ *  Reads every input file in a directory, or matching a glob pattern, on a shared work-stealing
+ *  thread pool. Each input file gets its own OrderReportFileHandler and Order Report collection, so
+ *  an Order Add is only counted if its Security is referenced in the same file.
+ *
+ *  Input files are submitted largest first. A large input file is split into chunks of about
+ *  CHUNK_SIZE bytes which are read as separate tasks, so one huge file is spread across every
+ *  thread instead of leaving the others idle once the smaller files are done.
+ *
+ *  The reports can either be written for each input file as soon as it has been read, or the
+ *  Order Report collections of every input file merged into one consolidated report.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include "OrderReportBatch.h"
+#include "PipelineStats.h"
+#include "ThreadPool.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <glob.h>
+#define GLOB_SUPPORTED
+#endif
+
+/** @brief Order Report Batch Constructor
+ *
+ *  @param inputFiles - Input File Names/Paths, in the order the Order Reports are merged
+ */
+OrderReportBatch::OrderReportBatch(const std::vector<std::string>& inputFiles)
+    : inputReadMethod(InputReadMethod::Auto),
+      pendingOrderLimit(0),
+      reportFormat(&OrderReportSchema::FORMAT),
+      quantileSketches(false),
+      trackOrders(false)
+{
+    batchFiles.resize(inputFiles.size());
+    for (size_t i = 0; i < inputFiles.size(); ++i)
+    {
+        std::error_code error;
+        uintmax_t fileSize = std::filesystem::file_size(inputFiles[i], error);
+
+        batchFiles[i].inputFile = inputFiles[i];
+        batchFiles[i].fileSize = error ? 0 : static_cast<size_t>(fileSize);
+    }
+}
+
+OrderReportBatch::~OrderReportBatch()
+{
+}
+
+
+/** @brief Finds the input files of a batch
+ * 
+ *  If inputPath is a directory then every regular file in it is found, other than hidden files.
+ *  Otherwise inputPath is taken as a glob pattern, e.g. "feeds/pretrade_*.txt.zst", and every
+ *  regular file matching it is found.
+ *
+ *  @param inputPath - Directory or glob pattern
+ *  @return Input File Names/Paths, sorted by name
+ */
+std::vector<std::string> OrderReportBatch::FindInputFiles(const std::string& inputPath)
+{
+    std::vector<std::string> inputFiles;
+    std::error_code error;
+
+    if (std::filesystem::is_directory(inputPath, error))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(inputPath, error))
+        {
+            if (entry.is_regular_file(error) && entry.path().filename().string()[0] != '.')
+                inputFiles.push_back(entry.path().string());
+        }
+    }
+    else
+    {
+#ifdef GLOB_SUPPORTED
+        glob_t matches = {};
+        if (glob(inputPath.c_str(), 0, nullptr, &matches) == 0)
+        {
+            for (size_t i = 0; i < matches.gl_pathc; ++i)
+            {
+                if (std::filesystem::is_regular_file(matches.gl_pathv[i], error))
+                    inputFiles.push_back(matches.gl_pathv[i]);
+            }
+        }
+        globfree(&matches);
+#else
+        if (std::filesystem::is_regular_file(inputPath, error))
+            inputFiles.push_back(inputPath);
+#endif
+    }
+
+    std::sort(inputFiles.begin(), inputFiles.end());
+    return inputFiles;
+}
+
+
+/** @brief Gets the name to give the reports on an input file
+ * 
+ *  The file name of the input file without its directory or extension, along with any
+ *  compression extension, e.g. "feeds/venue1_20240105.txt.zst" gives "venue1_20240105".
+ *
+ *  @param inputFile - Input File Name/Path
+ *  @return Report name
+ */
+std::string OrderReportBatch::GetReportName(const std::string& inputFile)
+{
+    std::filesystem::path reportName = std::filesystem::path(inputFile).filename();
+    if (reportName.extension() == ".gz" || reportName.extension() == ".zst")
+        reportName = reportName.stem();
+
+    return reportName.stem().string();
+}
+
+
+/** @brief Sets how the input files are read
+ * 
+ *  @param method - Input Read Method
+ *  @return void
+ */
+void OrderReportBatch::SetInputReadMethod(const InputReadMethod method)
+{
+    inputReadMethod = method;
+}
+
+
+/** @brief Sets the memory limit of the Pending Order Buffer of each input file
+ * 
+ *  @param memoryLimit - Most memory, in bytes, that pending orders may use per input file
+ *  @return void
+ */
+void OrderReportBatch::SetPendingOrderLimit(const size_t memoryLimit)
+{
+    pendingOrderLimit = memoryLimit;
+}
+
+
+/** @brief Sets the columns of the reports written on each input file
+ * 
+ *  @param format - Report Format of the Report Schema to write
+ *  @return void
+ */
+void OrderReportBatch::SetReportFormat(const ReportFormat* format)
+{
+    reportFormat = format;
+}
+
+
+/** @brief Sets whether the Order Report collection of each input file keeps sketches of its Orders
+ * 
+ *  Needed to report quantiles, and carried over when the collections are merged.
+ *
+ *  @param enable - Whether to keep sketches
+ *  @return void
+ */
+void OrderReportBatch::SetQuantileSketches(const bool enable)
+{
+    quantileSketches = enable;
+}
+
+
+/** @brief Sets whether the live Orders of each input file are tracked
+ * 
+ *  Needed to report resting & executed quantities. Each input file is then read by a single task.
+ *
+ *  @param enable - Whether to track live Orders
+ *  @return void
+ */
+void OrderReportBatch::SetOrderTracking(const bool enable)
+{
+    trackOrders = enable;
+}
+
+
+/** @brief Sets the rollups written on each input file
+ * 
+ *  @param dimensions - What each rollup groups the Securities by
+ *  @return void
+ */
+void OrderReportBatch::SetRollups(const std::vector<RollupDimension>& dimensions)
+{
+    rollupDimensions = dimensions;
+}
+
+
+/** @brief Gets the number of input files in the batch
+ * 
+ *  @return Number of input files
+ */
+size_t OrderReportBatch::GetNumFiles() const
+{
+    return batchFiles.size();
+}
+
+
+/** @brief Reads every input file in the batch
+ * 
+ *  Submits every input file to a pool of numThreads threads, largest first, and waits for them
+ *  all to be read. If outputDirectory is set, the reports on each input file are written to it
+ *  as soon as the file has been read, by the thread that finished reading it:
+ *    <Report Name>_order_report.txt                          - Securities that have Orders
+ *    <Report Name>_order_report_including_empty_securities.txt - Every Security
+ *    <Report Name>_order_report_by_<Dimension>.txt           - Each rollup, e.g. by currency
+ *
+ *  @param numThreads      - Number of threads to read the input files with
+ *  @param outputDirectory - Directory to write the report on each input file to, or empty to not write them
+ *  @return void
+ */
+void OrderReportBatch::ReadInputFiles(const size_t numThreads, const std::string& outputDirectory)
+{
+    std::vector<size_t> submitOrder(batchFiles.size());
+    std::iota(submitOrder.begin(), submitOrder.end(), 0);
+    std::stable_sort(submitOrder.begin(), submitOrder.end(), [this](const size_t lhs, const size_t rhs)
+    {
+        return batchFiles[lhs].fileSize > batchFiles[rhs].fileSize;
+    });
+
+    ThreadPool threadPool(numThreads);
+    for (size_t i : submitOrder)
+    {
+        BatchFile& batchFile = batchFiles[i];
+        batchFile.ordRptColl = std::make_shared<OrderReportCollection>();
+        batchFile.ordRptColl->EnableSketches(quantileSketches);
+        batchFile.fileHandler = std::make_unique<OrderReportFileHandler>( batchFile.inputFile,   // Input File
+                                                                          "",                    // Output File
+                                                                          batchFile.ordRptColl,  // Collection of Order Reports
+                                                                          '\t',                  // Output File Delimiter
+                                                                          false );               // Only print Securities that have Orders
+        batchFile.fileHandler->SetInputReadMethod(inputReadMethod);
+        batchFile.fileHandler->SetPendingOrderLimit(pendingOrderLimit);
+        batchFile.fileHandler->SetOrderTracking(trackOrders);
+        batchFile.fileHandler->SetReportFormat(reportFormat);
+
+        OrderReportFileHandler* fileHandler = batchFile.fileHandler.get();
+        std::function<void()> onRead;
+        if (!outputDirectory.empty())
+        {
+            std::string outputPrefix = outputDirectory + "/" + GetReportName(batchFile.inputFile);
+            const ReportFormat* format = reportFormat;
+            for (RollupDimension dimension : rollupDimensions)
+            {
+                std::string rollupFile = outputPrefix + "_order_report_by_" + std::string(RollupReport::GetDimensionName(dimension)) + ".txt";
+                fileHandler->AddRollup(RollupReport(dimension, rollupFile, format));
+            }
+            onRead = [fileHandler, outputPrefix, format]
+            {
+                fileHandler->AddReportSink({ outputPrefix + "_order_report.txt", '\t', &OrderReport::HasOrders, format });
+                fileHandler->AddReportSink({ outputPrefix + "_order_report_including_empty_securities.txt", '\t', nullptr, format });
+                fileHandler->WriteReportSinks();
+            };
+        }
+
+        size_t numChunks = (batchFile.fileSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        fileHandler->SubmitInputFile(threadPool, numChunks, onRead);
+    }
+    threadPool.Wait();
+}
+
+
+/** @brief Merges the Order Reports of every input file into one collection
+ * 
+ *  The input files are merged in the order they were given, so where a Security is referenced
+ *  in several input files its ISIN & currency are taken from the first of them.
+ *
+ *  @param mergedColl - Collection to merge the Order Reports into
+ *  @return void
+ */
+void OrderReportBatch::MergeOrderReports(OrderReportCollection& mergedColl) const
+{
+    ScopedStatTimer mergeTimer(StatTimer::MergeFiles);
+
+    for (const auto& batchFile : batchFiles)
+    {
+        if (batchFile.ordRptColl != nullptr)
+            mergedColl.Merge(*batchFile.ordRptColl);
+    }
+}
+
+
+/** @brief Reports the orders whose Security was never referenced, for each input file
+ * 
+ *  Nothing is written for an input file if every one of its orders was resolved.
+ *
+ *  @param output - Stream to write the report to
+ *  @return void
+ */
+void OrderReportBatch::ReportUnresolvedOrders(std::ostream& output) const
+{
+    for (const auto& batchFile : batchFiles)
+    {
+        if (batchFile.fileHandler == nullptr)
+            continue;
+
+        const PendingOrderBuffer& pendingOrders = batchFile.fileHandler->GetPendingOrders();
+        if (pendingOrders.Empty() && pendingOrders.GetNumDropped() == 0)
+            continue;
+
+        output << batchFile.inputFile << ":\n";
+        batchFile.fileHandler->ReportUnresolvedOrders(output);
+    }
+}
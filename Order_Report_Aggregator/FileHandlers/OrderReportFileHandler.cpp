@@ -3,25 +3,80 @@
  *
  *  This contains the data and functions needed to produce an Order Report on a collection of Securities.
  *  
- *  It will read the input file one line at a time and search for the strings "msgType_":8" & "msgType_":12".
+ *  It will read the input file one line at a time and find the message type of each line. Each line is then passed
+ *  to the handler registered for its message type, if there is one. "msgType_":8 & "msgType_":12 are always handled.
  *
- *  It creates an Order Report object and inserts it into the map for Message Type 8. For Message Type 12 it will
- *  search the map, and if it finds a Security ID that matches then it will update the related Order Report object.
+ *  It creates an Order Report object and inserts it into the collection for Message Type 8. For Message Type 12 it will
+ *  search the collection, and if it finds a Security ID that matches then it will update the related Order Report object.
+ *  If the Security hasn't been referenced yet the order is held in the Pending Order Buffer, and replayed into the
+ *  Security's Order Report once its Security Reference Data arrives. Anything still pending at the end can be reported.
  * 
- *  When outputing the Order Report File it will loop through every Order Report object in the Order Report map,
+ *  The input file can also be read in parallel. It is split into chunks at line boundaries and each chunk is read
+ *  on a thread pool into its own partial Order Reports, which are merged into the Order Report collection at the end.
+ *  Each chunk also keeps where its Order Adds & Security Reference Data are. When the chunks are merged, in order, the
+ *  Orders of a Security that had Orders pending in a serial read are applied one by one, through the Pending Order Buffer,
+ *  so a parallel read gives the same reports and unresolved Orders as a serial read. The chunks can be submitted to a
+ *  thread pool shared with other files, with the merge done by whichever thread reads the last chunk.
+ * 
+ *  When following a growing input file, a snapshot of the Order Report File is written every so often. Each Security's
+ *  row is kept formatted between snapshots and only the rows of Securities that changed are formatted again, so the
+ *  cost of a snapshot depends on how much activity there has been rather than on how many Securities there are.
+ * 
+ *  A binary checkpoint of the Order Report collection, and how far through the input file it covers, can be saved
+ *  every so often while reading. After a restart the checkpoint is restored and reading carries on from that point.
+ * 
+ *  A copy of the Order Report collection can also be published every so often while reading, as a Report Snapshot
+ *  that other threads, such as the query server, read without taking a lock.
+ * 
+ *  The Securities can also be split into partitions by their Security ID, with each process of a sharded aggregation
+ *  reading the whole input file but only aggregating the Securities in its own partition. The Order Reports of every
+ *  partition are then merged back together, in the order a single process would have referenced the Securities in,
+ *  so the reports are the same as if the input file had been read by one process.
+ * 
+ *  Lines are counted in the Pipeline Stats by message type, along with Order Adds dropped because their Security is
+ *  unknown, and each stage of reading & writing is timed.
+ * 
+ *  When outputing the Order Report File it will loop through every Order Report object in the Order Report collection,
  *  outputting the required data in the specified format.
  *
+ *  Several reports can be written in a single pass by registering a Report Sink for each of them. Each Security is
+ *  formatted at most once per Report Format and the row is then written to every Report Sink whose filter accepts the
+ *  Security. Each Report Sink can report its own subset of the columns by giving the Report Format of a Report Schema.
+ *
+ *  Rollups of the Securities, e.g. totals per currency or per ISIN country, can be written in the same pass too. The group
+ *  of each Security is resolved as its Security Reference Data is read, and the groups' totals are built from the Order
+ *  Reports when the reports are written.
+ *
+ *  An interval report, of each Security's volume & VWAP per time interval, can be written in the same pass as the input
+ *  file is read. It needs the timestamp of every Order Add, so an input file is always read serially while it's open.
+ *
+ *  Live Orders can also be tracked, from the Order Delete ("msgType_":13), Order Modify ("msgType_":14) & Order Execute
+ *  ("msgType_":15) records, so that the resting & executed quantity of each Security can be reported as well as the
+ *  totals. Each Order Add is then kept in the Order Store until it's deleted or fully executed. The updates to an Order
+ *  have to be applied after its Order Add, so an input file is always read serially while Orders are tracked.
+ *  Updates to an Order whose Order Add is still in the Pending Order Buffer are applied to the pending order, and
+ *  replayed with it.
+ *
  *  @author Sean Griffin
  *  @bug No known bugs.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
 #include "OrderReportFileHandler.h"
+#include "CompressedInputReader.h"
+#include "MappedFile.h"
+#include "MessageClassifier.h"
+#include "OrderReportCheckpoint.h"
+#include "PipelineStats.h"
+#include "ThreadPool.h"
 
 /** @brief Order Report File Handler Constructor
  *
  *  @param inputFile_    - Input File Name/Path
  *  @param outputFile_   - Output File Name/Path
- *  @param ordRptColl_   - Map of Order Report objects
+ *  @param ordRptColl_   - Collection of Order Report objects
  *  @param delim         - Output File Delimiter
  *  @param rptEmptyOrds_ - Denotes whether to output Securities with no Orders against them
  */
@@ -33,11 +88,25 @@ OrderReportFileHandler::OrderReportFileHandler( const std::string& inputFile_,
     : InputFileHandler(inputFile_),
       OutputFileHandler(outputFile_),
       ordRptColl(ordRptColl_),
+      trackOrders(false),
       outputFileDelimiter(delim),
-      reportEmptyOrders(rptEmptyOrds_)
+      reportEmptyOrders(rptEmptyOrds_),
+      reportFormat(&OrderReportSchema::FORMAT),
+      checkpointLines(0),
+      linesSinceCheckpoint(0),
+      snapshotPublisher(nullptr),
+      publishLines(0),
+      linesSincePublish(0),
+      partition(0),
+      numPartitions(0),
+      linesRead(0)
 {
     if(ordRptColl == nullptr)
         ordRptColl = std::make_shared<OrderReportCollection>();
+
+    messageHandlers.fill(nullptr);
+    SetMessageHandler(MSG_TYPE_ORDER_ADD, &OrderReportFileHandler::FindAndUpdateOrderReport);
+    SetMessageHandler(MSG_TYPE_SECURITY_REF, &OrderReportFileHandler::CreateOrderReport);
 }
 
 OrderReportFileHandler::~OrderReportFileHandler()
@@ -55,6 +124,7 @@ OrderReportFileHandler::~OrderReportFileHandler()
 void OrderReportFileHandler::SetOutputFileDelimiter(const char delim)
 {
     outputFileDelimiter = delim;
+    formattedRows.clear();
 }
 
 
@@ -69,33 +139,428 @@ void OrderReportFileHandler::SetOutputFileDelimiter(const char delim)
 void OrderReportFileHandler::SetReportEmptyOrders(const bool rptEmptyOrds)
 {
     reportEmptyOrders = rptEmptyOrds;
+    formattedRows.clear();
+}
+
+
+/** @brief Sets the columns of the Order Report File
+ * 
+ *  Used for the snapshots written while following the input file, and by WriteOutputData.
+ * 
+ *  @param format - Report Format of the Report Schema to write. nullptr for every column (OrderReportSchema).
+ *  @return void
+ */
+void OrderReportFileHandler::SetReportFormat(const ReportFormat* format)
+{
+    reportFormat = (format != nullptr) ? format : &OrderReportSchema::FORMAT;
+    formattedRows.clear();
+}
+
+
+/** @brief Sets the memory limit of the Pending Order Buffer
+ * 
+ *  Order Adds for Securities that haven't been referenced yet are held until they are, up to
+ *  this much memory. Orders over the limit are discarded, as they are when the limit is 0.
+ * 
+ *  @param memoryLimit - Most memory, in bytes, that pending orders may use
+ *  @return void
+ */
+void OrderReportFileHandler::SetPendingOrderLimit(const size_t memoryLimit)
+{
+    pendingOrders.SetMemoryLimit(memoryLimit);
+}
+
+
+/** @brief Gets the Pending Order Buffer
+ * 
+ *  @return Orders waiting for their Security to be referenced
+ */
+const PendingOrderBuffer& OrderReportFileHandler::GetPendingOrders() const
+{
+    return pendingOrders;
+}
+
+
+/** @brief Reports the orders whose Security was never referenced
+ * 
+ *  Writes how many orders are still pending and the Securities with the most of them, along with
+ *  how many orders were discarded because the Pending Order Buffer was full, and how many were left
+ *  out of the interval report for arriving too late. Nothing is written if every order was resolved.
+ * 
+ *  @param output - Stream to write the report to
+ *  @return void
+ */
+void OrderReportFileHandler::ReportUnresolvedOrders(std::ostream& output) const
+{
+    constexpr size_t MAX_SECURITIES_LISTED = 10;
+
+    if (pendingOrders.GetNumDropped() > 0)
+        output << pendingOrders.GetNumDropped() << " Order Adds were discarded as the Pending Order Buffer was full\n";
+
+    if (intervalReport.GetNumLateOrders() > 0)
+        output << intervalReport.GetNumLateOrders() << " Order Adds were left out of the interval report as they arrived too late\n";
+
+    if (pendingOrders.Empty())
+        return;
+
+    std::vector<std::pair<int, size_t>> unresolved = pendingOrders.GetUnresolved();
+    std::stable_sort(unresolved.begin(), unresolved.end(), [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+
+    output << pendingOrders.Size() << " Order Adds against " << unresolved.size()
+           << " Securities were never resolved, as the Securities were never referenced\n";
+    for (size_t i = 0; i < unresolved.size() && i < MAX_SECURITIES_LISTED; ++i)
+        output << "  Security ID " << unresolved[i].first << ": " << unresolved[i].second << " Order Adds\n";
+    if (unresolved.size() > MAX_SECURITIES_LISTED)
+        output << "  ... and " << (unresolved.size() - MAX_SECURITIES_LISTED) << " more Securities\n";
+}
+
+
+/** @brief Turns tracking of live Orders on or off
+ * 
+ *  While on, every Order Add is kept in the Order Store and the Order Delete, Modify & Execute
+ *  records are applied to it, keeping the resting & executed quantity of each Security up to date.
+ *  The input file is read serially while Orders are tracked, even if it's read in parallel, so that
+ *  each Order is updated in the order of the input file. Turning it off forgets every live Order.
+ *
+ *  @param enable - Whether to track live Orders
+ *  @return void
+ */
+void OrderReportFileHandler::SetOrderTracking(const bool enable)
+{
+    trackOrders = enable;
+    SetMessageHandler(MSG_TYPE_ORDER_DELETE, enable ? &OrderReportFileHandler::DeleteLiveOrder : nullptr);
+    SetMessageHandler(MSG_TYPE_ORDER_MODIFY, enable ? &OrderReportFileHandler::ModifyLiveOrder : nullptr);
+    SetMessageHandler(MSG_TYPE_ORDER_EXECUTE, enable ? &OrderReportFileHandler::ExecuteLiveOrder : nullptr);
+    pendingOrders.SetOrderIndex(enable);
+    if (!enable)
+        liveOrders.Clear();
+}
+
+
+/** @brief Checks whether live Orders are tracked
+ * 
+ *  @return true if live Orders are tracked
+ */
+bool OrderReportFileHandler::OrderTrackingEnabled() const
+{
+    return trackOrders;
+}
+
+
+/** @brief Gets the Order Store
+ * 
+ *  @return Orders still resting on the book, when live Orders are tracked
+ */
+const OrderStore& OrderReportFileHandler::GetLiveOrders() const
+{
+    return liveOrders;
+}
+
+
+/** @brief Opens the interval report
+ * 
+ *  From then on the Order Adds read are also totalled per interval of their timestamp, and each
+ *  interval is written to the interval report once it's complete. The input file is read serially
+ *  while the interval report is open, even if it's read in parallel, so that the intervals are
+ *  written in order. Pending orders keep their timestamps while it's open, so that they are counted
+ *  in their own interval when they are replayed. Open it before restoring a checkpoint, so that the
+ *  timestamps of the pending orders restored are kept too.
+ *
+ *  @param intervalFile - Interval Report File Name/Path
+ *  @param interval     - Length of each interval
+ *  @return true if the interval report was opened
+ */
+bool OrderReportFileHandler::OpenIntervalReport(const std::string& intervalFile, const std::chrono::nanoseconds interval)
+{
+    if (!intervalReport.Open(intervalFile, interval, ordRptColl.get(), outputFileDelimiter))
+        return false;
+
+    pendingOrders.SetTimestamps(true);
+    return true;
+}
+
+
+/** @brief Writes the intervals not yet written and closes the interval report
+ * 
+ *  @return void
+ */
+void OrderReportFileHandler::CloseIntervalReport()
+{
+    intervalReport.Close();
+    pendingOrders.SetTimestamps(false);
+}
+
+
+/** @brief Gets the interval report
+ * 
+ *  @return Interval report
+ */
+const IntervalReport& OrderReportFileHandler::GetIntervalReport() const
+{
+    return intervalReport;
+}
+
+
+/** @brief Sets where and how often to save checkpoints
+ * 
+ *  While reading the input file a checkpoint is saved every checkpointLines_ lines, and at every
+ *  snapshot when following the input file. Nothing is saved automatically if checkpointLines_ is 0.
+ *  Only complete lines are read from then on, so a checkpoint never covers a line that was still
+ *  being written; a final line without a newline is left for the next run.
+ * 
+ *  @param checkpointFile_  - Checkpoint File Name/Path
+ *  @param checkpointLines_ - Lines read between checkpoints
+ *  @return void
+ */
+void OrderReportFileHandler::SetCheckpoint(const std::string& checkpointFile_, const size_t checkpointLines_)
+{
+    checkpointFile = checkpointFile_;
+    checkpointLines = checkpointLines_;
+    linesSinceCheckpoint = 0;
+    SetCompleteLinesOnly(!checkpointFile.empty());
+}
+
+
+/** @brief Saves a checkpoint of the Order Report collection
+ * 
+ *  The checkpoint covers the input file up to the end of the last line read, and holds a
+ *  fingerprint of that part of it.
+ * 
+ *  @return true if the checkpoint was saved
+ */
+bool OrderReportFileHandler::SaveCheckpoint() const
+{
+    if (checkpointFile.empty())
+        return false;
+
+    ScopedStatTimer checkpointTimer(StatTimer::Checkpoint);
+    uint64_t inputFingerprint = 0;
+    if (!FingerprintInput(GetInputOffset(), inputFingerprint))
+        return false;
+    return OrderReportCheckpoint::Save(checkpointFile, *ordRptColl, pendingOrders, liveOrders, GetInputOffset(), inputFingerprint);
+}
+
+
+/** @brief Restores the Order Report collection from the checkpoint
+ * 
+ *  On success the Order Report collection is replaced by the one in the checkpoint and the
+ *  input file will next be read from where the checkpoint left off. If the input file is shorter
+ *  than the part the checkpoint covers, or that part no longer matches its fingerprint, e.g. as the
+ *  file has been rotated or rewritten, the checkpoint is ignored and the input file will be read
+ *  from the start. That is reported on stderr.
+ * 
+ *  @return true if the checkpoint was restored
+ */
+bool OrderReportFileHandler::RestoreCheckpoint()
+{
+    uint64_t checkpointOffset = 0;
+    uint64_t checkpointFingerprint = 0;
+    if (checkpointFile.empty() || !OrderReportCheckpoint::LoadInputPosition(checkpointFile, checkpointOffset, checkpointFingerprint))
+        return false;
+
+    uint64_t inputFingerprint = 0;
+    if (!FingerprintInput(checkpointOffset, inputFingerprint) || inputFingerprint != checkpointFingerprint)
+    {
+        std::cerr << "Ignoring checkpoint " << checkpointFile << ", as " << inputFile
+                  << " is shorter than it or has changed since it was saved. Reading it from the start." << std::endl;
+        return false;
+    }
+
+    if (!OrderReportCheckpoint::Load(checkpointFile, *ordRptColl, pendingOrders, liveOrders, checkpointOffset))
+        return false;
+
+    SetInputStartOffset(checkpointOffset);
+    inputOffset = checkpointOffset;
+    formattedRows.clear();
+    return true;
+}
+
+
+/** @brief Sets where and how often to publish snapshots of the Order Report collection
+ * 
+ *  While reading the input file serially a snapshot is published every publishLines_ lines, and
+ *  at every snapshot when following the input file. A parallel read only publishes when
+ *  PublishSnapshot is called, once the chunks have been merged.
+ * 
+ *  @param publisher     - Publisher to publish the snapshots through, or nullptr to stop publishing
+ *  @param publishLines_ - Lines read between snapshots. 0 to only publish when PublishSnapshot is called.
+ *  @return void
+ */
+void OrderReportFileHandler::SetSnapshotPublisher(SnapshotPublisher* publisher, const size_t publishLines_)
+{
+    snapshotPublisher = publisher;
+    publishLines = (publisher != nullptr) ? publishLines_ : 0;
+    linesSincePublish = 0;
+}
+
+
+/** @brief Publishes a snapshot of the Order Report collection
+ * 
+ *  The snapshot covers the input file up to the end of the last line read.
+ * 
+ *  @return void
+ */
+void OrderReportFileHandler::PublishSnapshot()
+{
+    if (snapshotPublisher != nullptr)
+        snapshotPublisher->Publish(*ordRptColl, GetInputOffset());
+}
+
+
+/** @brief Only aggregates the Securities in one partition of the Security IDs
+ * 
+ *  Order Adds & Security Reference Data records for Securities in other partitions are skipped as
+ *  soon as their Security ID has been parsed, without being counted. Order Deletes, Modifies &
+ *  Executes can't be told apart by Security, so are looked up as usual; those of Orders in other
+ *  partitions aren't found, and are counted as unknown. The input file is read serially while
+ *  partitioned, even if it's read in parallel, so that the Securities are referenced in order.
+ *
+ *  @param partition_     - Partition to aggregate, from 0 to numPartitions_ - 1
+ *  @param numPartitions_ - Number of partitions the Security IDs are split into
+ *  @return void
+ */
+void OrderReportFileHandler::SetPartition(const size_t partition_, const size_t numPartitions_)
+{
+    partition = partition_;
+    numPartitions = numPartitions_;
+    referenceLines.assign(ordRptColl->Size(), 0);
+}
+
+
+/** @brief Checks whether a line belongs to this handler's partition
+ * 
+ *  Lines without a valid Security ID belong to partition 0, so their parse errors are only counted once.
+ *
+ *  @param inputLine - Line from the input file that contains an Order Add or Security Reference Data record
+ *  @return true if the line's Security is in this handler's partition
+ */
+bool OrderReportFileHandler::InPartition(std::string_view inputLine) const
+{
+    int securityId = 0;
+    if (!OrderMessageParser::ParseSecurityId(inputLine, securityId))
+        return partition == 0;
+
+    return OrderReportShard::ShardOf(securityId, numPartitions) == partition;
+}
+
+
+/** @brief Writes the Order Reports of this handler's partition as a Shard Partial
+ * 
+ *  @param outBuffer - Buffer to write the Shard Partial to
+ *  @return true if the Shard Partial was written, false if the Securities aren't partitioned
+ */
+bool OrderReportFileHandler::WriteShardPartial(OutputBuffer& outBuffer) const
+{
+    if (numPartitions == 0)
+        return false;
+
+    return OrderReportShard::Write(outBuffer, partition, numPartitions, *ordRptColl, referenceLines, pendingOrders, trackOrders);
+}
+
+
+/** @brief Merges the Shard Partials of every partition into the ordRptColl collection
+ * 
+ *  The Securities of every partition are inserted in the order of the lines that first referenced
+ *  them, so the ordRptColl collection ends up in the same order as if every partition had been read
+ *  together. The Orders still pending in each partition are gathered into the Pending Order Buffer,
+ *  whatever its memory limit, along with the number each partition dropped.
+ *
+ *  @param partials - Shard Partial of each partition
+ *  @return void
+ */
+void OrderReportFileHandler::MergeShardPartials(const std::vector<ShardPartial>& partials)
+{
+    ScopedStatTimer mergeTimer(StatTimer::MergeShards);
+    std::vector<size_t> nextSlots(partials.size(), 0);
+
+    size_t numSecurities = ordRptColl->Size();
+    for (const auto& partial : partials)
+        numSecurities += partial.orders.Size();
+    ordRptColl->Reserve(numSecurities);
+
+    // Each partition's Securities are already in the order they were referenced, so repeatedly take
+    // whichever partition's next Security was referenced first
+    //
+    for (;;)
+    {
+        size_t nextPartial = partials.size();
+        for (size_t i = 0; i < partials.size(); ++i)
+        {
+            if ( nextSlots[i] < partials[i].orders.Size() &&
+                 ( nextPartial == partials.size() ||
+                   partials[i].referenceLines[nextSlots[i]] < partials[nextPartial].referenceLines[nextSlots[nextPartial]] ) )
+                nextPartial = i;
+        }
+        if (nextPartial == partials.size())
+            break;
+
+        const ShardPartial& partial = partials[nextPartial];
+        size_t partialSlot = nextSlots[nextPartial]++;
+        const SecurityInfo& secInfo = partial.orders.GetSecurityInfo(partialSlot);
+        size_t slot = ordRptColl->Insert(partial.orders.GetOrderReport(partialSlot).GetSecurityId(), secInfo.ISIN.View(), secInfo.currency.View());
+        ordRptColl->MergeSlot(slot, partial.orders, partialSlot);
+        ordRptColl->MarkChanged(slot);
+    }
+
+    size_t memoryLimit = pendingOrders.GetMemoryLimit();
+    pendingOrders.SetMemoryLimit(SIZE_MAX);
+    for (const auto& partial : partials)
+    {
+        partial.pendingOrders.ForEachOrder([this](const int securityId, const OrderAddData& ordData, const PendingOrderState& state)
+        {
+            pendingOrders.Add(securityId, ordData, state);
+        });
+        pendingOrders.CountDropped(partial.pendingOrders.GetNumDropped());
+    }
+    pendingOrders.SetMemoryLimit(memoryLimit);
+}
+
+
+/** @brief Sets the handler for a message type
+ * 
+ *  Lines with this message type will be passed to the handler. Message types
+ *  above MAX_MSG_TYPE can't be handled and are ignored.
+ *
+ *  @param msgType - Message type the handler is for
+ *  @param handler - Handler for the message type, or nullptr to ignore it
+ *  @return void
+ */
+void OrderReportFileHandler::SetMessageHandler(const int msgType, MessageHandler handler)
+{
+    if (msgType >= 0 && msgType <= MAX_MSG_TYPE)
+        messageHandlers[msgType] = handler;
 }
 
 
 /** @brief Reads the line from the input file
  * 
- *  Will check if the line from the input file contains "msgType_":8" or "msgType_":12".
- *  It will send the line to the appropiate function depending on the message type.
+ *  Finds the message type of the line with a single scan, then passes the line to
+ *  the handler for that message type. Lines with no handler are ignored, and counted. Saves a
+ *  checkpoint, and publishes a snapshot, once enough lines have been read since the last one.
  *
  *  @param inputLine - Line from the input file
  *  @return void
  */
-void OrderReportFileHandler::ReadInputData(const std::string& inputLine)
+void OrderReportFileHandler::ReadInputData(std::string_view inputLine)
 {
-    // There are a lot more MSG_TYPE_ORDER_ADD than MSG_TYPE_SECURITY_REF
-    // so we should evaluate it first
-    //
-    if (inputLine.find(MSG_TYPE_ORDER_ADD) != std::string::npos)
+    ++linesRead;
+    int msgType = MessageClassifier::Classify(inputLine);
+    MessageHandler handler = (msgType >= 0 && msgType <= MAX_MSG_TYPE) ? messageHandlers[msgType] : nullptr;
+    if (handler != nullptr)
+        (this->*handler)(inputLine);
+    else
+        PipelineStats::Count(StatCounter::IgnoredLines);
+
+    if (checkpointLines > 0 && ++linesSinceCheckpoint >= checkpointLines)
     {
-        // Find existing Order object and modify it
-        //
-        FindAndUpdateOrderReport(inputLine);
+        SaveCheckpoint();
+        linesSinceCheckpoint = 0;
     }
-    else if (inputLine.find(MSG_TYPE_SECURITY_REF) != std::string::npos)
+
+    if (publishLines > 0 && ++linesSincePublish >= publishLines)
     {
-        // Add new Order object
-        //
-        CreateOrderReport(inputLine);
+        PublishSnapshot();
+        linesSincePublish = 0;
     }
 }
 
@@ -103,38 +568,45 @@ void OrderReportFileHandler::ReadInputData(const std::string& inputLine)
 /** @brief Find and update an Order Report object
  * 
  *  This function is creating a OrderAddData object to temporary store the values from the Order Add ("msgType_":12).
- *  It is then searching the ordRptColl map by the securityId to see if an OrderReport object exists.
- *  If it finds an OrderReport object then it adds the data from the OrderAddData object to the OrderReport object.
+ *  It is then searching the ordRptColl collection by the securityId to see if an OrderReport object exists.
+ *  If it finds an OrderReport object then it adds the data from the OrderAddData object to the OrderReport object,
+ *  otherwise the order is held in the Pending Order Buffer until the Security is referenced.
+ *  The Order is kept in the Order Store as well when live Orders are tracked.
  *
  *  @param inputLine - Line from the input file that contains the Order Add record (msgType_ = 12)
  *  @return void
  */
-void OrderReportFileHandler::FindAndUpdateOrderReport(const std::string& inputLine)
+void OrderReportFileHandler::FindAndUpdateOrderReport(std::string_view inputLine)
 {
-    size_t valPos = 0;
-    size_t valLength = 0;
+    int securityId = 0;
     OrderAddData tmpData;
-    
-    // Message type 12 will always have the headings we need in the following order:
-    // securityId_\":, side_\":, quantity_\":, price_\":
-    // So rather than searching the whole string for these headings each time, we can begin our
-    // search for each subsequent heading from where the value of the previous heading ended.
-    //
-    CalcStrValPosFromStr(inputLine, "securityId_\":", valPos, valLength);
-    int securityId = stoi(inputLine.substr(valPos, valLength));
-
-    CalcStrValPosFromStr(inputLine, "side_\":", valPos, valLength, (valPos + valLength));
-    tmpData.side = (inputLine.substr(valPos, valLength) == "BUY") ? Side::Buy : Side::Sell;
+    unsigned optionalFields = (intervalReport.IsOpen() ? OrderMessageParser::PARSE_TIMESTAMP : 0) |
+                              (trackOrders ? OrderMessageParser::PARSE_ORDER_ID : 0);
 
-    CalcStrValPosFromStr(inputLine, "quantity_\":", valPos, valLength, (valPos + valLength));
-    tmpData.quantity = stoll(inputLine.substr(valPos, valLength));
+    if (numPartitions > 1 && !InPartition(inputLine))
+        return;
 
-    CalcStrValPosFromStr(inputLine, "price_\":", valPos, valLength, (valPos + valLength));
-    tmpData.price = stoll(inputLine.substr(valPos, valLength));
+    PipelineStats::Count(StatCounter::OrderAdds);
+    if (!OrderMessageParser::ParseOrderAdd(inputLine, securityId, tmpData, optionalFields))
+    {
+        PipelineStats::Count(StatCounter::ParseErrors);
+        return;
+    }
 
-    auto find = ordRptColl->find(securityId);
-    if ( find != ordRptColl->end() )
-        find->second.AddOrderData(tmpData);
+    size_t slot = ordRptColl->Find(securityId);
+    if ( slot != OrderReportCollection::NOT_FOUND )
+    {
+        ordRptColl->AddOrderData(slot, tmpData);
+        ordRptColl->MarkChanged(slot);
+        if (intervalReport.IsOpen())
+            intervalReport.AddOrderData(slot, tmpData);
+        if (trackOrders)
+            AddLiveOrder(slot, tmpData);
+    }
+    else if (pendingOrders.Add(securityId, tmpData))
+        PipelineStats::Count(StatCounter::PendingOrders);
+    else
+        PipelineStats::Count(StatCounter::UnknownSecurityOrders);
 }
 
 
@@ -143,61 +615,710 @@ void OrderReportFileHandler::FindAndUpdateOrderReport(const std::string& inputLi
  *  This function first creates a new empty OrderReport object.
  *  It then stores the securityId_, isin_ & currency_ from the
  *  Security Reference Data ("msgType_":8) into the OrderReport object.
- *  Finally it then adds the OrderReport object to the ordRptColl map.
+ *  Finally it then adds the OrderReport object to the ordRptColl collection.
  *
  *  @param inputLine - Line from the input file that contains the Security Reference Data record (msgType_ = 8)
  *  @return void
  */
-void OrderReportFileHandler::CreateOrderReport(const std::string& inputLine)
+void OrderReportFileHandler::CreateOrderReport(std::string_view inputLine)
 {
-    size_t valPos = 0;
-    size_t valLength = 0;
-    OrderReport newOrdRpt = OrderReport();
+    SecurityRefData refData;
+
+    if (numPartitions > 1 && !InPartition(inputLine))
+        return;
+
+    PipelineStats::Count(StatCounter::SecurityRefs);
+    if (OrderMessageParser::ParseSecurityRef(inputLine, refData))
+        InsertOrderReport(refData);
+    else
+        PipelineStats::Count(StatCounter::ParseErrors);
+}
+
+
+/** @brief Inserts a new Order Report object for a Security
+ * 
+ *  If the Security is already in the ordRptColl collection then the existing Order Report is kept.
+ *  Any orders pending for the Security are replayed into its Order Report. When partitioned, the
+ *  line that referenced a new Security is kept for merging the partitions back together. A new
+ *  Security is mapped to its group in each rollup.
+ *
+ *  @param refData - The relevant data from the Security Reference Data record
+ *  @return void
+ */
+void OrderReportFileHandler::InsertOrderReport(const SecurityRefData& refData)
+{
+    size_t slot = ordRptColl->Insert(refData.securityId, refData.ISIN, refData.currency);
+    if (numPartitions > 0 && slot == referenceLines.size())
+        referenceLines.push_back(linesRead);
+    for (auto& rollup : rollups)
+        rollup.MapSecurities(*ordRptColl);
+
+    if (!pendingOrders.Empty())
+    {
+        size_t numReplayed = pendingOrders.Replay(refData.securityId, [this, slot](const OrderAddData& ordData, const PendingOrderState& state)
+        {
+            ordRptColl->AddOrderData(slot, ordData);
+            if (intervalReport.IsOpen())
+                intervalReport.AddOrderData(slot, ordData);
+            if (trackOrders)
+                ReplayLiveOrder(slot, ordData, state);
+        });
+        if (numReplayed > 0)
+        {
+            ordRptColl->MarkChanged(slot);
+            PipelineStats::Count(StatCounter::ReplayedOrders, numReplayed);
+        }
+    }
+}
+
 
-    // Message type 8 will always have the headings we need in the following order:
-    // securityId_\":, isin_\":, currency_\":
-    // So rather than searching the whole string for these headings each time, we can begin our
-    // search for each subsequent heading from where the value of the previous heading ended.
+/** @brief Gets the resting quantity of one side of a Security
+ * 
+ *  @param activity - Activity of the Security
+ *  @param side     - Side of the Order
+ *  @return Resting quantity of that side
+ */
+static uint64_t& RestingQuantity(OrderActivity& activity, const Side side)
+{
+    return (side == Side::Buy) ? activity.restingBuyQuantity : activity.restingSellQuantity;
+}
+
+
+/** @brief Keeps an Order in the Order Store
+ * 
+ *  Its quantity rests on the book until it's deleted or executed. An Order Add reusing the ID of a
+ *  live Order replaces it, taking the old Order's quantity off the book.
+ *
+ *  @param slot    - Slot of the Order's Security
+ *  @param ordData - The relevant data from the Order Add record, including its Order ID
+ *  @return void
+ */
+void OrderReportFileHandler::AddLiveOrder(const size_t slot, const OrderAddData& ordData)
+{
+    LiveOrder* oldOrder = liveOrders.Find(ordData.orderId);
+    if (oldOrder != nullptr)
+    {
+        RestingQuantity(ordRptColl->GetActivity(oldOrder->slot), oldOrder->side) -= oldOrder->quantity;
+        ordRptColl->MarkChanged(oldOrder->slot);
+    }
+
+    LiveOrder& order = liveOrders.Insert(ordData.orderId);
+    order.quantity = ordData.quantity;
+    order.price = ordData.price;
+    order.slot = static_cast<uint32_t>(slot);
+    order.side = ordData.side;
+    RestingQuantity(ordRptColl->GetActivity(slot), ordData.side) += ordData.quantity;
+}
+
+
+/** @brief Keeps an Order replayed from the Pending Order Buffer in the Order Store
+ * 
+ *  Any of it executed while it was pending is counted as executed, and whatever is left of it rests
+ *  on the book, at its latest price, unless it was deleted or fully executed while pending.
+ *
+ *  @param slot    - Slot of the Order's Security
+ *  @param ordData - The relevant data from the Order Add record, including its Order ID
+ *  @param state   - What is left of the Order after the updates read while it was pending
+ *  @return void
+ */
+void OrderReportFileHandler::ReplayLiveOrder(const size_t slot, const OrderAddData& ordData, const PendingOrderState& state)
+{
+    OrderActivity& activity = ordRptColl->GetActivity(slot);
+    ((ordData.side == Side::Buy) ? activity.executedBuyQuantity : activity.executedSellQuantity) += state.executedQuantity;
+
+    if (state.restingQuantity > 0)
+        AddLiveOrder(slot, OrderAddData{ ordData.side, state.restingQuantity, state.restingPrice, ordData.timestamp, ordData.orderId });
+}
+
+
+/** @brief Deletes a live Order from an Order Delete record
+ * 
+ *  Its remaining quantity is taken off the book. If its Order Add is still pending, the pending order
+ *  is deleted instead. Deletes of other Orders, e.g. because their Order Add was dropped, are counted
+ *  and ignored.
+ *
+ *  @param inputLine - Line from the input file that contains the Order Delete record (msgType_ = 13)
+ *  @return void
+ */
+void OrderReportFileHandler::DeleteLiveOrder(std::string_view inputLine)
+{
+    uint64_t orderId = 0;
+
+    PipelineStats::Count(StatCounter::OrderDeletes);
+    if (!OrderMessageParser::ParseOrderDelete(inputLine, orderId))
+    {
+        PipelineStats::Count(StatCounter::ParseErrors);
+        return;
+    }
+
+    LiveOrder* order = liveOrders.Find(orderId);
+    if (order == nullptr)
+    {
+        if (!pendingOrders.DeleteOrder(orderId))
+            PipelineStats::Count(StatCounter::UnknownOrderUpdates);
+        return;
+    }
+
+    RestingQuantity(ordRptColl->GetActivity(order->slot), order->side) -= order->quantity;
+    ordRptColl->MarkChanged(order->slot);
+    liveOrders.Remove(orderId);
+}
+
+
+/** @brief Modifies a live Order from an Order Modify record
+ * 
+ *  The Order's resting quantity is replaced by its new quantity, and it's deleted if that's 0.
+ *  If its Order Add is still pending, the pending order is modified instead. Modifies of other
+ *  Orders are counted and ignored.
+ *
+ *  @param inputLine - Line from the input file that contains the Order Modify record (msgType_ = 14)
+ *  @return void
+ */
+void OrderReportFileHandler::ModifyLiveOrder(std::string_view inputLine)
+{
+    OrderUpdateData updData;
+
+    PipelineStats::Count(StatCounter::OrderModifies);
+    if (!OrderMessageParser::ParseOrderUpdate(inputLine, updData))
+    {
+        PipelineStats::Count(StatCounter::ParseErrors);
+        return;
+    }
+
+    LiveOrder* order = liveOrders.Find(updData.orderId);
+    if (order == nullptr)
+    {
+        PendingOrderState* pendingOrder = pendingOrders.FindOrder(updData.orderId);
+        if (pendingOrder != nullptr)
+        {
+            pendingOrder->restingQuantity = updData.quantity;
+            pendingOrder->restingPrice = updData.price;
+            if (pendingOrder->restingQuantity == 0)
+                pendingOrders.DeleteOrder(updData.orderId);
+        }
+        else
+            PipelineStats::Count(StatCounter::UnknownOrderUpdates);
+        return;
+    }
+
+    uint64_t& resting = RestingQuantity(ordRptColl->GetActivity(order->slot), order->side);
+    resting = resting - order->quantity + updData.quantity;
+    ordRptColl->MarkChanged(order->slot);
+
+    order->quantity = updData.quantity;
+    order->price = updData.price;
+    if (order->quantity == 0)
+        liveOrders.Remove(updData.orderId);
+}
+
+
+/** @brief Executes some or all of a live Order from an Order Execute record
+ * 
+ *  The quantity executed moves from resting to executed, and the Order is removed once none of it
+ *  is left. An execute for more than the Order's remaining quantity only executes what's left.
+ *  If its Order Add is still pending, the pending order is executed instead. Executes of other
+ *  Orders are counted and ignored.
+ *
+ *  @param inputLine - Line from the input file that contains the Order Execute record (msgType_ = 15)
+ *  @return void
+ */
+void OrderReportFileHandler::ExecuteLiveOrder(std::string_view inputLine)
+{
+    OrderUpdateData updData;
+
+    PipelineStats::Count(StatCounter::OrderExecutes);
+    if (!OrderMessageParser::ParseOrderUpdate(inputLine, updData))
+    {
+        PipelineStats::Count(StatCounter::ParseErrors);
+        return;
+    }
+
+    LiveOrder* order = liveOrders.Find(updData.orderId);
+    if (order == nullptr)
+    {
+        PendingOrderState* pendingOrder = pendingOrders.FindOrder(updData.orderId);
+        if (pendingOrder != nullptr)
+        {
+            uint64_t executedQuantity = std::min<uint64_t>(updData.quantity, pendingOrder->restingQuantity);
+            pendingOrder->restingQuantity -= executedQuantity;
+            pendingOrder->executedQuantity += executedQuantity;
+            if (pendingOrder->restingQuantity == 0)
+                pendingOrders.DeleteOrder(updData.orderId);
+        }
+        else
+            PipelineStats::Count(StatCounter::UnknownOrderUpdates);
+        return;
+    }
+
+    OrderActivity& activity = ordRptColl->GetActivity(order->slot);
+    uint64_t executedQuantity = std::min<uint64_t>(updData.quantity, order->quantity);
+    RestingQuantity(activity, order->side) -= executedQuantity;
+    ((order->side == Side::Buy) ? activity.executedBuyQuantity : activity.executedSellQuantity) += executedQuantity;
+    ordRptColl->MarkChanged(order->slot);
+
+    order->quantity -= executedQuantity;
+    if (order->quantity == 0)
+        liveOrders.Remove(updData.orderId);
+}
+
+
+/** @brief Reads the input file in parallel
+ * 
+ *  Reads the input file in chunks on a pool of numThreads threads, using a few chunks per thread so
+ *  that one slow chunk doesn't hold up the whole read. See SubmitInputFile.
+ * 
+ *  Reads the input file on the calling thread if numThreads is 1 or less, the interval report is open,
+ *  live Orders are tracked, or the Securities are partitioned.
+ *
+ *  @param numThreads - Number of threads to read the input file with
+ *  @return void
+ */
+void OrderReportFileHandler::ReadInputFileParallel(const size_t numThreads)
+{
+    if (numThreads <= 1 || intervalReport.IsOpen() || trackOrders || numPartitions > 0)
+    {
+        ReadInputFile();
+        return;
+    }
+
+    ThreadPool threadPool(numThreads);
+    SubmitInputFile(threadPool, numThreads * 4, nullptr);
+    threadPool.Wait();
+}
+
+
+/** @brief Submits the reading of the input file to a thread pool
+ * 
+ *  Memory maps the input file and splits it into numChunks chunks at line boundaries, starting from the Input Start Offset.
+ *  Each chunk is read on the pool into its own OrderReportPartial, so the threads never share any state
+ *  while reading. The task that reads the last chunk merges the partials into the ordRptColl collection.
+ * 
+ *  If numChunks is 1 or less, the interval report is open, live Orders are tracked, the Securities are partitioned, or the input file
+ *  can't be memory mapped, the whole input file is read by a single task instead. A compressed input file is also read by a single task, with decompression running
+ *  alongside it.
+ * 
+ *  Returns as soon as the tasks have been submitted. Once the whole input file has been read onRead is called,
+ *  on whichever thread read it last, so the pool may be waited on or onRead used to carry on with the file.
+ *
+ *  @param threadPool - Thread pool to read the input file on
+ *  @param numChunks  - Number of chunks to split the input file into
+ *  @param onRead     - Called once the input file has been read, if set
+ *  @return void
+ */
+void OrderReportFileHandler::SubmitInputFile(ThreadPool& threadPool, const size_t numChunks, std::function<void()> onRead)
+{
+    auto readWhole = [this, onRead]
+    {
+        ReadInputFile();
+        if (onRead)
+            onRead();
+    };
+
+    std::shared_ptr<ChunkedRead> read = std::make_shared<ChunkedRead>();
+    if ( numChunks <= 1 ||
+         intervalReport.IsOpen() ||
+         trackOrders ||
+         numPartitions > 0 ||
+         inputReadMethod != InputReadMethod::Auto ||
+         CompressedInputReader::DetectFormat(inputFile) != CompressionFormat::None ||
+         !read->mappedFile.Open(inputFile) )
+    {
+        threadPool.Submit(readWhole);
+        return;
+    }
+
+    std::string_view fileData = CompleteLines(read->mappedFile.GetData());
+    read->chunks = SplitInputData(fileData.substr(std::min(inputStartOffset, fileData.size())), numChunks);
+    if (read->chunks.empty())
+    {
+        inputOffset = fileData.size();
+        threadPool.Submit([onRead] { if (onRead) onRead(); });
+        return;
+    }
+
+    read->partials.resize(read->chunks.size());
+    for (auto& partial : read->partials)
+        partial.orders.EnableSketches(ordRptColl->SketchesEnabled());
+    read->chunksLeft.store(read->chunks.size());
+    read->timing = PipelineStats::IsEnabled();
+    read->start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < read->chunks.size(); ++i)
+    {
+        threadPool.Submit([this, read, onRead, i]
+        {
+            ReadInputChunk(read->chunks[i], read->mappedFile.GetData(), read->partials[i]);
+            if (read->chunksLeft.fetch_sub(1) != 1)
+                return;
+
+            MergeInputChunks(read->mappedFile.GetData(), read->partials);
+            inputOffset = CompleteLines(read->mappedFile.GetData()).size();
+            if (read->timing)
+                PipelineStats::RecordTime( StatTimer::ReadInput,
+                                           std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - read->start).count() );
+            if (onRead)
+                onRead();
+        });
+    }
+}
+
+
+/** @brief Reads a chunk of the input file into a partial
+ * 
+ *  Order Add records are added to a partial Order Report for their Security, whether or not the Security has
+ *  been seen yet, and the offset of each is kept. Security Reference Data records are kept to one side, with
+ *  their offsets, so that they can be applied to the ordRptColl collection in file order when the partials are
+ *  merged. Whether a Security got its slot from an Order Add, and where it was first referenced in the chunk,
+ *  are kept by slot, so the merge can tell which Securities had Orders before they were referenced.
+ *
+ *  @param inputChunk - Chunk of the input file, made up of whole lines
+ *  @param fileData   - The whole input file, that offsets are taken from
+ *  @param partial    - Partial to read the chunk into
+ *  @return void
+ */
+void OrderReportFileHandler::ReadInputChunk(std::string_view inputChunk, std::string_view fileData, OrderReportPartial& partial) const
+{
+    ScopedStatTimer chunkTimer(StatTimer::ReadChunk);
+    size_t numLines = 0;
+    size_t numOrderAdds = 0;
+    size_t numSecurityRefs = 0;
+    size_t numParseErrors = 0;
+
+    // Finds the partial slot of a Security, recording where the line that gave it the slot is if it is new
+    //
+    auto findSlot = [&partial](const int securityId, const uint64_t firstOrderAdd)
+    {
+        size_t partialSlot = partial.orders.FindOrInsert(securityId);
+        if (partialSlot == partial.firstOrderAdds.size())
+        {
+            partial.firstOrderAdds.push_back(firstOrderAdd);
+            partial.firstReferences.push_back(UINT64_MAX);
+        }
+        return partialSlot;
+    };
+
+    ForEachInputLine(inputChunk, [&partial, fileData, &findSlot, &numLines, &numOrderAdds, &numSecurityRefs, &numParseErrors](std::string_view inputLine)
+    {
+        ++numLines;
+        int msgType = MessageClassifier::Classify(inputLine);
+        if (msgType == MSG_TYPE_ORDER_ADD)
+        {
+            int securityId = 0;
+            OrderAddData tmpData;
+            ++numOrderAdds;
+            if (OrderMessageParser::ParseOrderAdd(inputLine, securityId, tmpData))
+            {
+                uint64_t offset = static_cast<uint64_t>(inputLine.data() - fileData.data());
+                size_t partialSlot = findSlot(securityId, offset);
+                partial.orders.AddOrderData(partialSlot, tmpData);
+                partial.orderAdds.push_back({offset, static_cast<uint32_t>(partialSlot)});
+            }
+            else
+                ++numParseErrors;
+        }
+        else if (msgType == MSG_TYPE_SECURITY_REF)
+        {
+            SecurityRefData refData;
+            ++numSecurityRefs;
+            if (OrderMessageParser::ParseSecurityRef(inputLine, refData))
+            {
+                uint64_t offset = static_cast<uint64_t>(inputLine.data() - fileData.data());
+                size_t partialSlot = findSlot(refData.securityId, UINT64_MAX);
+                if (partial.firstReferences[partialSlot] == UINT64_MAX)
+                    partial.firstReferences[partialSlot] = offset;
+                partial.securityRefs.push_back(refData);
+                partial.securityRefOffsets.push_back(offset);
+            }
+            else
+                ++numParseErrors;
+        }
+    });
+
+    // Counted locally and recorded once, so the lines of a chunk cost nothing extra when stats are disabled
     //
-    CalcStrValPosFromStr(inputLine, "securityId_\":", valPos, valLength);
-    newOrdRpt.SetSecurityId(stoi(inputLine.substr(valPos, valLength)));
+    PipelineStats::Count(StatCounter::LinesRead, numLines);
+    PipelineStats::Count(StatCounter::BytesRead, inputChunk.size());
+    PipelineStats::Count(StatCounter::OrderAdds, numOrderAdds);
+    PipelineStats::Count(StatCounter::SecurityRefs, numSecurityRefs);
+    PipelineStats::Count(StatCounter::IgnoredLines, numLines - numOrderAdds - numSecurityRefs);
+    PipelineStats::Count(StatCounter::ParseErrors, numParseErrors);
+}
+
 
-    CalcStrValPosFromStr(inputLine, "isin_\":", valPos, valLength, (valPos + valLength));
-    newOrdRpt.SetISIN(inputLine.substr(valPos, valLength));
+/** @brief Merges the partials read from each chunk into the ordRptColl collection
+ * 
+ *  The partials are merged in the order of their chunks. A Security that had Orders in a chunk before it was
+ *  referenced in that chunk, and wasn't referenced in an earlier chunk either, had Orders pending in a serial
+ *  read. The chunk's Orders for such a Security are parsed again and applied one by one, in file order with the
+ *  chunk's Security Reference Data: those before the Security was referenced are added to the Pending Order
+ *  Buffer, and the rest to its Order Report. So the same Orders are held, replayed, discarded when the buffer
+ *  is full, or left unresolved at the end, as in a serial read. Every other partial Order Report is merged into
+ *  the Order Report for its Security.
+ *
+ *  @param fileData - The whole input file, that the partials' offsets are taken from
+ *  @param partials - Partials read from each chunk, in the same order as the chunks
+ *  @return void
+ */
+void OrderReportFileHandler::MergeInputChunks(std::string_view fileData, const std::vector<OrderReportPartial>& partials)
+{
+    ScopedStatTimer mergeTimer(StatTimer::MergeChunks);
+    std::vector<size_t> slots;
+    std::vector<bool> hadPendingOrders;
+
+    for (const auto& partial : partials)
+    {
+        bool anyPendingOrders = false;
+        slots.resize(partial.orders.Size());
+        hadPendingOrders.assign(partial.orders.Size(), false);
+        for (size_t partialSlot = 0; partialSlot < partial.orders.Size(); ++partialSlot)
+        {
+            slots[partialSlot] = ordRptColl->Find(partial.orders.GetOrderReport(partialSlot).GetSecurityId());
+            if (slots[partialSlot] == OrderReportCollection::NOT_FOUND && partial.firstOrderAdds[partialSlot] != UINT64_MAX)
+            {
+                hadPendingOrders[partialSlot] = true;
+                anyPendingOrders = true;
+            }
+        }
 
-    CalcStrValPosFromStr(inputLine, "currency_\":", valPos, valLength, (valPos + valLength));
-    newOrdRpt.SetCurrency(inputLine.substr(valPos, valLength));
+        size_t ref = 0;
+        if (anyPendingOrders)
+        {
+            for (const auto& orderAdd : partial.orderAdds)
+            {
+                if (!hadPendingOrders[orderAdd.slot])
+                    continue;
 
-    ordRptColl->insert(std::make_pair(newOrdRpt.GetSecurityId(), std::move(newOrdRpt)));
+                for (; ref < partial.securityRefs.size() && partial.securityRefOffsets[ref] < orderAdd.offset; ++ref)
+                    InsertOrderReport(partial.securityRefs[ref]);
+
+                std::string_view inputLine = fileData.substr(orderAdd.offset);
+                int securityId = 0;
+                OrderAddData tmpData;
+                OrderMessageParser::ParseOrderAdd(inputLine.substr(0, inputLine.find('\n')), securityId, tmpData);
+                if (orderAdd.offset > partial.firstReferences[orderAdd.slot])
+                {
+                    size_t slot = ordRptColl->Find(securityId);
+                    ordRptColl->AddOrderData(slot, tmpData);
+                    ordRptColl->MarkChanged(slot);
+                }
+                else if (pendingOrders.Add(securityId, tmpData))
+                    PipelineStats::Count(StatCounter::PendingOrders);
+                else
+                    PipelineStats::Count(StatCounter::UnknownSecurityOrders);
+            }
+        }
+        for (; ref < partial.securityRefs.size(); ++ref)
+            InsertOrderReport(partial.securityRefs[ref]);
+
+        for (size_t partialSlot = 0; partialSlot < partial.orders.Size(); ++partialSlot)
+        {
+            if (hadPendingOrders[partialSlot] || !partial.orders.GetOrderReport(partialSlot).HasOrders())
+                continue;
+
+            size_t slot = slots[partialSlot];
+            if (slot == OrderReportCollection::NOT_FOUND)
+                slot = ordRptColl->Find(partial.orders.GetOrderReport(partialSlot).GetSecurityId());
+            ordRptColl->MergeSlot(slot, partial.orders, partialSlot);
+            ordRptColl->MarkChanged(slot);
+        }
+    }
+}
+
+
+/** @brief Called when a snapshot is due while following the input file
+ * 
+ *  @return void
+ */
+void OrderReportFileHandler::OnInputSnapshot()
+{
+    WriteOutputSnapshot();
+    if (checkpointLines > 0)
+        SaveCheckpoint();
+    if (snapshotPublisher != nullptr)
+        PublishSnapshot();
+}
+
+
+/** @brief Writes a snapshot of the Order Report File
+ * 
+ *  Rows are written in the Report Format set with SetReportFormat. Only the rows of Securities that have been
+ *  added or have changed since the last snapshot are formatted; every other row is reused from the last snapshot. The snapshot is written to
+ *  a temporary file which then replaces the Output File, so readers never see a partial report.
+ *
+ *  @return void
+ */
+void OrderReportFileHandler::WriteOutputSnapshot()
+{
+    ScopedStatTimer snapshotTimer(StatTimer::Snapshot, StatHistogram::SnapshotLatency);
+    ReportRow row;
+    auto formatRow = [this, &row](const size_t slot)
+    {
+        const OrderReport& ordRpt = ordRptColl->GetOrderReport(slot);
+        std::string& formattedRow = formattedRows[slot];
+
+        formattedRow.clear();
+        if (reportEmptyOrders || ordRpt.HasOrders())
+        {
+            reportFormat->formatRow(row, *ordRptColl, slot);
+            row.AppendTo(formattedRow, outputFileDelimiter);
+        }
+    };
+
+    size_t prevNumRows = formattedRows.size();
+    formattedRows.resize(ordRptColl->Size());
+
+    for (uint32_t slot : ordRptColl->GetChangedSlots())
+    {
+        if (slot < prevNumRows)
+            formatRow(slot);
+    }
+    for (size_t slot = prevNumRows; slot < formattedRows.size(); ++slot)
+        formatRow(slot);
+    ordRptColl->ClearChanges();
+
+    // The unchanged rows are written straight from the cache, without being copied again
+    //
+    std::string snapshotFile = outputFile + ".tmp";
+    OutputBuffer outBuffer;
+    outBuffer.Open(snapshotFile);
+    reportFormat->writeHeader(outBuffer, outputFileDelimiter);
+    outBuffer.AppendAll(formattedRows);
+    outBuffer.Close();
+
+    std::rename(snapshotFile.c_str(), outputFile.c_str());
+}
+
+
+/** @brief Adds a Report Sink
+ * 
+ *  Every Report Sink added is written to by WriteReportSinks.
+ *
+ *  @param sink - Output File, Delimiter & filter for the report
+ *  @return void
+ */
+void OrderReportFileHandler::AddReportSink(const ReportSink& sink)
+{
+    reportSinks.push_back(sink);
+}
+
+
+/** @brief Removes every Report Sink
+ * 
+ *  @return void
+ */
+void OrderReportFileHandler::ClearReportSinks()
+{
+    reportSinks.clear();
+}
+
+
+/** @brief Adds a rollup
+ * 
+ *  Every rollup added is built & written by WriteReportSinks. Securities already in the Order Report
+ *  collection are mapped to their groups when it's first built.
+ *
+ *  @param rollup - What to group the Securities by, the Output File & the columns of the rollup
+ *  @return void
+ */
+void OrderReportFileHandler::AddRollup(const RollupReport& rollup)
+{
+    rollups.push_back(rollup);
+}
+
+
+/** @brief Writes the report to every Report Sink in a single pass
+ * 
+ *  Loops through the Order Report collection once. Each Security is only formatted if at least
+ *  one Report Sink's filter accepts it, and is formatted once however many Report Sinks with the same
+ *  Report Format it is written to. Rows are gathered in an Output Buffer per Report Sink and written out in large blocks.
+ *  Each rollup is then built from the Order Reports and written to its own Output File.
+ *
+ *  @return void
+ */
+void OrderReportFileHandler::WriteReportSinks()
+{
+    ScopedStatTimer writeTimer(StatTimer::WriteOutput);
+    std::vector<OutputBuffer> outBuffers(reportSinks.size());
+    std::vector<const ReportFormat*> formats(reportSinks.size());
+    ReportRow row;
+    size_t rowsWritten = 0;
+
+    for (size_t i = 0; i < reportSinks.size(); ++i)
+    {
+        formats[i] = (reportSinks[i].format != nullptr) ? reportSinks[i].format : &OrderReportSchema::FORMAT;
+        outBuffers[i].Open(reportSinks[i].outputFile);
+        formats[i]->writeHeader(outBuffers[i], reportSinks[i].delimiter);
+    }
+
+    for (size_t slot = 0; slot < ordRptColl->Size(); ++slot)
+    {
+        const OrderReport& ordRpt = ordRptColl->GetOrderReport(slot);
+        const ReportFormat* rowFormat = nullptr;
+
+        for (size_t i = 0; i < reportSinks.size(); ++i)
+        {
+            const ReportSink& sink = reportSinks[i];
+            if (sink.filter && !sink.filter(ordRpt))
+                continue;
+
+            if (rowFormat != formats[i])
+            {
+                formats[i]->formatRow(row, *ordRptColl, slot);
+                rowFormat = formats[i];
+            }
+
+            row.AppendTo(outBuffers[i], sink.delimiter);
+            ++rowsWritten;
+        }
+    }
+    PipelineStats::Count(StatCounter::RowsWritten, rowsWritten);
+
+    for (auto& outBuffer : outBuffers)
+        outBuffer.Close();
+
+    for (auto& rollup : rollups)
+    {
+        rollup.Build(*ordRptColl);
+        rollup.Write(outputFileDelimiter);
+    }
 }
 
 
 /** @brief Outputs the data needed to the Order Report File
  * 
- *  The output report will contain the following headers in the following order:
+ *  Writes the columns of the Report Format set with SetReportFormat. By default that is every column
+ *  of OrderReportSchema, which will contain the following headers in the following order:
  *    ISIN | Currency | Total Buy Count | Total Sell Count | Total Buy Quantity | Total Sell Quantity |
  *    Weighted Average Buy Price | Weighted Average Sell Price | Max Buy Price | Min Sell Price
  * 
  *  It will go through the collection of Order Reports and write the output each Order Report object
- *  to the output (Order Report) file.
+ *  to the output (Order Report) file. Whether to report Securities with no Orders is decided once,
+ *  by choosing the row writer, rather than for every row.
  *
- *  @param outStream - The stream to the Order Report file
+ *  @param outBuffer - The buffer for the Order Report file
  *  @return void
  */
-void OrderReportFileHandler::WriteOutputData(std::ofstream& outStream) const
+void OrderReportFileHandler::WriteOutputData(OutputBuffer& outBuffer) const
 {
-    outStream << "ISIN" << outputFileDelimiter
-              << "Currency" << outputFileDelimiter
-              << "Total Buy Count" << outputFileDelimiter
-              << "Total Sell Count" << outputFileDelimiter
-              << "Total Buy Quantity" << outputFileDelimiter
-              << "Total Sell Quantity" << outputFileDelimiter
-              << "Weighted Average Buy Price" << outputFileDelimiter
-              << "Weighted Average Sell Price" << outputFileDelimiter
-              << "Max Buy Price" << outputFileDelimiter
-              << "Min Sell Price"
-              << "\n";
+    if (reportFormat != &OrderReportSchema::FORMAT)
+    {
+        ReportRow row;
+        reportFormat->writeHeader(outBuffer, outputFileDelimiter);
+        for (size_t slot = 0; slot < ordRptColl->Size(); ++slot)
+        {
+            if (reportEmptyOrders || ordRptColl->GetOrderReport(slot).HasOrders())
+            {
+                reportFormat->formatRow(row, *ordRptColl, slot);
+                row.AppendTo(outBuffer, outputFileDelimiter);
+            }
+        }
+        return;
+    }
+
+    OrderReportSchema::WriteHeader(outBuffer, outputFileDelimiter);
 
-    for(auto ord : *ordRptColl)
-        ord.second.OutputReport(outStream, outputFileDelimiter, reportEmptyOrders);
+    if (reportEmptyOrders)
+        OrderReportSchema::WriteRows<true>(outBuffer, *ordRptColl, outputFileDelimiter);
+    else
+        OrderReportSchema::WriteRows<false>(outBuffer, *ordRptColl, outputFileDelimiter);
 }
\ No newline at end of file
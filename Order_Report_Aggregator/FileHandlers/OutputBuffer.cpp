@@ -0,0 +1,235 @@
+/** @file OutputBuffer.cpp
+ *  @brief Buffered writer for output files
+ *
+ *  Collects text in a large reusable buffer and writes it to the output file in big
+ *  blocks, rather than going through a std::ofstream for every value. Numbers are
+ *  converted straight into the buffer with std::to_chars, which avoids the locale and
+ *  virtual stream buffer calls made by operator<< on every field.
+ *
+ *  Text that is already formatted elsewhere can be written without copying it into
+ *  the buffer at all, in a single writev call.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <cerrno>
+#include "OutputBuffer.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define OUTPUTBUFFER_POSIX
+#endif
+
+/** @brief Output Buffer Constructor
+ *
+ *  @param capacity_ - Size of the buffer in bytes. Text is written to the file each time it fills up.
+ */
+OutputBuffer::OutputBuffer(const size_t capacity_)
+    : fileDescriptor(-1),
+      file(nullptr),
+      buffer(new char[(capacity_ > MAX_NUMBER_LENGTH) ? capacity_ : MAX_NUMBER_LENGTH]),
+      capacity((capacity_ > MAX_NUMBER_LENGTH) ? capacity_ : MAX_NUMBER_LENGTH),
+      used(0)
+{
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    Close();
+}
+
+
+/** @brief Opens the output file, replacing anything already in it
+ * 
+ *  Any file already open is flushed and closed first.
+ *
+ *  @param fileName - Output File Name/Path
+ *  @return true if the file was opened
+ */
+bool OutputBuffer::Open(const std::string& fileName)
+{
+    Close();
+
+#ifdef OUTPUTBUFFER_POSIX
+    fileDescriptor = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#else
+    file = std::fopen(fileName.c_str(), "wb");
+#endif
+
+    return IsOpen();
+}
+
+
+/** @brief Writes to a file descriptor that is already open, such as a pipe
+ * 
+ *  Any file already open is flushed and closed first. The file descriptor is closed along
+ *  with the Output Buffer. Only supported where file descriptors are.
+ *
+ *  @param fileDescriptor_ - Open file descriptor to write to
+ *  @return true if the file descriptor can be written to
+ */
+bool OutputBuffer::Attach(const int fileDescriptor_)
+{
+    Close();
+
+#ifdef OUTPUTBUFFER_POSIX
+    fileDescriptor = fileDescriptor_;
+#else
+    (void)fileDescriptor_;
+#endif
+
+    return IsOpen();
+}
+
+
+/** @brief Checks whether an output file is open
+ * 
+ *  @return true if an output file is open
+ */
+bool OutputBuffer::IsOpen() const
+{
+    return fileDescriptor >= 0 || file != nullptr;
+}
+
+
+/** @brief Writes anything left in the buffer and closes the output file
+ * 
+ *  @return void
+ */
+void OutputBuffer::Close()
+{
+    Flush();
+
+#ifdef OUTPUTBUFFER_POSIX
+    if (fileDescriptor >= 0)
+        close(fileDescriptor);
+#endif
+    if (file != nullptr)
+        std::fclose(file);
+
+    fileDescriptor = -1;
+    file = nullptr;
+}
+
+
+/** @brief Writes the contents of the buffer to the output file
+ * 
+ *  @return void
+ */
+void OutputBuffer::Flush()
+{
+    WriteToFile(buffer.get(), used);
+    used = 0;
+}
+
+
+/** @brief Writes the contents of the buffer and waits for the output file to reach the disk
+ * 
+ *  @return true if the output file was synced to disk
+ */
+bool OutputBuffer::Sync()
+{
+    Flush();
+
+#ifdef OUTPUTBUFFER_POSIX
+    if (fileDescriptor >= 0)
+        return fsync(fileDescriptor) == 0;
+#endif
+    if (file != nullptr)
+        return std::fflush(file) == 0;
+
+    return false;
+}
+
+
+/** @brief Writes a list of already formatted texts to the output file
+ * 
+ *  The texts are written straight from where they are with writev, IOV_MAX at a time,
+ *  rather than being copied into the buffer first.
+ *
+ *  @param texts - Texts to write, in order
+ *  @return void
+ */
+void OutputBuffer::AppendAll(const std::vector<std::string>& texts)
+{
+    Flush();
+
+#ifdef OUTPUTBUFFER_POSIX
+    if (fileDescriptor >= 0)
+    {
+        std::vector<iovec> ioVectors;
+        ioVectors.reserve(IOV_MAX);
+
+        for (size_t i = 0; i < texts.size(); )
+        {
+            ioVectors.clear();
+            for (; i < texts.size() && ioVectors.size() < IOV_MAX; ++i)
+            {
+                if (!texts[i].empty())
+                    ioVectors.push_back(iovec{ const_cast<char*>(texts[i].data()), texts[i].size() });
+            }
+
+            // writev may write less than asked, in which case skip past what was written and try again
+            //
+            size_t first = 0;
+            while (first < ioVectors.size())
+            {
+                ssize_t written = writev(fileDescriptor, ioVectors.data() + first, static_cast<int>(ioVectors.size() - first));
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+
+                size_t remaining = static_cast<size_t>(written);
+                while (first < ioVectors.size() && remaining >= ioVectors[first].iov_len)
+                    remaining -= ioVectors[first++].iov_len;
+                if (first < ioVectors.size())
+                {
+                    ioVectors[first].iov_base = static_cast<char*>(ioVectors[first].iov_base) + remaining;
+                    ioVectors[first].iov_len -= remaining;
+                }
+            }
+        }
+        return;
+    }
+#endif
+
+    for (const auto& text : texts)
+        WriteToFile(text.data(), text.size());
+}
+
+
+/** @brief Writes data straight to the output file
+ * 
+ *  Does nothing if no output file is open.
+ *
+ *  @param data   - Data to write
+ *  @param length - Length of the data
+ *  @return void
+ */
+void OutputBuffer::WriteToFile(const char* data, size_t length)
+{
+#ifdef OUTPUTBUFFER_POSIX
+    while (fileDescriptor >= 0 && length > 0)
+    {
+        ssize_t written = write(fileDescriptor, data, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+#endif
+
+    if (file != nullptr && length > 0)
+        std::fwrite(data, 1, length, file);
+}
@@ -1,8 +1,8 @@
 /** @file OutputFileHandler.cpp
  *  @brief Base class to handle writing to output files
  *
- *  Base class for writing to an output file. Will create a stream to the output file
- *  before passing the stream to the virtual function WriteOutputData. This function 
+ *  Base class for writing to an output file. Will create an Output Buffer for the output file
+ *  before passing the buffer to the virtual function WriteOutputData. This function 
  *  should be overridden in the derived class to write the actual data that will go
  *  into the file.
  *
@@ -11,6 +11,7 @@
  */
 
 #include <OutputFileHandler.h>
+#include "PipelineStats.h"
 
 /** @brief Output File Handler Constructor
  *
@@ -39,17 +40,19 @@ void OutputFileHandler::SetOutputFile(const std::string& outputFile_)
 
 /** @brief Writes to the Output File
  * 
- *  Will create a stream to the output file before passing the stream to the
- *  virtual function WriteOutputData, which should write the actual data that
+ *  Will create an Output Buffer for the output file before passing the buffer to
+ *  the virtual function WriteOutputData, which should write the actual data that
  *  will go into the file.
  * 
  *  @return void
  */
 void OutputFileHandler::WriteOutputFile() const
 {
-    std::ofstream outStream(outputFile);
+    ScopedStatTimer writeTimer(StatTimer::WriteOutput);
+    OutputBuffer outBuffer;
+    outBuffer.Open(outputFile);
 
-    WriteOutputData(outStream);
+    WriteOutputData(outBuffer);
 
-    outStream.close();
+    outBuffer.Close();
 }
\ No newline at end of file
@@ -0,0 +1,287 @@
+/** @file PipelineStats.cpp
+ *  @brief Counters, timers & latency histograms for the ingestion pipeline
+ *
+ *  Records how many lines were read, what they were classified as, how many orders were dropped
+ *  and how long each stage of the pipeline took, so it can be seen where the time goes.
+ *
+ *  Every thread records into its own block of stats, so the hot path never shares a cache line
+ *  with another thread or takes a lock. The blocks are only added together when the stats are
+ *  written out as JSON.
+ *
+ *  Stats are off by default. While they are off every call returns after a single check of the
+ *  enabled flag, so they can be left in the hot path. Latency histograms are enabled separately,
+ *  as timing every line costs a clock read per line.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include "PipelineStats.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <signal.h>
+#define PIPELINESTATS_SIGNALS_SUPPORTED
+#endif
+
+static const char* const COUNTER_NAMES[] = { "lines_read",
+                                             "bytes_read",
+                                             "security_refs",
+                                             "order_adds",
+                                             "ignored_lines",
+                                             "unknown_security_orders",
+                                             "pending_orders",
+                                             "replayed_orders",
+                                             "late_interval_orders",
+                                             "order_deletes",
+                                             "order_modifies",
+                                             "order_executes",
+                                             "unknown_order_updates",
+                                             "parse_errors",
+                                             "rows_written",
+                                             "queries_served" };
+
+static const char* const TIMER_NAMES[] = { "read_input",
+                                           "decompress",
+                                           "read_chunk",
+                                           "merge_chunks",
+                                           "merge_files",
+                                           "write_output",
+                                           "snapshot",
+                                           "checkpoint",
+                                           "publish",
+                                           "query",
+                                           "read_shards",
+                                           "merge_shards" };
+
+static const char* const HISTOGRAM_NAMES[] = { "line_latency_ns",
+                                               "snapshot_latency_ns",
+                                               "query_latency_ns" };
+
+static_assert(std::size(COUNTER_NAMES) == static_cast<size_t>(StatCounter::Count), "Every counter needs a name");
+static_assert(std::size(TIMER_NAMES) == static_cast<size_t>(StatTimer::Count), "Every timer needs a name");
+static_assert(std::size(HISTOGRAM_NAMES) == static_cast<size_t>(StatHistogram::Count), "Every histogram needs a name");
+
+std::atomic<bool> PipelineStats::enabled(false);
+std::atomic<bool> PipelineStats::histogramsEnabled(false);
+std::chrono::steady_clock::time_point PipelineStats::startTime = std::chrono::steady_clock::now();
+std::mutex PipelineStats::threadStatsMutex;
+std::vector<PipelineStats::ThreadStats*> PipelineStats::allThreadStats;
+
+
+/** @brief Turns recording of stats on or off
+ * 
+ *  The elapsed time in the JSON output is measured from when stats were last enabled.
+ * 
+ *  @param enable           - Record counters & timers
+ *  @param enableHistograms - Also record latency histograms
+ *  @return void
+ */
+void PipelineStats::Enable(const bool enable, const bool enableHistograms)
+{
+    if (enable && !IsEnabled())
+        startTime = std::chrono::steady_clock::now();
+
+    histogramsEnabled.store(enable && enableHistograms, std::memory_order_relaxed);
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+
+/** @brief Gets the calling thread's stats, creating them the first time
+ * 
+ *  A thread's stats are kept after it exits, so that nothing it recorded is lost.
+ *
+ *  @return Stats for the calling thread
+ */
+PipelineStats::ThreadStats& PipelineStats::GetThreadStats()
+{
+    static thread_local ThreadStats* threadStats = nullptr;
+    if (threadStats == nullptr)
+    {
+        threadStats = new ThreadStats();
+        std::lock_guard<std::mutex> lock(threadStatsMutex);
+        allThreadStats.push_back(threadStats);
+    }
+    return *threadStats;
+}
+
+
+void PipelineStats::AddToCounter(const StatCounter counter, const uint64_t amount)
+{
+    std::atomic<uint64_t>& value = GetThreadStats().counters[static_cast<size_t>(counter)];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+
+void PipelineStats::AddToTimer(const StatTimer timer, const uint64_t elapsedNs)
+{
+    TimerStats& timerStats = GetThreadStats().timers[static_cast<size_t>(timer)];
+    timerStats.count.store(timerStats.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    timerStats.totalNs.store(timerStats.totalNs.load(std::memory_order_relaxed) + elapsedNs, std::memory_order_relaxed);
+    if (elapsedNs > timerStats.maxNs.load(std::memory_order_relaxed))
+        timerStats.maxNs.store(elapsedNs, std::memory_order_relaxed);
+}
+
+
+void PipelineStats::AddToHistogram(const StatHistogram histogram, const uint64_t latencyNs)
+{
+    size_t bucket = 0;
+    while (bucket < NUM_HISTOGRAM_BUCKETS - 1 && (latencyNs >> bucket) != 0)
+        ++bucket;
+
+    std::atomic<uint64_t>& value = GetThreadStats().histograms[static_cast<size_t>(histogram)][bucket];
+    value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+
+/** @brief Writes the stats recorded so far as JSON
+ * 
+ *  Counters, timers & histograms are totalled across every thread. The counters of
+ *  each thread are also written out on their own, to show how work was spread.
+ *
+ *  @param output - Stream to write to
+ *  @return void
+ */
+void PipelineStats::WriteJson(std::ostream& output)
+{
+    std::vector<ThreadStats*> threadStatsList;
+    {
+        std::lock_guard<std::mutex> lock(threadStatsMutex);
+        threadStatsList = allThreadStats;
+    }
+
+    std::array<uint64_t, NUM_COUNTERS> counters = {};
+    std::array<std::array<uint64_t, 3>, NUM_TIMERS> timers = {};
+    std::array<std::array<uint64_t, NUM_HISTOGRAM_BUCKETS>, NUM_HISTOGRAMS> histograms = {};
+
+    for (const ThreadStats* threadStats : threadStatsList)
+    {
+        for (size_t i = 0; i < NUM_COUNTERS; ++i)
+            counters[i] += threadStats->counters[i].load(std::memory_order_relaxed);
+        for (size_t i = 0; i < NUM_TIMERS; ++i)
+        {
+            timers[i][0] += threadStats->timers[i].count.load(std::memory_order_relaxed);
+            timers[i][1] += threadStats->timers[i].totalNs.load(std::memory_order_relaxed);
+            timers[i][2] = std::max(timers[i][2], threadStats->timers[i].maxNs.load(std::memory_order_relaxed));
+        }
+        for (size_t i = 0; i < NUM_HISTOGRAMS; ++i)
+        {
+            for (size_t bucket = 0; bucket < NUM_HISTOGRAM_BUCKETS; ++bucket)
+                histograms[i][bucket] += threadStats->histograms[i][bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    double readSeconds = timers[static_cast<size_t>(StatTimer::ReadInput)][1] / 1e9;
+    uint64_t linesRead = counters[static_cast<size_t>(StatCounter::LinesRead)];
+
+    output << "{\n";
+    output << "  \"enabled\": " << (IsEnabled() ? "true" : "false") << ",\n";
+    output << "  \"elapsed_seconds\": " << elapsedSeconds << ",\n";
+    output << "  \"threads\": " << threadStatsList.size() << ",\n";
+    output << "  \"lines_per_second\": " << (readSeconds > 0 ? linesRead / readSeconds : 0.0) << ",\n";
+
+    output << "  \"counters\": {";
+    for (size_t i = 0; i < NUM_COUNTERS; ++i)
+        output << (i > 0 ? ",\n" : "\n") << "    \"" << COUNTER_NAMES[i] << "\": " << counters[i];
+    output << "\n  },\n";
+
+    output << "  \"timers\": {";
+    for (size_t i = 0; i < NUM_TIMERS; ++i)
+    {
+        output << (i > 0 ? ",\n" : "\n") << "    \"" << TIMER_NAMES[i] << "\": { "
+               << "\"count\": " << timers[i][0] << ", "
+               << "\"total_seconds\": " << timers[i][1] / 1e9 << ", "
+               << "\"max_seconds\": " << timers[i][2] / 1e9 << " }";
+    }
+    output << "\n  },\n";
+
+    // Only the buckets with something in them are written. Each bucket holds the latencies below "lt_ns".
+    //
+    output << "  \"histograms\": {";
+    for (size_t i = 0; i < NUM_HISTOGRAMS; ++i)
+    {
+        output << (i > 0 ? ",\n" : "\n") << "    \"" << HISTOGRAM_NAMES[i] << "\": [";
+        bool firstBucket = true;
+        for (size_t bucket = 0; bucket < NUM_HISTOGRAM_BUCKETS; ++bucket)
+        {
+            if (histograms[i][bucket] == 0)
+                continue;
+            output << (firstBucket ? " " : ", ") << "{ \"lt_ns\": " << (uint64_t(1) << bucket) << ", \"count\": " << histograms[i][bucket] << " }";
+            firstBucket = false;
+        }
+        output << " ]";
+    }
+    output << "\n  },\n";
+
+    output << "  \"per_thread\": [";
+    for (size_t t = 0; t < threadStatsList.size(); ++t)
+    {
+        output << (t > 0 ? ",\n" : "\n") << "    {";
+        for (size_t i = 0; i < NUM_COUNTERS; ++i)
+            output << (i > 0 ? ", " : " ") << "\"" << COUNTER_NAMES[i] << "\": " << threadStatsList[t]->counters[i].load(std::memory_order_relaxed);
+        output << " }";
+    }
+    output << "\n  ]\n}\n";
+}
+
+
+/** @brief Writes the stats recorded so far to a JSON file
+ * 
+ *  The stats are written to a temporary file which then replaces the stats file, so
+ *  readers never see a partly written file.
+ *
+ *  @param statsFile - Stats File Name/Path
+ *  @return true if the stats file was written
+ */
+bool PipelineStats::WriteJsonFile(const std::string& statsFile)
+{
+    std::string tmpFile = statsFile + ".tmp";
+    {
+        std::ofstream output(tmpFile);
+        if (!output)
+            return false;
+        WriteJson(output);
+        if (!output)
+            return false;
+    }
+
+    return std::rename(tmpFile.c_str(), statsFile.c_str()) == 0;
+}
+
+
+/** @brief Writes the stats to a JSON file whenever a signal is received
+ * 
+ *  The signal is blocked in the calling thread and a background thread waits for it, so the
+ *  stats are written outside of a signal handler. Call this before starting any other threads,
+ *  so that they inherit the blocked signal. Does nothing where POSIX signals aren't available.
+ *
+ *  @param statsFile    - Stats File Name/Path
+ *  @param signalNumber - Signal to write the stats on, e.g. SIGUSR1
+ *  @return void
+ */
+void PipelineStats::WriteJsonOnSignal(const std::string& statsFile, const int signalNumber)
+{
+#ifdef PIPELINESTATS_SIGNALS_SUPPORTED
+    sigset_t signalSet;
+    sigemptyset(&signalSet);
+    sigaddset(&signalSet, signalNumber);
+    if (pthread_sigmask(SIG_BLOCK, &signalSet, nullptr) != 0)
+        return;
+
+    std::thread([statsFile, signalSet]
+    {
+        int receivedSignal = 0;
+        while (sigwait(&signalSet, &receivedSignal) == 0)
+            WriteJsonFile(statsFile);
+    }).detach();
+#else
+    (void)statsFile;
+    (void)signalNumber;
+#endif
+}
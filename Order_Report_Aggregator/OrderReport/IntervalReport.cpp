@@ -0,0 +1,217 @@
+/** @file IntervalReport.cpp
+ *  @brief Volume & VWAP of each Security per time interval, written while the input file is read
+ *
+ *  Splits time into fixed length intervals, e.g. 1 minute, using the timestamp of each Order Add,
+ *  and totals the quantity & notional (price * quantity) of each side of every Security in each
+ *  interval. The volume & Volume Weighted Average Price of each Security with Orders in an interval
+ *  are written as one row of the interval report.
+ *
+ *  Each Security has a ring of NUM_RING_INTERVALS buckets, one per interval, held in one flat array
+ *  with every Security's ring side by side. A bucket is one 64 byte cache line, so adding an Order
+ *  touches a single cache line, the same as updating its Order Report. When an Order arrives for an
+ *  interval past the end of the rings, the oldest intervals are written out and their buckets
+ *  reused, so the memory used depends on the number of Securities and not on the length of the
+ *  input file. Orders arriving out of order are still counted, as long as they are no more than
+ *  NUM_RING_INTERVALS - 1 intervals behind the latest; older ones are left out & counted as late.
+ *
+ *  Each notional is held in 128 bits, so quantity * price can't wrap it. A VWAP is never more than
+ *  the highest price, so it always fits in 64 bits unless the volume itself has wrapped; a VWAP
+ *  that doesn't fit is left empty rather than written wrong.
+ *
+ *  Only the Securities that had Orders in an interval are written, in the order they were inserted.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include "IntervalReport.h"
+#include "PipelineStats.h"
+
+namespace
+{
+    /** @brief Appends a Volume Weighted Average Price
+     *
+     *  Appends 0 if there is no volume, and nothing if the VWAP doesn't fit in 64 bits, which can only
+     *  happen once the volume has wrapped. Notionals that fit in 64 bits, as nearly all do, are divided
+     *  without the slower 128 bit division.
+     *
+     *  @param outBuffer - Buffer to append to
+     *  @param notional  - Total of price * quantity
+     *  @param quantity  - Volume
+     *  @return void
+     */
+    void AppendVwap(OutputBuffer& outBuffer, const unsigned __int128 notional, const uint64_t quantity)
+    {
+        if (quantity == 0)
+            outBuffer.AppendNumber(static_cast<uint64_t>(0));
+        else if ((notional >> 64) == 0)
+            outBuffer.AppendNumber(static_cast<uint64_t>(notional) / quantity);
+        else if (notional / quantity <= UINT64_MAX)
+            outBuffer.AppendNumber(static_cast<uint64_t>(notional / quantity));
+    }
+}
+
+IntervalReport::IntervalReport()
+    : open(false),
+      intervalNs(1),
+      firstInterval(0),
+      numSlots(0),
+      ordRptColl(nullptr),
+      delimiter('\t'),
+      numLateOrders(0)
+{
+}
+
+IntervalReport::~IntervalReport()
+{
+    Close();
+}
+
+
+/** @brief Opens the interval report and writes its heading row
+ *
+ *  @param outputFile  - Interval Report File Name/Path
+ *  @param interval    - Length of each interval
+ *  @param ordRptColl_ - Collection whose slots the Orders are added against, for the ISIN & currency of each row
+ *  @param delim       - The delimiter that will seperate each value
+ *  @return true if the interval report was opened
+ */
+bool IntervalReport::Open( const std::string&             outputFile,
+                           const std::chrono::nanoseconds interval,
+                           const OrderReportCollection*   ordRptColl_,
+                           const char                     delim )
+{
+    Close();
+    if (interval.count() <= 0 || !outBuffer.Open(outputFile))
+        return false;
+
+    intervalNs = static_cast<uint64_t>(interval.count());
+    ordRptColl = ordRptColl_;
+    delimiter = delim;
+    firstInterval = 0;
+    numSlots = 0;
+    buckets.clear();
+    numLateOrders = 0;
+    open = true;
+
+    outBuffer.Append("Interval Start");
+    for (std::string_view heading : { "ISIN", "Currency", "Buy Volume", "Sell Volume", "Buy VWAP", "Sell VWAP" })
+    {
+        outBuffer.Append(delimiter);
+        outBuffer.Append(heading);
+    }
+    outBuffer.Append('\n');
+    return true;
+}
+
+
+/** @brief Adds an Order that falls outside the rings
+ *
+ *  The rings are grown to take in a new Security. The first Order places the rings so that they end
+ *  at its interval. An Order past the end of the rings moves them on to end at its interval, writing
+ *  out the intervals that drop off the start. An Order before the start of the rings is late.
+ *
+ *  @param slot     - Slot of the Security in the Order Report collection
+ *  @param interval - Interval of the Order
+ *  @param ordData  - The relevant data from the Order Add record
+ *  @return void
+ */
+void IntervalReport::AddOutsideRings(const size_t slot, const uint64_t interval, const OrderAddData& ordData)
+{
+    if (buckets.empty())
+        firstInterval = (interval >= NUM_RING_INTERVALS - 1) ? interval - (NUM_RING_INTERVALS - 1) : 0;
+
+    if (slot >= numSlots)
+    {
+        numSlots = slot + 1;
+        buckets.resize(numSlots * NUM_RING_INTERVALS, IntervalBucket{ 0, 0, 0, 0 });
+    }
+
+    if (interval < firstInterval)
+    {
+        ++numLateOrders;
+        PipelineStats::Count(StatCounter::LateIntervalOrders);
+        return;
+    }
+
+    if (interval - firstInterval >= NUM_RING_INTERVALS)
+    {
+        uint64_t newFirstInterval = interval - (NUM_RING_INTERVALS - 1);
+        for (uint64_t oldInterval = firstInterval; oldInterval < std::min(newFirstInterval, firstInterval + NUM_RING_INTERVALS); ++oldInterval)
+            WriteInterval(oldInterval);
+        firstInterval = newFirstInterval;
+    }
+
+    AddToBucket(slot, interval, ordData);
+}
+
+
+/** @brief Writes the rows of an interval and empties its buckets
+ *
+ *  @param interval - Interval to write
+ *  @return void
+ */
+void IntervalReport::WriteInterval(const uint64_t interval)
+{
+    std::vector<uint32_t>& slots = activeSlots[interval & (NUM_RING_INTERVALS - 1)];
+    std::sort(slots.begin(), slots.end());
+
+    for (uint32_t slot : slots)
+    {
+        IntervalBucket& bucket = buckets[(slot * NUM_RING_INTERVALS) + (interval & (NUM_RING_INTERVALS - 1))];
+        const SecurityInfo& secInfo = ordRptColl->GetSecurityInfo(slot);
+
+        outBuffer.AppendNumber(interval * intervalNs);
+        outBuffer.Append(delimiter);
+        outBuffer.Append(secInfo.ISIN.View());
+        outBuffer.Append(delimiter);
+        outBuffer.Append(secInfo.currency.View());
+        outBuffer.Append(delimiter);
+        outBuffer.AppendNumber(bucket.buyQuantity);
+        outBuffer.Append(delimiter);
+        outBuffer.AppendNumber(bucket.sellQuantity);
+        outBuffer.Append(delimiter);
+        AppendVwap(outBuffer, bucket.buyNotional, bucket.buyQuantity);
+        outBuffer.Append(delimiter);
+        AppendVwap(outBuffer, bucket.sellNotional, bucket.sellQuantity);
+        outBuffer.Append('\n');
+
+        bucket = IntervalBucket{ 0, 0, 0, 0 };
+    }
+
+    PipelineStats::Count(StatCounter::RowsWritten, slots.size());
+    slots.clear();
+}
+
+
+/** @brief Writes every interval still held in the rings and closes the interval report
+ *
+ *  @return void
+ */
+void IntervalReport::Close()
+{
+    if (!open)
+        return;
+
+    if (!buckets.empty())
+    {
+        for (uint64_t interval = firstInterval; interval < firstInterval + NUM_RING_INTERVALS; ++interval)
+            WriteInterval(interval);
+    }
+
+    outBuffer.Close();
+    buckets.clear();
+    numSlots = 0;
+    open = false;
+}
+
+
+/** @brief Gets the number of Orders left out of the interval report for arriving too late
+ *
+ *  @return Number of late Orders
+ */
+size_t IntervalReport::GetNumLateOrders() const
+{
+    return numLateOrders;
+}
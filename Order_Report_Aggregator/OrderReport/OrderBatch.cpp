@@ -0,0 +1,554 @@
+/** @file OrderBatch.cpp
+ *  @brief A block of parsed Order Adds, applied to their Order Reports a Security at a time
+ *
+ *  Order Adds are collected as they are parsed, rather than looked up and added one at a time.
+ *  Once the batch is full they are grouped by Security ID with a stable radix sort, and each
+ *  Security is then looked up once and has the totals of all its Orders added in one go.
+ *
+ *  The Orders are held as separate arrays of quantities, prices & sides, so the totals of a group
+ *  are summed with SIMD: counts, quantities, the amount spent and the max & min prices of several
+ *  Orders at a time. AVX2 or SSE2 is chosen at runtime, with a scalar fallback. Every instruction
+ *  set gives exactly the same totals, and adding them gives exactly the same Order Report as adding
+ *  each Order on its own.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include "OrderBatch.h"
+
+#ifdef ORA_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Totals of no Orders. The Min Sell Price starts as high as a price can be, so any Sell Order's is lower.
+    //
+    constexpr OrderTotals NO_ORDER_TOTALS = { 0, 0, 0, 0, 0, SIZE_MAX, 0, 0 };
+
+    /** @brief Adds quantity * price to an amount spent
+     *
+     *  The sum only stops at the largest 128 bit value if it would otherwise wrap, which is far
+     *  above the most an Order Report can hold, so it is capped at the same value either way.
+     *
+     *  @param spent    - Amount spent
+     *  @param quantity - Quantity of the Order
+     *  @param price    - Price of the Order
+     *  @return void
+     */
+    inline void AddSpent(unsigned __int128& spent, const uint64_t quantity, const uint64_t price)
+    {
+        if (__builtin_add_overflow(spent, static_cast<unsigned __int128>(quantity) * price, &spent))
+            spent = ~static_cast<unsigned __int128>(0);
+    }
+
+    /** @brief Adds one Order to the totals
+     *
+     *  @param totals   - Totals of the Orders so far
+     *  @param quantity - Quantity of the Order
+     *  @param price    - Price of the Order
+     *  @param buyMask  - All ones for a Buy Order, 0 for a Sell Order
+     *  @return void
+     */
+    inline void AddOrder(OrderTotals& totals, const uint64_t quantity, const uint64_t price, const uint64_t buyMask)
+    {
+        if (buyMask != 0)
+        {
+            totals.buyCount++;
+            totals.buyQuantity += quantity;
+            if (price > totals.maxBuyPrice)
+                totals.maxBuyPrice = price;
+            AddSpent(totals.buySpent, quantity, price);
+        }
+        else
+        {
+            totals.sellCount++;
+            totals.sellQuantity += quantity;
+            if (price < totals.minSellPrice)
+                totals.minSellPrice = price;
+            AddSpent(totals.sellSpent, quantity, price);
+        }
+    }
+
+    /** @brief Adds up the amount spent on some Orders, one at a time
+     *
+     *  @param totals     - Totals to set the Buy & Sell amounts spent of
+     *  @param quantities - Quantity of each Order
+     *  @param prices     - Price of each Order
+     *  @param buyMasks   - All ones for each Buy Order, 0 for each Sell Order
+     *  @param count      - Number of Orders
+     *  @return void
+     */
+    void SumSpent(OrderTotals& totals, const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count)
+    {
+        totals.buySpent = 0;
+        totals.sellSpent = 0;
+        for (size_t i = 0; i < count; ++i)
+            AddSpent((buyMasks[i] != 0) ? totals.buySpent : totals.sellSpent, quantities[i], prices[i]);
+    }
+
+#ifdef ORA_X86_SIMD
+    /** @brief Adds up the four lanes of an AVX2 register
+     *
+     *  @param lanes - Four 64 bit values
+     *  @return Sum of the lanes
+     */
+    __attribute__((target("avx2")))
+    inline uint64_t SumLanes(const __m256i lanes)
+    {
+        alignas(32) uint64_t values[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(values), lanes);
+        return values[0] + values[1] + values[2] + values[3];
+    }
+
+    /** @brief Adds up the two lanes of an SSE2 register
+     *
+     *  @param lanes - Two 64 bit values
+     *  @return Sum of the lanes
+     */
+    inline uint64_t SumLanes(const __m128i lanes)
+    {
+        alignas(16) uint64_t values[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(values), lanes);
+        return values[0] + values[1];
+    }
+#endif
+}
+
+SimdLevel OrderBatch::simdLevel = DetectSimdLevel();
+OrderBatch::SumOrdersFunc OrderBatch::sumOrders = GetSumOrdersFunc(OrderBatch::simdLevel);
+
+OrderBatch::OrderBatch()
+    : numOrders(0),
+      sortKeys(CAPACITY),
+      quantities(CAPACITY),
+      prices(CAPACITY),
+      buyMasks(CAPACITY),
+      groupedKeys(CAPACITY),
+      sortScratch(CAPACITY),
+      securityCounts(COUNTING_SORT_RANGE),
+      groupedQuantities(CAPACITY),
+      groupedPrices(CAPACITY),
+      groupedBuyMasks(CAPACITY)
+{
+    groups.reserve(CAPACITY);
+}
+
+
+/** @brief Empties the batch, ready for the next block of Orders
+ *
+ *  @return void
+ */
+void OrderBatch::Clear()
+{
+    numOrders = 0;
+    groups.clear();
+}
+
+
+/** @brief Groups the Orders in the batch by Security
+ *
+ *  When the Security IDs in the batch are close enough together, as they usually are, they are
+ *  grouped with a single counting sort: the Orders of each Security are counted, which gives where
+ *  each group starts, and every Order is then moved straight to the next place in its group.
+ *  Otherwise they are sorted with a radix sort (see RadixSortGroups).
+ *
+ *  Either way the sort is stable, so the Orders of each group stay in the order they were added,
+ *  and the first Order of a group is the first that was added against its Security. The
+ *  quantities, prices & sides are moved with them, so each group's Orders are next to each other
+ *  for SumGroup.
+ *
+ *  @return The groups, one per Security, in order of Security ID
+ */
+const std::vector<OrderBatchGroup>& OrderBatch::GroupBySecurity()
+{
+    groups.clear();
+    if (numOrders == 0)
+        return groups;
+
+    uint32_t minSecurityId = UINT32_MAX;
+    uint32_t maxSecurityId = 0;
+    for (size_t order = 0; order < numOrders; ++order)
+    {
+        uint32_t securityId = static_cast<uint32_t>(sortKeys[order] >> KEY_SHIFT);
+        minSecurityId = (securityId < minSecurityId) ? securityId : minSecurityId;
+        maxSecurityId = (securityId > maxSecurityId) ? securityId : maxSecurityId;
+    }
+
+    if (maxSecurityId - minSecurityId >= COUNTING_SORT_RANGE)
+    {
+        RadixSortGroups();
+        return groups;
+    }
+
+    uint32_t* counts = securityCounts.data();
+    const size_t range = maxSecurityId - minSecurityId + 1;
+    std::fill(counts, counts + range, 0);
+    for (size_t order = 0; order < numOrders; ++order)
+        ++counts[(sortKeys[order] >> KEY_SHIFT) - minSecurityId];
+
+    uint32_t pos = 0;
+    for (size_t value = 0; value < range; ++value)
+    {
+        uint32_t count = counts[value];
+        if (count == 0)
+            continue;
+
+        groups.push_back({ static_cast<int>(minSecurityId + value), pos, count });
+        counts[value] = pos;
+        pos += count;
+    }
+
+    for (size_t order = 0; order < numOrders; ++order)
+    {
+        uint32_t groupedPos = counts[(sortKeys[order] >> KEY_SHIFT) - minSecurityId]++;
+        groupedKeys[groupedPos] = sortKeys[order];
+        groupedQuantities[groupedPos] = quantities[order];
+        groupedPrices[groupedPos] = prices[order];
+        groupedBuyMasks[groupedPos] = buyMasks[order];
+    }
+
+    return groups;
+}
+
+
+/** @brief Groups the Orders in the batch by Security with a radix sort
+ *
+ *  For batches whose Security IDs are too far apart to count. Sorts the Orders by Security ID
+ *  with a least significant digit radix sort, 8 bits at a time. The counts of every digit are
+ *  taken in one pass first, so a digit that every Order shares, such as the top byte of a batch
+ *  of small Security IDs, is skipped without moving anything. The quantities, prices & sides are
+ *  then gathered into the sorted order.
+ *
+ *  @return void
+ */
+void OrderBatch::RadixSortGroups()
+{
+    uint32_t digitCounts[KEY_DIGITS][RADIX_SIZE] = {};
+    for (size_t order = 0; order < numOrders; ++order)
+    {
+        uint32_t securityId = static_cast<uint32_t>(sortKeys[order] >> KEY_SHIFT);
+        for (size_t digit = 0; digit < KEY_DIGITS; ++digit)
+            ++digitCounts[digit][(securityId >> (digit * RADIX_BITS)) & (RADIX_SIZE - 1)];
+    }
+
+    // Each pass reads the keys in order and writes each to the next place for its digit
+    //
+    const uint64_t* keys = sortKeys.data();
+    for (size_t digit = 0; digit < KEY_DIGITS; ++digit)
+    {
+        const size_t shift = KEY_SHIFT + (digit * RADIX_BITS);
+        uint32_t* counts = digitCounts[digit];
+        if (counts[(keys[0] >> shift) & (RADIX_SIZE - 1)] == numOrders)
+            continue;
+
+        uint32_t pos = 0;
+        for (size_t value = 0; value < RADIX_SIZE; ++value)
+        {
+            uint32_t count = counts[value];
+            counts[value] = pos;
+            pos += count;
+        }
+
+        uint64_t* sortedKeys = (keys == groupedKeys.data()) ? sortScratch.data() : groupedKeys.data();
+        for (size_t i = 0; i < numOrders; ++i)
+            sortedKeys[counts[(keys[i] >> shift) & (RADIX_SIZE - 1)]++] = keys[i];
+        keys = sortedKeys;
+    }
+    if (keys != groupedKeys.data())
+        std::copy(keys, keys + numOrders, groupedKeys.data());
+
+    for (size_t i = 0; i < numOrders; ++i)
+    {
+        uint32_t order = static_cast<uint32_t>(groupedKeys[i]);
+        int securityId = static_cast<int>(groupedKeys[i] >> KEY_SHIFT);
+        groupedQuantities[i] = quantities[order];
+        groupedPrices[i] = prices[order];
+        groupedBuyMasks[i] = buyMasks[order];
+
+        if (groups.empty() || securityId != groups.back().securityId)
+            groups.push_back({ securityId, static_cast<uint32_t>(i), 0 });
+        ++groups.back().count;
+    }
+}
+
+
+/** @brief Sums up the Orders of a group
+ *
+ *  Uses the best instruction set the CPU supports, unless another has been chosen with SetSimdLevel.
+ *  Groups of only a few Orders are summed without SIMD, as setting up the vectors costs more than
+ *  it saves.
+ *
+ *  @param group - Group from GroupBySecurity
+ *  @return Totals of the group's Orders, to add to its Security's Order Report
+ */
+OrderTotals OrderBatch::SumGroup(const OrderBatchGroup& group) const
+{
+    SumOrdersFunc sum = (group.count >= MIN_SIMD_GROUP_SIZE) ? sumOrders : SumOrdersScalar;
+    return sum( groupedQuantities.data() + group.start,
+                groupedPrices.data() + group.start,
+                groupedBuyMasks.data() + group.start,
+                group.count );
+}
+
+
+/** @brief Gets the Order at a position once grouped
+ *
+ *  @param pos - Position in the grouped Orders, e.g. a group's start
+ *  @return Position the Order was added at, for GetOrderData
+ */
+size_t OrderBatch::GetGroupedOrder(const size_t pos) const
+{
+    return static_cast<uint32_t>(groupedKeys[pos]);
+}
+
+
+/** @brief Gets the data of an Order in the batch
+ *
+ *  Only the side, quantity & price are kept; the timestamp & Order ID are 0.
+ *
+ *  @param order - Position the Order was added at
+ *  @return The Order's data
+ */
+OrderAddData OrderBatch::GetOrderData(const size_t order) const
+{
+    OrderAddData ordData = {};
+    ordData.side = (buyMasks[order] != 0) ? Side::Buy : Side::Sell;
+    ordData.quantity = quantities[order];
+    ordData.price = prices[order];
+    return ordData;
+}
+
+
+/** @brief Sets the SIMD instruction set used to sum up groups
+ *
+ *  A level the CPU doesn't support is lowered to the best one it does. Mainly useful for
+ *  comparing the different sums against each other. Must not be called while any other
+ *  thread is summing up a batch.
+ *
+ *  @param level - SIMD level to use
+ *  @return void
+ */
+void OrderBatch::SetSimdLevel(const SimdLevel level)
+{
+    SimdLevel supportedLevel = DetectSimdLevel();
+    simdLevel = (level < supportedLevel) ? level : supportedLevel;
+    sumOrders = GetSumOrdersFunc(simdLevel);
+}
+
+
+/** @brief Gets the SIMD instruction set used to sum up groups
+ *
+ *  @return SIMD level in use
+ */
+SimdLevel OrderBatch::GetSimdLevel()
+{
+    return simdLevel;
+}
+
+
+/** @brief Gets the group sum for a SIMD instruction set
+ *
+ *  @param level - SIMD level
+ *  @return Group sum function
+ */
+OrderBatch::SumOrdersFunc OrderBatch::GetSumOrdersFunc(const SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef ORA_X86_SIMD
+        case SimdLevel::AVX2: return SumOrdersAVX2;
+        case SimdLevel::SSE2: return SumOrdersSSE2;
+#endif
+        default:              return SumOrdersScalar;
+    }
+}
+
+
+/** @brief Sums up Orders one at a time, without SIMD
+ *
+ *  @param quantities - Quantity of each Order
+ *  @param prices     - Price of each Order
+ *  @param buyMasks   - All ones for each Buy Order, 0 for each Sell Order
+ *  @param count      - Number of Orders
+ *  @return Totals of the Orders
+ */
+OrderTotals OrderBatch::SumOrdersScalar(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count)
+{
+    OrderTotals totals = NO_ORDER_TOTALS;
+    for (size_t i = 0; i < count; ++i)
+        AddOrder(totals, quantities[i], prices[i], buyMasks[i]);
+    return totals;
+}
+
+#ifdef ORA_X86_SIMD
+
+/** @brief Sums up Orders two at a time with SSE2
+ *
+ *  The side of each Order masks its quantity into either the Buy or the Sell sum. While every
+ *  quantity & price fits in 32 bits, as they do in practice, quantity * price is worked out for both
+ *  Orders at once with a 32x32 bit multiply, and the low & high halves of the products are summed
+ *  separately so they can't wrap. If any doesn't fit, the amounts spent are added up again a 128 bit
+ *  product at a time. SSE2 has no 64 bit compare, so the max & min prices are kept with scalar code,
+ *  with a Sell Order's price masked to 0 for the max and a Buy Order's to all ones for the min.
+ *  A last odd Order is added on its own.
+ *
+ *  @param quantities - Quantity of each Order
+ *  @param prices     - Price of each Order
+ *  @param buyMasks   - All ones for each Buy Order, 0 for each Sell Order
+ *  @param count      - Number of Orders
+ *  @return Totals of the Orders
+ */
+OrderTotals OrderBatch::SumOrdersSSE2(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count)
+{
+    const __m128i lowHalves = _mm_set1_epi64x(0xFFFFFFFF);
+    __m128i buyCounts = _mm_setzero_si128();
+    __m128i buyQuantity = _mm_setzero_si128();
+    __m128i sellQuantity = _mm_setzero_si128();
+    __m128i buySpentLow = _mm_setzero_si128();
+    __m128i buySpentHigh = _mm_setzero_si128();
+    __m128i sellSpentLow = _mm_setzero_si128();
+    __m128i sellSpentHigh = _mm_setzero_si128();
+    __m128i wideValues = _mm_setzero_si128();
+    uint64_t maxBuyPrice = 0;
+    uint64_t minSellPrice = UINT64_MAX;
+    size_t i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i quantity = _mm_loadu_si128(reinterpret_cast<const __m128i*>(quantities + i));
+        __m128i price = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prices + i));
+        __m128i buy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buyMasks + i));
+
+        buyCounts = _mm_sub_epi64(buyCounts, buy);
+        buyQuantity = _mm_add_epi64(buyQuantity, _mm_and_si128(buy, quantity));
+        sellQuantity = _mm_add_epi64(sellQuantity, _mm_andnot_si128(buy, quantity));
+
+        __m128i spent = _mm_mul_epu32(quantity, price);
+        __m128i spentLow = _mm_and_si128(spent, lowHalves);
+        __m128i spentHigh = _mm_srli_epi64(spent, 32);
+        buySpentLow = _mm_add_epi64(buySpentLow, _mm_and_si128(buy, spentLow));
+        buySpentHigh = _mm_add_epi64(buySpentHigh, _mm_and_si128(buy, spentHigh));
+        sellSpentLow = _mm_add_epi64(sellSpentLow, _mm_andnot_si128(buy, spentLow));
+        sellSpentHigh = _mm_add_epi64(sellSpentHigh, _mm_andnot_si128(buy, spentHigh));
+        wideValues = _mm_or_si128(wideValues, _mm_or_si128(quantity, price));
+
+        for (size_t lane = i; lane < i + 2; ++lane)
+        {
+            uint64_t buyPrice = prices[lane] & buyMasks[lane];
+            uint64_t sellPrice = prices[lane] | buyMasks[lane];
+            maxBuyPrice = (buyPrice > maxBuyPrice) ? buyPrice : maxBuyPrice;
+            minSellPrice = (sellPrice < minSellPrice) ? sellPrice : minSellPrice;
+        }
+    }
+
+    OrderTotals totals = NO_ORDER_TOTALS;
+    totals.buyCount = static_cast<int>(SumLanes(buyCounts));
+    totals.sellCount = static_cast<int>(i) - totals.buyCount;
+    totals.buyQuantity = SumLanes(buyQuantity);
+    totals.sellQuantity = SumLanes(sellQuantity);
+    totals.maxBuyPrice = maxBuyPrice;
+    totals.minSellPrice = minSellPrice;
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi64(wideValues, 32), _mm_setzero_si128())) != 0xFFFF)
+        SumSpent(totals, quantities, prices, buyMasks, i);
+    else
+    {
+        totals.buySpent = SumLanes(buySpentLow) + (static_cast<unsigned __int128>(SumLanes(buySpentHigh)) << 32);
+        totals.sellSpent = SumLanes(sellSpentLow) + (static_cast<unsigned __int128>(SumLanes(sellSpentHigh)) << 32);
+    }
+
+    for (; i < count; ++i)
+        AddOrder(totals, quantities[i], prices[i], buyMasks[i]);
+
+    return totals;
+}
+
+
+/** @brief Sums up Orders four at a time with AVX2
+ *
+ *  Works as the SSE2 sum does, but keeps the max & min prices with SIMD as well. Prices are
+ *  compared as signed numbers with their top bit flipped, as AVX2 only has a signed 64 bit
+ *  compare. Any Orders left over after the last four are added one at a time.
+ *
+ *  @param quantities - Quantity of each Order
+ *  @param prices     - Price of each Order
+ *  @param buyMasks   - All ones for each Buy Order, 0 for each Sell Order
+ *  @param count      - Number of Orders
+ *  @return Totals of the Orders
+ */
+__attribute__((target("avx2")))
+OrderTotals OrderBatch::SumOrdersAVX2(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count)
+{
+    const __m256i lowHalves = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i signBits = _mm256_set1_epi64x(INT64_MIN);
+    __m256i buyCounts = _mm256_setzero_si256();
+    __m256i buyQuantity = _mm256_setzero_si256();
+    __m256i sellQuantity = _mm256_setzero_si256();
+    __m256i buySpentLow = _mm256_setzero_si256();
+    __m256i buySpentHigh = _mm256_setzero_si256();
+    __m256i sellSpentLow = _mm256_setzero_si256();
+    __m256i sellSpentHigh = _mm256_setzero_si256();
+    __m256i wideValues = _mm256_setzero_si256();
+    __m256i maxBuyPrice = signBits;                             // 0, flipped
+    __m256i minSellPrice = _mm256_set1_epi64x(INT64_MAX);       // UINT64_MAX, flipped
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i quantity = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(quantities + i));
+        __m256i price = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices + i));
+        __m256i buy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buyMasks + i));
+
+        buyCounts = _mm256_sub_epi64(buyCounts, buy);
+        buyQuantity = _mm256_add_epi64(buyQuantity, _mm256_and_si256(buy, quantity));
+        sellQuantity = _mm256_add_epi64(sellQuantity, _mm256_andnot_si256(buy, quantity));
+
+        __m256i spent = _mm256_mul_epu32(quantity, price);
+        __m256i spentLow = _mm256_and_si256(spent, lowHalves);
+        __m256i spentHigh = _mm256_srli_epi64(spent, 32);
+        buySpentLow = _mm256_add_epi64(buySpentLow, _mm256_and_si256(buy, spentLow));
+        buySpentHigh = _mm256_add_epi64(buySpentHigh, _mm256_and_si256(buy, spentHigh));
+        sellSpentLow = _mm256_add_epi64(sellSpentLow, _mm256_andnot_si256(buy, spentLow));
+        sellSpentHigh = _mm256_add_epi64(sellSpentHigh, _mm256_andnot_si256(buy, spentHigh));
+        wideValues = _mm256_or_si256(wideValues, _mm256_or_si256(quantity, price));
+
+        __m256i buyPrice = _mm256_xor_si256(_mm256_and_si256(price, buy), signBits);
+        __m256i sellPrice = _mm256_xor_si256(_mm256_or_si256(price, buy), signBits);
+        maxBuyPrice = _mm256_blendv_epi8(maxBuyPrice, buyPrice, _mm256_cmpgt_epi64(buyPrice, maxBuyPrice));
+        minSellPrice = _mm256_blendv_epi8(minSellPrice, sellPrice, _mm256_cmpgt_epi64(minSellPrice, sellPrice));
+    }
+
+    alignas(32) uint64_t maxBuyLanes[4];
+    alignas(32) uint64_t minSellLanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxBuyLanes), _mm256_xor_si256(maxBuyPrice, signBits));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(minSellLanes), _mm256_xor_si256(minSellPrice, signBits));
+
+    OrderTotals totals = NO_ORDER_TOTALS;
+    totals.buyCount = static_cast<int>(SumLanes(buyCounts));
+    totals.sellCount = static_cast<int>(i) - totals.buyCount;
+    totals.buyQuantity = SumLanes(buyQuantity);
+    totals.sellQuantity = SumLanes(sellQuantity);
+    totals.maxBuyPrice = 0;
+    for (uint64_t lanePrice : maxBuyLanes)
+        totals.maxBuyPrice = (lanePrice > totals.maxBuyPrice) ? lanePrice : totals.maxBuyPrice;
+    for (uint64_t lanePrice : minSellLanes)
+        totals.minSellPrice = (lanePrice < totals.minSellPrice) ? lanePrice : totals.minSellPrice;
+
+    if (!_mm256_testz_si256(wideValues, _mm256_set1_epi64x(static_cast<int64_t>(0xFFFFFFFF00000000ULL))))
+        SumSpent(totals, quantities, prices, buyMasks, i);
+    else
+    {
+        totals.buySpent = SumLanes(buySpentLow) + (static_cast<unsigned __int128>(SumLanes(buySpentHigh)) << 32);
+        totals.sellSpent = SumLanes(sellSpentLow) + (static_cast<unsigned __int128>(SumLanes(sellSpentHigh)) << 32);
+    }
+
+    for (; i < count; ++i)
+        AddOrder(totals, quantities[i], prices[i], buyMasks[i]);
+
+    return totals;
+}
+
+#endif
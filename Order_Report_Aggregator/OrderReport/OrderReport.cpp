@@ -3,19 +3,42 @@
  *
  *  This contains the data and functions needed to produce an Order Report on a Security.
  *
+ *  Only the counters that are updated for every order are held in the Order Report, and they
+ *  fit in a single 64 byte cache line. The Security's ISIN & currency are held separately in a
+ *  SecurityInfo, as they are only needed when outputting the report. The distributions of order
+ *  prices & quantities, for reporting quantiles, are held separately again in OrderSketches, and
+ *  the resting & executed quantities of live Orders in OrderActivity.
+ *
+ *  The Totals Spent are held in 80 bits, the top 16 of them in what would otherwise be padding, so
+ *  quantity * price can't wrap them. Orders can be added one at a time, or a group at a time as the
+ *  totals of a batch (see OrderBatch.h), which gives exactly the same Order Report.
+ *
+ *  None of them hold any pointers or allocations. The ISIN & currency are kept in fixed size inline
+ *  storage, so all are trivially copyable and can be snapshotted & restored with memcpy.
+ *
+ *  Each value that can be reported on is a Report Column, and is read with GetColumn. Which columns
+ *  a report holds, and in what order, is set by a Report Schema (see ReportSchema.h).
+ *
  *  @author Sean Griffin
  *  @bug No known bugs.
  */
 
+#include <type_traits>
 #include "OrderReport.h"
 
+static_assert(sizeof(OrderReport) == 64, "The Order Report counters should fill exactly one cache line");
+static_assert(std::is_trivially_copyable<OrderReport>::value, "Order Reports are snapshotted as raw bytes");
+static_assert(std::is_trivially_copyable<SecurityInfo>::value, "Security data is copied as raw bytes");
+static_assert(std::is_trivially_copyable<OrderSketches>::value, "Order Sketches are copied as raw bytes");
+static_assert(std::is_trivially_copyable<OrderActivity>::value, "Order Activity is copied as raw bytes");
+
 OrderReport::OrderReport()
 {
-    ISIN = "";
-    currency = "";
     securityId = 0;
     buyCount = 0;
     sellCount = 0;
+    buySpentHigh = 0;
+    sellSpentHigh = 0;
     buyQuantity = 0;
     sellQuantity = 0;
     maxBuyPrice = 0;
@@ -24,10 +47,6 @@ OrderReport::OrderReport()
     totalSellSpent = 0;
 }
 
-OrderReport::~OrderReport()
-{
-}
-
 
 /** @brief Gets the Security ID
  * 
@@ -39,25 +58,13 @@ int OrderReport::GetSecurityId() const
 }
 
 
-/** @brief Sets the ISIN
+/** @brief Gets the number of Orders against the Security
  * 
- *  @param isin - ISIN
- *  @return void
+ *  @return Number of Buy & Sell Orders
  */
-void OrderReport::SetISIN(const std::string& isin_)
+int OrderReport::GetOrderCount() const
 {
-    ISIN = isin_;
-}
-
-
-/** @brief Sets the Currency
- * 
- *  @param cur - Currency
- *  @return void
- */
-void OrderReport::SetCurrency(const std::string& cur_)
-{
-    currency = cur_;
+    return buyCount + sellCount;
 }
 
 
@@ -88,7 +95,7 @@ void OrderReport::AddOrderData(const OrderAddData& ordData)
         buyQuantity += ordData.quantity;
         if (ordData.price > maxBuyPrice)
             maxBuyPrice = ordData.price;
-        totalBuySpent += (ordData.quantity * ordData.price);
+        AddSpent(totalBuySpent, buySpentHigh, static_cast<unsigned __int128>(ordData.quantity) * ordData.price);
     }
     else
     {
@@ -96,62 +103,119 @@ void OrderReport::AddOrderData(const OrderAddData& ordData)
         sellQuantity += ordData.quantity;
         if (ordData.price < minSellPrice)
             minSellPrice = ordData.price;
-        totalSellSpent += (ordData.quantity * ordData.price);
+        AddSpent(totalSellSpent, sellSpentHigh, static_cast<unsigned __int128>(ordData.quantity) * ordData.price);
+    }
+}
+
+
+/** @brief Adds the totals of a group of Orders
+ * 
+ *  Gives exactly the same result as adding each of the Orders in the group with AddOrderData,
+ *  whatever order they are in, so a batch of Orders can be summed up per Security first.
+ *
+ *  @param totals - Totals of the Orders against this Security
+ *  @return void
+ */
+void OrderReport::AddOrderTotals(const OrderTotals& totals)
+{
+    if (totals.buyCount > 0)
+    {
+        buyCount += totals.buyCount;
+        buyQuantity += totals.buyQuantity;
+        if (totals.maxBuyPrice > maxBuyPrice)
+            maxBuyPrice = totals.maxBuyPrice;
+        AddSpent(totalBuySpent, buySpentHigh, totals.buySpent);
+    }
+
+    if (totals.sellCount > 0)
+    {
+        sellCount += totals.sellCount;
+        sellQuantity += totals.sellQuantity;
+        if (totals.minSellPrice < minSellPrice)
+            minSellPrice = totals.minSellPrice;
+        AddSpent(totalSellSpent, sellSpentHigh, totals.sellSpent);
     }
 }
 
 
-/** @brief Calculates the Weighted Average Buy Price
+/** @brief Merges the Order Data from another Order Report
  * 
- *  Will first check that the Buy Quantity is not zero, so that we don't divide by it.
- *  Will return the Total Spent on Buying, which should be 0, if Buy Quantity is 0.
+ *  Combines the orders added to another Order Report for the same Security into this one,
+ *  giving the same result as if every order had been added to this Order Report instead.
+ *  This allows partial Order Reports built from different parts of the input file to be
+ *  combined at the end. The Security ID of this Order Report is kept.
+ *
+ *  @param other - Order Report holding the Order Data to merge in
+ *  @return void
+ */
+void OrderReport::Merge(const OrderReport& other)
+{
+    if (other.buyCount > 0)
+    {
+        if (buyCount == 0 || other.maxBuyPrice > maxBuyPrice)
+            maxBuyPrice = other.maxBuyPrice;
+        buyCount += other.buyCount;
+        buyQuantity += other.buyQuantity;
+        AddSpent(totalBuySpent, buySpentHigh, GetSpent(other.totalBuySpent, other.buySpentHigh));
+    }
+
+    if (other.sellCount > 0)
+    {
+        if (sellCount == 0 || other.minSellPrice < minSellPrice)
+            minSellPrice = other.minSellPrice;
+        sellCount += other.sellCount;
+        sellQuantity += other.sellQuantity;
+        AddSpent(totalSellSpent, sellSpentHigh, GetSpent(other.totalSellSpent, other.sellSpentHigh));
+    }
+}
+
+
+/** @brief Merges the sketches of another Security's orders
  * 
- *  @return Weighted Average Buy Price
+ *  @param other - Sketches holding the Order Data to merge in
+ *  @return void
  */
-size_t OrderReport::CalcWeightedAvgBuyPrice() const
+void OrderSketches::Merge(const OrderSketches& other)
 {
-    return ((buyQuantity != 0) ? (totalBuySpent/buyQuantity) : totalBuySpent);
+    buyPrice.Merge(other.buyPrice);
+    buyQuantity.Merge(other.buyQuantity);
+    sellPrice.Merge(other.sellPrice);
+    sellQuantity.Merge(other.sellQuantity);
 }
 
 
-/** @brief Calculates the Weighted Average Sell Price
+/** @brief Checks every sketch is consistent
  * 
- *  Will first check that the Sell Quantity is not zero, so that we don't divide by it.
- *  Will return the Total Spent on Selling, which should be 0, if Sell Quantity is 0.
+ *  @return true if the sketches can be used safely
+ */
+bool OrderSketches::IsValid() const
+{
+    return buyPrice.IsValid() && buyQuantity.IsValid() && sellPrice.IsValid() && sellQuantity.IsValid();
+}
+
+
+/** @brief Estimates a quantile from one of a Security's sketches
  * 
- *  @return Weighted Average Sell Price
+ *  @param sketches - Sketches of the Security's Orders, or nullptr if there are none
+ *  @param sketch   - The sketch to estimate from, e.g. &OrderSketches::buyPrice
+ *  @param fraction - Quantile to estimate, from 0 to 1
+ *  @return Estimated value of the quantile, or 0 if there are no Orders in the sketch
  */
-size_t OrderReport::CalcWeightedAvgSellPrice() const
+size_t OrderSketches::GetQuantile(const OrderSketches* sketches, QuantileSketch OrderSketches::* sketch, const double fraction)
 {
-    return ((sellQuantity != 0) ? (totalSellSpent/sellQuantity) : totalSellSpent);
+    return (sketches != nullptr) ? static_cast<size_t>((sketches->*sketch).Quantile(fraction)) : 0;
 }
 
 
-/** @brief Outputs the data needed for the Order Report
+/** @brief Merges the activity of another part of the input into this one
  * 
- *  The output report will contain the following headers in the following order:
- *    ISIN | Currency | Total Buy Count | Total Sell Count | Total Buy Quantity | Total Sell Quantity |
- *    Weighted Average Buy Price | Weighted Average Sell Price | Max Buy Price | Min Sell Price
- *
- *  @param outStream    - The stream to output the Order Report to
- *  @param delim        - The delimiter that will seperate each value 
- *  @param rptEmptyOrds - Whether to output the security when it has no orders
+ *  @param other - Activity to merge in
  *  @return void
  */
-void OrderReport::OutputReport(std::ofstream& outStream, const char delim, const bool rptEmptyOrds) const
+void OrderActivity::Merge(const OrderActivity& other)
 {
-    if(rptEmptyOrds || buyCount > 0 || sellCount > 0)
-    {
-        outStream << ISIN << delim
-                  << currency << delim
-                  << buyCount << delim
-                  << sellCount << delim
-                  << buyQuantity << delim
-                  << sellQuantity << delim
-                  << CalcWeightedAvgBuyPrice() << delim
-                  << CalcWeightedAvgSellPrice() << delim
-                  << maxBuyPrice << delim
-                  << minSellPrice
-                  << "\n";
-    }
+    restingBuyQuantity += other.restingBuyQuantity;
+    restingSellQuantity += other.restingSellQuantity;
+    executedBuyQuantity += other.executedBuyQuantity;
+    executedSellQuantity += other.executedSellQuantity;
 }
\ No newline at end of file
@@ -0,0 +1,298 @@
+/** @file OrderReportCheckpoint.cpp
+ *  @brief Saves and restores an Order Report collection as a binary checkpoint
+ *
+ *  A checkpoint holds every Order Report in a collection along with the offset in the input
+ *  file it covers up to, so that reading can carry on from that offset after a restart rather
+ *  than parsing the whole input file again. It also holds a fingerprint of the input file up to
+ *  that offset, so it is only carried on from if the input file is still the one it was saved from.
+ *
+ *  Orders still waiting in the Pending Order Buffer for their Security to be referenced are saved too,
+ *  as are the live Orders in the Order Store, and the Securities' Order Sketches when the collection keeps them.
+ *
+ *  The file is laid out so it can be memory mapped and read in place:
+ *    CheckpointHeader | OrderReport[numSecurities] | SecurityInfo[numSecurities] | OrderActivity[numSecurities] |
+ *    CheckpointPendingOrder[numPendingOrders] | CheckpointLiveOrder[numLiveOrders] |
+ *    uint32_t sketchIndex[numSecurities] | OrderSketches[numSketches]
+ *  The sketch indexes and sketches are left out when there are no sketches. Each Security's sketch index is
+ *  the position of its sketches, or UINT32_MAX if it has none.
+ *  The Order Reports and Security data are stored exactly as they are held in memory, so a checkpoint
+ *  can only be restored by a build with the same layout; anything else is rejected by the version &
+ *  size checks in the header.
+ *
+ *  Checkpoints are written to a temporary file, synced to disk and then renamed over the old
+ *  checkpoint, so a crash while saving never leaves a half written checkpoint behind.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include "OrderReportCheckpoint.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+
+static_assert(std::is_trivially_copyable<OrderReport>::value, "Order Reports are written to checkpoints as raw bytes");
+static_assert(std::is_trivially_copyable<SecurityInfo>::value, "Security data is written to checkpoints as raw bytes");
+static_assert(std::is_trivially_copyable<OrderSketches>::value, "Order Sketches are written to checkpoints as raw bytes");
+static_assert(std::is_trivially_copyable<OrderActivity>::value, "Order Activity is written to checkpoints as raw bytes");
+static_assert(sizeof(CheckpointHeader) % alignof(OrderReport) == 0, "Order Reports must be aligned in a mapped checkpoint");
+
+/** @brief Saves a checkpoint of an Order Report collection
+ * 
+ *  @param checkpointFile - Checkpoint File Name/Path
+ *  @param ordRptColl     - Collection of Order Reports to save
+ *  @param pendingOrders  - Orders waiting for their Security to be referenced
+ *  @param liveOrders     - Orders still resting on the book
+ *  @param inputOffset    - Offset in the input file that the collection covers up to
+ *  @param inputFingerprint - Fingerprint of the input file up to inputOffset
+ *  @return true if the checkpoint was saved
+ */
+bool OrderReportCheckpoint::Save( const std::string&           checkpointFile,
+                                  const OrderReportCollection& ordRptColl,
+                                  const PendingOrderBuffer&    pendingOrders,
+                                  const OrderStore&            liveOrders,
+                                  const uint64_t               inputOffset,
+                                  const uint64_t               inputFingerprint )
+{
+    size_t numSecurities = ordRptColl.Size();
+    size_t numSketches = 0;
+    for (size_t slot = 0; slot < numSecurities; ++slot)
+    {
+        if (ordRptColl.GetSketches(slot) != nullptr)
+            ++numSketches;
+    }
+
+    // Zeroed first so that the padding bytes written to the file are always the same
+    //
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.orderReportSize = sizeof(OrderReport);
+    header.securityInfoSize = sizeof(SecurityInfo);
+    header.orderSketchesSize = sizeof(OrderSketches);
+    header.orderActivitySize = sizeof(OrderActivity);
+    header.inputOffset = inputOffset;
+    header.inputFingerprint = inputFingerprint;
+    header.numSecurities = numSecurities;
+    header.numPendingOrders = pendingOrders.Size();
+    header.numLiveOrders = liveOrders.Size();
+    header.numSketches = numSketches;
+
+    std::string tmpFile = checkpointFile + ".tmp";
+    OutputBuffer outBuffer;
+    if (!outBuffer.Open(tmpFile))
+        return false;
+
+    outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)));
+    if (numSecurities > 0)
+    {
+        outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&ordRptColl.GetOrderReport(0)), numSecurities * sizeof(OrderReport)));
+        outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&ordRptColl.GetSecurityInfo(0)), numSecurities * sizeof(SecurityInfo)));
+        outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&ordRptColl.GetActivity(0)), numSecurities * sizeof(OrderActivity)));
+    }
+    pendingOrders.ForEachOrder([&outBuffer](const int securityId, const OrderAddData& ordData, const PendingOrderState& state)
+    {
+        CheckpointPendingOrder pendingOrder = { securityId, static_cast<uint32_t>(ordData.side), ordData.quantity, ordData.price, ordData.timestamp, ordData.orderId,
+                                                state.restingQuantity, state.restingPrice, state.executedQuantity };
+        outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&pendingOrder), sizeof(pendingOrder)));
+    });
+    liveOrders.ForEachOrder([&outBuffer, &ordRptColl](const LiveOrder& order)
+    {
+        CheckpointLiveOrder liveOrder = { ordRptColl.GetOrderReport(order.slot).GetSecurityId(), static_cast<uint32_t>(order.side), order.orderId, order.quantity, order.price };
+        outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&liveOrder), sizeof(liveOrder)));
+    });
+
+    if (numSketches > 0)
+    {
+        uint32_t sketchIndex = 0;
+        for (size_t slot = 0; slot < numSecurities; ++slot)
+        {
+            uint32_t slotSketchIndex = (ordRptColl.GetSketches(slot) != nullptr) ? sketchIndex++ : NO_SKETCH_INDEX;
+            outBuffer.Append(std::string_view(reinterpret_cast<const char*>(&slotSketchIndex), sizeof(slotSketchIndex)));
+        }
+        for (size_t slot = 0; slot < numSecurities; ++slot)
+        {
+            const OrderSketches* sketches = ordRptColl.GetSketches(slot);
+            if (sketches != nullptr)
+                outBuffer.Append(std::string_view(reinterpret_cast<const char*>(sketches), sizeof(OrderSketches)));
+        }
+    }
+
+    if (!outBuffer.Sync())
+        return false;
+    outBuffer.Close();
+
+    return std::rename(tmpFile.c_str(), checkpointFile.c_str()) == 0;
+}
+
+
+/** @brief Reads the header of a checkpoint
+ * 
+ *  @param data   - Checkpoint
+ *  @param header - Set to the checkpoint's header
+ *  @return true if the header was written by a build with the same layout
+ */
+bool OrderReportCheckpoint::ReadHeader(std::string_view data, CheckpointHeader& header)
+{
+    if (data.size() < sizeof(CheckpointHeader))
+        return false;
+
+    memcpy(&header, data.data(), sizeof(header));
+    return memcmp(header.magic, MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == VERSION &&
+           header.orderReportSize == sizeof(OrderReport) &&
+           header.securityInfoSize == sizeof(SecurityInfo) &&
+           header.orderSketchesSize == sizeof(OrderSketches) &&
+           header.orderActivitySize == sizeof(OrderActivity) &&
+           header.numSketches <= header.numSecurities;
+}
+
+
+/** @brief Reads where in the input file a checkpoint covers up to, without loading it
+ * 
+ *  Lets the input file be checked against the checkpoint before anything is replaced by it.
+ *
+ *  @param checkpointFile   - Checkpoint File Name/Path
+ *  @param inputOffset      - Offset in the input file that the checkpoint covers up to
+ *  @param inputFingerprint - Fingerprint of the input file up to inputOffset when the checkpoint was saved
+ *  @return true if the checkpoint was written by a build with the same layout
+ */
+bool OrderReportCheckpoint::LoadInputPosition(const std::string& checkpointFile, uint64_t& inputOffset, uint64_t& inputFingerprint)
+{
+    MappedFile mappedFile;
+    CheckpointHeader header;
+    if (!mappedFile.Open(checkpointFile) || !ReadHeader(mappedFile.GetData(), header))
+        return false;
+
+    inputOffset = header.inputOffset;
+    inputFingerprint = header.inputFingerprint;
+    return true;
+}
+
+
+/** @brief Loads a checkpoint into an Order Report collection
+ * 
+ *  The checkpoint is memory mapped and its Order Reports are copied straight into the
+ *  collection, replacing anything already in it. The pending orders replace any in the
+ *  Pending Order Buffer, and are kept even if they are over its memory limit, and the live
+ *  Orders replace any in the Order Store. Any Order Sketches are only restored if the collection
+ *  keeps sketches. Nothing is changed if the checkpoint is missing, truncated or was written by
+ *  an incompatible build.
+ *
+ *  @param checkpointFile - Checkpoint File Name/Path
+ *  @param ordRptColl     - Collection of Order Reports to load into
+ *  @param pendingOrders  - Pending Order Buffer to load the pending orders into
+ *  @param liveOrders     - Order Store to load the live Orders into
+ *  @param inputOffset    - Offset in the input file that the checkpoint covers up to
+ *  @return true if the checkpoint was loaded
+ */
+bool OrderReportCheckpoint::Load( const std::string&     checkpointFile,
+                                  OrderReportCollection& ordRptColl,
+                                  PendingOrderBuffer&    pendingOrders,
+                                  OrderStore&            liveOrders,
+                                  uint64_t&              inputOffset )
+{
+    MappedFile mappedFile;
+    if (!mappedFile.Open(checkpointFile))
+        return false;
+
+    std::string_view data = mappedFile.GetData();
+    CheckpointHeader header;
+    if (!ReadHeader(data, header))
+        return false;
+
+    uint64_t reportsSize = header.numSecurities * sizeof(OrderReport);
+    uint64_t securityInfosSize = header.numSecurities * sizeof(SecurityInfo);
+    uint64_t activitiesSize = header.numSecurities * sizeof(OrderActivity);
+    uint64_t pendingSize = header.numPendingOrders * sizeof(CheckpointPendingOrder);
+    uint64_t liveSize = header.numLiveOrders * sizeof(CheckpointLiveOrder);
+    uint64_t sketchIndexesSize = (header.numSketches > 0) ? header.numSecurities * sizeof(uint32_t) : 0;
+    uint64_t sketchesSize = header.numSketches * sizeof(OrderSketches);
+    if (data.size() != sizeof(CheckpointHeader) + reportsSize + securityInfosSize + activitiesSize + pendingSize + liveSize + sketchIndexesSize + sketchesSize)
+        return false;
+
+    const OrderReport* ordRpts = reinterpret_cast<const OrderReport*>(data.data() + sizeof(CheckpointHeader));
+    const SecurityInfo* secInfos = reinterpret_cast<const SecurityInfo*>(data.data() + sizeof(CheckpointHeader) + reportsSize);
+    const char* activityData = data.data() + sizeof(CheckpointHeader) + reportsSize + securityInfosSize;
+    const char* pendingData = activityData + activitiesSize;
+    const char* liveData = pendingData + pendingSize;
+    const char* sketchIndexData = liveData + liveSize;
+    const char* sketchData = sketchIndexData + sketchIndexesSize;
+
+    for (uint64_t i = 0; i < header.numSecurities; ++i)
+    {
+        if (!secInfos[i].ISIN.IsValid() || !secInfos[i].currency.IsValid())
+            return false;
+    }
+
+    // The sketches follow the pending orders, so may not be aligned; each is copied out before it's checked
+    //
+    for (uint64_t i = 0; i < header.numSketches; ++i)
+    {
+        OrderSketches sketches;
+        memcpy(&sketches, sketchData + (i * sizeof(OrderSketches)), sizeof(sketches));
+        if (!sketches.IsValid())
+            return false;
+    }
+    for (uint64_t i = 0; i < header.numSecurities && header.numSketches > 0; ++i)
+    {
+        uint32_t sketchIndex;
+        memcpy(&sketchIndex, sketchIndexData + (i * sizeof(uint32_t)), sizeof(sketchIndex));
+        if (sketchIndex != NO_SKETCH_INDEX && sketchIndex >= header.numSketches)
+            return false;
+    }
+
+    ordRptColl.Clear();
+    ordRptColl.Reserve(header.numSecurities);
+    for (uint64_t i = 0; i < header.numSecurities; ++i)
+    {
+        size_t slot = ordRptColl.Insert(ordRpts[i].GetSecurityId(), secInfos[i].ISIN.View(), secInfos[i].currency.View());
+        ordRptColl.GetOrderReport(slot) = ordRpts[i];
+        memcpy(&ordRptColl.GetActivity(slot), activityData + (i * sizeof(OrderActivity)), sizeof(OrderActivity));
+
+        uint32_t sketchIndex = NO_SKETCH_INDEX;
+        if (header.numSketches > 0)
+            memcpy(&sketchIndex, sketchIndexData + (i * sizeof(uint32_t)), sizeof(sketchIndex));
+        if (sketchIndex != NO_SKETCH_INDEX && ordRptColl.SketchesEnabled())
+            memcpy(&ordRptColl.GetOrCreateSketches(slot), sketchData + (sketchIndex * sizeof(OrderSketches)), sizeof(OrderSketches));
+    }
+
+    // The memory limit is lifted while loading so that no pending order is dropped
+    //
+    size_t memoryLimit = pendingOrders.GetMemoryLimit();
+    pendingOrders.Clear();
+    pendingOrders.SetMemoryLimit(SIZE_MAX);
+    for (uint64_t i = 0; i < header.numPendingOrders; ++i)
+    {
+        CheckpointPendingOrder pendingOrder;
+        memcpy(&pendingOrder, pendingData + (i * sizeof(CheckpointPendingOrder)), sizeof(pendingOrder));
+        pendingOrders.Add( pendingOrder.securityId,
+                           OrderAddData{ static_cast<Side>(pendingOrder.side), pendingOrder.quantity, pendingOrder.price, pendingOrder.timestamp, pendingOrder.orderId },
+                           PendingOrderState{ pendingOrder.restingQuantity, pendingOrder.restingPrice, pendingOrder.executedQuantity } );
+    }
+    pendingOrders.SetMemoryLimit(memoryLimit);
+
+    // Live Orders against a Security that isn't in the checkpoint can't be valid, so are left out
+    //
+    liveOrders.Clear();
+    for (uint64_t i = 0; i < header.numLiveOrders; ++i)
+    {
+        CheckpointLiveOrder liveOrder;
+        memcpy(&liveOrder, liveData + (i * sizeof(CheckpointLiveOrder)), sizeof(liveOrder));
+        size_t slot = ordRptColl.Find(liveOrder.securityId);
+        if (slot == OrderReportCollection::NOT_FOUND)
+            continue;
+
+        LiveOrder& order = liveOrders.Insert(liveOrder.orderId);
+        order.quantity = liveOrder.quantity;
+        order.price = liveOrder.price;
+        order.slot = static_cast<uint32_t>(slot);
+        order.side = static_cast<Side>(liveOrder.side);
+    }
+
+    inputOffset = header.inputOffset;
+    return true;
+}
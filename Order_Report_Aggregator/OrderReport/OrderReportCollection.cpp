@@ -0,0 +1,342 @@
+/** @file OrderReportCollection.cpp
+ *  @brief Flat collection of Order Reports keyed by Security ID
+ *
+ *  Stores every Order Report in one contiguous array, in the order the Securities were
+ *  inserted. The hot Order Report counters are kept apart from the cold Security data
+ *  (ISIN & currency), which is only needed when outputting the report. Both arrays hold
+ *  fixed size, trivially copyable entries, so nothing is allocated per Security.
+ *
+ *  Security IDs are mapped to their slot in the array through an open addressing hash index
+ *  with linear probing. Each index entry holds the Security ID next to its slot, so a lookup
+ *  normally touches one index entry and then the Order Report itself.
+ *
+ *  Sketches of the distribution of each Security's order prices & quantities can be kept as well,
+ *  for reporting quantiles. They are only allocated for Securities that have Orders, and only when
+ *  enabled, as they are about 1KB each.
+ *
+ *  Changes to Order Reports can be marked, so that only the Securities that changed since the
+ *  last time the changes were cleared need to be looked at again.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include "OrderReportCollection.h"
+#include "OrderBatch.h"
+
+OrderReportCollection::OrderReportCollection()
+    : index(MIN_INDEX_SIZE, IndexEntry{ 0, EMPTY_SLOT }),
+      indexMask(MIN_INDEX_SIZE - 1),
+      sketchesEnabled(false)
+{
+}
+
+OrderReportCollection::~OrderReportCollection()
+{
+}
+
+
+/** @brief Inserts a Security into the collection
+ * 
+ *  Creates a new, empty Order Report for the Security. If the Security is already in the
+ *  collection then its existing Order Report and Security data are kept. An ISIN or currency
+ *  too long for SecurityInfo is truncated.
+ *
+ *  @param securityId - Security ID
+ *  @param isin       - ISIN
+ *  @param currency   - Currency
+ *  @return Slot of the Security
+ */
+size_t OrderReportCollection::Insert(const int securityId, std::string_view isin, std::string_view currency)
+{
+    size_t indexPos = FindIndexPos(securityId);
+    if (index[indexPos].slot != EMPTY_SLOT)
+        return static_cast<size_t>(index[indexPos].slot);
+
+    size_t slot = AddSlot(indexPos, securityId);
+    securityInfos[slot].ISIN.Assign(isin);
+    securityInfos[slot].currency.Assign(currency);
+    return slot;
+}
+
+
+/** @brief Finds a Security, inserting it if it isn't in the collection
+ * 
+ *  Any Security inserted will have no ISIN or Currency.
+ *
+ *  @param securityId - Security ID
+ *  @return Slot of the Security
+ */
+size_t OrderReportCollection::FindOrInsert(const int securityId)
+{
+    size_t indexPos = FindIndexPos(securityId);
+    if (index[indexPos].slot != EMPTY_SLOT)
+        return static_cast<size_t>(index[indexPos].slot);
+
+    return AddSlot(indexPos, securityId);
+}
+
+
+/** @brief Merges another collection into this one
+ * 
+ *  The Order Data of each Security in the other collection is merged into this collection's
+ *  Order Report for the Security, which is inserted if this collection doesn't have it yet.
+ *  Where both collections have a Security its ISIN & currency are kept from this collection.
+ *  Every Order Report merged into is marked as changed. If the other collection keeps sketches
+ *  then so will this one.
+ *
+ *  @param other - Collection to merge in
+ *  @return void
+ */
+void OrderReportCollection::Merge(const OrderReportCollection& other)
+{
+    if (other.sketchesEnabled)
+        sketchesEnabled = true;
+
+    for (size_t otherSlot = 0; otherSlot < other.Size(); ++otherSlot)
+    {
+        const SecurityInfo& otherInfo = other.securityInfos[otherSlot];
+        size_t slot = Insert(other.orderReports[otherSlot].GetSecurityId(), otherInfo.ISIN.View(), otherInfo.currency.View());
+
+        MergeSlot(slot, other, otherSlot);
+        MarkChanged(slot);
+    }
+}
+
+
+/** @brief Merges the Order Data of one Security in another collection into a slot
+ * 
+ *  The Security's sketches are merged too, if both collections keep them, and so is its activity.
+ *
+ *  @param slot      - Slot of the Security in this collection
+ *  @param other     - Collection holding the Order Data to merge in
+ *  @param otherSlot - Slot of the Security in the other collection
+ *  @return void
+ */
+void OrderReportCollection::MergeSlot(const size_t slot, const OrderReportCollection& other, const size_t otherSlot)
+{
+    orderReports[slot].Merge(other.orderReports[otherSlot]);
+
+    const OrderSketches* otherSketches = other.GetSketches(otherSlot);
+    if (sketchesEnabled && otherSketches != nullptr)
+        GetOrCreateSketches(slot).Merge(*otherSketches);
+
+    activities[slot].Merge(other.activities[otherSlot]);
+}
+
+
+/** @brief Adds a batch of Orders to the Order Reports of their Securities
+ * 
+ *  The batch is grouped by Security, so each Security is only looked up once, however many Orders
+ *  it has in the batch, and the totals of its Orders are added in one go. Securities not in the
+ *  collection are inserted, in the order their first Orders were added to the batch, so every
+ *  Security gets the same slot as it would if the Orders were added one at a time. When sketches
+ *  are kept, each Order is added to its Security's sketches in the order it was added to the batch.
+ *
+ *  @param batch - Batch of Orders. Left grouped, but not cleared.
+ *  @return void
+ */
+void OrderReportCollection::AddOrderBatch(OrderBatch& batch)
+{
+    const std::vector<OrderBatchGroup>& groups = batch.GroupBySecurity();
+    std::vector<size_t> groupSlots(groups.size());
+    std::vector<size_t> newGroups;
+
+    for (size_t group = 0; group < groups.size(); ++group)
+    {
+        groupSlots[group] = Find(groups[group].securityId);
+        if (groupSlots[group] == NOT_FOUND)
+            newGroups.push_back(group);
+    }
+
+    std::sort(newGroups.begin(), newGroups.end(), [&batch, &groups](const size_t lhs, const size_t rhs)
+    {
+        return batch.GetGroupedOrder(groups[lhs].start) < batch.GetGroupedOrder(groups[rhs].start);
+    });
+    for (size_t group : newGroups)
+        groupSlots[group] = FindOrInsert(groups[group].securityId);
+
+    for (size_t group = 0; group < groups.size(); ++group)
+        orderReports[groupSlots[group]].AddOrderTotals(batch.SumGroup(groups[group]));
+
+    if (!sketchesEnabled)
+        return;
+
+    std::vector<size_t> orderSlots(batch.Size());
+    for (size_t group = 0; group < groups.size(); ++group)
+    {
+        for (size_t pos = groups[group].start; pos < groups[group].start + groups[group].count; ++pos)
+            orderSlots[batch.GetGroupedOrder(pos)] = groupSlots[group];
+    }
+    for (size_t order = 0; order < orderSlots.size(); ++order)
+        GetOrCreateSketches(orderSlots[order]).AddOrderData(batch.GetOrderData(order));
+}
+
+
+/** @brief Turns the sketches of each Security's Orders on or off
+ * 
+ *  Only Orders added while they are on are counted in the sketches, so they should be turned on
+ *  before any Orders are added.
+ *
+ *  @param enable - Whether to keep sketches
+ *  @return void
+ */
+void OrderReportCollection::EnableSketches(const bool enable)
+{
+    sketchesEnabled = enable;
+}
+
+
+/** @brief Checks whether sketches of each Security's Orders are kept
+ * 
+ *  @return true if sketches are kept
+ */
+bool OrderReportCollection::SketchesEnabled() const
+{
+    return sketchesEnabled;
+}
+
+
+/** @brief Gets the sketches of the Orders in a slot
+ * 
+ *  @param slot - Slot of the Security
+ *  @return Sketches of the Security, or nullptr if no Orders have been sketched for it
+ */
+const OrderSketches* OrderReportCollection::GetSketches(const size_t slot) const
+{
+    return (sketchSlots[slot] != NO_SKETCHES) ? &sketches[sketchSlots[slot]] : nullptr;
+}
+
+
+/** @brief Reserves space for a number of Securities
+ * 
+ *  Avoids growing the arrays and rebuilding the index while the Securities are inserted.
+ *
+ *  @param numSecurities - Number of Securities to reserve space for
+ *  @return void
+ */
+void OrderReportCollection::Reserve(const size_t numSecurities)
+{
+    orderReports.reserve(numSecurities);
+    securityInfos.reserve(numSecurities);
+    slotChanged.reserve(numSecurities);
+    sketchSlots.reserve(numSecurities);
+    activities.reserve(numSecurities);
+
+    size_t newIndexSize = index.size();
+    while (newIndexSize < numSecurities * 2)
+        newIndexSize *= 2;
+
+    if (newIndexSize != index.size())
+        ResizeIndex(newIndexSize);
+}
+
+
+/** @brief Removes every Security from the collection
+ * 
+ *  @return void
+ */
+void OrderReportCollection::Clear()
+{
+    index.assign(MIN_INDEX_SIZE, IndexEntry{ 0, EMPTY_SLOT });
+    indexMask = MIN_INDEX_SIZE - 1;
+    orderReports.clear();
+    securityInfos.clear();
+    slotChanged.clear();
+    changedSlots.clear();
+    sketchSlots.clear();
+    sketches.clear();
+    activities.clear();
+}
+
+
+/** @brief Gets the number of Securities in the collection
+ * 
+ *  Slots run from 0 to Size() - 1, in the order the Securities were inserted.
+ *
+ *  @return Number of Securities
+ */
+size_t OrderReportCollection::Size() const
+{
+    return orderReports.size();
+}
+
+
+/** @brief Gets the Security data in a slot
+ * 
+ *  @param slot - Slot of the Security
+ *  @return Security data
+ */
+const SecurityInfo& OrderReportCollection::GetSecurityInfo(const size_t slot) const
+{
+    return securityInfos[slot];
+}
+
+
+/** @brief Gets the slots marked as changed
+ * 
+ *  @return Changed slots, in the order they were first marked
+ */
+const std::vector<uint32_t>& OrderReportCollection::GetChangedSlots() const
+{
+    return changedSlots;
+}
+
+
+/** @brief Clears every change marked so far
+ * 
+ *  @return void
+ */
+void OrderReportCollection::ClearChanges()
+{
+    for (uint32_t slot : changedSlots)
+        slotChanged[slot] = 0;
+    changedSlots.clear();
+}
+
+
+/** @brief Adds a new slot for a Security
+ * 
+ *  The index is kept at most half full so that probe sequences stay short.
+ *
+ *  @param indexPos   - Position of the empty index entry for the Security
+ *  @param securityId - Security ID
+ *  @return Slot of the Security
+ */
+size_t OrderReportCollection::AddSlot(const size_t indexPos, const int securityId)
+{
+    size_t slot = orderReports.size();
+    OrderReport newOrdRpt = OrderReport();
+    newOrdRpt.SetSecurityId(securityId);
+    orderReports.push_back(newOrdRpt);
+    securityInfos.emplace_back();
+    slotChanged.push_back(0);
+    sketchSlots.push_back(NO_SKETCHES);
+    activities.push_back(OrderActivity{ 0, 0, 0, 0 });
+
+    index[indexPos] = IndexEntry{ securityId, static_cast<int32_t>(slot) };
+
+    if (orderReports.size() * 2 > index.size())
+        ResizeIndex(index.size() * 2);
+
+    return slot;
+}
+
+
+/** @brief Rebuilds the index with a new size
+ * 
+ *  @param newIndexSize - New number of index entries. Must be a power of 2.
+ *  @return void
+ */
+void OrderReportCollection::ResizeIndex(const size_t newIndexSize)
+{
+    index.assign(newIndexSize, IndexEntry{ 0, EMPTY_SLOT });
+    indexMask = newIndexSize - 1;
+
+    for (size_t slot = 0; slot < orderReports.size(); ++slot)
+    {
+        int securityId = orderReports[slot].GetSecurityId();
+        index[FindIndexPos(securityId)] = IndexEntry{ securityId, static_cast<int32_t>(slot) };
+    }
+}
@@ -0,0 +1,274 @@
+/** @file OrderReportShard.cpp
+ *  @brief Writes and reads the partial Order Reports of one shard of a sharded aggregation
+ *
+ *  In a sharded aggregation the Security IDs are split into partitions by their hash, and each
+ *  shard only aggregates the Securities in its own partition. Every Order Add for a Security goes
+ *  to the same shard, so each Security's Order Report is exactly what a single process would have
+ *  made. Each shard sends its Order Reports to a coordinator as a Shard Partial, and the coordinator
+ *  merges the Shard Partials of every shard into the final reports.
+ *
+ *  Along with each Order Report a Shard Partial holds the line of the input file that first
+ *  referenced the Security, so the coordinator can put the Securities of every shard back into the
+ *  order a single process would have had them in. The Orders still pending, and the number dropped,
+ *  are kept too so unresolved Orders are reported the same way.
+ *
+ *  A Shard Partial is laid out much like a checkpoint, as the structs are held in memory:
+ *    ShardPartialHeader | OrderReport[numSecurities] | SecurityInfo[numSecurities] | uint64_t referenceLine[numSecurities] |
+ *    OrderActivity[numActivities] | CheckpointPendingOrder[numPendingOrders] |
+ *    uint32_t sketchIndex[numSecurities] | OrderSketches[numSketches]
+ *  Activity is only kept when live Orders are tracked, so numActivities is either numSecurities or 0.
+ *  The sketch indexes and sketches are left out when there are no sketches. A Shard Partial is written
+ *  front to back in a single pass, so it can be streamed down a pipe as well as written to a file.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <cstring>
+#include "OrderReportShard.h"
+#include "MappedFile.h"
+
+/** @brief Appends the raw bytes of an array to the Output Buffer
+ *
+ *  @param outBuffer - Buffer to append to
+ *  @param values    - First value of the array
+ *  @param count     - Number of values in the array
+ *  @return void
+ */
+template <typename T>
+static void AppendRaw(OutputBuffer& outBuffer, const T* values, const size_t count)
+{
+    if (count > 0)
+        outBuffer.Append(std::string_view(reinterpret_cast<const char*>(values), count * sizeof(T)));
+}
+
+
+/** @brief Writes the Shard Partial of one shard
+ *
+ *  @param outBuffer      - Buffer to write the Shard Partial to, e.g. one end of a pipe
+ *  @param shard          - Shard the Order Reports were aggregated by
+ *  @param numShards      - Number of shards
+ *  @param ordRptColl     - Collection of the shard's Order Reports
+ *  @param referenceLines - Line of the input file that first referenced each Security in the collection
+ *  @param pendingOrders  - Orders still waiting for their Security to be referenced
+ *  @param writeActivity  - Whether live Orders were tracked, so the resting & executed quantity of each Security is written
+ *  @return true if the Shard Partial was written
+ */
+bool OrderReportShard::Write( OutputBuffer&                outBuffer,
+                              const size_t                 shard,
+                              const size_t                 numShards,
+                              const OrderReportCollection& ordRptColl,
+                              const std::vector<uint64_t>& referenceLines,
+                              const PendingOrderBuffer&    pendingOrders,
+                              const bool                   writeActivity )
+{
+    size_t numSecurities = ordRptColl.Size();
+    if (!outBuffer.IsOpen() || referenceLines.size() != numSecurities)
+        return false;
+
+    size_t numSketches = 0;
+    for (size_t slot = 0; slot < numSecurities; ++slot)
+    {
+        if (ordRptColl.GetSketches(slot) != nullptr)
+            ++numSketches;
+    }
+
+    // Zeroed first so that the padding bytes written are always the same
+    //
+    ShardPartialHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.orderReportSize = sizeof(OrderReport);
+    header.securityInfoSize = sizeof(SecurityInfo);
+    header.orderSketchesSize = sizeof(OrderSketches);
+    header.orderActivitySize = sizeof(OrderActivity);
+    header.shard = static_cast<uint32_t>(shard);
+    header.numShards = static_cast<uint32_t>(numShards);
+    header.ordersTracked = writeActivity ? 1 : 0;
+    header.numSecurities = numSecurities;
+    header.numActivities = writeActivity ? numSecurities : 0;
+    header.numPendingOrders = pendingOrders.Size();
+    header.numDroppedOrders = pendingOrders.GetNumDropped();
+    header.numSketches = numSketches;
+
+    AppendRaw(outBuffer, &header, 1);
+    if (numSecurities > 0)
+    {
+        AppendRaw(outBuffer, &ordRptColl.GetOrderReport(0), numSecurities);
+        AppendRaw(outBuffer, &ordRptColl.GetSecurityInfo(0), numSecurities);
+        AppendRaw(outBuffer, referenceLines.data(), numSecurities);
+        if (writeActivity)
+            AppendRaw(outBuffer, &ordRptColl.GetActivity(0), numSecurities);
+    }
+    pendingOrders.ForEachOrder([&outBuffer](const int securityId, const OrderAddData& ordData, const PendingOrderState& state)
+    {
+        CheckpointPendingOrder pendingOrder = { securityId, static_cast<uint32_t>(ordData.side), ordData.quantity, ordData.price, ordData.timestamp, ordData.orderId,
+                                                state.restingQuantity, state.restingPrice, state.executedQuantity };
+        AppendRaw(outBuffer, &pendingOrder, 1);
+    });
+
+    if (numSketches > 0)
+    {
+        uint32_t sketchIndex = 0;
+        for (size_t slot = 0; slot < numSecurities; ++slot)
+        {
+            uint32_t slotSketchIndex = (ordRptColl.GetSketches(slot) != nullptr) ? sketchIndex++ : NO_SKETCH_INDEX;
+            AppendRaw(outBuffer, &slotSketchIndex, 1);
+        }
+        for (size_t slot = 0; slot < numSecurities; ++slot)
+        {
+            const OrderSketches* sketches = ordRptColl.GetSketches(slot);
+            if (sketches != nullptr)
+                AppendRaw(outBuffer, sketches, 1);
+        }
+    }
+
+    outBuffer.Flush();
+    return true;
+}
+
+
+/** @brief Reads a Shard Partial
+ *
+ *  The Order Reports are copied into the partial's collection, which keeps sketches if the
+ *  Shard Partial has any. Pending orders are kept even if they are over the memory limit. Nothing
+ *  is read if the Shard Partial is truncated or was written by an incompatible build.
+ *
+ *  @param data    - The whole Shard Partial
+ *  @param partial - Shard Partial to read into. Should be empty.
+ *  @return true if the Shard Partial was read
+ */
+bool OrderReportShard::Read(std::string_view data, ShardPartial& partial)
+{
+    if (data.size() < sizeof(ShardPartialHeader))
+        return false;
+
+    ShardPartialHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != VERSION ||
+        header.orderReportSize != sizeof(OrderReport) ||
+        header.securityInfoSize != sizeof(SecurityInfo) ||
+        header.orderSketchesSize != sizeof(OrderSketches) ||
+        header.orderActivitySize != sizeof(OrderActivity) ||
+        header.shard >= header.numShards ||
+        (header.numActivities != 0 && header.numActivities != header.numSecurities) ||
+        header.numSketches > header.numSecurities)
+        return false;
+
+    uint64_t reportsSize = header.numSecurities * sizeof(OrderReport);
+    uint64_t securityInfosSize = header.numSecurities * sizeof(SecurityInfo);
+    uint64_t referenceLinesSize = header.numSecurities * sizeof(uint64_t);
+    uint64_t activitiesSize = header.numActivities * sizeof(OrderActivity);
+    uint64_t pendingSize = header.numPendingOrders * sizeof(CheckpointPendingOrder);
+    uint64_t sketchIndexesSize = (header.numSketches > 0) ? header.numSecurities * sizeof(uint32_t) : 0;
+    uint64_t sketchesSize = header.numSketches * sizeof(OrderSketches);
+    if (data.size() != sizeof(ShardPartialHeader) + reportsSize + securityInfosSize + referenceLinesSize + activitiesSize + pendingSize + sketchIndexesSize + sketchesSize)
+        return false;
+
+    // A Shard Partial received down a pipe isn't aligned, so everything is copied out before it's used
+    //
+    const char* reportData = data.data() + sizeof(ShardPartialHeader);
+    const char* secInfoData = reportData + reportsSize;
+    const char* referenceLineData = secInfoData + securityInfosSize;
+    const char* activityData = referenceLineData + referenceLinesSize;
+    const char* pendingData = activityData + activitiesSize;
+    const char* sketchIndexData = pendingData + pendingSize;
+    const char* sketchData = sketchIndexData + sketchIndexesSize;
+
+    std::vector<SecurityInfo> secInfos(header.numSecurities);
+    if (header.numSecurities > 0)
+        memcpy(secInfos.data(), secInfoData, securityInfosSize);
+    for (const SecurityInfo& secInfo : secInfos)
+    {
+        if (!secInfo.ISIN.IsValid() || !secInfo.currency.IsValid())
+            return false;
+    }
+
+    for (uint64_t i = 0; i < header.numSketches; ++i)
+    {
+        OrderSketches sketches;
+        memcpy(&sketches, sketchData + (i * sizeof(OrderSketches)), sizeof(sketches));
+        if (!sketches.IsValid())
+            return false;
+    }
+    for (uint64_t i = 0; i < header.numSecurities && header.numSketches > 0; ++i)
+    {
+        uint32_t sketchIndex;
+        memcpy(&sketchIndex, sketchIndexData + (i * sizeof(uint32_t)), sizeof(sketchIndex));
+        if (sketchIndex != NO_SKETCH_INDEX && sketchIndex >= header.numSketches)
+            return false;
+    }
+
+    partial.shard = header.shard;
+    partial.numShards = header.numShards;
+    partial.orders.Clear();
+    partial.orders.Reserve(header.numSecurities);
+    partial.orders.EnableSketches(header.numSketches > 0);
+    partial.referenceLines.resize(header.numSecurities);
+    if (header.numSecurities > 0)
+        memcpy(partial.referenceLines.data(), referenceLineData, referenceLinesSize);
+
+    for (uint64_t i = 0; i < header.numSecurities; ++i)
+    {
+        OrderReport ordRpt;
+        memcpy(&ordRpt, reportData + (i * sizeof(OrderReport)), sizeof(ordRpt));
+        size_t slot = partial.orders.Insert(ordRpt.GetSecurityId(), secInfos[i].ISIN.View(), secInfos[i].currency.View());
+        partial.orders.GetOrderReport(slot) = ordRpt;
+        if (header.numActivities > 0)
+            memcpy(&partial.orders.GetActivity(slot), activityData + (i * sizeof(OrderActivity)), sizeof(OrderActivity));
+
+        uint32_t sketchIndex = NO_SKETCH_INDEX;
+        if (header.numSketches > 0)
+            memcpy(&sketchIndex, sketchIndexData + (i * sizeof(uint32_t)), sizeof(sketchIndex));
+        if (sketchIndex != NO_SKETCH_INDEX)
+            memcpy(&partial.orders.GetOrCreateSketches(slot), sketchData + (sketchIndex * sizeof(OrderSketches)), sizeof(OrderSketches));
+    }
+
+    partial.pendingOrders.Clear();
+    partial.pendingOrders.SetOrderIndex(header.ordersTracked != 0);
+    partial.pendingOrders.SetMemoryLimit(SIZE_MAX);
+    for (uint64_t i = 0; i < header.numPendingOrders; ++i)
+    {
+        CheckpointPendingOrder pendingOrder;
+        memcpy(&pendingOrder, pendingData + (i * sizeof(CheckpointPendingOrder)), sizeof(pendingOrder));
+        partial.pendingOrders.Add( pendingOrder.securityId,
+                                   OrderAddData{ static_cast<Side>(pendingOrder.side), pendingOrder.quantity, pendingOrder.price, pendingOrder.timestamp, pendingOrder.orderId },
+                                   PendingOrderState{ pendingOrder.restingQuantity, pendingOrder.restingPrice, pendingOrder.executedQuantity } );
+    }
+    partial.pendingOrders.CountDropped(header.numDroppedOrders);
+
+    return true;
+}
+
+
+/** @brief Reads a Shard Partial written to a file
+ *
+ *  @param partialFile - Shard Partial File Name/Path
+ *  @param partial     - Shard Partial to read into. Should be empty.
+ *  @return true if the Shard Partial was read
+ */
+bool OrderReportShard::ReadFile(const std::string& partialFile, ShardPartial& partial)
+{
+    MappedFile mappedFile;
+    return mappedFile.Open(partialFile) && Read(mappedFile.GetData(), partial);
+}
+
+
+/** @brief Checks that a set of Shard Partials covers every Security exactly once
+ *
+ *  @param partials - Shard Partials to merge
+ *  @return true if there is one Shard Partial from each shard, and they were all split the same way
+ */
+bool OrderReportShard::IsComplete(const std::vector<ShardPartial>& partials)
+{
+    std::vector<bool> seen(partials.size(), false);
+    for (const ShardPartial& partial : partials)
+    {
+        if (partial.numShards != partials.size() || seen[partial.shard])
+            return false;
+        seen[partial.shard] = true;
+    }
+    return !partials.empty();
+}
@@ -0,0 +1,186 @@
+/** @file OrderStore.cpp
+ *  @brief State of every live Order, keyed by Order ID
+ *
+ *  Order Deletes, Modifies & Executes only carry the Order ID, so the Security, side, price and
+ *  remaining quantity of every Order still resting on the book are kept here from its Order Add
+ *  until it's deleted or fully executed.
+ *
+ *  Orders are fixed size entries in a pool made of equal sized blocks. A block is never moved or
+ *  freed once allocated, and the entries of removed Orders go on a free list and are reused, so
+ *  tens of millions of live Orders cost a few large allocations rather than one each, and the
+ *  pool only grows to the largest number of Orders live at once.
+ *
+ *  Order IDs are mapped to their entry through an open addressing hash index with linear probing.
+ *  Each index entry holds the position of the Order's entry next to the top 32 bits of its Order
+ *  ID's hash, 8 bytes in all, so probing only reads the index and the pool is only touched once
+ *  the hash matches. That keeps an index three quarters full as cheap to search as a sparser one,
+ *  and lets the index be rebuilt, or entries shifted, without reading the pool at all. Removed
+ *  Orders are taken out of the index by shifting the entries after them back, so the index never
+ *  fills up with tombstones.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include "OrderStore.h"
+
+OrderStore::OrderStore()
+    : numEntries(0),
+      freeHead(EMPTY_ENTRY),
+      index(MIN_INDEX_SIZE, IndexEntry{ EMPTY_ENTRY, 0 }),
+      indexMask(MIN_INDEX_SIZE - 1),
+      numOrders(0)
+{
+}
+
+OrderStore::~OrderStore()
+{
+}
+
+
+/** @brief Inserts a live Order
+ *
+ *  The new entry only has its Order ID set; the caller fills in the rest. If the Order ID is
+ *  already live its entry is returned as it is. The index is kept at most three quarters full so
+ *  that probe sequences stay within a cache line or two.
+ *
+ *  @param orderId - Order ID
+ *  @return Entry of the Order
+ */
+LiveOrder& OrderStore::Insert(const uint64_t orderId)
+{
+    uint32_t hash = Hash(orderId);
+    size_t indexPos = FindIndexPos(orderId, hash);
+    if (index[indexPos].entry != EMPTY_ENTRY)
+        return Entry(index[indexPos].entry);
+
+    uint32_t entry = AllocateEntry();
+    Entry(entry).orderId = orderId;
+    index[indexPos] = IndexEntry{ entry, hash };
+
+    if (++numOrders * 4 > index.size() * 3)
+        ResizeIndex(index.size() * 2);
+
+    return Entry(entry);
+}
+
+
+/** @brief Removes a live Order
+ *
+ *  Its entry goes on the free list, and every entry after it in the same run of the index is
+ *  shifted back if that brings it closer to where it hashes to, so no lookup ever has to skip
+ *  over a removed Order. Nothing happens if the Order isn't live.
+ *
+ *  @param orderId - Order ID
+ *  @return void
+ */
+void OrderStore::Remove(const uint64_t orderId)
+{
+    size_t indexPos = FindIndexPos(orderId, Hash(orderId));
+    uint32_t entry = index[indexPos].entry;
+    if (entry == EMPTY_ENTRY)
+        return;
+
+    Entry(entry).slot = freeHead;
+    freeHead = entry;
+    --numOrders;
+
+    for (size_t nextPos = (indexPos + 1) & indexMask; index[nextPos].entry != EMPTY_ENTRY; nextPos = (nextPos + 1) & indexMask)
+    {
+        // The entry can fill the gap if the gap lies between where it hashes to and where it is now
+        //
+        size_t homePos = index[nextPos].hash & indexMask;
+        if (((nextPos - homePos) & indexMask) >= ((nextPos - indexPos) & indexMask))
+        {
+            index[indexPos] = index[nextPos];
+            indexPos = nextPos;
+        }
+    }
+    index[indexPos].entry = EMPTY_ENTRY;
+}
+
+
+/** @brief Removes every Order and frees the pool
+ *
+ *  @return void
+ */
+void OrderStore::Clear()
+{
+    blocks.clear();
+    numEntries = 0;
+    freeHead = EMPTY_ENTRY;
+    index.assign(MIN_INDEX_SIZE, IndexEntry{ EMPTY_ENTRY, 0 });
+    index.shrink_to_fit();
+    indexMask = MIN_INDEX_SIZE - 1;
+    numOrders = 0;
+}
+
+
+/** @brief Gets the number of live Orders
+ *
+ *  @return Number of live Orders
+ */
+size_t OrderStore::Size() const
+{
+    return numOrders;
+}
+
+
+/** @brief Gets the memory allocated for the pool & index
+ *
+ *  Counts every block allocated, including the entries on the free list or not yet handed out.
+ *
+ *  @return Memory used, in bytes
+ */
+size_t OrderStore::GetMemoryUsed() const
+{
+    return (blocks.size() * BLOCK_SIZE * sizeof(LiveOrder)) + (index.capacity() * sizeof(IndexEntry));
+}
+
+
+/** @brief Takes an entry off the free list, or from the pool
+ *
+ *  A new block is allocated once every entry of the last one has been handed out.
+ *
+ *  @return Position of the entry
+ */
+uint32_t OrderStore::AllocateEntry()
+{
+    if (freeHead != EMPTY_ENTRY)
+    {
+        uint32_t entry = freeHead;
+        freeHead = Entry(entry).slot;
+        return entry;
+    }
+
+    if ((numEntries & (BLOCK_SIZE - 1)) == 0)
+        blocks.emplace_back(new LiveOrder[BLOCK_SIZE]);
+
+    return numEntries++;
+}
+
+
+/** @brief Rebuilds the index with a new size
+ *
+ *  Only the index is rebuilt, from the hashes it holds; the Orders stay where they are in the pool.
+ *
+ *  @param newIndexSize - New number of index entries. Must be a power of 2, and no more than 2^32.
+ *  @return void
+ */
+void OrderStore::ResizeIndex(const size_t newIndexSize)
+{
+    std::vector<IndexEntry> oldIndex(newIndexSize, IndexEntry{ EMPTY_ENTRY, 0 });
+    oldIndex.swap(index);
+    indexMask = newIndexSize - 1;
+
+    for (const IndexEntry& indexEntry : oldIndex)
+    {
+        if (indexEntry.entry == EMPTY_ENTRY)
+            continue;
+
+        size_t indexPos = indexEntry.hash & indexMask;
+        while (index[indexPos].entry != EMPTY_ENTRY)
+            indexPos = (indexPos + 1) & indexMask;
+        index[indexPos] = indexEntry;
+    }
+}
@@ -0,0 +1,317 @@
+/** @file PendingOrderBuffer.cpp
+ *  @brief Holds Order Adds for Securities that haven't been referenced yet
+ *
+ *  An Order Add can appear in the input file before the Security Reference Data for its Security.
+ *  Rather than discarding it, the order is held here until the Security is referenced, and is then
+ *  replayed into the Security's new Order Report. This lets an out of order input file be read
+ *  correctly in a single pass.
+ *
+ *  Orders are stored as packed entries in a single arena, chained together per Security in the
+ *  order they arrived. Entries freed by a replay are reused, so the arena only grows to the largest
+ *  number of orders pending at once. A memory limit caps how big the buffer can get; orders that
+ *  would take it over the limit are dropped and counted.
+ *
+ *  When live Orders are tracked, the pending orders are also indexed by Order ID, so that an Order
+ *  Delete, Modify or Execute read while its Order Add is still pending is applied to the pending
+ *  order. Its resting & executed quantity are then replayed along with it. A pending order that is
+ *  deleted or fully executed leaves the index, so later updates of it are unknown, as they would be
+ *  for a live Order.
+ *
+ *  An entry only holds what every pending order needs. The Order ID & state of each entry, and its
+ *  timestamp, are kept in side arrays that are only filled while they are needed, i.e. while the
+ *  orders are indexed and while timestamps are kept for the interval report.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include "PendingOrderBuffer.h"
+
+PendingOrderBuffer::PendingOrderBuffer()
+    : freeHead(END_OF_CHAIN),
+      indexOrders(false),
+      keepTimestamps(false),
+      numOrders(0),
+      numDropped(0),
+      memoryLimit(0)
+{
+}
+
+PendingOrderBuffer::~PendingOrderBuffer()
+{
+}
+
+
+/** @brief Sets the memory limit
+ * 
+ *  Orders already pending are kept, even if they are over the new limit.
+ *
+ *  @param memoryLimit_ - Most memory, in bytes, the pending orders may use. 0 to hold no orders at all.
+ *  @return void
+ */
+void PendingOrderBuffer::SetMemoryLimit(const size_t memoryLimit_)
+{
+    memoryLimit = memoryLimit_;
+}
+
+
+/** @brief Gets the memory limit
+ * 
+ *  @return Most memory, in bytes, the pending orders may use
+ */
+size_t PendingOrderBuffer::GetMemoryLimit() const
+{
+    return memoryLimit;
+}
+
+
+/** @brief Gets the memory used by the pending orders
+ * 
+ *  Counts the orders, chains & Order ID index entries currently in use, rather than what has been
+ *  allocated, so replaying orders frees memory up for new ones.
+ *
+ *  @return Memory used, in bytes
+ */
+size_t PendingOrderBuffer::GetMemoryUsed() const
+{
+    return (numOrders * GetEntrySize()) + (chains.size() * CHAIN_OVERHEAD) + (orderEntries.size() * ORDER_INDEX_OVERHEAD);
+}
+
+
+/** @brief Gets the memory used by an entry, including its side arrays
+ * 
+ *  @return Memory used by each entry, in bytes
+ */
+size_t PendingOrderBuffer::GetEntrySize() const
+{
+    return sizeof(PendingOrder) + (indexOrders ? sizeof(TrackedOrder) : 0) + (keepTimestamps ? sizeof(uint64_t) : 0);
+}
+
+
+/** @brief Sets whether the pending orders are indexed by Order ID
+ * 
+ *  Needed to apply Order Deletes, Modifies & Executes to pending orders, so enabled when live Orders
+ *  are tracked. The Order ID & state of each entry are only kept while indexed. Only orders added
+ *  from then on are indexed; those already pending are replayed in full.
+ *
+ *  @param enable - Whether to index the pending orders
+ *  @return void
+ */
+void PendingOrderBuffer::SetOrderIndex(const bool enable)
+{
+    if (enable && !indexOrders)
+    {
+        trackedOrders.resize(arena.size());
+        for (size_t entry = 0; entry < arena.size(); ++entry)
+            trackedOrders[entry] = TrackedOrder{ 0, PendingOrderState{ arena[entry].quantity, arena[entry].price, 0 } };
+    }
+    else if (!enable)
+    {
+        trackedOrders = std::vector<TrackedOrder>();
+        orderEntries.clear();
+    }
+    indexOrders = enable;
+}
+
+
+/** @brief Sets whether the timestamp of each pending order is kept
+ * 
+ *  Needed by the interval report. Orders already pending get a timestamp of 0.
+ *
+ *  @param enable - Whether to keep timestamps
+ *  @return void
+ */
+void PendingOrderBuffer::SetTimestamps(const bool enable)
+{
+    if (enable)
+        timestamps.resize(arena.size(), 0);
+    else
+        timestamps = std::vector<uint64_t>();
+    keepTimestamps = enable;
+}
+
+
+/** @brief Holds an order until its Security is referenced
+ * 
+ *  @param securityId - Security ID of the order
+ *  @param ordData    - Order Data
+ *  @return true if the order is pending, false if it was dropped as it would go over the memory limit
+ */
+bool PendingOrderBuffer::Add(const int securityId, const OrderAddData& ordData)
+{
+    return Add(securityId, ordData, PendingOrderState{ ordData.quantity, ordData.price, 0 });
+}
+
+
+/** @brief Holds an order that has already been updated until its Security is referenced
+ * 
+ *  Used to restore pending orders, e.g. from a checkpoint. When indexed, a pending order with the
+ *  same Order ID is replaced, the same as a live Order would be, so nothing of it is left resting.
+ *
+ *  @param securityId - Security ID of the order
+ *  @param ordData    - Order Data, as it was added
+ *  @param state      - What is left of the order after its updates
+ *  @return true if the order is pending, false if it was dropped as it would go over the memory limit
+ */
+bool PendingOrderBuffer::Add(const int securityId, const OrderAddData& ordData, const PendingOrderState& state)
+{
+    auto chainIt = chains.find(securityId);
+    size_t extraMemory = GetEntrySize() + ((chainIt == chains.end()) ? CHAIN_OVERHEAD : 0) + (indexOrders ? ORDER_INDEX_OVERHEAD : 0);
+    if (GetMemoryUsed() + extraMemory > memoryLimit)
+    {
+        ++numDropped;
+        return false;
+    }
+
+    int32_t entry = freeHead;
+    if (entry != END_OF_CHAIN)
+        freeHead = arena[entry].next;
+    else
+    {
+        entry = static_cast<int32_t>(arena.size());
+        arena.emplace_back();
+        if (indexOrders)
+            trackedOrders.emplace_back();
+        if (keepTimestamps)
+            timestamps.emplace_back();
+    }
+    arena[entry] = PendingOrder{ ordData.quantity, ordData.price, END_OF_CHAIN, ordData.side };
+    if (keepTimestamps)
+        timestamps[entry] = ordData.timestamp;
+
+    // Only orders with something left resting are indexed, so deleted ones can't be updated again
+    //
+    if (indexOrders)
+    {
+        trackedOrders[entry] = TrackedOrder{ ordData.orderId, state };
+        auto [orderIt, inserted] = orderEntries.try_emplace(ordData.orderId, entry);
+        if (!inserted)
+        {
+            trackedOrders[orderIt->second].state.restingQuantity = 0;
+            orderIt->second = entry;
+        }
+        if (state.restingQuantity == 0)
+            orderEntries.erase(orderIt);
+    }
+
+    if (chainIt == chains.end())
+        chains.emplace(securityId, PendingChain{ entry, entry, 1 });
+    else
+    {
+        arena[chainIt->second.tail].next = entry;
+        chainIt->second.tail = entry;
+        ++chainIt->second.numOrders;
+    }
+
+    ++numOrders;
+    return true;
+}
+
+
+/** @brief Finds a pending order that is still resting by its Order ID
+ * 
+ *  Only finds orders while they are indexed. Orders that have been deleted or fully executed
+ *  aren't found, the same as they wouldn't be in the Order Store. An update that leaves nothing of
+ *  the order resting should be followed by DeleteOrder.
+ *
+ *  @param orderId - Order ID
+ *  @return What is left of the order, to apply an update to, or nullptr if no such order is pending
+ */
+PendingOrderState* PendingOrderBuffer::FindOrder(const uint64_t orderId)
+{
+    auto orderIt = orderEntries.find(orderId);
+    if (orderIt == orderEntries.end())
+        return nullptr;
+    return &trackedOrders[orderIt->second].state;
+}
+
+
+/** @brief Deletes a pending order by its Order ID
+ * 
+ *  Nothing of it is left resting when it's replayed, though what was executed is still counted.
+ *  It's taken out of the index, so later updates of it aren't found, the same as for a live Order
+ *  that has been removed from the Order Store.
+ *
+ *  @param orderId - Order ID
+ *  @return true if the order was deleted, false if no such order is pending
+ */
+bool PendingOrderBuffer::DeleteOrder(const uint64_t orderId)
+{
+    auto orderIt = orderEntries.find(orderId);
+    if (orderIt == orderEntries.end())
+        return false;
+
+    trackedOrders[orderIt->second].state.restingQuantity = 0;
+    orderEntries.erase(orderIt);
+    return true;
+}
+
+
+/** @brief Removes every pending order
+ * 
+ *  The count of dropped orders is also reset.
+ *
+ *  @return void
+ */
+void PendingOrderBuffer::Clear()
+{
+    arena.clear();
+    trackedOrders.clear();
+    timestamps.clear();
+    freeHead = END_OF_CHAIN;
+    chains.clear();
+    orderEntries.clear();
+    numOrders = 0;
+    numDropped = 0;
+}
+
+
+/** @brief Gets the number of pending orders
+ * 
+ *  @return Number of pending orders
+ */
+size_t PendingOrderBuffer::Size() const
+{
+    return numOrders;
+}
+
+
+/** @brief Gets the number of orders dropped because of the memory limit
+ * 
+ *  @return Number of dropped orders
+ */
+size_t PendingOrderBuffer::GetNumDropped() const
+{
+    return numDropped;
+}
+
+
+/** @brief Counts orders dropped by another Pending Order Buffer
+ * 
+ *  Used when pending orders are gathered from several buffers, e.g. one per shard, so that the
+ *  orders each of them dropped are still reported.
+ *
+ *  @param numOrders_ - Number of orders dropped
+ *  @return void
+ */
+void PendingOrderBuffer::CountDropped(const size_t numOrders_)
+{
+    numDropped += numOrders_;
+}
+
+
+/** @brief Gets the Securities that still have pending orders
+ * 
+ *  @return Security ID & number of pending orders of each Security, ordered by Security ID
+ */
+std::vector<std::pair<int, size_t>> PendingOrderBuffer::GetUnresolved() const
+{
+    std::vector<std::pair<int, size_t>> unresolved;
+    unresolved.reserve(chains.size());
+    for (const auto& chain : chains)
+        unresolved.emplace_back(chain.first, chain.second.numOrders);
+
+    std::sort(unresolved.begin(), unresolved.end());
+    return unresolved;
+}
@@ -0,0 +1,293 @@
+/** @file QuantileSketch.cpp
+ *  @brief Fixed size, mergeable sketch of a distribution of values, for estimating quantiles
+ *
+ *  Counts values in log scale buckets, in the same way as an HDR histogram: each power of 2 is
+ *  split into 2^subBucketBits buckets of equal width, so every bucket is within a fixed relative
+ *  width of the values in it. Values below 2^subBucketBits each have a bucket of their own.
+ *
+ *  Only a window of NUM_BUCKETS consecutive buckets is held, positioned around the values seen so
+ *  far, so the memory used is fixed and nothing is ever allocated. When a value falls outside the
+ *  window the window is moved, if everything counted still fits, or otherwise the resolution is
+ *  halved by merging neighbouring buckets, which doubles the range the window covers. At the
+ *  starting resolution a quantile is estimated to within about 3% of the true value, and the
+ *  window covers a range of 16x. Each halving doubles the error, so values spread over a range
+ *  of 256x are still estimated to within about 6%, and 65536x to within about 12.5%.
+ *
+ *  The smallest & largest values are kept exactly, and estimates are clamped to them.
+ *
+ *  Sketches can be merged, e.g. the sketches built from different parts of the input file, at the
+ *  coarser of the two resolutions.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include "QuantileSketch.h"
+
+static_assert(std::is_trivially_copyable<QuantileSketch>::value, "Sketches are copied & checkpointed as raw bytes");
+
+QuantileSketch::QuantileSketch()
+    : totalCount(0),
+      minValue(UINT64_MAX),
+      maxValue(0),
+      windowStart(0),
+      subBucketBits(MAX_SUB_BUCKET_BITS)
+{
+    memset(counts, 0, sizeof(counts));
+}
+
+
+/** @brief Gets the smallest value counted in a bucket
+ *
+ *  @param bucket  - Index of the bucket
+ *  @param subBits - Resolution, as the log2 of the number of buckets per power of 2
+ *  @return Smallest value in the bucket
+ */
+uint64_t QuantileSketch::BucketLowerBound(const uint32_t bucket, const uint32_t subBits)
+{
+    if (bucket < (1u << subBits))
+        return bucket;
+
+    uint32_t exponent = (bucket >> subBits) + subBits - 1;
+    uint64_t subBucket = bucket & ((1u << subBits) - 1);
+    return ((uint64_t(1) << subBits) + subBucket) << (exponent - subBits);
+}
+
+
+/** @brief Gets the largest value counted in a bucket
+ *
+ *  @param bucket  - Index of the bucket
+ *  @param subBits - Resolution, as the log2 of the number of buckets per power of 2
+ *  @return Largest value in the bucket
+ */
+uint64_t QuantileSketch::BucketUpperBound(const uint32_t bucket, const uint32_t subBits)
+{
+    if (bucket < (1u << subBits))
+        return bucket;
+
+    uint32_t exponent = (bucket >> subBits) + subBits - 1;
+    return BucketLowerBound(bucket, subBits) + ((uint64_t(1) << (exponent - subBits)) - 1);
+}
+
+
+/** @brief Counts a value that falls outside the window
+ *
+ *  The first value counted places the window with the value in the middle of it. After that the
+ *  window is moved to take in the value if it can be, or the resolution is halved until it can.
+ *  At the lowest resolution the window covers every value below 2^63; anything above that is
+ *  counted in the top bucket.
+ *
+ *  @param value - Value to count
+ *  @param count - Number of times to count it
+ *  @return void
+ */
+void QuantileSketch::AddOutsideWindow(const uint64_t value, const uint64_t count)
+{
+    uint32_t bucket = BucketIndex(value, subBucketBits);
+
+    if (totalCount == 0)
+    {
+        windowStart = (bucket > NUM_BUCKETS / 2) ? bucket - NUM_BUCKETS / 2 : 0;
+    }
+    else
+    {
+        while (bucket - windowStart >= NUM_BUCKETS && !MoveWindow(bucket))
+        {
+            // At the lowest resolution the window covers every value below 2^63 once it starts at 0.
+            // Anything above that is counted in the top bucket.
+            //
+            if (subBucketBits == 0)
+            {
+                uint32_t newCounts[NUM_BUCKETS] = {};
+                for (size_t i = 0; i < NUM_BUCKETS; ++i)
+                    newCounts[std::min<size_t>(windowStart + i, NUM_BUCKETS - 1)] += counts[i];
+
+                memcpy(counts, newCounts, sizeof(counts));
+                windowStart = 0;
+                bucket = std::min<uint32_t>(bucket, NUM_BUCKETS - 1);
+                break;
+            }
+
+            HalveResolution();
+            bucket = BucketIndex(value, subBucketBits);
+        }
+    }
+
+    counts[bucket - windowStart] += static_cast<uint32_t>(count);
+    totalCount += count;
+}
+
+
+/** @brief Moves the window so that it covers a bucket as well as every bucket counted so far
+ *
+ *  The buckets in use are placed in the middle of the window, leaving room either side.
+ *
+ *  @param bucket - Index of the bucket to take in
+ *  @return true if the window was moved, false if it can't cover all of the buckets at once
+ */
+bool QuantileSketch::MoveWindow(const uint32_t bucket)
+{
+    size_t firstUsed = 0;
+    while (counts[firstUsed] == 0)
+        ++firstUsed;
+    size_t lastUsed = NUM_BUCKETS - 1;
+    while (counts[lastUsed] == 0)
+        --lastUsed;
+
+    uint32_t lowest = std::min<uint32_t>(bucket, windowStart + static_cast<uint32_t>(firstUsed));
+    uint32_t highest = std::max<uint32_t>(bucket, windowStart + static_cast<uint32_t>(lastUsed));
+    if (highest - lowest >= NUM_BUCKETS)
+        return false;
+
+    uint32_t margin = static_cast<uint32_t>(NUM_BUCKETS - 1 - (highest - lowest)) / 2;
+    uint32_t newWindowStart = (lowest > margin) ? lowest - margin : 0;
+
+    uint32_t newCounts[NUM_BUCKETS] = {};
+    for (size_t i = firstUsed; i <= lastUsed; ++i)
+        newCounts[windowStart + i - newWindowStart] = counts[i];
+
+    memcpy(counts, newCounts, sizeof(counts));
+    windowStart = newWindowStart;
+    return true;
+}
+
+
+/** @brief Halves the resolution, merging each pair of neighbouring buckets
+ *
+ *  The buckets in use then take up about half as much of the window.
+ *
+ *  @return void
+ */
+void QuantileSketch::HalveResolution()
+{
+    uint32_t newSubBits = subBucketBits - 1;
+    uint32_t newCounts[NUM_BUCKETS] = {};
+    uint32_t newWindowStart = 0;
+    bool placed = false;
+
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        uint32_t newBucket = BucketIndex(BucketLowerBound(windowStart + static_cast<uint32_t>(i), subBucketBits), newSubBits);
+        if (!placed)
+        {
+            newWindowStart = newBucket;
+            placed = true;
+        }
+        newCounts[newBucket - newWindowStart] += counts[i];
+    }
+
+    memcpy(counts, newCounts, sizeof(counts));
+    windowStart = newWindowStart;
+    subBucketBits = newSubBits;
+}
+
+
+/** @brief Merges another sketch into this one
+ *
+ *  Gives the same result as if every value had been added to this sketch, at the coarser of
+ *  the two resolutions.
+ *
+ *  @param other - Sketch to merge in
+ *  @return void
+ */
+void QuantileSketch::Merge(const QuantileSketch& other)
+{
+    if (other.totalCount == 0)
+        return;
+
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+
+    if (totalCount == 0)
+        subBucketBits = std::min(subBucketBits, other.subBucketBits);
+    while (subBucketBits > other.subBucketBits)
+        HalveResolution();
+
+    // Each of the other sketch's buckets falls inside one of ours, so its smallest value stands for all of it
+    //
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+        if (other.counts[i] == 0)
+            continue;
+
+        uint64_t value = BucketLowerBound(other.windowStart + static_cast<uint32_t>(i), other.subBucketBits);
+        uint32_t windowPos = BucketIndex(value, subBucketBits) - windowStart;
+        if (windowPos < NUM_BUCKETS && totalCount > 0)
+        {
+            counts[windowPos] += other.counts[i];
+            totalCount += other.counts[i];
+        }
+        else
+            AddOutsideWindow(value, other.counts[i]);
+    }
+}
+
+
+/** @brief Estimates a quantile of the values added
+ *
+ *  Finds the bucket holding the value of that rank, and gives the middle of the bucket, clamped
+ *  to the smallest & largest values added.
+ *
+ *  @param fraction - Quantile to estimate, from 0 to 1, e.g. 0.95 for the 95th percentile
+ *  @return Estimated value of the quantile, or 0 if no values have been added
+ */
+uint64_t QuantileSketch::Quantile(const double fraction) const
+{
+    if (totalCount == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(totalCount)));
+    rank = std::min(std::max<uint64_t>(rank, 1), totalCount);
+    if (rank == totalCount)
+        return maxValue;
+
+    uint64_t countSoFar = 0;
+    size_t i = 0;
+    for (; i < NUM_BUCKETS - 1; ++i)
+    {
+        countSoFar += counts[i];
+        if (countSoFar >= rank)
+            break;
+    }
+
+    uint64_t lowerBound = BucketLowerBound(windowStart + static_cast<uint32_t>(i), subBucketBits);
+    uint64_t upperBound = BucketUpperBound(windowStart + static_cast<uint32_t>(i), subBucketBits);
+    return std::min(std::max(lowerBound + (upperBound - lowerBound) / 2, minValue), maxValue);
+}
+
+
+/** @brief Gets the number of values added
+ *
+ *  @return Number of values
+ */
+uint64_t QuantileSketch::GetCount() const
+{
+    return totalCount;
+}
+
+
+/** @brief Checks the sketch is consistent
+ *
+ *  Always true unless the bytes came from somewhere else, e.g. a corrupt checkpoint.
+ *
+ *  @return true if the sketch can be used safely
+ */
+bool QuantileSketch::IsValid() const
+{
+    if (subBucketBits > MAX_SUB_BUCKET_BITS || windowStart > BucketIndex(UINT64_MAX, subBucketBits))
+        return false;
+    if (totalCount > 0 && minValue > maxValue)
+        return false;
+
+    uint64_t countSum = 0;
+    for (uint32_t count : counts)
+        countSum += count;
+    return countSum == totalCount;
+}
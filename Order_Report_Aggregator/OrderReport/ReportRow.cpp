@@ -0,0 +1,107 @@
+/** @file ReportRow.cpp
+ *  @brief A row of a report, formatted once and written with any delimiter
+ *
+ *  Holds the fields of one row of a report. Numbers are converted to text as they are
+ *  added, with std::to_chars, into a buffer inside the row, so building a row never
+ *  allocates. The same row can then be appended to any number of outputs, each with its
+ *  own delimiter, without formatting it again.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <charconv>
+#include "ReportRow.h"
+
+ReportRow::ReportRow()
+    : numFields(0),
+      numberBufferUsed(0)
+{
+}
+
+
+/** @brief Removes every field from the row
+ * 
+ *  @return void
+ */
+void ReportRow::Clear()
+{
+    numFields = 0;
+    numberBufferUsed = 0;
+}
+
+
+/** @brief Adds a text field to the row
+ * 
+ *  The text isn't copied, so it must stay valid for as long as the row is used.
+ *  Fields past MAX_FIELDS are ignored.
+ *
+ *  @param field - Text of the field
+ *  @return void
+ */
+void ReportRow::AddField(std::string_view field)
+{
+    if (numFields < MAX_FIELDS)
+        fields[numFields++] = field;
+}
+
+
+/** @brief Adds a number field to the row
+ * 
+ *  Fields past MAX_FIELDS are ignored.
+ *
+ *  @param number - Value of the field
+ *  @return void
+ */
+void ReportRow::AddField(const size_t number)
+{
+    if (numFields >= MAX_FIELDS)
+        return;
+
+    char* start = numberBuffer + numberBufferUsed;
+    char* end = std::to_chars(start, start + MAX_NUMBER_LENGTH, number).ptr;
+    numberBufferUsed += end - start;
+    AddField(std::string_view(start, end - start));
+}
+
+void ReportRow::AddField(const int number)
+{
+    if (numFields >= MAX_FIELDS)
+        return;
+
+    char* start = numberBuffer + numberBufferUsed;
+    char* end = std::to_chars(start, start + MAX_NUMBER_LENGTH, number).ptr;
+    numberBufferUsed += end - start;
+    AddField(std::string_view(start, end - start));
+}
+
+
+/** @brief Appends the row to an output
+ * 
+ *  Each field is separated by the delimiter, and the row ends with a newline.
+ *
+ *  @param output - Output to append the row to
+ *  @param delim  - The delimiter that will seperate each value
+ *  @return void
+ */
+void ReportRow::AppendTo(std::string& output, const char delim) const
+{
+    for (size_t i = 0; i < numFields; ++i)
+    {
+        if (i > 0)
+            output += delim;
+        output.append(fields[i]);
+    }
+    output += '\n';
+}
+
+void ReportRow::AppendTo(OutputBuffer& output, const char delim) const
+{
+    for (size_t i = 0; i < numFields; ++i)
+    {
+        if (i > 0)
+            output.Append(delim);
+        output.Append(fields[i]);
+    }
+    output.Append('\n');
+}
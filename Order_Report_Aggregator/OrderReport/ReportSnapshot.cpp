@@ -0,0 +1,168 @@
+/** @file ReportSnapshot.cpp
+ *  @brief Read-only copies of the Order Report collection, published for other threads to read
+ *
+ *  The thread reading the input file publishes a Report Snapshot every so often: a copy of the
+ *  Order Report collection as it stood at that point. Other threads, e.g. the query server, read
+ *  the latest snapshot without taking any lock, so a reader never holds up the Order Adds being
+ *  aggregated, and publishing never waits for a reader.
+ *
+ *  Snapshots are reclaimed with epochs. A reader announces the epoch it started reading in before
+ *  it picks up the latest snapshot, and clears it once it's done. A snapshot that has been replaced
+ *  is only reused once every reader is either idle or started reading after it was replaced, so
+ *  it can't be overwritten while anyone could still be reading it. Reused snapshots keep the
+ *  memory of their vectors, so once there are enough of them publishing doesn't allocate.
+ *
+ *  Only one thread may publish. Each reading thread registers once, up to MAX_READERS of them.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include "PipelineStats.h"
+#include "ReportSnapshot.h"
+
+SnapshotPublisher::SnapshotPublisher()
+    : current(nullptr),
+      globalEpoch(IDLE_EPOCH + 1),
+      numReaders(0),
+      numPublished(0)
+{
+    for (ReaderEpoch& readerEpoch : readerEpochs)
+        readerEpoch.epoch.store(IDLE_EPOCH);
+}
+
+SnapshotPublisher::~SnapshotPublisher()
+{
+}
+
+
+/** @brief Publishes a copy of the Order Report collection as the latest snapshot
+ *
+ *  The copy is made into a snapshot no reader can still be reading, so readers carry on with the
+ *  snapshot they have while it's made. The snapshot it replaces is retired until every reader that
+ *  could have picked it up has finished with it.
+ *
+ *  @param ordRptColl  - Collection of Order Reports to publish
+ *  @param inputOffset - How far through the input file the collection covers
+ *  @return void
+ */
+void SnapshotPublisher::Publish(const OrderReportCollection& ordRptColl, const size_t inputOffset)
+{
+    ScopedStatTimer publishTimer(StatTimer::Publish);
+    ReclaimSnapshots();
+
+    ReportSnapshot* snapshot = nullptr;
+    if (!spare.empty())
+    {
+        snapshot = spare.back();
+        spare.pop_back();
+    }
+    else
+    {
+        snapshots.push_back(std::make_unique<ReportSnapshot>());
+        snapshot = snapshots.back().get();
+    }
+
+    snapshot->orders = ordRptColl;
+    snapshot->sequence = ++numPublished;
+    snapshot->inputOffset = inputOffset;
+
+    // Readers that announce the new epoch are sure to pick up the new snapshot
+    //
+    ReportSnapshot* replaced = current.exchange(snapshot);
+    uint64_t retireEpoch = globalEpoch.fetch_add(1) + 1;
+    if (replaced != nullptr)
+        retired.push_back(RetiredSnapshot{ replaced, retireEpoch });
+}
+
+
+/** @brief Moves the retired snapshots that no reader can still be reading to the spares
+ *
+ *  @return void
+ */
+void SnapshotPublisher::ReclaimSnapshots()
+{
+    uint64_t oldestEpoch = UINT64_MAX;
+    for (size_t reader = 0; reader < numReaders.load(); ++reader)
+    {
+        uint64_t readerEpoch = readerEpochs[reader].epoch.load();
+        if (readerEpoch != IDLE_EPOCH)
+            oldestEpoch = std::min(oldestEpoch, readerEpoch);
+    }
+
+    auto stillRead = [this, oldestEpoch](const RetiredSnapshot& retiredSnapshot)
+    {
+        if (retiredSnapshot.retireEpoch > oldestEpoch)
+            return true;
+        spare.push_back(retiredSnapshot.snapshot);
+        return false;
+    };
+    retired.erase(std::remove_if(retired.begin(), retired.end(), stillRead), retired.end());
+}
+
+
+/** @brief Gets the number of snapshots published
+ *
+ *  Only to be called by the publishing thread.
+ *
+ *  @return Number of snapshots published
+ */
+uint64_t SnapshotPublisher::GetNumPublished() const
+{
+    return numPublished;
+}
+
+
+/** @brief Gets the number of snapshots allocated, whether current, retired or spare
+ *
+ *  Only to be called by the publishing thread.
+ *
+ *  @return Number of snapshots
+ */
+size_t SnapshotPublisher::GetNumSnapshots() const
+{
+    return snapshots.size();
+}
+
+
+/** @brief Registers a thread that reads snapshots
+ *
+ *  @return Reader to pass to Acquire & Release, or NO_READER if MAX_READERS are already registered
+ */
+size_t SnapshotPublisher::RegisterReader()
+{
+    size_t reader = numReaders.load();
+    while (reader < MAX_READERS && !numReaders.compare_exchange_weak(reader, reader + 1))
+    {
+    }
+    return (reader < MAX_READERS) ? reader : NO_READER;
+}
+
+
+/** @brief Scoped Snapshot Constructor
+ *
+ *  @param publisher_ - Publisher of the snapshots
+ *  @param reader_    - Reader registered by the calling thread
+ */
+ScopedSnapshot::ScopedSnapshot(SnapshotPublisher& publisher_, const size_t reader_)
+    : publisher(publisher_),
+      reader(reader_),
+      snapshot(publisher.Acquire(reader))
+{
+}
+
+ScopedSnapshot::~ScopedSnapshot()
+{
+    publisher.Release(reader);
+}
+
+
+/** @brief Gets the snapshot being read
+ *
+ *  @return The snapshot, or nullptr if none had been published
+ */
+const ReportSnapshot* ScopedSnapshot::Get() const
+{
+    return snapshot;
+}
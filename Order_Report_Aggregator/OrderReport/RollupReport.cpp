@@ -0,0 +1,213 @@
+/** @file RollupReport.cpp
+ *  @brief Totals of the Order Reports of groups of Securities, e.g. per currency or per ISIN country
+ *
+ *  A rollup groups the Securities by a Rollup Dimension: their currency, the country prefix of their
+ *  ISIN (its first two letters), or both. Each group is held as one slot of its own Order Report
+ *  collection, so it is written with the same Report Formats as the Securities are. The ISIN & currency
+ *  columns of a group's row hold its key, and are left empty when they aren't part of the key.
+ *
+ *  The group of each Security is resolved once, when it is first mapped, normally as its Security
+ *  Reference Data is read, and kept by slot. The groups' totals are then built by merging the Order
+ *  Report of each Security into its group, which gives the same totals as adding every Order to the
+ *  group as it is read. Building them from the Order Reports, rather than as each Order is read, costs
+ *  nothing per Order and works however the Order Reports were produced, e.g. read in parallel,
+ *  restored from a checkpoint or merged from shards.
+ *
+ *  Groups are written in the order their first Security was inserted, including groups with no Orders.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include "RollupReport.h"
+#include "OutputBuffer.h"
+#include "PipelineStats.h"
+#include "ReportRow.h"
+
+/** @brief Rollup Report Constructor
+ *
+ *  @param dimension_  - What the Securities are grouped by
+ *  @param outputFile_ - Rollup Report File Name/Path
+ *  @param format_     - Columns to report. nullptr for every column (OrderReportSchema).
+ */
+RollupReport::RollupReport(const RollupDimension dimension_, const std::string& outputFile_, const ReportFormat* format_)
+    : dimension(dimension_),
+      outputFile(outputFile_),
+      format((format_ != nullptr) ? format_ : &OrderReportSchema::FORMAT)
+{
+}
+
+RollupReport::~RollupReport()
+{
+}
+
+
+/** @brief Gets the Rollup Dimension with a name
+ *
+ *  @param name      - Name of the dimension: currency, country or country-currency
+ *  @param dimension - Set to the dimension, if the name is known
+ *  @return true if the name is of a Rollup Dimension
+ */
+bool RollupReport::ParseDimension(std::string_view name, RollupDimension& dimension)
+{
+    if (name == "currency")
+        dimension = RollupDimension::Currency;
+    else if (name == "country")
+        dimension = RollupDimension::Country;
+    else if (name == "country-currency")
+        dimension = RollupDimension::CountryCurrency;
+    else
+        return false;
+    return true;
+}
+
+
+/** @brief Gets the name of a Rollup Dimension, as used in the names of the Rollup Report Files
+ *
+ *  @param dimension - Rollup Dimension
+ *  @return Name of the dimension
+ */
+std::string_view RollupReport::GetDimensionName(const RollupDimension dimension)
+{
+    switch (dimension)
+    {
+        case RollupDimension::Currency:        return "currency";
+        case RollupDimension::Country:         return "country";
+        case RollupDimension::CountryCurrency: return "country_currency";
+    }
+    return "";
+}
+
+
+/** @brief Gets what the Securities are grouped by
+ *
+ *  @return Rollup Dimension
+ */
+RollupDimension RollupReport::GetDimension() const
+{
+    return dimension;
+}
+
+
+/** @brief Gets the Rollup Report File
+ *
+ *  @return Rollup Report File Name/Path
+ */
+const std::string& RollupReport::GetOutputFile() const
+{
+    return outputFile;
+}
+
+
+/** @brief Gets the key of the group a Security belongs to
+ *
+ *  The country prefix keeps the quotes the ISIN is written with, so it is written the same way.
+ *
+ *  @param secInfo - ISIN & currency of the Security
+ *  @return ISIN country prefix & currency of the group, each empty if it isn't part of the key
+ */
+SecurityInfo RollupReport::GetGroupKey(const SecurityInfo& secInfo) const
+{
+    SecurityInfo groupKey;
+
+    if (dimension != RollupDimension::Currency)
+    {
+        std::string_view isin = secInfo.ISIN.View();
+        if (!isin.empty() && isin.front() == '"')
+        {
+            std::string country = "\"";
+            country += isin.substr(1, COUNTRY_PREFIX_LENGTH);
+            country += '"';
+            groupKey.ISIN.Assign(country);
+        }
+        else
+            groupKey.ISIN.Assign(isin.substr(0, COUNTRY_PREFIX_LENGTH));
+    }
+
+    if (dimension != RollupDimension::Country)
+        groupKey.currency.Assign(secInfo.currency.View());
+
+    return groupKey;
+}
+
+
+/** @brief Resolves the group of every Security not mapped yet
+ *
+ *  Securities are only ever added to the end of a collection, so only the slots past the last one
+ *  mapped are looked at, and each Security's group is resolved once. New groups are added in the
+ *  order of their first Security.
+ *
+ *  @param ordRptColl - Collection of the Securities' Order Reports
+ *  @return void
+ */
+void RollupReport::MapSecurities(const OrderReportCollection& ordRptColl)
+{
+    for (size_t slot = securityGroups.size(); slot < ordRptColl.Size(); ++slot)
+    {
+        SecurityInfo groupKey = GetGroupKey(ordRptColl.GetSecurityInfo(slot));
+        std::string key(groupKey.ISIN.View());
+        key += '\t';
+        key += groupKey.currency.View();
+
+        auto [groupSlot, inserted] = groupSlots.try_emplace(std::move(key), static_cast<uint32_t>(groupKeys.size()));
+        if (inserted)
+            groupKeys.push_back(groupKey);
+        securityGroups.push_back(groupSlot->second);
+    }
+}
+
+
+/** @brief Builds the totals of every group from the Order Reports of its Securities
+ *
+ *  Maps any Securities not mapped yet first. The groups keep sketches if the Securities do, so
+ *  quantiles can be reported for them too, and their activity is the total of their Securities'.
+ *
+ *  @param ordRptColl - Collection of the Securities' Order Reports
+ *  @return void
+ */
+void RollupReport::Build(const OrderReportCollection& ordRptColl)
+{
+    MapSecurities(ordRptColl);
+
+    groups.Clear();
+    groups.EnableSketches(ordRptColl.SketchesEnabled());
+    groups.Reserve(groupKeys.size());
+    for (size_t group = 0; group < groupKeys.size(); ++group)
+        groups.Insert(static_cast<int>(group), groupKeys[group].ISIN.View(), groupKeys[group].currency.View());
+
+    for (size_t slot = 0; slot < ordRptColl.Size(); ++slot)
+        groups.MergeSlot(securityGroups[slot], ordRptColl, slot);
+}
+
+
+/** @brief Gets the groups, as of the last time they were built
+ *
+ *  @return Collection holding the totals of each group, one slot per group
+ */
+const OrderReportCollection& RollupReport::GetGroups() const
+{
+    return groups;
+}
+
+
+/** @brief Writes every group, as of the last time they were built, to the Rollup Report File
+ *
+ *  @param delim - The delimiter that will seperate each value
+ *  @return void
+ */
+void RollupReport::Write(const char delim) const
+{
+    OutputBuffer outBuffer;
+    ReportRow row;
+
+    outBuffer.Open(outputFile);
+    format->writeHeader(outBuffer, delim);
+    for (size_t group = 0; group < groups.Size(); ++group)
+    {
+        format->formatRow(row, groups, group);
+        row.AppendTo(outBuffer, delim);
+    }
+    outBuffer.Close();
+
+    PipelineStats::Count(StatCounter::RowsWritten, groups.Size());
+}
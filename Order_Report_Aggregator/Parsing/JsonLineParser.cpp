@@ -0,0 +1,605 @@
+/** @file JsonLineParser.cpp
+ *  @brief Pulls the values of a set of keys out of a line of JSON, whatever order they are in
+ *
+ *  Each line is parsed in two stages, in the style of simdjson's structural index. The first stage
+ *  scans the line 64 bytes at a time and builds bitmasks of the quotes, backslashes, colons and
+ *  structural characters (: , { } [ ]) in each block. The second stage removes escaped quotes, takes
+ *  a prefix XOR of the quotes to mark which bytes are inside strings, and drops the colons and
+ *  structural characters inside strings. The colons that are left are then looked at a bit at a time,
+ *  so the bytes in between are never looked at one by one. Each key asked for is only compared at the
+ *  colons with a quote just before them and another quote its length before that, found for a whole
+ *  block at once by shifting the quotes' bitmask.
+ *
+ *  The key of each colon is the string closed by the last quote before it, and is matched against
+ *  the keys asked for at any depth. The value of a key that matches runs from the ':' up to the next
+ *  structural character, with any whitespace around it trimmed. Values are returned as views into the
+ *  line exactly as they appear in it, so a string keeps its quotes. A key whose value is an object or
+ *  array is skipped over, and the keys inside it are looked at instead. The first value of each key is
+ *  the one returned, and parsing stops as soon as every key asked for has been found. Nothing is
+ *  allocated.
+ *
+ *  The bitmasks are built with AVX2 or SSE2, chosen at runtime, with a scalar fallback. Every
+ *  instruction set builds exactly the same bitmasks, so gives exactly the same values.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "JsonLineParser.h"
+
+#ifdef ORA_X86_SIMD
+#include <immintrin.h>
+#endif
+
+SimdLevel JsonLineParser::simdLevel = DetectSimdLevel();
+JsonLineParser::ScanBlocksFunc JsonLineParser::scanBlocks = GetScanBlocksFunc(JsonLineParser::simdLevel);
+
+
+/** @brief Prepares a set of keys to extract
+ *
+ *  @param keyList - Keys to find, without their quotes. Must not hold quotes or backslashes, and must
+ *                   outlive the key set.
+ *  @param count   - Number of keys, no more than MAX_KEYS
+ */
+JsonKeySet::JsonKeySet(const std::string_view* keyList, const size_t count) : numKeys(count), hasLongKeys(false)
+{
+    for (size_t i = 0; i < numKeys; ++i)
+    {
+        const std::string_view key = keyList[i];
+        const size_t wordLength = std::min(key.size(), WORD_SIZE);
+        unsigned char headBytes[WORD_SIZE] = {};
+        unsigned char tailBytes[WORD_SIZE] = {};
+        unsigned char maskBytes[WORD_SIZE] = {};
+
+        // The tail is right aligned, so it lines up with the bytes before the key's closing quote
+        //
+        memcpy(headBytes, key.data(), wordLength);
+        memcpy(tailBytes + WORD_SIZE - wordLength, key.data() + key.size() - wordLength, wordLength);
+        memset(maskBytes + WORD_SIZE - wordLength, 0xFF, wordLength);
+
+        keys[i] = key;
+        memcpy(&heads[i], headBytes, WORD_SIZE);
+        memcpy(&tails[i], tailBytes, WORD_SIZE);
+        memcpy(&tailMasks[i], maskBytes, WORD_SIZE);
+        quoteShifts[i] = static_cast<unsigned char>(key.size() + 2);
+        hasLongKeys |= (key.size() > MAX_MASKED_KEY_LENGTH);
+    }
+}
+
+
+/** @brief Extracts the values of a set of keys from a line
+ *
+ *  Uses the best instruction set the CPU supports, unless another has been chosen with SetSimdLevel.
+ *
+ *  @param inputLine - Line from the input file, holding a JSON object
+ *  @param keySet    - Keys to find
+ *  @param values    - The value of each key, as a view into the line. Empty, with no data, for keys not found.
+ *  @return true if every key was found
+ */
+bool JsonLineParser::ExtractFields(std::string_view inputLine, const JsonKeySet& keySet, std::string_view* values)
+{
+    const char* line = inputLine.data();
+    const size_t lineLength = inputLine.size();
+    const size_t numKeys = keySet.numKeys;
+    const uint64_t allKeys = (uint64_t(1) << numKeys) - 1;
+    uint64_t foundKeys = 0;         // Bit of each key whose value has been found
+    uint64_t stringCarry = 0;       // All ones if the last block ended inside a string
+    bool escapeCarry = false;       // Whether the first byte of the next block is escaped
+    uint64_t lastQuotes = 0;        // Quotes of the block before, for keys that start in it
+    size_t lastQuote = 0;           // Last quote before this block
+    size_t field = numKeys;         // Key whose value runs on into the next block, or numKeys if none does
+    size_t fieldStart = 0;          // Start of that key's value
+
+    for (size_t i = 0; i < numKeys; ++i)
+        values[i] = std::string_view();
+
+    for (size_t chunkStart = 0; chunkStart < lineLength; chunkStart += BLOCKS_PER_SCAN * BLOCK_SIZE)
+    {
+        BlockMasks chunkMasks[BLOCKS_PER_SCAN];
+        const size_t numBlocks = ScanChunk(line + chunkStart, lineLength - chunkStart, chunkMasks);
+
+        for (size_t block = 0; block < numBlocks; ++block)
+        {
+            const size_t blockStart = chunkStart + (block * BLOCK_SIZE);
+            const BlockMasks& masks = chunkMasks[block];
+
+            uint64_t escaped = (masks.backslashes != 0 || escapeCarry) ? FindEscaped(masks.backslashes, escapeCarry) : 0;
+            const uint64_t quotes = masks.quotes & ~escaped;
+            const uint64_t inString = PrefixXor(quotes) ^ stringCarry;
+            stringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+            const uint64_t structurals = masks.structurals & ~inString;
+            const uint64_t colons = masks.colons & ~inString;
+
+            // Stores the value of a key, which runs from its ':' to the next structural character. That
+            // can be in a later block, in which case it's stored once that block is reached.
+            //
+            auto storeValue = [&](const size_t key, const unsigned colonBit)
+            {
+                const uint64_t structuralsAfter = structurals & ~((uint64_t(2) << colonBit) - 1);
+                if (structuralsAfter == 0)
+                {
+                    field = key;
+                    fieldStart = blockStart + colonBit + 1;
+                    return true;
+                }
+
+                values[key] = GetValue(line, blockStart + colonBit + 1, blockStart + __builtin_ctzll(structuralsAfter));
+                foundKeys |= uint64_t(values[key].data() != nullptr) << key;
+                return values[key].data() != nullptr;
+            };
+
+            if (field < numKeys && structurals != 0)
+            {
+                values[field] = GetValue(line, fieldStart, blockStart + __builtin_ctzll(structurals));
+                foundKeys |= uint64_t(values[field].data() != nullptr) << field;
+                field = numKeys;
+            }
+
+            // Nearly every key is followed straight away by its ':'. When that's true of every ':' in the
+            // block, the keys of each length are found for every ':' at once, as those with a quote just
+            // before them and another quote the length of the key before that. Only those are compared.
+            //
+            const uint64_t keyEnds = (quotes << 1) | (lastQuotes >> 63);
+            if ((colons & ~keyEnds) == 0 && !keySet.hasLongKeys)
+            {
+                const uint64_t directColons = colons & keyEnds;
+                for (uint64_t keysLeft = (directColons != 0) ? allKeys & ~foundKeys : 0; keysLeft != 0; keysLeft &= keysLeft - 1)
+                {
+                    const size_t key = static_cast<size_t>(__builtin_ctzll(keysLeft));
+                    const unsigned shift = keySet.quoteShifts[key];
+                    uint64_t candidates = directColons & ((quotes << shift) | (lastQuotes >> (BLOCK_SIZE - shift)));
+
+                    for (; candidates != 0; candidates &= candidates - 1)
+                    {
+                        const unsigned bit = static_cast<unsigned>(__builtin_ctzll(candidates));
+                        if (KeyMatches(line, blockStart + bit - 1, keySet, key) && storeValue(key, bit))
+                            break;
+                    }
+                }
+            }
+            else
+            {
+                // Otherwise each ':' is visited in turn, and its key is the string closed by the last quote before it
+                //
+                for (uint64_t colonsLeft = colons; colonsLeft != 0; colonsLeft &= colonsLeft - 1)
+                {
+                    const unsigned bit = static_cast<unsigned>(__builtin_ctzll(colonsLeft));
+                    const uint64_t quotesBefore = quotes & ((uint64_t(1) << bit) - 1);
+                    const size_t keyEnd = (quotesBefore != 0) ? blockStart + 63 - __builtin_clzll(quotesBefore) : lastQuote;
+                    const size_t key = MatchKey(line, keyEnd, keySet, foundKeys);
+                    if (key < numKeys)
+                        storeValue(key, bit);
+                }
+            }
+
+            if (foundKeys == allKeys)
+                return true;
+
+            lastQuotes = quotes;
+            if (quotes != 0)
+                lastQuote = blockStart + 63 - __builtin_clzll(quotes);
+        }
+    }
+
+    // The last value can also run to the end of a line that was cut short
+    //
+    if (field < numKeys)
+    {
+        values[field] = Trim(inputLine.substr(fieldStart));
+        foundKeys |= uint64_t(1) << field;
+    }
+
+    return foundKeys == allKeys;
+}
+
+
+/** @brief Builds the bitmasks of up to BLOCKS_PER_SCAN blocks from the start of the data
+ *
+ *  The blocks are scanned with a single call, so the SIMD constants are only set up once for most
+ *  lines. A block cut short by the end of the data is scanned in place when that can't read into the
+ *  next page, so can't fault, and the bits past the end are cleared. Otherwise it's copied and padded
+ *  with spaces, which are neither structural nor part of a value.
+ *
+ *  @param data   - Start of the chunk of the line
+ *  @param length - Length of the rest of the line
+ *  @param masks  - Bitmasks of each block
+ *  @return Number of blocks scanned
+ */
+inline size_t JsonLineParser::ScanChunk(const char* data, const size_t length, BlockMasks* masks)
+{
+    size_t numBlocks = length / BLOCK_SIZE;
+    if (numBlocks >= BLOCKS_PER_SCAN)
+    {
+        scanBlocks(data, BLOCKS_PER_SCAN, masks);
+        return BLOCKS_PER_SCAN;
+    }
+
+    const size_t tailLength = length % BLOCK_SIZE;
+    const char* tail = data + (numBlocks * BLOCK_SIZE);
+    if (tailLength == 0)
+    {
+        scanBlocks(data, numBlocks, masks);
+        return numBlocks;
+    }
+
+    if ((reinterpret_cast<uintptr_t>(tail) & (PAGE_SIZE - 1)) <= PAGE_SIZE - BLOCK_SIZE)
+    {
+        scanBlocks(data, numBlocks + 1, masks);
+    }
+    else
+    {
+        char paddedBlock[BLOCK_SIZE];
+        memset(paddedBlock, ' ', BLOCK_SIZE);
+        memcpy(paddedBlock, tail, tailLength);
+        if (numBlocks != 0)
+            scanBlocks(data, numBlocks, masks);
+        scanBlocks(paddedBlock, 1, masks + numBlocks);
+    }
+
+    const uint64_t inData = (uint64_t(1) << tailLength) - 1;
+    BlockMasks& tailMasks = masks[numBlocks];
+    tailMasks.quotes &= inData;
+    tailMasks.backslashes &= inData;
+    tailMasks.colons &= inData;
+    tailMasks.structurals &= inData;
+    return numBlocks + 1;
+}
+
+
+/** @brief Finds which of the keys asked for, if any, is closed by a quote in the line
+ *
+ *  Keys whose value has already been found are skipped, so the first value of each key is kept.
+ *
+ *  @param line      - Start of the line
+ *  @param keyEnd    - Position of the key's closing quote
+ *  @param keySet    - Keys to find
+ *  @param foundKeys - Bit of each key whose value has been found
+ *  @return Index of the key, or the number of keys if it isn't one of them
+ */
+size_t JsonLineParser::MatchKey(const char* line, const size_t keyEnd, const JsonKeySet& keySet, const uint64_t foundKeys)
+{
+    for (size_t key = 0; key < keySet.numKeys; ++key)
+    {
+        const size_t keyLength = keySet.keys[key].size();
+        if (((foundKeys >> key) & 1) == 0 && keyEnd > keyLength && line[keyEnd - keyLength - 1] == '"' &&
+            KeyMatches(line, keyEnd, keySet, key) && !IsEscaped(line, keyEnd - keyLength - 1))
+            return key;
+    }
+
+    return keySet.numKeys;
+}
+
+
+/** @brief Checks whether the characters before a closing quote are a key
+ *
+ *  Keys of up to 16 characters are compared a word at a time, against the first and last 8 bytes
+ *  of the key, rather than with memcmp. The opening quote isn't checked.
+ *
+ *  @param line   - Start of the line
+ *  @param keyEnd - Position of the closing quote, after the opening quote & key
+ *  @param keySet - Keys to find
+ *  @param key    - Index of the key to check for
+ *  @return true if the characters are the key
+ */
+inline bool JsonLineParser::KeyMatches(const char* line, const size_t keyEnd, const JsonKeySet& keySet, const size_t key)
+{
+    constexpr size_t WORD_SIZE = JsonKeySet::WORD_SIZE;
+    const std::string_view& keyName = keySet.keys[key];
+    const char* keyStart = line + keyEnd - keyName.size();
+
+    if (keyEnd < WORD_SIZE || keyName.size() > 2 * WORD_SIZE)
+        return memcmp(keyStart, keyName.data(), keyName.size()) == 0;
+
+    uint64_t tail;
+    memcpy(&tail, line + keyEnd - WORD_SIZE, WORD_SIZE);
+    if ((tail & keySet.tailMasks[key]) != keySet.tails[key])
+        return false;
+    if (keyName.size() <= WORD_SIZE)
+        return true;
+
+    uint64_t head;
+    memcpy(&head, keyStart, WORD_SIZE);
+    return head == keySet.heads[key];
+}
+
+
+/** @brief Checks whether a character is escaped, by an odd number of backslashes before it
+ *
+ *  @param line - Start of the line
+ *  @param pos  - Position of the character
+ *  @return true if the character is escaped
+ */
+bool JsonLineParser::IsEscaped(const char* line, const size_t pos)
+{
+    size_t numBackslashes = 0;
+    while (numBackslashes < pos && line[pos - numBackslashes - 1] == '\\')
+        ++numBackslashes;
+    return (numBackslashes & 1) != 0;
+}
+
+
+/** @brief Gets the value of a key, once the structural character that ends it has been found
+ *
+ *  @param line       - Start of the line
+ *  @param valueStart - Position just after the key's ':'
+ *  @param valueEnd   - Position of the structural character after the value
+ *  @return The trimmed value, or an empty view with no data if the value is an object or array
+ */
+inline std::string_view JsonLineParser::GetValue(const char* line, const size_t valueStart, const size_t valueEnd)
+{
+    if (line[valueEnd] == '{' || line[valueEnd] == '[')
+        return std::string_view();
+
+    // Values are rarely padded, so only trim when they might be
+    //
+    std::string_view value(line + valueStart, valueEnd - valueStart);
+    if (!value.empty() && value.front() > ' ' && value.back() > ' ')
+        return value;
+    return Trim(value);
+}
+
+
+/** @brief Finds the bytes that are escaped by a backslash
+ *
+ *  Each backslash escapes the byte after it, unless it's escaped itself. Only called for blocks
+ *  with a backslash in them, or that start escaped, so it's rarely needed.
+ *
+ *  @param backslashes - Bitmask of the backslashes in the block
+ *  @param escapeCarry - Whether the first byte of the block is escaped. Updated for the next block.
+ *  @return Bitmask of the escaped bytes in the block
+ */
+uint64_t JsonLineParser::FindEscaped(uint64_t backslashes, bool& escapeCarry)
+{
+    uint64_t escaped = escapeCarry ? 1 : 0;
+    escapeCarry = false;
+
+    backslashes &= ~escaped;
+    while (backslashes != 0)
+    {
+        unsigned bit = static_cast<unsigned>(__builtin_ctzll(backslashes));
+        if (bit == BLOCK_SIZE - 1)
+            escapeCarry = true;
+        else
+            escaped |= uint64_t(1) << (bit + 1);
+        backslashes &= backslashes - 1;
+        backslashes &= ~escaped;
+    }
+
+    return escaped;
+}
+
+
+/** @brief Sets each bit to the XOR of itself and every bit below it
+ *
+ *  Applied to the quotes of a block, this sets the bits of an opening quote and everything up to,
+ *  but not including, its closing quote.
+ *
+ *  @param bits - Bitmask
+ *  @return Prefix XOR of the bitmask
+ */
+uint64_t JsonLineParser::PrefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+
+/** @brief Trims whitespace from both ends of a value
+ *
+ *  @param value - Value
+ *  @return The value without leading or trailing whitespace, still pointing into the line
+ */
+std::string_view JsonLineParser::Trim(std::string_view value)
+{
+    auto isSpace = [](const char character) { return character == ' ' || character == '\t' || character == '\r' || character == '\n'; };
+
+    while (!value.empty() && isSpace(value.front()))
+        value.remove_prefix(1);
+    while (!value.empty() && isSpace(value.back()))
+        value.remove_suffix(1);
+    return value;
+}
+
+
+/** @brief Sets the SIMD instruction set used to scan each block
+ *
+ *  A level the CPU doesn't support is lowered to the best one it does. Mainly useful for
+ *  comparing the different scans against each other. Must not be called while any other
+ *  thread is parsing lines.
+ *
+ *  @param level - SIMD level to use
+ *  @return void
+ */
+void JsonLineParser::SetSimdLevel(const SimdLevel level)
+{
+    SimdLevel supportedLevel = DetectSimdLevel();
+    simdLevel = (level < supportedLevel) ? level : supportedLevel;
+    scanBlocks = GetScanBlocksFunc(simdLevel);
+}
+
+
+/** @brief Gets the SIMD instruction set used to scan each block
+ *
+ *  @return SIMD level in use
+ */
+SimdLevel JsonLineParser::GetSimdLevel()
+{
+    return simdLevel;
+}
+
+
+/** @brief Gets the block scan for a SIMD instruction set
+ *
+ *  @param level - SIMD level
+ *  @return Block scan function
+ */
+JsonLineParser::ScanBlocksFunc JsonLineParser::GetScanBlocksFunc(const SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef ORA_X86_SIMD
+        case SimdLevel::AVX2: return ScanBlocksAVX2;
+        case SimdLevel::SSE2: return ScanBlocksSSE2;
+#endif
+        default:              return ScanBlocksScalar;
+    }
+}
+
+
+/** @brief Builds the bitmasks of each block without SIMD
+ *
+ *  Looks at 8 bytes at a time, held in a 64 bit word. '[' & ']' differ from '{' & '}' only in the
+ *  0x20 bit, so setting that bit matches both of each pair at once.
+ *
+ *  @param data      - Start of the blocks
+ *  @param numBlocks - Number of 64 byte blocks
+ *  @param masks     - Bitmasks of each block
+ *  @return void
+ */
+void JsonLineParser::ScanBlocksScalar(const char* data, const size_t numBlocks, BlockMasks* masks)
+{
+    constexpr uint64_t ONES = 0x0101010101010101;
+    constexpr uint64_t FOLD_BITS = 0x20 * ONES;
+
+    for (size_t block = 0; block < numBlocks; ++block, data += BLOCK_SIZE)
+    {
+        BlockMasks blockMasks{ 0, 0, 0, 0 };
+        for (size_t i = 0; i < BLOCK_SIZE; i += WORD_SIZE)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, WORD_SIZE);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            word = __builtin_bswap64(word);
+#endif
+            const uint64_t folded = word | FOLD_BITS;
+            const uint64_t isColon = MatchBytes(word, ':');
+
+            blockMasks.quotes |= PackBytes(MatchBytes(word, '"')) << i;
+            blockMasks.backslashes |= PackBytes(MatchBytes(word, '\\')) << i;
+            blockMasks.colons |= PackBytes(isColon) << i;
+            blockMasks.structurals |= PackBytes(isColon | MatchBytes(word, ',') | MatchBytes(folded, '{') | MatchBytes(folded, '}')) << i;
+        }
+        masks[block] = blockMasks;
+    }
+}
+
+
+/** @brief Finds the bytes of a word equal to a character
+ *
+ *  Exact for every byte, unlike the usual test for a zero byte, which can also flag the byte
+ *  after a match.
+ *
+ *  @param word      - 8 bytes, the first in the lowest byte
+ *  @param character - Character to match
+ *  @return The top bit of each byte that matches
+ */
+uint64_t JsonLineParser::MatchBytes(const uint64_t word, const char character)
+{
+    constexpr uint64_t ONES = 0x0101010101010101;
+    constexpr uint64_t LOW_BITS = 0x7F * ONES;
+
+    const uint64_t diff = word ^ (static_cast<unsigned char>(character) * ONES);
+    return ~(((diff & LOW_BITS) + LOW_BITS) | diff) & ~LOW_BITS;
+}
+
+
+/** @brief Packs the top bit of each byte of a word into the low 8 bits
+ *
+ *  @param topBits - Word with only the top bit of each byte set, if any
+ *  @return One bit per byte, the first byte in the lowest bit
+ */
+uint64_t JsonLineParser::PackBytes(const uint64_t topBits)
+{
+    return ((topBits >> 7) * 0x0102040810204080) >> 56;
+}
+
+#ifdef ORA_X86_SIMD
+
+/** @brief Builds the bitmasks of each block with SSE2
+ *
+ *  Compares 16 bytes at a time, in four steps per block.
+ *
+ *  @param data      - Start of the blocks
+ *  @param numBlocks - Number of 64 byte blocks
+ *  @param masks     - Bitmasks of each block
+ *  @return void
+ */
+void JsonLineParser::ScanBlocksSSE2(const char* data, const size_t numBlocks, BlockMasks* masks)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i foldBit = _mm_set1_epi8(0x20);
+
+    for (size_t block = 0; block < numBlocks; ++block, data += BLOCK_SIZE)
+    {
+        BlockMasks blockMasks{ 0, 0, 0, 0 };
+        for (size_t i = 0; i < BLOCK_SIZE; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i folded = _mm_or_si128(chunk, foldBit);
+            __m128i isColon = _mm_cmpeq_epi8(chunk, colon);
+            __m128i structural = _mm_or_si128(_mm_or_si128(isColon, _mm_cmpeq_epi8(chunk, comma)),
+                                              _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)));
+
+            blockMasks.quotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)))) << i;
+            blockMasks.backslashes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)))) << i;
+            blockMasks.colons |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(isColon))) << i;
+            blockMasks.structurals |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(structural))) << i;
+        }
+        masks[block] = blockMasks;
+    }
+}
+
+
+/** @brief Builds the bitmasks of each block with AVX2
+ *
+ *  Same approach as ScanBlocksSSE2, but compares 32 bytes at a time, in two steps per block.
+ *
+ *  @param data      - Start of the blocks
+ *  @param numBlocks - Number of 64 byte blocks
+ *  @param masks     - Bitmasks of each block
+ *  @return void
+ */
+__attribute__((target("avx2")))
+void JsonLineParser::ScanBlocksAVX2(const char* data, const size_t numBlocks, BlockMasks* masks)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i foldBit = _mm256_set1_epi8(0x20);
+
+    for (size_t block = 0; block < numBlocks; ++block, data += BLOCK_SIZE)
+    {
+        BlockMasks blockMasks{ 0, 0, 0, 0 };
+        for (size_t i = 0; i < BLOCK_SIZE; i += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i folded = _mm256_or_si256(chunk, foldBit);
+            __m256i isColon = _mm256_cmpeq_epi8(chunk, colon);
+            __m256i structural = _mm256_or_si256(_mm256_or_si256(isColon, _mm256_cmpeq_epi8(chunk, comma)),
+                                                 _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)));
+
+            blockMasks.quotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)))) << i;
+            blockMasks.backslashes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)))) << i;
+            blockMasks.colons |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(isColon))) << i;
+            blockMasks.structurals |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(structural))) << i;
+        }
+        masks[block] = blockMasks;
+    }
+}
+
+#endif
@@ -0,0 +1,196 @@
+/** @file MessageClassifier.cpp
+ *  @brief Finds the message type of a line from the input file
+ *
+ *  Locates the "msgType_": heading once and reads the number that follows it, so each
+ *  line is only scanned once however many message types are being handled. The caller
+ *  can then dispatch on the number, rather than searching the line once per message type.
+ *
+ *  The heading is searched for with SSE2 or AVX2, comparing the first and last characters
+ *  of the heading against a whole block of the line at once and only checking the rest of
+ *  the heading where both match. The instruction set is chosen at runtime, with a scalar
+ *  search as a fallback.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <cstring>
+#include "MessageClassifier.h"
+
+#ifdef ORA_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr char MSG_TYPE_HEADING[] = "msgType_\":";
+    constexpr size_t MSG_TYPE_HEADING_LEN = sizeof(MSG_TYPE_HEADING) - 1;
+    constexpr size_t MSG_TYPE_LAST_CHAR = MSG_TYPE_HEADING_LEN - 1;
+    constexpr int MAX_MSG_TYPE_DIGITS = 9;     // Any 9 digit number fits in an int
+}
+
+SimdLevel MessageClassifier::simdLevel = DetectSimdLevel();
+MessageClassifier::FindHeadingFunc MessageClassifier::findHeading = GetFindHeadingFunc(MessageClassifier::simdLevel);
+
+
+/** @brief Finds the message type of a line
+ * 
+ *  Uses the best instruction set the CPU supports, unless another has been chosen with SetSimdLevel.
+ *
+ *  @param inputLine - Line from the input file
+ *  @return The number following "msgType_":, or UNKNOWN_MSG_TYPE if there isn't one or it is too long for an int
+ */
+int MessageClassifier::Classify(std::string_view inputLine)
+{
+    const char* headingPos = findHeading(inputLine.data(), inputLine.size());
+    if (headingPos == nullptr)
+        return UNKNOWN_MSG_TYPE;
+
+    const char* digit = headingPos + MSG_TYPE_HEADING_LEN;
+    const char* lineEnd = inputLine.data() + inputLine.size();
+    if (digit == lineEnd || *digit < '0' || *digit > '9')
+        return UNKNOWN_MSG_TYPE;
+
+    int msgType = 0;
+    int digitCount = 0;
+    for (; digit != lineEnd && *digit >= '0' && *digit <= '9'; ++digit)
+    {
+        if (++digitCount > MAX_MSG_TYPE_DIGITS)
+            return UNKNOWN_MSG_TYPE;
+        msgType = (msgType * 10) + (*digit - '0');
+    }
+
+    return msgType;
+}
+
+
+/** @brief Sets the SIMD instruction set used to find the heading
+ * 
+ *  A level the CPU doesn't support is lowered to the best one it does. Mainly useful for
+ *  comparing the different searches against each other. Must not be called while any
+ *  other thread is classifying lines.
+ *
+ *  @param level - SIMD level to use
+ *  @return void
+ */
+void MessageClassifier::SetSimdLevel(const SimdLevel level)
+{
+    SimdLevel supportedLevel = DetectSimdLevel();
+    simdLevel = (level < supportedLevel) ? level : supportedLevel;
+    findHeading = GetFindHeadingFunc(simdLevel);
+}
+
+
+/** @brief Gets the heading search for a SIMD instruction set
+ * 
+ *  @param level - SIMD level
+ *  @return Heading search function
+ */
+MessageClassifier::FindHeadingFunc MessageClassifier::GetFindHeadingFunc(const SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef ORA_X86_SIMD
+        case SimdLevel::AVX2: return FindHeadingAVX2;
+        case SimdLevel::SSE2: return FindHeadingSSE2;
+#endif
+        default:              return FindHeadingScalar;
+    }
+}
+
+
+/** @brief Gets the SIMD instruction set used to find the heading
+ * 
+ *  @return SIMD level in use
+ */
+SimdLevel MessageClassifier::GetSimdLevel()
+{
+    return simdLevel;
+}
+
+
+/** @brief Finds the "msgType_": heading without SIMD
+ * 
+ *  @param data   - Start of the line
+ *  @param length - Length of the line
+ *  @return Start of the heading, or nullptr if it isn't in the line
+ */
+const char* MessageClassifier::FindHeadingScalar(const char* data, size_t length)
+{
+    size_t headingPos = std::string_view(data, length).find(MSG_TYPE_HEADING);
+    return (headingPos != std::string_view::npos) ? data + headingPos : nullptr;
+}
+
+#ifdef ORA_X86_SIMD
+
+/** @brief Finds the "msgType_": heading with SSE2
+ * 
+ *  Compares 16 possible heading positions at a time. A position is only checked in
+ *  full when both the first ('m') and last (':') characters of the heading match.
+ *  Whatever is left at the end of the line is handed to the scalar search.
+ *
+ *  @param data   - Start of the line
+ *  @param length - Length of the line
+ *  @return Start of the heading, or nullptr if it isn't in the line
+ */
+const char* MessageClassifier::FindHeadingSSE2(const char* data, size_t length)
+{
+    const __m128i firstChar = _mm_set1_epi8(MSG_TYPE_HEADING[0]);
+    const __m128i lastChar = _mm_set1_epi8(MSG_TYPE_HEADING[MSG_TYPE_LAST_CHAR]);
+    size_t pos = 0;
+
+    for (; pos + MSG_TYPE_LAST_CHAR + 16 <= length; pos += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + MSG_TYPE_LAST_CHAR));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, firstChar), _mm_cmpeq_epi8(blockLast, lastChar))));
+
+        while (mask != 0)
+        {
+            size_t candidate = pos + __builtin_ctz(mask);
+            if (memcmp(data + candidate + 1, MSG_TYPE_HEADING + 1, MSG_TYPE_LAST_CHAR - 1) == 0)
+                return data + candidate;
+            mask &= mask - 1;
+        }
+    }
+
+    return FindHeadingScalar(data + pos, length - pos);
+}
+
+
+/** @brief Finds the "msgType_": heading with AVX2
+ * 
+ *  Same approach as FindHeadingSSE2, but compares 32 possible heading positions at a time.
+ *
+ *  @param data   - Start of the line
+ *  @param length - Length of the line
+ *  @return Start of the heading, or nullptr if it isn't in the line
+ */
+__attribute__((target("avx2")))
+const char* MessageClassifier::FindHeadingAVX2(const char* data, size_t length)
+{
+    const __m256i firstChar = _mm256_set1_epi8(MSG_TYPE_HEADING[0]);
+    const __m256i lastChar = _mm256_set1_epi8(MSG_TYPE_HEADING[MSG_TYPE_LAST_CHAR]);
+    size_t pos = 0;
+
+    for (; pos + MSG_TYPE_LAST_CHAR + 32 <= length; pos += 32)
+    {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + MSG_TYPE_LAST_CHAR));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, firstChar), _mm256_cmpeq_epi8(blockLast, lastChar))));
+
+        while (mask != 0)
+        {
+            size_t candidate = pos + __builtin_ctz(mask);
+            if (memcmp(data + candidate + 1, MSG_TYPE_HEADING + 1, MSG_TYPE_LAST_CHAR - 1) == 0)
+                return data + candidate;
+            mask &= mask - 1;
+        }
+    }
+
+    return FindHeadingSSE2(data + pos, length - pos);
+}
+
+#endif
@@ -0,0 +1,369 @@
+/** @file OrderMessageParser.cpp
+ *  @brief Extracts the fields we need from Order Add, Delete, Modify & Execute and Security Reference Data records
+ *
+ *  Parses the values out of a line from the input file without allocating. Every value
+ *  is either returned as a view into the line or converted straight to a number with
+ *  std::from_chars, so there are no temporary strings and no locale or exception overhead.
+ *
+ *  The values are first looked for in the order the feed writes them, searching for each heading
+ *  from the end of the value before it, which is the quickest way to find them. A line whose
+ *  fields can't all be found that way, e.g. because they are in another order, are the last in
+ *  their object or are padded with whitespace, is parsed by the JSON Line Parser instead, in a
+ *  single scan of the line, so the fields can be in any order. Only values the JSON Line Parser
+ *  would give too are taken from the search in order, unless the line has a key more than once.
+ *
+ *  If a field is missing or its value isn't a valid number then the record is rejected. Numbers
+ *  and the side may be quoted or not; the ISIN & currency are kept exactly as they appear,
+ *  quotes included.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <array>
+#include <charconv>
+#include "OrderMessageParser.h"
+#include "JsonLineParser.h"
+
+namespace
+{
+    // There is a key set for each combination of the optional Order Add fields, indexed by them. The
+    // fields that are always needed come first, then the timestamp_ and orderId_ when asked for.
+    //
+    constexpr size_t NUM_ORDER_ADD_KEYS = 4;
+    constexpr size_t MAX_ORDER_ADD_KEYS = NUM_ORDER_ADD_KEYS + 2;
+    constexpr std::string_view ORDER_ADD_KEYS[] = { "securityId_", "side_", "quantity_", "price_" };
+    constexpr std::string_view ORDER_ADD_TIMESTAMP_KEYS[] = { "securityId_", "side_", "quantity_", "price_", "timestamp_" };
+    constexpr std::string_view ORDER_ADD_ORDER_ID_KEYS[] = { "securityId_", "side_", "quantity_", "price_", "orderId_" };
+    constexpr std::string_view ORDER_ADD_ALL_KEYS[] = { "securityId_", "side_", "quantity_", "price_", "timestamp_", "orderId_" };
+    const JsonKeySet ORDER_ADD_KEY_SETS[] = { JsonKeySet(ORDER_ADD_KEYS),
+                                              JsonKeySet(ORDER_ADD_TIMESTAMP_KEYS),
+                                              JsonKeySet(ORDER_ADD_ORDER_ID_KEYS),
+                                              JsonKeySet(ORDER_ADD_ALL_KEYS) };
+
+    constexpr std::string_view ORDER_ID_KEY[] = { "orderId_" };
+    constexpr std::string_view ORDER_UPDATE_KEYS[] = { "orderId_", "quantity_", "price_" };
+    constexpr std::string_view SECURITY_REF_KEYS[] = { "securityId_", "isin_", "currency_" };
+    constexpr std::string_view SECURITY_ID_KEY[] = { "securityId_" };
+    const JsonKeySet ORDER_ID_KEY_SET(ORDER_ID_KEY);
+    const JsonKeySet ORDER_UPDATE_KEY_SET(ORDER_UPDATE_KEYS);
+    const JsonKeySet SECURITY_REF_KEY_SET(SECURITY_REF_KEYS);
+    const JsonKeySet SECURITY_ID_KEY_SET(SECURITY_ID_KEY);
+
+    // Headings of the fields, for the search in the order the feed writes them. The quote that
+    // opens each key is checked separately.
+    //
+    constexpr std::string_view TIMESTAMP_HEADING = "timestamp_\":";
+    constexpr std::string_view ORDER_ID_HEADING = "orderId_\":";
+    constexpr std::string_view SECURITY_ID_HEADING = "securityId_\":";
+    constexpr std::string_view SIDE_HEADING = "side_\":";
+    constexpr std::string_view QUANTITY_HEADING = "quantity_\":";
+    constexpr std::string_view PRICE_HEADING = "price_\":";
+    constexpr std::string_view ISIN_HEADING = "isin_\":";
+    constexpr std::string_view CURRENCY_HEADING = "currency_\":";
+
+    // Characters that can be part of a number or word value, e.g. 816 or BUY: anything but
+    // whitespace, quotes & the structural characters (: , { } [ ])
+    //
+    constexpr std::array<bool, 256> PLAIN_VALUE_CHARS = []
+    {
+        std::array<bool, 256> plainChars{};
+        for (size_t character = ' ' + 1; character < plainChars.size(); ++character)
+            plainChars[character] = true;
+        for (unsigned char character : std::string_view(":,{}[]\""))
+            plainChars[character] = false;
+        return plainChars;
+    }();
+}
+
+/** @brief Finds where the value of a field starts, searching for its heading
+ *
+ *  The first match of the heading must be a key, opened by an unescaped quote. Otherwise the line
+ *  is left to the JSON Line Parser.
+ *
+ *  @param inputLine - Line from the input file
+ *  @param heading   - Heading of the value that needs to be extracted
+ *  @param searchPos - Position to start searching from
+ *  @return Position just after the heading, or npos if it wasn't found as a key
+ */
+inline size_t OrderMessageParser::FindHeading(std::string_view inputLine, std::string_view heading, const size_t searchPos)
+{
+    const size_t headingStartPos = inputLine.find(heading, searchPos);
+    if (headingStartPos == std::string_view::npos || headingStartPos < 2 ||
+        inputLine[headingStartPos - 1] != '"' || inputLine[headingStartPos - 2] == '\\')
+        return std::string_view::npos;
+
+    return headingStartPos + heading.size();
+}
+
+
+/** @brief Finds the value of a field, searching for its heading from where the last value ended
+ *
+ *  The value must start straight after the ':' and be followed straight away by ',' or '}', and be
+ *  a string with no escapes or a number or word, which is exactly the value the JSON Line Parser
+ *  would find for the key. Otherwise the line is left to the JSON Line Parser.
+ *
+ *  @param inputLine - Line from the input file
+ *  @param heading   - Heading of the value that needs to be extracted
+ *  @param searchPos - Position to start searching from. Updated to the end of the value.
+ *  @param value     - View of the value in the input line
+ *  @return true if the heading was found, with a value the JSON Line Parser would agree with
+ */
+bool OrderMessageParser::FindFieldValue( std::string_view  inputLine,
+                                         std::string_view  heading,
+                                         size_t&           searchPos,
+                                         std::string_view& value )
+{
+    const size_t valPos = FindHeading(inputLine, heading, searchPos);
+    if (valPos == std::string_view::npos)
+        return false;
+
+    size_t valEndPos = valPos;
+    if (valPos < inputLine.size() && inputLine[valPos] == '"')
+    {
+        valEndPos = inputLine.find('"', valPos + 1);
+        if (valEndPos == std::string_view::npos || inputLine[valEndPos - 1] == '\\')
+            return false;
+        ++valEndPos;
+    }
+    else
+    {
+        while (valEndPos < inputLine.size() && PLAIN_VALUE_CHARS[static_cast<unsigned char>(inputLine[valEndPos])])
+            ++valEndPos;
+    }
+
+    if (valEndPos == valPos || valEndPos >= inputLine.size() || (inputLine[valEndPos] != ',' && inputLine[valEndPos] != '}'))
+        return false;
+
+    value = inputLine.substr(valPos, valEndPos - valPos);
+    searchPos = valEndPos;
+    return true;
+}
+
+
+/** @brief Finds & converts the value of a number field, searching for its heading from where the last value ended
+ *
+ *  The number is converted straight from the line, and must be followed straight away by ',' or
+ *  '}', so the end of the value isn't looked for separately. Any other value, e.g. a quoted number,
+ *  is left to the JSON Line Parser.
+ *
+ *  @param inputLine - Line from the input file
+ *  @param heading   - Heading of the value that needs to be converted
+ *  @param searchPos - Position to start searching from. Updated to the end of the value.
+ *  @param number    - The converted number
+ *  @return true if the heading was found, with a valid number the JSON Line Parser would agree with
+ */
+template <typename T>
+bool OrderMessageParser::FindNumberValue(std::string_view inputLine, std::string_view heading, size_t& searchPos, T& number)
+{
+    const size_t valPos = FindHeading(inputLine, heading, searchPos);
+    if (valPos == std::string_view::npos)
+        return false;
+
+    const char* lineEnd = inputLine.data() + inputLine.size();
+    const std::from_chars_result result = std::from_chars(inputLine.data() + valPos, lineEnd, number);
+    if (result.ec != std::errc() || result.ptr == lineEnd || (*result.ptr != ',' && *result.ptr != '}'))
+        return false;
+
+    searchPos = static_cast<size_t>(result.ptr - inputLine.data());
+    return true;
+}
+
+
+/** @brief Removes the quotes from around a value, if it has them
+ *
+ *  @param value - View of the value in the input line
+ *  @return The value without its quotes
+ */
+std::string_view OrderMessageParser::Unquoted(std::string_view value)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        return value.substr(1, value.size() - 2);
+    return value;
+}
+
+
+/** @brief Converts a value to a number
+ *
+ *  Like stoi/stoll, any characters after the leading digits are ignored. A quoted number is
+ *  converted from inside its quotes.
+ *
+ *  @param value  - View of the value in the input line
+ *  @param number - The converted number
+ *  @return true if the value starts with a valid number
+ */
+template <typename T>
+bool OrderMessageParser::ParseNumber(std::string_view value, T& number)
+{
+    if (!value.empty() && value.front() == '"')
+        value = Unquoted(value);
+    return std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc();
+}
+
+
+/** @brief Parses an Order Add record ("msgType_":12)
+ *
+ *  Needs the securityId_, side_, quantity_ & price_ fields, in any order. The timestamp_, in the
+ *  header, is only needed for the interval report and the orderId_ for tracking live Orders, so
+ *  they are only looked for when asked for.
+ *
+ *  The feed writes the headings we need in the following order:
+ *  timestamp_\":, orderId_\":, securityId_\":, side_\":, quantity_\":, price_\":
+ *  So rather than searching the whole line for these headings each time, we begin our
+ *  search for each subsequent heading from where the value of the previous heading ended.
+ *  If a field can't be found that way the whole line is parsed again with the JSON Line Parser.
+ *
+ *  @param inputLine      - Line from the input file that contains the Order Add record
+ *  @param securityId     - Security ID the Order is against
+ *  @param ordData        - The relevant data from the Order Add record
+ *  @param optionalFields - PARSE_TIMESTAMP and/or PARSE_ORDER_ID. Fields not parsed are set to 0.
+ *  @return true if every field was found and valid
+ */
+bool OrderMessageParser::ParseOrderAdd(std::string_view inputLine, int& securityId, OrderAddData& ordData, const unsigned optionalFields)
+{
+    size_t searchPos = 0;
+    std::string_view side;
+
+    ordData.timestamp = 0;
+    ordData.orderId = 0;
+    if ((!(optionalFields & PARSE_TIMESTAMP) || FindNumberValue(inputLine, TIMESTAMP_HEADING, searchPos, ordData.timestamp)) &&
+        (!(optionalFields & PARSE_ORDER_ID) || FindNumberValue(inputLine, ORDER_ID_HEADING, searchPos, ordData.orderId)) &&
+        FindNumberValue(inputLine, SECURITY_ID_HEADING, searchPos, securityId) &&
+        FindFieldValue(inputLine, SIDE_HEADING, searchPos, side) &&
+        FindNumberValue(inputLine, QUANTITY_HEADING, searchPos, ordData.quantity) &&
+        FindNumberValue(inputLine, PRICE_HEADING, searchPos, ordData.price))
+    {
+        ordData.side = (Unquoted(side) == "BUY") ? Side::Buy : Side::Sell;
+        return true;
+    }
+
+    return ParseOrderAddAnyOrder(inputLine, securityId, ordData, optionalFields);
+}
+
+
+/** @brief Parses an Order Add record with the JSON Line Parser, whatever order its fields are in
+ *
+ *  @param inputLine      - Line from the input file that contains the Order Add record
+ *  @param securityId     - Security ID the Order is against
+ *  @param ordData        - The relevant data from the Order Add record
+ *  @param optionalFields - PARSE_TIMESTAMP and/or PARSE_ORDER_ID. Fields not parsed are set to 0.
+ *  @return true if every field was found and valid
+ */
+bool OrderMessageParser::ParseOrderAddAnyOrder(std::string_view inputLine, int& securityId, OrderAddData& ordData, const unsigned optionalFields)
+{
+    const JsonKeySet& keySet = ORDER_ADD_KEY_SETS[optionalFields & (PARSE_TIMESTAMP | PARSE_ORDER_ID)];
+    std::string_view values[MAX_ORDER_ADD_KEYS];
+
+    if (!JsonLineParser::ExtractFields(inputLine, keySet, values))
+        return false;
+
+    ordData.timestamp = 0;
+    if ((optionalFields & PARSE_TIMESTAMP) && !ParseNumber(values[NUM_ORDER_ADD_KEYS], ordData.timestamp))
+        return false;
+
+    ordData.orderId = 0;
+    if ((optionalFields & PARSE_ORDER_ID) && !ParseNumber(values[keySet.numKeys - 1], ordData.orderId))
+        return false;
+
+    ordData.side = (Unquoted(values[1]) == "BUY") ? Side::Buy : Side::Sell;
+
+    return ParseNumber(values[0], securityId) &&
+           ParseNumber(values[2], ordData.quantity) &&
+           ParseNumber(values[3], ordData.price);
+}
+
+
+/** @brief Parses an Order Delete record ("msgType_":13)
+ *
+ *  Only needs the orderId_ field. The securityId_ of the Order isn't needed, as the Order is
+ *  looked up by its ID.
+ *
+ *  @param inputLine - Line from the input file that contains the Order Delete record
+ *  @param orderId   - ID of the Order deleted
+ *  @return true if the Order ID was found and valid
+ */
+bool OrderMessageParser::ParseOrderDelete(std::string_view inputLine, uint64_t& orderId)
+{
+    size_t searchPos = 0;
+    if (FindNumberValue(inputLine, ORDER_ID_HEADING, searchPos, orderId))
+        return true;
+
+    std::string_view value;
+    return JsonLineParser::ExtractFields(inputLine, ORDER_ID_KEY_SET, &value) && ParseNumber(value, orderId);
+}
+
+
+/** @brief Parses an Order Modify ("msgType_":14) or Order Execute ("msgType_":15) record
+ *
+ *  Both message types need the orderId_, quantity_ & price_ fields, in any order. They are searched
+ *  for in that order first. For an Order Modify they are the Order's new quantity & price, and for
+ *  an Order Execute the quantity executed & the price it traded at.
+ *
+ *  @param inputLine - Line from the input file that contains the Order Modify or Execute record
+ *  @param updData   - The relevant data from the record
+ *  @return true if every field was found and valid
+ */
+bool OrderMessageParser::ParseOrderUpdate(std::string_view inputLine, OrderUpdateData& updData)
+{
+    size_t searchPos = 0;
+    if (FindNumberValue(inputLine, ORDER_ID_HEADING, searchPos, updData.orderId) &&
+        FindNumberValue(inputLine, QUANTITY_HEADING, searchPos, updData.quantity) &&
+        FindNumberValue(inputLine, PRICE_HEADING, searchPos, updData.price))
+        return true;
+
+    std::string_view values[3];
+    if (!JsonLineParser::ExtractFields(inputLine, ORDER_UPDATE_KEY_SET, values))
+        return false;
+
+    return ParseNumber(values[0], updData.orderId) &&
+           ParseNumber(values[1], updData.quantity) &&
+           ParseNumber(values[2], updData.price);
+}
+
+
+/** @brief Parses a Security Reference Data record ("msgType_":8)
+ *
+ *  Needs the securityId_, isin_ & currency_ fields, in any order. They are searched for in that
+ *  order first. The ISIN and currency are returned as views into the input line, so are only
+ *  valid for as long as the line is.
+ *
+ *  @param inputLine - Line from the input file that contains the Security Reference Data record
+ *  @param refData   - The relevant data from the Security Reference Data record
+ *  @return true if every field was found and valid
+ */
+bool OrderMessageParser::ParseSecurityRef(std::string_view inputLine, SecurityRefData& refData)
+{
+    size_t searchPos = 0;
+    if (FindNumberValue(inputLine, SECURITY_ID_HEADING, searchPos, refData.securityId) &&
+        FindFieldValue(inputLine, ISIN_HEADING, searchPos, refData.ISIN) &&
+        FindFieldValue(inputLine, CURRENCY_HEADING, searchPos, refData.currency))
+        return true;
+
+    std::string_view values[3];
+    if (!JsonLineParser::ExtractFields(inputLine, SECURITY_REF_KEY_SET, values))
+        return false;
+
+    refData.ISIN = values[1];
+    refData.currency = values[2];
+    return ParseNumber(values[0], refData.securityId);
+}
+
+
+/** @brief Parses just the Security ID of an Order Add or Security Reference Data record
+ *
+ *  Used to decide whether a record is wanted at all, e.g. whether its Security is in this
+ *  shard's partition, before the rest of it is parsed.
+ *
+ *  @param inputLine  - Line from the input file that contains the record
+ *  @param securityId - Security ID of the record
+ *  @return true if the Security ID was found and valid
+ */
+bool OrderMessageParser::ParseSecurityId(std::string_view inputLine, int& securityId)
+{
+    size_t searchPos = 0;
+    if (FindNumberValue(inputLine, SECURITY_ID_HEADING, searchPos, securityId))
+        return true;
+
+    std::string_view value;
+    return JsonLineParser::ExtractFields(inputLine, SECURITY_ID_KEY_SET, &value) && ParseNumber(value, securityId);
+}
@@ -0,0 +1,546 @@
+/** @file QueryServer.cpp
+ *  @brief Answers queries on the Order Reports over a Unix domain socket, while the input file is read
+ *
+ *  Runs on a thread of its own, alongside the thread reading the input file, and answers queries
+ *  from the latest Report Snapshot published by it. Snapshots are read without taking a lock, so
+ *  answering a query never holds up the Order Adds being aggregated, and a query is never held up
+ *  by them either.
+ *
+ *  Each query is a line of text, and each answer is the heading row of the report followed by one
+ *  row per Security, in the Report Format given, and ends with an empty line:
+ *    ISIN <isin>         - The Security with that ISIN.
+ *    SECURITY <id>       - The Security with that Security ID.
+ *    TOP <n>             - The n Securities with the largest total quantity, largest first.
+ *    DUMP                - Every Security, in the order they were referenced.
+ *    STATUS              - The sequence number & input file offset of the snapshot, and its number of Securities.
+ *  A Security that isn't found gives no rows. A query that can't be answered gets "ERROR <reason>"
+ *  and an empty line. Any number of clients can be connected at once, and each can send several
+ *  queries without waiting for the answers.
+ *
+ *  Every client is served from one poll loop. A snapshot is held only while the queries already
+ *  received from a client are answered, never while waiting on a socket, so retired snapshots can
+ *  always be reused soon after. ISINs are looked up through a map kept by the server thread, which
+ *  only has to take in the Securities added since the last query, as slots are never reordered.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include "PipelineStats.h"
+#include "QueryServer.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define QUERYSERVER_SUPPORTED
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+/** @brief Removes the quotes around a value, if it has them
+ *
+ *  @param value - Value, as held in the Order Report collection or as given in a query
+ *  @return The value without quotes
+ */
+static std::string_view Unquoted(std::string_view value)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        return value.substr(1, value.size() - 2);
+    return value;
+}
+
+
+/** @brief Query Server Constructor
+ *
+ *  @param publisher_ - Publisher of the snapshots to answer queries from
+ *  @param format_    - Columns of the rows in each answer. nullptr for every column (OrderReportSchema).
+ *  @param delim      - The delimiter that will seperate each value
+ */
+QueryServer::QueryServer(SnapshotPublisher& publisher_, const ReportFormat* format_, const char delim)
+    : publisher(publisher_),
+      format((format_ != nullptr) ? format_ : &OrderReportSchema::FORMAT),
+      delimiter(delim),
+      reader(SnapshotPublisher::NO_READER),
+      listenSocket(-1),
+      wakePipe{ -1, -1 },
+      stopping(false),
+      indexedSlots(0)
+{
+}
+
+QueryServer::~QueryServer()
+{
+    Stop();
+}
+
+
+/** @brief Starts listening on a Unix domain socket and answering queries
+ *
+ *  A socket left at the path by an earlier run is removed first; anything else there is left alone.
+ *
+ *  @param socketPath_ - Socket File Name/Path
+ *  @return true if the server was started
+ */
+bool QueryServer::Start(const std::string& socketPath_)
+{
+    Stop();
+
+#ifdef QUERYSERVER_SUPPORTED
+    sockaddr_un address = {};
+    if (socketPath_.empty() || socketPath_.size() >= sizeof(address.sun_path))
+        return false;
+
+    if (reader == SnapshotPublisher::NO_READER)
+        reader = publisher.RegisterReader();
+    if (reader == SnapshotPublisher::NO_READER)
+        return false;
+
+    struct stat socketStat;
+    if (stat(socketPath_.c_str(), &socketStat) == 0 && S_ISSOCK(socketStat.st_mode))
+        unlink(socketPath_.c_str());
+
+    address.sun_family = AF_UNIX;
+    socketPath_.copy(address.sun_path, socketPath_.size());
+
+    listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ( listenSocket < 0 ||
+         bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+         listen(listenSocket, SOMAXCONN) != 0 ||
+         fcntl(listenSocket, F_SETFL, O_NONBLOCK) != 0 ||
+         pipe(wakePipe) != 0 )
+    {
+        CloseSockets();
+        return false;
+    }
+
+    socketPath = socketPath_;
+    stopping.store(false);
+    serverThread = std::thread(&QueryServer::Serve, this);
+    return true;
+#else
+    (void)socketPath_;
+    return false;
+#endif
+}
+
+
+/** @brief Stops answering queries, disconnects every client and removes the socket
+ *
+ *  @return void
+ */
+void QueryServer::Stop()
+{
+#ifdef QUERYSERVER_SUPPORTED
+    if (serverThread.joinable())
+    {
+        stopping.store(true);
+        char wake = 0;
+        while (write(wakePipe[1], &wake, 1) < 0 && errno == EINTR)
+        {
+        }
+        serverThread.join();
+    }
+
+    CloseSockets();
+    if (!socketPath.empty())
+        unlink(socketPath.c_str());
+#endif
+    socketPath.clear();
+}
+
+
+/** @brief Checks whether the server is answering queries
+ *
+ *  @return true if the server has been started and not stopped
+ */
+bool QueryServer::IsRunning() const
+{
+    return serverThread.joinable();
+}
+
+
+/** @brief Closes the listening socket, the wake up pipe and every client's socket
+ *
+ *  @return void
+ */
+void QueryServer::CloseSockets()
+{
+#ifdef QUERYSERVER_SUPPORTED
+    for (Client& client : clients)
+        close(client.socket);
+    for (int fd : { listenSocket, wakePipe[0], wakePipe[1] })
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+    clients.clear();
+    listenSocket = -1;
+    wakePipe[0] = -1;
+    wakePipe[1] = -1;
+}
+
+
+/** @brief Serves every client until the server is stopped
+ *
+ *  A client with answers still to send isn't read from until they have all been sent, so a
+ *  client that doesn't read its answers can't make the server buffer without limit.
+ *
+ *  @return void
+ */
+void QueryServer::Serve()
+{
+#ifdef QUERYSERVER_SUPPORTED
+    std::vector<pollfd> pollFds;
+
+    while (!stopping.load())
+    {
+        pollFds.clear();
+        pollFds.push_back(pollfd{ wakePipe[0], POLLIN, 0 });
+        pollFds.push_back(pollfd{ listenSocket, POLLIN, 0 });
+        for (const Client& client : clients)
+        {
+            bool sending = client.responseSent < client.response.size();
+            pollFds.push_back(pollfd{ client.socket, static_cast<short>(sending ? POLLOUT : POLLIN), 0 });
+        }
+
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        // Only the clients polled; any accepted below are polled next time round
+        //
+        size_t numPolled = pollFds.size() - 2;
+        for (size_t i = 0; i < numPolled; ++i)
+        {
+            Client& client = clients[i];
+            short events = pollFds[i + 2].revents;
+            bool keep = true;
+
+            if ((events & POLLOUT) != 0)
+                keep = SendResponse(client);
+            else if ((events & POLLIN) != 0)
+            {
+                keep = ReceiveRequests(client);
+                if (keep)
+                {
+                    AnswerRequests(client);
+                    keep = SendResponse(client);
+                }
+            }
+            else if ((events & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+                keep = false;
+
+            if (!keep || (client.closing && client.responseSent == client.response.size()))
+            {
+                close(client.socket);
+                client.socket = -1;
+            }
+        }
+        clients.erase( std::remove_if(clients.begin(), clients.end(), [](const Client& client) { return client.socket < 0; }),
+                       clients.end() );
+
+        if ((pollFds[1].revents & POLLIN) != 0)
+            AcceptClients();
+    }
+#endif
+}
+
+
+/** @brief Accepts every client waiting to connect
+ *
+ *  @return void
+ */
+void QueryServer::AcceptClients()
+{
+#ifdef QUERYSERVER_SUPPORTED
+    int clientSocket;
+    while ((clientSocket = accept(listenSocket, nullptr, nullptr)) >= 0)
+    {
+        if (fcntl(clientSocket, F_SETFL, O_NONBLOCK) != 0)
+        {
+            close(clientSocket);
+            continue;
+        }
+        clients.push_back(Client{ clientSocket, std::string(), std::string(), 0, false });
+    }
+#endif
+}
+
+
+/** @brief Receives everything a client has sent so far
+ *
+ *  @param client - Client to receive from
+ *  @return false if the client should be disconnected
+ */
+bool QueryServer::ReceiveRequests(Client& client)
+{
+#ifdef QUERYSERVER_SUPPORTED
+    char buffer[RECEIVE_SIZE];
+    while (true)
+    {
+        ssize_t received = recv(client.socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            client.requests.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received == 0)
+        {
+            if (!client.requests.empty() && client.requests.back() != '\n')
+                client.requests += '\n';
+            client.closing = true;
+            return true;
+        }
+        if (errno == EINTR)
+            continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+#else
+    (void)client;
+    return false;
+#endif
+}
+
+
+/** @brief Sends as much of a client's answers as the socket will take
+ *
+ *  @param client - Client to send to
+ *  @return false if the client should be disconnected
+ */
+bool QueryServer::SendResponse(Client& client)
+{
+#ifdef QUERYSERVER_SUPPORTED
+    while (client.responseSent < client.response.size())
+    {
+        ssize_t sent = send( client.socket,
+                             client.response.data() + client.responseSent,
+                             client.response.size() - client.responseSent,
+                             MSG_NOSIGNAL );
+        if (sent > 0)
+        {
+            client.responseSent += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR)
+            continue;
+        return sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    client.response.clear();
+    client.responseSent = 0;
+    return true;
+#else
+    (void)client;
+    return false;
+#endif
+}
+
+
+/** @brief Answers every whole line a client has sent, from a single snapshot
+ *
+ *  A line longer than MAX_REQUEST_LENGTH is answered with an error and the client is
+ *  disconnected once it has been sent.
+ *
+ *  @param client - Client to answer
+ *  @return void
+ */
+void QueryServer::AnswerRequests(Client& client)
+{
+    size_t lineStart = 0;
+    size_t lineEnd = client.requests.find('\n');
+    if (lineEnd == std::string::npos && client.requests.size() <= MAX_REQUEST_LENGTH)
+        return;
+
+    ScopedSnapshot snapshot(publisher, reader);
+    for (; lineEnd != std::string::npos; lineEnd = client.requests.find('\n', lineStart))
+    {
+        std::string_view request(client.requests.data() + lineStart, lineEnd - lineStart);
+        if (!request.empty() && request.back() == '\r')
+            request.remove_suffix(1);
+        if (!request.empty())
+            AnswerQuery(request, snapshot.Get(), client.response);
+        lineStart = lineEnd + 1;
+    }
+    client.requests.erase(0, lineStart);
+
+    if (client.requests.size() > MAX_REQUEST_LENGTH)
+    {
+        client.response += "ERROR Query too long\n\n";
+        client.requests.clear();
+        client.closing = true;
+    }
+}
+
+
+/** @brief Answers a single query
+ *
+ *  @param request  - The query, without its line ending
+ *  @param snapshot - Snapshot to answer from, or nullptr if none has been published yet
+ *  @param response - The string to append the answer to
+ *  @return void
+ */
+void QueryServer::AnswerQuery(std::string_view request, const ReportSnapshot* snapshot, std::string& response)
+{
+    ScopedStatTimer queryTimer(StatTimer::Query, StatHistogram::QueryLatency);
+    PipelineStats::Count(StatCounter::QueriesServed);
+
+    size_t separator = request.find(' ');
+    std::string_view command = request.substr(0, separator);
+    std::string_view argument = (separator != std::string_view::npos) ? request.substr(separator + 1) : std::string_view();
+
+    if (snapshot == nullptr)
+    {
+        response += "ERROR No snapshot published yet\n\n";
+        return;
+    }
+    const OrderReportCollection& orders = snapshot->orders;
+
+    if (command == "STATUS")
+    {
+        response += "Sequence";
+        response += delimiter;
+        response += "Input Offset";
+        response += delimiter;
+        response += "Securities\n";
+        row.Clear();
+        row.AddField(static_cast<size_t>(snapshot->sequence));
+        row.AddField(snapshot->inputOffset);
+        row.AddField(orders.Size());
+        row.AppendTo(response, delimiter);
+        response += '\n';
+        return;
+    }
+
+    size_t number = 0;
+    bool isNumber = !argument.empty() && std::from_chars(argument.data(), argument.data() + argument.size(), number).ptr == argument.data() + argument.size();
+
+    if (command == "ISIN" && !argument.empty())
+    {
+        format->appendHeader(response, delimiter);
+        size_t slot = FindIsin(orders, argument);
+        if (slot != OrderReportCollection::NOT_FOUND)
+            AppendRow(orders, slot, response);
+    }
+    else if (command == "SECURITY" && isNumber && number <= static_cast<size_t>(INT32_MAX))
+    {
+        format->appendHeader(response, delimiter);
+        size_t slot = orders.Find(static_cast<int>(number));
+        if (slot != OrderReportCollection::NOT_FOUND)
+            AppendRow(orders, slot, response);
+    }
+    else if (command == "TOP" && isNumber)
+    {
+        format->appendHeader(response, delimiter);
+        AppendTopSlots(orders, number, response);
+    }
+    else if (command == "DUMP" && argument.empty())
+    {
+        format->appendHeader(response, delimiter);
+        for (size_t slot = 0; slot < orders.Size(); ++slot)
+            AppendRow(orders, slot, response);
+    }
+    else
+    {
+        response += "ERROR Unknown query\n\n";
+        return;
+    }
+    response += '\n';
+}
+
+
+/** @brief Appends the row of a Security to an answer
+ *
+ *  @param orders   - Collection of Order Reports in the snapshot
+ *  @param slot     - Slot of the Security
+ *  @param response - The string to append the row to
+ *  @return void
+ */
+void QueryServer::AppendRow(const OrderReportCollection& orders, const size_t slot, std::string& response)
+{
+    format->formatRow(row, orders, slot);
+    row.AppendTo(response, delimiter);
+}
+
+
+/** @brief Appends the rows of the Securities with the largest total quantity, largest first
+ *
+ *  Securities with equal quantities are given in the order they were referenced. Securities with
+ *  no Orders are left out.
+ *
+ *  @param orders   - Collection of Order Reports in the snapshot
+ *  @param numSlots - Most Securities to give
+ *  @param response - The string to append the rows to
+ *  @return void
+ */
+void QueryServer::AppendTopSlots(const OrderReportCollection& orders, const size_t numSlots, std::string& response)
+{
+    auto totalQuantity = [&orders](const uint32_t slot)
+    {
+        const OrderReport& ordRpt = orders.GetOrderReport(slot);
+        return ordRpt.GetColumn<ReportColumn::BuyQuantity>() + ordRpt.GetColumn<ReportColumn::SellQuantity>();
+    };
+
+    rankedSlots.clear();
+    for (size_t slot = 0; slot < orders.Size(); ++slot)
+    {
+        if (orders.GetOrderReport(slot).HasOrders())
+            rankedSlots.push_back(static_cast<uint32_t>(slot));
+    }
+
+    size_t numRanked = std::min(numSlots, rankedSlots.size());
+    std::partial_sort( rankedSlots.begin(), rankedSlots.begin() + numRanked, rankedSlots.end(),
+                       [&totalQuantity](const uint32_t a, const uint32_t b)
+                       {
+                           size_t quantityA = totalQuantity(a);
+                           size_t quantityB = totalQuantity(b);
+                           return (quantityA != quantityB) ? quantityA > quantityB : a < b;
+                       } );
+
+    for (size_t i = 0; i < numRanked; ++i)
+        AppendRow(orders, rankedSlots[i], response);
+}
+
+
+/** @brief Finds the slot of the Security with an ISIN
+ *
+ *  The map only has to take in the slots added since it was last brought up to date. It is
+ *  rebuilt if the collection has been replaced, e.g. by a restored checkpoint. Where two
+ *  Securities share an ISIN, the first one referenced is found. The ISIN can be given with or
+ *  without the quotes it has in the reports.
+ *
+ *  @param orders - Collection of Order Reports in the snapshot
+ *  @param isin   - ISIN to find
+ *  @return Slot of the Security, or OrderReportCollection::NOT_FOUND
+ */
+size_t QueryServer::FindIsin(const OrderReportCollection& orders, std::string_view isin)
+{
+    isin = Unquoted(isin);
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        for (; indexedSlots < orders.Size(); ++indexedSlots)
+            isinSlots.emplace(std::string(Unquoted(orders.GetSecurityInfo(indexedSlots).ISIN.View())), static_cast<uint32_t>(indexedSlots));
+
+        auto found = isinSlots.find(std::string(isin));
+        if (found == isinSlots.end() && indexedSlots == orders.Size())
+            return OrderReportCollection::NOT_FOUND;
+        if (found != isinSlots.end() && found->second < orders.Size() && Unquoted(orders.GetSecurityInfo(found->second).ISIN.View()) == isin)
+            return found->second;
+
+        isinSlots.clear();
+        indexedSlots = 0;
+    }
+    return OrderReportCollection::NOT_FOUND;
+}
@@ -0,0 +1,138 @@
+/** @file ShardRunner.cpp
+ *  @brief Runs each shard of a sharded aggregation in a worker process of its own
+ *
+ *  Forks one worker process per shard. Each worker runs the shard function, which writes its results
+ *  to an Output Buffer on the write end of a pipe, and then exits. The coordinating process reads every
+ *  worker's results back from its pipe, standing in for the network between the hosts a sharded
+ *  aggregation would otherwise run on. The workers share nothing but the input file, so they don't
+ *  slow each other down the way threads sharing a heap & Order Report collection would.
+ *
+ *  Only supported where processes can be forked.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include <cerrno>
+#include <iostream>
+#include "ShardRunner.h"
+#include "PipelineStats.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define SHARDRUNNER_SUPPORTED
+#endif
+
+/** @brief Checks whether shards can be run in worker processes on this platform
+ *
+ *  @return true if they can
+ */
+bool ShardRunner::IsSupported()
+{
+#ifdef SHARDRUNNER_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/** @brief Runs every shard in a worker process and gathers their results
+ *
+ *  The workers are all started before any results are read, so they run side by side. A worker
+ *  that finishes before its results are read waits on its pipe until they are. The workers are
+ *  forked from the calling thread, and no other thread is carried into them.
+ *
+ *  @param numShards    - Number of shards, and so of worker processes
+ *  @param runShard     - Function each worker calls with its shard, from 0 to numShards - 1, and the
+ *                        Output Buffer to write its results to. Returns whether it succeeded.
+ *  @param shardResults - Everything each worker wrote, by shard
+ *  @return true if every worker ran & succeeded
+ */
+bool ShardRunner::Run(const size_t numShards, const ShardFunc& runShard, std::vector<std::string>& shardResults)
+{
+    shardResults.assign(numShards, std::string());
+
+#ifdef SHARDRUNNER_SUPPORTED
+    ScopedStatTimer readTimer(StatTimer::ReadShards);
+    std::vector<pid_t> workers;
+    std::vector<int> resultPipes;
+    bool succeeded = true;
+
+    // Anything still buffered would otherwise be written by every worker as well
+    //
+    std::cout.flush();
+    std::cerr.flush();
+
+    for (size_t shard = 0; shard < numShards; ++shard)
+    {
+        int pipeEnds[2];
+        if (pipe(pipeEnds) != 0)
+        {
+            succeeded = false;
+            break;
+        }
+
+        pid_t worker = fork();
+        if (worker == 0)
+        {
+            for (int resultPipe : resultPipes)
+                close(resultPipe);
+            close(pipeEnds[0]);
+
+            OutputBuffer outBuffer;
+            outBuffer.Attach(pipeEnds[1]);
+            bool shardSucceeded = runShard(shard, outBuffer);
+            outBuffer.Close();
+            _exit(shardSucceeded ? 0 : 1);
+        }
+
+        // Only the worker keeps the write end open, so the pipe ends once the worker exits
+        //
+        close(pipeEnds[1]);
+        if (worker < 0)
+        {
+            close(pipeEnds[0]);
+            succeeded = false;
+            break;
+        }
+        workers.push_back(worker);
+        resultPipes.push_back(pipeEnds[0]);
+    }
+
+    constexpr size_t READ_SIZE = 1 << 20;
+    for (size_t shard = 0; shard < workers.size(); ++shard)
+    {
+        std::string& results = shardResults[shard];
+        for (;;)
+        {
+            size_t resultsSize = results.size();
+            results.resize(resultsSize + READ_SIZE);
+            ssize_t bytesRead = read(resultPipes[shard], &results[resultsSize], READ_SIZE);
+            results.resize(resultsSize + ((bytesRead > 0) ? static_cast<size_t>(bytesRead) : 0));
+            if (bytesRead > 0 || (bytesRead < 0 && errno == EINTR))
+                continue;
+            if (bytesRead < 0)
+                succeeded = false;
+            break;
+        }
+        close(resultPipes[shard]);
+
+        int status = 0;
+        pid_t waited = 0;
+        do
+        {
+            waited = waitpid(workers[shard], &status, 0);
+        } while (waited < 0 && errno == EINTR);
+        if (waited < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            succeeded = false;
+    }
+
+    return succeeded;
+#else
+    (void)runShard;
+    return false;
+#endif
+}
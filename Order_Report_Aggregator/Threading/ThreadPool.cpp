@@ -0,0 +1,182 @@
+/** @file ThreadPool.cpp
+ *  @brief Fixed size pool of worker threads that steal work from each other
+ *
+ *  Runs submitted tasks on a fixed number of worker threads. Each worker has its own queue of
+ *  tasks. Tasks submitted from outside the pool are handed to the workers' queues in turn, while
+ *  a task that submits more work from a worker thread adds it to that worker's own queue. A worker
+ *  runs the newest task in its own queue first, and once that is empty steals the oldest task from
+ *  another worker's queue, so no worker sits idle while any work is left.
+ *
+ *  Wait() blocks until every submitted task has finished, including any tasks they submitted, so
+ *  the pool can be reused for several batches of work.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#include "ThreadPool.h"
+
+namespace
+{
+    // The pool & worker the calling thread belongs to, if it is a worker thread
+    //
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+/** @brief Thread Pool Constructor
+ *
+ *  @param numThreads - Number of worker threads. At least one thread is always started.
+ */
+ThreadPool::ThreadPool(const size_t numThreads)
+    : queuedTasks(0),
+      activeTasks(0),
+      nextQueue(0),
+      stopping(false)
+{
+    size_t threadCount = (numThreads > 0) ? numThreads : 1;
+    queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+        queues.push_back(std::make_unique<WorkerQueue>());
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::RunWorker, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+
+/** @brief Submits a task to be run on one of the worker threads
+ * 
+ *  Called from one of the pool's worker threads, the task is added to that worker's own queue.
+ *  Otherwise the task is added to the next worker's queue in turn.
+ * 
+ *  @param task - Task to run
+ *  @return void
+ */
+void ThreadPool::Submit(std::function<void()> task)
+{
+    size_t queueIndex = (currentPool == this) ? currentWorker : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+
+    // The task is only counted once it is in a queue, so that a worker that claims it is sure to find it
+    //
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        ++queuedTasks;
+        ++activeTasks;
+    }
+    taskAvailable.notify_one();
+}
+
+
+/** @brief Waits for every submitted task to finish
+ * 
+ *  Must not be called from one of the pool's worker threads.
+ * 
+ *  @return void
+ */
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(tasksMutex);
+    tasksFinished.wait(lock, [this] { return activeTasks == 0; });
+}
+
+
+/** @brief Gets the number of worker threads
+ * 
+ *  @return Number of worker threads
+ */
+size_t ThreadPool::GetNumThreads() const
+{
+    return workers.size();
+}
+
+
+/** @brief Worker thread loop
+ * 
+ *  Claims a queued task, then takes and runs it, until the pool is destroyed.
+ * 
+ *  @param workerIndex - Index of the worker, and of its queue
+ *  @return void
+ */
+void ThreadPool::RunWorker(const size_t workerIndex)
+{
+    currentPool = this;
+    currentWorker = workerIndex;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(tasksMutex);
+            taskAvailable.wait(lock, [this] { return stopping || queuedTasks > 0; });
+            if (queuedTasks == 0)
+                return;
+            --queuedTasks;
+        }
+
+        std::function<void()> task = TakeTask(workerIndex);
+        task();
+
+        bool finished = false;
+        {
+            std::lock_guard<std::mutex> lock(tasksMutex);
+            finished = (--activeTasks == 0);
+        }
+        if (finished)
+            tasksFinished.notify_all();
+    }
+}
+
+
+/** @brief Takes a claimed task off the queues
+ * 
+ *  Takes the newest task from the worker's own queue, as it is the most likely to still be in
+ *  cache. If that is empty, steals the oldest task from the next worker's queue that has one.
+ *  A task has always been claimed before this is called, so there is always one to find.
+ * 
+ *  @param workerIndex - Index of the worker taking the task
+ *  @return Task to run
+ */
+std::function<void()> ThreadPool::TakeTask(const size_t workerIndex)
+{
+    while (true)
+    {
+        {
+            WorkerQueue& ownQueue = *queues[workerIndex];
+            std::lock_guard<std::mutex> lock(ownQueue.mutex);
+            if (!ownQueue.tasks.empty())
+            {
+                std::function<void()> task = std::move(ownQueue.tasks.back());
+                ownQueue.tasks.pop_back();
+                return task;
+            }
+        }
+
+        for (size_t i = 1; i < queues.size(); ++i)
+        {
+            WorkerQueue& otherQueue = *queues[(workerIndex + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(otherQueue.mutex);
+            if (!otherQueue.tasks.empty())
+            {
+                std::function<void()> task = std::move(otherQueue.tasks.front());
+                otherQueue.tasks.pop_front();
+                return task;
+            }
+        }
+    }
+}
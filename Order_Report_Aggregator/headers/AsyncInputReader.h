@@ -0,0 +1,86 @@
+/** @file AsyncInputReader.h
+ *  @brief Reads an input file with several large reads kept in flight
+ *
+ *  Reads a file in order, in large blocks, into a small pool of fixed buffers. While the caller
+ *  works on one block, reads for the following blocks are already queued with io_uring, so the
+ *  device is kept busy rather than sitting idle between synchronous reads.
+ *
+ *  io_uring is used through its system calls directly, so no extra library is needed. If the
+ *  kernel doesn't support it, or it isn't allowed (e.g. by a seccomp filter), each block is
+ *  read with pread instead, one at a time.
+ *
+ *  Blocks are handed out whole, so a line may start in one block and end in the next.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ASYNCINPUTREADER_H
+#define ASYNCINPUTREADER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+class AsyncInputReader
+{
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 21;
+    static constexpr size_t NUM_BUFFERS = 4;
+
+    struct Buffer
+    {
+        std::unique_ptr<char[]> data;
+        size_t offset;      // Offset in the file of the first byte read into the buffer
+        size_t length;      // Bytes requested
+        long result;        // Bytes read, or -errno if the read failed
+        bool inFlight;
+    };
+
+    struct IoUring
+    {
+        int ringDescriptor;
+        void* sqRing;
+        void* cqRing;
+        size_t sqRingSize;
+        size_t cqRingSize;
+        void* sqes;
+        size_t sqesSize;
+        unsigned* sqTail;
+        unsigned* sqMask;
+        unsigned* sqArray;
+        unsigned* cqHead;
+        unsigned* cqTail;
+        unsigned* cqMask;
+        void* cqes;
+    };
+
+    int fileDescriptor;
+    size_t fileSize;
+    size_t nextReadOffset;
+    size_t blocksQueued;
+    size_t blocksRead;
+    bool holdingBlock;
+    Buffer buffers[NUM_BUFFERS];
+    IoUring ring;
+
+    bool SetUpIoUring();
+    void TearDownIoUring();
+    void QueueRead();
+    void WaitForRead(Buffer& buffer);
+    void ReapCompletion();
+    void ReadRemainder(Buffer& buffer);
+
+public:
+    AsyncInputReader();
+    ~AsyncInputReader();
+    AsyncInputReader(const AsyncInputReader&) = delete;
+    AsyncInputReader& operator=(const AsyncInputReader&) = delete;
+
+    bool Open(const std::string& fileName, const size_t startOffset = 0);
+    bool NextBlock(std::string_view& block);
+    void Close();
+    bool UsingIoUring() const;
+};
+
+#endif
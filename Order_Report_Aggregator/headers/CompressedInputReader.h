@@ -0,0 +1,79 @@
+/** @file CompressedInputReader.h
+ *  @brief Decompresses a gzip or zstd input file on its own thread
+ *
+ *  Reads a compressed input file and hands the decompressed data out in large blocks. The
+ *  decompression runs on a background thread which fills a small ring of blocks ahead of the
+ *  reader, so decompressing the next block overlaps with processing the current one.
+ *
+ *  The format is detected from the first bytes of the file rather than its name. Support for
+ *  each format is optional, as it needs an extra library to be linked:
+ *    gzip - Build with -DORA_ZLIB and link with -lz
+ *    zstd - Build with -DORA_ZSTD and link with -lzstd
+ *  Concatenated gzip members and zstd frames are read one after another, as gzip -d & zstd -d do.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef COMPRESSEDINPUTREADER_H
+#define COMPRESSEDINPUTREADER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+enum class CompressionFormat { None, Gzip, Zstd };
+
+class CompressedInputReader
+{
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+    static constexpr size_t NUM_BLOCKS = 4;
+
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::FILE* file;
+    CompressionFormat format;
+    Block blocks[NUM_BLOCKS];
+    size_t readPos;        // Next block to hand to the reader
+    size_t writePos;       // Next block for the decompressor to fill
+    size_t filledBlocks;   // Blocks filled and not yet released by the reader, including the one it holds
+    bool holdingBlock;
+    bool finished;
+    bool failed;
+    bool stopping;
+    std::mutex blocksMutex;
+    std::condition_variable blockFilled;
+    std::condition_variable blockReleased;
+    std::thread decompressor;
+
+    void RunDecompressor();
+    bool DecompressGzip();
+    bool DecompressZstd();
+    char* WaitForFreeBlock();
+    void PublishBlock(const size_t size);
+
+public:
+    CompressedInputReader();
+    ~CompressedInputReader();
+    CompressedInputReader(const CompressedInputReader&) = delete;
+    CompressedInputReader& operator=(const CompressedInputReader&) = delete;
+
+    static CompressionFormat DetectFormat(const std::string& fileName);
+    static bool IsSupported(const CompressionFormat format_);
+
+    bool Open(const std::string& fileName);
+    bool NextBlock(std::string_view& block);
+    void Close();
+    bool Failed();
+};
+
+#endif
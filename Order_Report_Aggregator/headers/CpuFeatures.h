@@ -0,0 +1,37 @@
+/** @file CpuFeatures.h
+ *  @brief Detects which SIMD instruction sets the CPU supports
+ *
+ *  Vectorised code paths are compiled for every instruction set they support and the
+ *  best one is picked at runtime with CPUID, so one binary runs on any x86-64 machine.
+ *  Non x86 builds always use the scalar code paths.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ORA_X86_SIMD
+#endif
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+/** @brief Detects the best SIMD instruction set the CPU supports
+ * 
+ *  @return Best supported SIMD level
+ */
+inline SimdLevel DetectSimdLevel()
+{
+#ifdef ORA_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+#endif
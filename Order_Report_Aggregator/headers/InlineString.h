@@ -0,0 +1,99 @@
+/** @file InlineString.h
+ *  @brief Short string held inline in a fixed size character array
+ *
+ *  Holds text of up to Capacity characters inside the object itself, along with its length.
+ *  Nothing is ever allocated, so an InlineString is trivially copyable and can be copied,
+ *  snapshotted or written to disk with memcpy. Text longer than Capacity is truncated.
+ *
+ *  Unused characters are always zero, so two InlineStrings holding the same text have the
+ *  same bytes.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef INLINESTRING_H
+#define INLINESTRING_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+template <size_t Capacity>
+class InlineString
+{
+private:
+    static_assert(Capacity <= UINT8_MAX, "The length of an InlineString is held in a single byte");
+
+    char characters[Capacity];
+    uint8_t length;
+
+public:
+    InlineString();
+
+    void Assign(std::string_view text);
+    std::string_view View() const;
+    size_t Size() const;
+    bool IsValid() const;
+};
+
+
+template <size_t Capacity>
+inline InlineString<Capacity>::InlineString()
+    : length(0)
+{
+    memset(characters, 0, Capacity);
+}
+
+
+/** @brief Replaces the text held
+ *
+ *  Only the first Capacity characters of the text are kept.
+ *
+ *  @param text - Text to hold
+ *  @return void
+ */
+template <size_t Capacity>
+inline void InlineString<Capacity>::Assign(std::string_view text)
+{
+    length = static_cast<uint8_t>(text.size() < Capacity ? text.size() : Capacity);
+    memcpy(characters, text.data(), length);
+    memset(characters + length, 0, Capacity - length);
+}
+
+
+/** @brief Gets the text held
+ *
+ *  @return View of the text, valid for as long as the InlineString is unchanged
+ */
+template <size_t Capacity>
+inline std::string_view InlineString<Capacity>::View() const
+{
+    return std::string_view(characters, length);
+}
+
+
+/** @brief Gets the number of characters held
+ *
+ *  @return Length of the text
+ */
+template <size_t Capacity>
+inline size_t InlineString<Capacity>::Size() const
+{
+    return length;
+}
+
+
+/** @brief Checks the length is within the capacity
+ *
+ *  Always true unless the bytes came from somewhere else, e.g. a corrupt checkpoint.
+ *
+ *  @return true if the InlineString can be read safely
+ */
+template <size_t Capacity>
+inline bool InlineString<Capacity>::IsValid() const
+{
+    return length <= Capacity;
+}
+
+#endif
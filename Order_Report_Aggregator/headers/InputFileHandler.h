@@ -4,8 +4,33 @@
  *  Base class for reading in an input file. Will read in the input file line by line,
  *  sending sending each line to the ReadInputData virtual function. This function
  *  should be overridden in the derived class so that each line can be processed.
+ *
+ *  Regular files are memory mapped and each line is passed as a view straight out of the
+ *  mapped region. Anything that can't be mapped (pipes, devices etc.) falls back to
+ *  reading the file through a stream with std::getline.
+ *
+ *  Regular files can also be read into a pool of large buffers with io_uring, keeping several
+ *  reads in flight while the lines already read are processed (or with pread, where io_uring
+ *  isn't available).
+ *
+ *  gzip & zstd compressed files are detected from their first bytes and decompressed on a
+ *  separate thread while the lines already decompressed are being read. Offsets in a
+ *  compressed file are offsets into its decompressed data.
+ *
+ *  The input file can also be followed as it grows, like tail -f. New lines are read as
+ *  they are appended, and the OnInputSnapshot virtual function is called every so often
+ *  so the derived class can output what it has read so far.
+ *
+ *  Reading can start part way through the input file, e.g. to carry on from where a previous
+ *  run got to. The offset just past the last line read is tracked so it can be recorded. When
+ *  only complete lines are read, a final line without a newline is left unread, as it may still
+ *  be being written, so the offset recorded is never part way through a line. The part of the input
+ *  file up to an offset can be fingerprinted, so a later run can tell whether it is still the same file.
+ *  
+ *  Each line read is counted in the Pipeline Stats, and timed when latency histograms are enabled.
  *  
- *  Also contains helper function(s) that may be useful when manipulating the input data.
+ *  Also contains helpers for splitting the input data into lines, and into chunks at line
+ *  boundaries so they can be read in parallel.
  *
  *  @author Sean Griffin
  *  @bug No known bugs.
@@ -14,28 +39,125 @@
 #ifndef INPUTFILEHANDLER_H
 #define INPUTFILEHANDLER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "PipelineStats.h"
+
+enum class InputReadMethod { Auto, Stream, AsyncRead };
+
+struct FollowSettings
+{
+    std::chrono::milliseconds snapshotInterval;  // Time between snapshots. 0 to disable.
+    size_t snapshotLines;                        // Lines read between snapshots. 0 to disable.
+    std::chrono::milliseconds pollInterval;      // How often to check for new data without inotify
+    const std::atomic<bool>* stopFollowing;      // Set to stop following the input file
+};
 
 class InputFileHandler
 {
 protected:
     std::string inputFile;
+    InputReadMethod inputReadMethod;
+    size_t inputStartOffset;
+    size_t inputOffset;
+    bool completeLinesOnly;
 
-    virtual void ReadInputData(const std::string& inputLine) = 0;
-    void CalcStrValPosFromStr( const std::string& searchStr,
-                               const std::string& heading,
-                               size_t&            valPos,
-                               size_t&            valLength,
-                               const size_t       searchPos = 0 ) const;
+    virtual void ReadInputData(std::string_view inputLine) = 0;
+    virtual void OnInputSnapshot();
+    void ReadInputLine(std::string_view inputLine);
+    size_t ReadInputBlock(std::string_view inputBlock, size_t blockOffset, std::string& partialLine);
+    std::string_view CompleteLines(std::string_view inputData) const;
+    static std::vector<std::string_view> SplitInputData(std::string_view inputData, const size_t numChunks);
+
+    template <typename LineFunc>
+    static void ForEachInputLine(std::string_view inputData, LineFunc&& lineFunc);
+
+private:
+    bool ReadMappedInputFile();
+    void ReadCompressedInputFile();
+    bool ReadAsyncInputFile();
+    void ReadStreamedInputFile();
+    void WaitForInput(const int watchDescriptor, const std::chrono::milliseconds timeout) const;
 
 public:
     InputFileHandler(const std::string& inputFile_);
     virtual ~InputFileHandler();
     void SetInputFile(const std::string& inputFile_);
+    void SetInputReadMethod(const InputReadMethod readMethod);
+    void SetInputStartOffset(const size_t startOffset);
+    void SetCompleteLinesOnly(const bool enable);
+    size_t GetInputOffset() const;
+    bool FingerprintInput(const size_t endOffset, uint64_t& fingerprint) const;
     void ReadInputFile();
+    void FollowInputFile(const FollowSettings& settings);
 };
 
+
+/** @brief Passes a line to ReadInputData
+ * 
+ *  Records the line in the Pipeline Stats if they are enabled. While they are
+ *  disabled this costs a single check of the enabled flag.
+ * 
+ *  @param inputLine - Line from the input file
+ *  @return void
+ */
+inline void InputFileHandler::ReadInputLine(std::string_view inputLine)
+{
+    if (!PipelineStats::IsEnabled())
+    {
+        ReadInputData(inputLine);
+        return;
+    }
+
+    PipelineStats::Count(StatCounter::LinesRead);
+    PipelineStats::Count(StatCounter::BytesRead, inputLine.size() + 1);
+
+    if (!PipelineStats::HistogramsEnabled())
+    {
+        ReadInputData(inputLine);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ReadInputData(inputLine);
+    PipelineStats::RecordLatency( StatHistogram::LineLatency,
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() );
+}
+
+
+/** @brief Calls lineFunc for every line in the input data
+ * 
+ *  Lines are split on '\n' in the same way as std::getline, so a final line without
+ *  a newline is still passed on and a trailing newline doesn't produce an empty line.
+ *  Each line is a view into inputData, so no line is ever copied.
+ * 
+ *  @param inputData - Input data to split into lines
+ *  @param lineFunc  - Function to call with each line
+ *  @return void
+ */
+template <typename LineFunc>
+void InputFileHandler::ForEachInputLine(std::string_view inputData, LineFunc&& lineFunc)
+{
+    const char* lineStart = inputData.data();
+    const char* dataEnd = lineStart + inputData.size();
+
+    while (lineStart < dataEnd)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', dataEnd - lineStart));
+        if (lineEnd == nullptr)
+            lineEnd = dataEnd;
+
+        lineFunc(std::string_view(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+    }
+}
+
 #endif
\ No newline at end of file
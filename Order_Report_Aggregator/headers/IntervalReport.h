@@ -0,0 +1,143 @@
+/** @file IntervalReport.h
+ *  @brief Volume & VWAP of each Security per time interval, written while the input file is read
+ *
+ *  Splits time into fixed length intervals, e.g. 1 minute, using the timestamp of each Order Add,
+ *  and totals the quantity & notional (price * quantity) of each side of every Security in each
+ *  interval. The volume & Volume Weighted Average Price of each Security with Orders in an interval
+ *  are written as one row of the interval report.
+ *
+ *  Each Security has a ring of NUM_RING_INTERVALS buckets, one per interval, held in one flat array
+ *  with every Security's ring side by side. A bucket is one 64 byte cache line, so adding an Order
+ *  touches a single cache line, the same as updating its Order Report. When an Order arrives for an
+ *  interval past the end of the rings, the oldest intervals are written out and their buckets
+ *  reused, so the memory used depends on the number of Securities and not on the length of the
+ *  input file. Orders arriving out of order are still counted, as long as they are no more than
+ *  NUM_RING_INTERVALS - 1 intervals behind the latest; older ones are left out & counted as late.
+ *
+ *  Each notional is held in 128 bits, so quantity * price can't wrap it. A VWAP is never more than
+ *  the highest price, so it always fits in 64 bits unless the volume itself has wrapped; a VWAP
+ *  that doesn't fit is left empty rather than written wrong.
+ *
+ *  Only the Securities that had Orders in an interval are written, in the order they were inserted.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef INTERVALREPORT_H
+#define INTERVALREPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "OrderReport.h"
+#include "OrderReportCollection.h"
+#include "OutputBuffer.h"
+
+class IntervalReport
+{
+private:
+    static constexpr size_t NUM_RING_INTERVALS = 4;
+    static_assert((NUM_RING_INTERVALS & (NUM_RING_INTERVALS - 1)) == 0, "The ring is indexed with a mask");
+
+    struct alignas(64) IntervalBucket
+    {
+        uint64_t buyQuantity;
+        uint64_t sellQuantity;
+        unsigned __int128 buyNotional;
+        unsigned __int128 sellNotional;
+    };
+
+    bool open;
+    uint64_t intervalNs;
+    uint64_t firstInterval;                                 // Oldest interval held in the rings
+    size_t numSlots;
+    std::vector<IntervalBucket> buckets;                    // NUM_RING_INTERVALS per slot
+    std::vector<uint32_t> activeSlots[NUM_RING_INTERVALS];  // Slots with Orders in each ring position
+    const OrderReportCollection* ordRptColl;
+    OutputBuffer outBuffer;
+    char delimiter;
+    size_t numLateOrders;
+
+    void AddToBucket(const size_t slot, const uint64_t interval, const OrderAddData& ordData);
+    void AddOutsideRings(const size_t slot, const uint64_t interval, const OrderAddData& ordData);
+    void WriteInterval(const uint64_t interval);
+
+public:
+    IntervalReport();
+    ~IntervalReport();
+    IntervalReport(const IntervalReport&) = delete;
+    IntervalReport& operator=(const IntervalReport&) = delete;
+
+    bool Open( const std::string&             outputFile,
+               const std::chrono::nanoseconds interval,
+               const OrderReportCollection*   ordRptColl_,
+               const char                     delim );
+    bool IsOpen() const;
+    void AddOrderData(const size_t slot, const OrderAddData& ordData);
+    void Close();
+    size_t GetNumLateOrders() const;
+};
+
+
+/** @brief Checks whether the interval report is being written
+ *
+ *  @return true if the interval report is open
+ */
+inline bool IntervalReport::IsOpen() const
+{
+    return open;
+}
+
+
+/** @brief Adds an Order to the bucket of its Security & interval
+ *
+ *  Defined in the header so it can be inlined into the per order hot path. Orders in an interval
+ *  the rings already hold only cost the division to find their interval and the bucket update.
+ *
+ *  @param slot    - Slot of the Security in the Order Report collection
+ *  @param ordData - The relevant data from the Order Add record, including its timestamp
+ *  @return void
+ */
+inline void IntervalReport::AddOrderData(const size_t slot, const OrderAddData& ordData)
+{
+    uint64_t interval = ordData.timestamp / intervalNs;
+    if (interval - firstInterval < NUM_RING_INTERVALS && slot < numSlots)
+        AddToBucket(slot, interval, ordData);
+    else
+        AddOutsideRings(slot, interval, ordData);
+}
+
+
+/** @brief Adds an Order to a bucket the rings already hold
+ *
+ *  The Security is recorded as active in the interval the first time the bucket gets any quantity.
+ *
+ *  @param slot     - Slot of the Security in the Order Report collection
+ *  @param interval - Interval of the Order
+ *  @param ordData  - The relevant data from the Order Add record
+ *  @return void
+ */
+inline void IntervalReport::AddToBucket(const size_t slot, const uint64_t interval, const OrderAddData& ordData)
+{
+    size_t ringPos = interval & (NUM_RING_INTERVALS - 1);
+    IntervalBucket& bucket = buckets[(slot * NUM_RING_INTERVALS) + ringPos];
+    bool wasEmpty = (bucket.buyQuantity | bucket.sellQuantity) == 0;
+
+    if (ordData.side == Side::Buy)
+    {
+        bucket.buyQuantity += ordData.quantity;
+        bucket.buyNotional += static_cast<unsigned __int128>(ordData.quantity) * ordData.price;
+    }
+    else
+    {
+        bucket.sellQuantity += ordData.quantity;
+        bucket.sellNotional += static_cast<unsigned __int128>(ordData.quantity) * ordData.price;
+    }
+
+    if (wasEmpty && (bucket.buyQuantity | bucket.sellQuantity) != 0)
+        activeSlots[ringPos].push_back(static_cast<uint32_t>(slot));
+}
+
+#endif
@@ -0,0 +1,108 @@
+/** @file JsonLineParser.h
+ *  @brief Pulls the values of a set of keys out of a line of JSON, whatever order they are in
+ *
+ *  Each line is parsed in two stages, in the style of simdjson's structural index. The first stage
+ *  scans the line 64 bytes at a time and builds bitmasks of the quotes, backslashes, colons and
+ *  structural characters (: , { } [ ]) in each block. The second stage removes escaped quotes, takes
+ *  a prefix XOR of the quotes to mark which bytes are inside strings, and drops the colons and
+ *  structural characters inside strings. The colons that are left are then looked at a bit at a time,
+ *  so the bytes in between are never looked at one by one. Each key asked for is only compared at the
+ *  colons with a quote just before them and another quote its length before that, found for a whole
+ *  block at once by shifting the quotes' bitmask.
+ *
+ *  The key of each colon is the string closed by the last quote before it, and is matched against
+ *  the keys asked for at any depth. The value of a key that matches runs from the ':' up to the next
+ *  structural character, with any whitespace around it trimmed. Values are returned as views into the
+ *  line exactly as they appear in it, so a string keeps its quotes. A key whose value is an object or
+ *  array is skipped over, and the keys inside it are looked at instead. The first value of each key is
+ *  the one returned, and parsing stops as soon as every key asked for has been found. Nothing is
+ *  allocated.
+ *
+ *  The bitmasks are built with AVX2 or SSE2, chosen at runtime, with a scalar fallback. Every
+ *  instruction set builds exactly the same bitmasks, so gives exactly the same values.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef JSONLINEPARSER_H
+#define JSONLINEPARSER_H
+
+#include <cstdint>
+#include <string_view>
+#include "CpuFeatures.h"
+
+// A set of keys to extract, prepared once so each key in a line can be compared against all of them
+// at once
+//
+struct JsonKeySet
+{
+    static constexpr size_t MAX_KEYS = 8;
+    static constexpr size_t MAX_MASKED_KEY_LENGTH = 61;     // Longest key found with the block's bitmasks
+    static constexpr size_t WORD_SIZE = sizeof(uint64_t);
+
+    size_t numKeys;
+    bool hasLongKeys;
+    std::string_view keys[MAX_KEYS];
+    uint64_t heads[MAX_KEYS];       // First 8 bytes of each key
+    uint64_t tails[MAX_KEYS];       // Last 8 bytes of each key, right aligned if it's shorter
+    uint64_t tailMasks[MAX_KEYS];   // Bytes of each tail that are compared
+    unsigned char quoteShifts[MAX_KEYS];    // Distance from each key's opening quote to its ':'
+
+    template <size_t N>
+    JsonKeySet(const std::string_view (&keyList)[N]) : JsonKeySet(keyList, N)
+    {
+        static_assert(N <= MAX_KEYS, "Too many keys for a JSON key set");
+    }
+
+private:
+    JsonKeySet(const std::string_view* keyList, const size_t count);
+};
+
+class JsonLineParser
+{
+private:
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr size_t BLOCKS_PER_SCAN = 4;
+    static constexpr uintptr_t PAGE_SIZE = 4096;
+    static constexpr size_t WORD_SIZE = sizeof(uint64_t);
+
+    // Bitmasks of the characters in a block, one bit per byte
+    //
+    struct BlockMasks
+    {
+        uint64_t quotes;
+        uint64_t backslashes;
+        uint64_t colons;
+        uint64_t structurals;   // : , { } [ ]
+    };
+
+    typedef void (*ScanBlocksFunc)(const char* data, const size_t numBlocks, BlockMasks* masks);
+
+    static ScanBlocksFunc scanBlocks;
+    static SimdLevel simdLevel;
+
+    static ScanBlocksFunc GetScanBlocksFunc(const SimdLevel level);
+    static size_t ScanChunk(const char* data, const size_t length, BlockMasks* masks);
+    static void ScanBlocksScalar(const char* data, const size_t numBlocks, BlockMasks* masks);
+    static uint64_t MatchBytes(const uint64_t word, const char character);
+    static uint64_t PackBytes(const uint64_t topBits);
+#ifdef ORA_X86_SIMD
+    static void ScanBlocksSSE2(const char* data, const size_t numBlocks, BlockMasks* masks);
+    static void ScanBlocksAVX2(const char* data, const size_t numBlocks, BlockMasks* masks);
+#endif
+    static uint64_t FindEscaped(uint64_t backslashes, bool& escapeCarry);
+    static uint64_t PrefixXor(uint64_t bits);
+    static size_t MatchKey(const char* line, const size_t keyEnd, const JsonKeySet& keySet, const uint64_t foundKeys);
+    static bool KeyMatches(const char* line, const size_t keyEnd, const JsonKeySet& keySet, const size_t key);
+    static bool IsEscaped(const char* line, const size_t pos);
+    static std::string_view GetValue(const char* line, const size_t valueStart, const size_t valueEnd);
+    static std::string_view Trim(std::string_view value);
+
+public:
+    static bool ExtractFields(std::string_view inputLine, const JsonKeySet& keySet, std::string_view* values);
+    static void SetSimdLevel(const SimdLevel level);
+    static SimdLevel GetSimdLevel();
+};
+
+#endif
@@ -0,0 +1,38 @@
+/** @file MappedFile.h
+ *  @brief Read-only memory mapping of an input file
+ *
+ *  Maps a regular file into memory so that its contents can be read in place,
+ *  without copying each line into a std::string first. Only regular files can be
+ *  mapped; pipes, character devices etc. will fail to open and the caller should
+ *  fall back to reading the file through a stream.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+
+class MappedFile
+{
+private:
+    int fileDescriptor;
+    const char* data;
+    size_t size;
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& fileName);
+    void Close();
+    bool IsOpen() const;
+    std::string_view GetData() const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+/** @file MessageClassifier.h
+ *  @brief Finds the message type of a line from the input file
+ *
+ *  Locates the "msgType_": heading once and reads the number that follows it, so each
+ *  line is only scanned once however many message types are being handled. The caller
+ *  can then dispatch on the number, rather than searching the line once per message type.
+ *
+ *  The heading is searched for with SSE2 or AVX2, comparing the first and last characters
+ *  of the heading against a whole block of the line at once and only checking the rest of
+ *  the heading where both match. The instruction set is chosen at runtime, with a scalar
+ *  search as a fallback.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef MESSAGECLASSIFIER_H
+#define MESSAGECLASSIFIER_H
+
+#include <string_view>
+#include "CpuFeatures.h"
+
+class MessageClassifier
+{
+private:
+    typedef const char* (*FindHeadingFunc)(const char* data, size_t length);
+
+    static FindHeadingFunc findHeading;
+    static SimdLevel simdLevel;
+
+    static FindHeadingFunc GetFindHeadingFunc(const SimdLevel level);
+    static const char* FindHeadingScalar(const char* data, size_t length);
+#ifdef ORA_X86_SIMD
+    static const char* FindHeadingSSE2(const char* data, size_t length);
+    static const char* FindHeadingAVX2(const char* data, size_t length);
+#endif
+
+public:
+    static constexpr int UNKNOWN_MSG_TYPE = -1;
+
+    static int Classify(std::string_view inputLine);
+    static void SetSimdLevel(const SimdLevel level);
+    static SimdLevel GetSimdLevel();
+};
+
+#endif
@@ -0,0 +1,135 @@
+/** @file OrderBatch.h
+ *  @brief A block of parsed Order Adds, applied to their Order Reports a Security at a time
+ *
+ *  Order Adds are collected as they are parsed, rather than looked up and added one at a time.
+ *  Once the batch is full they are grouped by Security ID with a stable radix sort, and each
+ *  Security is then looked up once and has the totals of all its Orders added in one go.
+ *
+ *  The Orders are held as separate arrays of quantities, prices & sides, so the totals of a group
+ *  are summed with SIMD: counts, quantities, the amount spent and the max & min prices of several
+ *  Orders at a time. AVX2 or SSE2 is chosen at runtime, with a scalar fallback. Every instruction
+ *  set gives exactly the same totals, and adding them gives exactly the same Order Report as adding
+ *  each Order on its own.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERBATCH_H
+#define ORDERBATCH_H
+
+#include <cstdint>
+#include <vector>
+#include "CpuFeatures.h"
+#include "OrderReport.h"
+
+// Orders in a batch that are all against one Security. Once grouped, they are next to each other.
+//
+struct OrderBatchGroup
+{
+    int securityId;
+    uint32_t start;     // Position of the group's first Order, once grouped
+    uint32_t count;
+};
+
+class OrderBatch
+{
+private:
+    static constexpr size_t RADIX_BITS = 8;
+    static constexpr size_t RADIX_SIZE = 1 << RADIX_BITS;
+    static constexpr size_t KEY_DIGITS = sizeof(uint32_t) * 8 / RADIX_BITS;
+    static constexpr size_t KEY_SHIFT = 32;
+    static constexpr size_t MIN_SIMD_GROUP_SIZE = 8;
+    static constexpr size_t COUNTING_SORT_RANGE = 16384;      // Widest range of Security IDs grouped with a counting sort
+
+    typedef OrderTotals (*SumOrdersFunc)(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count);
+
+    static SumOrdersFunc sumOrders;
+    static SimdLevel simdLevel;
+
+    // Each Order in the order it was added
+    //
+    size_t numOrders;
+    std::vector<uint64_t> sortKeys;     // Security ID in the top 32 bits, position the Order was added at in the bottom
+    std::vector<uint64_t> quantities;
+    std::vector<uint64_t> prices;
+    std::vector<uint64_t> buyMasks;     // All ones for a Buy Order, 0 for a Sell Order
+
+    // The same Orders once grouped by Security
+    //
+    std::vector<uint64_t> groupedKeys;
+    std::vector<uint64_t> sortScratch;
+    std::vector<uint32_t> securityCounts;
+    std::vector<uint64_t> groupedQuantities;
+    std::vector<uint64_t> groupedPrices;
+    std::vector<uint64_t> groupedBuyMasks;
+    std::vector<OrderBatchGroup> groups;
+
+    void RadixSortGroups();
+
+    static SumOrdersFunc GetSumOrdersFunc(const SimdLevel level);
+    static OrderTotals SumOrdersScalar(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count);
+#ifdef ORA_X86_SIMD
+    static OrderTotals SumOrdersSSE2(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count);
+    static OrderTotals SumOrdersAVX2(const uint64_t* quantities, const uint64_t* prices, const uint64_t* buyMasks, const size_t count);
+#endif
+
+public:
+    static constexpr size_t CAPACITY = 8192;
+
+    OrderBatch();
+    ~OrderBatch() = default;
+
+    void Add(const int securityId, const OrderAddData& ordData);
+    size_t Size() const;
+    bool Full() const;
+    void Clear();
+
+    const std::vector<OrderBatchGroup>& GroupBySecurity();
+    OrderTotals SumGroup(const OrderBatchGroup& group) const;
+    size_t GetGroupedOrder(const size_t pos) const;
+    OrderAddData GetOrderData(const size_t order) const;
+
+    static void SetSimdLevel(const SimdLevel level);
+    static SimdLevel GetSimdLevel();
+};
+
+
+/** @brief Adds a parsed Order Add to the batch
+ *
+ *  The batch must not be full. Only the side, quantity & price of the Order are kept.
+ *
+ *  @param securityId - Security ID the Order is against
+ *  @param ordData    - The relevant data from the Order Add record
+ *  @return void
+ */
+inline void OrderBatch::Add(const int securityId, const OrderAddData& ordData)
+{
+    sortKeys[numOrders] = (static_cast<uint64_t>(static_cast<uint32_t>(securityId)) << 32) | numOrders;
+    quantities[numOrders] = ordData.quantity;
+    prices[numOrders] = ordData.price;
+    buyMasks[numOrders] = (ordData.side == Side::Buy) ? UINT64_MAX : 0;
+    ++numOrders;
+}
+
+
+/** @brief Gets the number of Orders in the batch
+ *
+ *  @return Number of Orders
+ */
+inline size_t OrderBatch::Size() const
+{
+    return numOrders;
+}
+
+
+/** @brief Checks whether the batch has room for another Order
+ *
+ *  @return true if the batch is full
+ */
+inline bool OrderBatch::Full() const
+{
+    return numOrders == CAPACITY;
+}
+
+#endif
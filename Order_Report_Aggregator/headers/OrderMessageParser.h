@@ -0,0 +1,72 @@
+/** @file OrderMessageParser.h
+ *  @brief Extracts the fields we need from Order Add, Delete, Modify & Execute and Security Reference Data records
+ *
+ *  Parses the values out of a line from the input file without allocating. Every value
+ *  is either returned as a view into the line or converted straight to a number with
+ *  std::from_chars, so there are no temporary strings and no locale or exception overhead.
+ *
+ *  The values are first looked for in the order the feed writes them, searching for each heading
+ *  from the end of the value before it, which is the quickest way to find them. A line whose
+ *  fields can't all be found that way, e.g. because they are in another order, are the last in
+ *  their object or are padded with whitespace, is parsed by the JSON Line Parser instead, in a
+ *  single scan of the line, so the fields can be in any order. Only values the JSON Line Parser
+ *  would give too are taken from the search in order, unless the line has a key more than once.
+ *
+ *  If a field is missing or its value isn't a valid number then the record is rejected. Numbers
+ *  and the side may be quoted or not; the ISIN & currency are kept exactly as they appear,
+ *  quotes included.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERMESSAGEPARSER_H
+#define ORDERMESSAGEPARSER_H
+
+#include <cstdint>
+#include <string_view>
+#include "OrderReport.h"
+
+// An Order Modify gives the Order's new quantity & price, and an Order Execute the quantity
+// & price it traded at
+//
+struct OrderUpdateData
+{
+    uint64_t orderId;
+    size_t quantity;
+    size_t price;
+};
+
+struct SecurityRefData
+{
+    int securityId;
+    std::string_view ISIN;
+    std::string_view currency;
+};
+
+class OrderMessageParser
+{
+private:
+    static size_t FindHeading(std::string_view inputLine, std::string_view heading, const size_t searchPos);
+    static bool FindFieldValue(std::string_view inputLine, std::string_view heading, size_t& searchPos, std::string_view& value);
+    template <typename T>
+    static bool FindNumberValue(std::string_view inputLine, std::string_view heading, size_t& searchPos, T& number);
+    static std::string_view Unquoted(std::string_view value);
+    template <typename T>
+    static bool ParseNumber(std::string_view value, T& number);
+    static bool ParseOrderAddAnyOrder(std::string_view inputLine, int& securityId, OrderAddData& ordData, const unsigned optionalFields);
+
+public:
+    // Optional Order Add fields, only parsed when asked for
+    //
+    static constexpr unsigned PARSE_TIMESTAMP = 1;
+    static constexpr unsigned PARSE_ORDER_ID = 2;
+
+    static bool ParseOrderAdd(std::string_view inputLine, int& securityId, OrderAddData& ordData, const unsigned optionalFields = 0);
+    static bool ParseOrderDelete(std::string_view inputLine, uint64_t& orderId);
+    static bool ParseOrderUpdate(std::string_view inputLine, OrderUpdateData& updData);
+    static bool ParseSecurityRef(std::string_view inputLine, SecurityRefData& refData);
+    static bool ParseSecurityId(std::string_view inputLine, int& securityId);
+};
+
+#endif
@@ -3,6 +3,21 @@
  *
  *  This contains the data and functions needed to produce an Order Report on a Security.
  *
+ *  Only the counters that are updated for every order are held in the Order Report, and they
+ *  fit in a single 64 byte cache line. The Security's ISIN & currency are held separately in a
+ *  SecurityInfo, as they are only needed when outputting the report. The distributions of order
+ *  prices & quantities, for reporting quantiles, are held separately again in OrderSketches.
+ *
+ *  The Totals Spent are held in 80 bits, the top 16 of them in what would otherwise be padding, so
+ *  quantity * price can't wrap them. Orders can be added one at a time, or a group at a time as the
+ *  totals of a batch (see OrderBatch.h), which gives exactly the same Order Report.
+ *
+ *  None of them hold any pointers or allocations. The ISIN & currency are kept in fixed size inline
+ *  storage, so all are trivially copyable and can be snapshotted & restored with memcpy.
+ *
+ *  Each value that can be reported on is a Report Column, and is read with GetColumn. Which columns
+ *  a report holds, and in what order, is set by a Report Schema (see ReportSchema.h).
+ *
  *  @author Sean Griffin
  *  @bug No known bugs.
  */
@@ -10,47 +25,322 @@
 #ifndef ORDERREPORT_H
 #define ORDERREPORT_H
 
-#include <fstream>
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include "InlineString.h"
+#include "QuantileSketch.h"
 
 enum class Side { Buy, Sell };
 
+enum class ReportColumn
+{
+    ISIN,
+    Currency,
+    BuyCount,
+    SellCount,
+    BuyQuantity,
+    SellQuantity,
+    WeightedAvgBuyPrice,
+    WeightedAvgSellPrice,
+    MaxBuyPrice,
+    MinSellPrice,
+    BuyPriceP50,
+    BuyPriceP95,
+    BuyPriceP99,
+    SellPriceP50,
+    SellPriceP95,
+    SellPriceP99,
+    BuyQuantityP50,
+    BuyQuantityP95,
+    BuyQuantityP99,
+    SellQuantityP50,
+    SellQuantityP95,
+    SellQuantityP99,
+    RestingBuyQuantity,
+    RestingSellQuantity,
+    ExecutedBuyQuantity,
+    ExecutedSellQuantity
+};
+
 struct OrderAddData
 {
     Side side;
     size_t quantity;
     size_t price;
+    uint64_t timestamp;     // Nanoseconds since the epoch. Only parsed for the interval report, 0 otherwise.
+    uint64_t orderId;       // Only parsed when tracking live Orders, 0 otherwise.
+};
+
+// Totals of a group of Orders against one Security, added to its Order Report in one go (see OrderBatch.h).
+// The Max Buy Price is only meaningful when there are Buy Orders, and the Min Sell Price when there are Sell Orders.
+//
+struct OrderTotals
+{
+    int buyCount;
+    int sellCount;
+    size_t buyQuantity;
+    size_t sellQuantity;
+    size_t maxBuyPrice;
+    size_t minSellPrice;
+    unsigned __int128 buySpent;
+    unsigned __int128 sellSpent;
+};
+
+// ISINs are 12 characters and currencies 3, plus the quotes kept from the input file.
+// Anything longer is truncated.
+//
+struct SecurityInfo
+{
+    InlineString<15> ISIN;
+    InlineString<7> currency;
+};
+
+// Distributions of the prices & quantities of the Orders against a Security, for estimating quantiles.
+// Only kept when quantiles are reported, as they take about 1KB per Security.
+//
+struct OrderSketches
+{
+    QuantileSketch buyPrice;
+    QuantileSketch buyQuantity;
+    QuantileSketch sellPrice;
+    QuantileSketch sellQuantity;
+
+    void AddOrderData(const OrderAddData& ordData);
+    void Merge(const OrderSketches& other);
+    bool IsValid() const;
+
+    static size_t GetQuantile(const OrderSketches* sketches, QuantileSketch OrderSketches::* sketch, const double fraction);
+    template <ReportColumn Column>
+    static size_t GetColumn(const OrderSketches* sketches);
+};
+
+// Resting & executed quantity of the Orders against a Security, from the Order Deletes, Modifies & Executes.
+// Only kept up to date when live Orders are tracked.
+//
+struct OrderActivity
+{
+    uint64_t restingBuyQuantity;
+    uint64_t restingSellQuantity;
+    uint64_t executedBuyQuantity;
+    uint64_t executedSellQuantity;
+
+    void Merge(const OrderActivity& other);
 };
 
-class OrderReport
+class alignas(64) OrderReport
 {
 private:
-    std::string ISIN;
-    std::string currency;
     int securityId;
     int buyCount;
     int sellCount;
+    uint16_t buySpentHigh;      // Top 16 bits of the 80 bit Total Spent on Buying, held in what would be padding
+    uint16_t sellSpentHigh;     // Top 16 bits of the 80 bit Total Spent on Selling
     size_t buyQuantity;
     size_t sellQuantity;
     size_t maxBuyPrice;
     size_t minSellPrice;
-    size_t totalBuySpent;
-    size_t totalSellSpent;
+    size_t totalBuySpent;       // Bottom 64 bits of the Total Spent on Buying
+    size_t totalSellSpent;      // Bottom 64 bits of the Total Spent on Selling
+
+    static constexpr unsigned __int128 MAX_SPENT = (static_cast<unsigned __int128>(1) << 80) - 1;
 
+    static unsigned __int128 GetSpent(const size_t spent, const uint16_t spentHigh);
+    static void AddSpent(size_t& spent, uint16_t& spentHigh, const unsigned __int128 amount);
+    static size_t CalcWeightedAvg(const size_t spent, const uint16_t spentHigh, const size_t quantity);
     size_t CalcWeightedAvgBuyPrice() const;
     size_t CalcWeightedAvgSellPrice() const;
 
 public:
     OrderReport();
-    ~OrderReport();
+    ~OrderReport() = default;
 
-    void SetISIN(const std::string& isin_);
-    void SetCurrency(const std::string& cur_);
     void SetSecurityId(const int secId_);
     void AddOrderData(const OrderAddData& ordData);
+    void AddOrderTotals(const OrderTotals& totals);
+    void Merge(const OrderReport& other);
     
     int GetSecurityId() const;
-    void OutputReport(std::ofstream& outStream, const char delim, const bool rptEmptyOrds) const;
+    bool HasOrders() const;
+    int GetOrderCount() const;
+
+    template <ReportColumn Column>
+    auto GetColumn() const;
 };
 
+
+/** @brief Adds new Order Data to the sketches of its side
+ * 
+ *  @param ordData - The relevant data from the Order Add record
+ *  @return void
+ */
+inline void OrderSketches::AddOrderData(const OrderAddData& ordData)
+{
+    if (ordData.side == Side::Buy)
+    {
+        buyPrice.Add(ordData.price);
+        buyQuantity.Add(ordData.quantity);
+    }
+    else
+    {
+        sellPrice.Add(ordData.price);
+        sellQuantity.Add(ordData.quantity);
+    }
+}
+
+
+/** @brief Checks whether any Orders have been added
+ * 
+ *  @return true if there has been at least one Buy or Sell Order
+ */
+inline bool OrderReport::HasOrders() const
+{
+    return buyCount > 0 || sellCount > 0;
+}
+
+
+/** @brief Gets a Total Spent from its two parts
+ * 
+ *  @param spent     - Bottom 64 bits of the Total Spent
+ *  @param spentHigh - Top 16 bits of the Total Spent
+ *  @return Total Spent
+ */
+inline unsigned __int128 OrderReport::GetSpent(const size_t spent, const uint16_t spentHigh)
+{
+    return (static_cast<unsigned __int128>(spentHigh) << 64) | spent;
+}
+
+
+/** @brief Adds an amount to a Total Spent
+ * 
+ *  The total is held in 80 bits, so quantity * price can't wrap it. Should it ever reach 2^80 it
+ *  stays at the largest value it can hold, which gives the same result whatever order the amounts
+ *  are added in.
+ *
+ *  @param spent     - Bottom 64 bits of the Total Spent
+ *  @param spentHigh - Top 16 bits of the Total Spent
+ *  @param amount    - Amount to add
+ *  @return void
+ */
+inline void OrderReport::AddSpent(size_t& spent, uint16_t& spentHigh, const unsigned __int128 amount)
+{
+    unsigned __int128 total;
+    if (__builtin_add_overflow(GetSpent(spent, spentHigh), amount, &total) || total > MAX_SPENT)
+        total = MAX_SPENT;
+
+    spent = static_cast<size_t>(total);
+    spentHigh = static_cast<uint16_t>(total >> 64);
+}
+
+
+/** @brief Calculates a Weighted Average Price
+ * 
+ *  Will first check that the quantity is not zero, so that we don't divide by it.
+ *  Will return the Total Spent, which should be 0, if the quantity is 0. Totals that fit
+ *  in 64 bits, as nearly all do, are divided without the slower 128 bit division.
+ * 
+ *  @param spent     - Bottom 64 bits of the Total Spent
+ *  @param spentHigh - Top 16 bits of the Total Spent
+ *  @param quantity  - Total quantity the amount was spent on
+ *  @return Weighted Average Price
+ */
+inline size_t OrderReport::CalcWeightedAvg(const size_t spent, const uint16_t spentHigh, const size_t quantity)
+{
+    if (spentHigh == 0)
+        return ((quantity != 0) ? (spent/quantity) : spent);
+
+    unsigned __int128 avgPrice = (quantity != 0) ? (GetSpent(spent, spentHigh)/quantity) : GetSpent(spent, spentHigh);
+    return (avgPrice > SIZE_MAX) ? SIZE_MAX : static_cast<size_t>(avgPrice);
+}
+
+
+/** @brief Calculates the Weighted Average Buy Price
+ * 
+ *  @return Weighted Average Buy Price
+ */
+inline size_t OrderReport::CalcWeightedAvgBuyPrice() const
+{
+    return CalcWeightedAvg(totalBuySpent, buySpentHigh, buyQuantity);
+}
+
+
+/** @brief Calculates the Weighted Average Sell Price
+ * 
+ *  @return Weighted Average Sell Price
+ */
+inline size_t OrderReport::CalcWeightedAvgSellPrice() const
+{
+    return CalcWeightedAvg(totalSellSpent, sellSpentHigh, sellQuantity);
+}
+
+
+/** @brief Gets the value of a Report Column
+ * 
+ *  The column is chosen at compile time, so reading it compiles down to a single load,
+ *  or the division for a weighted average. Only the columns kept in the Order Report itself
+ *  can be read here; OrderReportCollection::GetColumn reads the rest.
+ *
+ *  @return Value of the column
+ */
+template <ReportColumn Column>
+inline auto OrderReport::GetColumn() const
+{
+    if constexpr (Column == ReportColumn::BuyCount)
+        return buyCount;
+    else if constexpr (Column == ReportColumn::SellCount)
+        return sellCount;
+    else if constexpr (Column == ReportColumn::BuyQuantity)
+        return buyQuantity;
+    else if constexpr (Column == ReportColumn::SellQuantity)
+        return sellQuantity;
+    else if constexpr (Column == ReportColumn::WeightedAvgBuyPrice)
+        return CalcWeightedAvgBuyPrice();
+    else if constexpr (Column == ReportColumn::WeightedAvgSellPrice)
+        return CalcWeightedAvgSellPrice();
+    else if constexpr (Column == ReportColumn::MaxBuyPrice)
+        return maxBuyPrice;
+    else
+    {
+        static_assert(Column == ReportColumn::MinSellPrice, "Not a column of the Order Report");
+        return minSellPrice;
+    }
+}
+
+
+/** @brief Gets the value of a quantile Report Column
+ * 
+ *  @param sketches - Sketches of the Security's Orders, or nullptr if there are none
+ *  @return Estimated quantile, or 0 if there are no sketches
+ */
+template <ReportColumn Column>
+inline size_t OrderSketches::GetColumn(const OrderSketches* sketches)
+{
+    if constexpr (Column == ReportColumn::BuyPriceP50)
+        return GetQuantile(sketches, &OrderSketches::buyPrice, 0.50);
+    else if constexpr (Column == ReportColumn::BuyPriceP95)
+        return GetQuantile(sketches, &OrderSketches::buyPrice, 0.95);
+    else if constexpr (Column == ReportColumn::BuyPriceP99)
+        return GetQuantile(sketches, &OrderSketches::buyPrice, 0.99);
+    else if constexpr (Column == ReportColumn::SellPriceP50)
+        return GetQuantile(sketches, &OrderSketches::sellPrice, 0.50);
+    else if constexpr (Column == ReportColumn::SellPriceP95)
+        return GetQuantile(sketches, &OrderSketches::sellPrice, 0.95);
+    else if constexpr (Column == ReportColumn::SellPriceP99)
+        return GetQuantile(sketches, &OrderSketches::sellPrice, 0.99);
+    else if constexpr (Column == ReportColumn::BuyQuantityP50)
+        return GetQuantile(sketches, &OrderSketches::buyQuantity, 0.50);
+    else if constexpr (Column == ReportColumn::BuyQuantityP95)
+        return GetQuantile(sketches, &OrderSketches::buyQuantity, 0.95);
+    else if constexpr (Column == ReportColumn::BuyQuantityP99)
+        return GetQuantile(sketches, &OrderSketches::buyQuantity, 0.99);
+    else if constexpr (Column == ReportColumn::SellQuantityP50)
+        return GetQuantile(sketches, &OrderSketches::sellQuantity, 0.50);
+    else if constexpr (Column == ReportColumn::SellQuantityP95)
+        return GetQuantile(sketches, &OrderSketches::sellQuantity, 0.95);
+    else
+    {
+        static_assert(Column == ReportColumn::SellQuantityP99, "Not a quantile column");
+        return GetQuantile(sketches, &OrderSketches::sellQuantity, 0.99);
+    }
+}
+
 #endif
\ No newline at end of file
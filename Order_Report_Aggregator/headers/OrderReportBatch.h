@@ -0,0 +1,68 @@
+/** @file OrderReportBatch.h
+ *  @brief Produces Order Reports for a batch of input files
+ *
+ *  Reads every input file in a directory, or matching a glob pattern, on a shared work-stealing
+ *  thread pool. Each input file gets its own OrderReportFileHandler and Order Report collection, so
+ *  an Order Add is only counted if its Security is referenced in the same file.
+ *
+ *  Input files are submitted largest first. A large input file is split into chunks of about
+ *  CHUNK_SIZE bytes which are read as separate tasks, so one huge file is spread across every
+ *  thread instead of leaving the others idle once the smaller files are done.
+ *
+ *  The reports can either be written for each input file as soon as it has been read, or the
+ *  Order Report collections of every input file merged into one consolidated report.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERREPORTBATCH_H
+#define ORDERREPORTBATCH_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "OrderReportFileHandler.h"
+
+class OrderReportBatch
+{
+private:
+    static constexpr size_t CHUNK_SIZE = 32 << 20;
+
+    struct BatchFile
+    {
+        std::string inputFile;
+        size_t fileSize;
+        std::shared_ptr<OrderReportCollection> ordRptColl;
+        std::unique_ptr<OrderReportFileHandler> fileHandler;
+    };
+
+    std::vector<BatchFile> batchFiles;
+    InputReadMethod inputReadMethod;
+    size_t pendingOrderLimit;
+    const ReportFormat* reportFormat;
+    bool quantileSketches;
+    bool trackOrders;
+    std::vector<RollupDimension> rollupDimensions;
+
+public:
+    OrderReportBatch(const std::vector<std::string>& inputFiles);
+    ~OrderReportBatch();
+
+    static std::vector<std::string> FindInputFiles(const std::string& inputPath);
+    static std::string GetReportName(const std::string& inputFile);
+
+    void SetInputReadMethod(const InputReadMethod method);
+    void SetPendingOrderLimit(const size_t memoryLimit);
+    void SetReportFormat(const ReportFormat* format);
+    void SetQuantileSketches(const bool enable);
+    void SetOrderTracking(const bool enable);
+    void SetRollups(const std::vector<RollupDimension>& dimensions);
+    size_t GetNumFiles() const;
+    void ReadInputFiles(const size_t numThreads, const std::string& outputDirectory);
+    void MergeOrderReports(OrderReportCollection& mergedColl) const;
+    void ReportUnresolvedOrders(std::ostream& output) const;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/** @file OrderReportCheckpoint.h
+ *  @brief Saves and restores an Order Report collection as a binary checkpoint
+ *
+ *  A checkpoint holds every Order Report in a collection along with the offset in the input
+ *  file it covers up to, so that reading can carry on from that offset after a restart rather
+ *  than parsing the whole input file again. It also holds a fingerprint of the input file up to
+ *  that offset, so it is only carried on from if the input file is still the one it was saved from.
+ *
+ *  Orders still waiting in the Pending Order Buffer for their Security to be referenced are saved too,
+ *  as are the live Orders in the Order Store, and the Securities' Order Sketches when the collection keeps them.
+ *
+ *  The file is laid out so it can be memory mapped and read in place:
+ *    CheckpointHeader | OrderReport[numSecurities] | SecurityInfo[numSecurities] | OrderActivity[numSecurities] |
+ *    CheckpointPendingOrder[numPendingOrders] | CheckpointLiveOrder[numLiveOrders] |
+ *    uint32_t sketchIndex[numSecurities] | OrderSketches[numSketches]
+ *  The sketch indexes and sketches are left out when there are no sketches. Each Security's sketch index is
+ *  the position of its sketches, or UINT32_MAX if it has none.
+ *  The Order Reports and Security data are stored exactly as they are held in memory, so a checkpoint
+ *  can only be restored by a build with the same layout; anything else is rejected by the version &
+ *  size checks in the header.
+ *
+ *  Checkpoints are written to a temporary file, synced to disk and then renamed over the old
+ *  checkpoint, so a crash while saving never leaves a half written checkpoint behind.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERREPORTCHECKPOINT_H
+#define ORDERREPORTCHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "OrderReportCollection.h"
+#include "OrderStore.h"
+#include "PendingOrderBuffer.h"
+
+// Padded to a whole cache line so the Order Reports that follow it are aligned in a mapped checkpoint
+//
+struct alignas(64) CheckpointHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t orderReportSize;
+    uint32_t securityInfoSize;
+    uint32_t orderSketchesSize;
+    uint32_t orderActivitySize;
+    uint64_t inputOffset;
+    uint64_t inputFingerprint;
+    uint64_t numSecurities;
+    uint64_t numPendingOrders;
+    uint64_t numLiveOrders;
+    uint64_t numSketches;
+};
+
+struct CheckpointPendingOrder
+{
+    int32_t securityId;
+    uint32_t side;
+    uint64_t quantity;
+    uint64_t price;
+    uint64_t timestamp;
+    uint64_t orderId;
+    uint64_t restingQuantity;
+    uint64_t restingPrice;
+    uint64_t executedQuantity;
+};
+
+struct CheckpointLiveOrder
+{
+    int32_t securityId;
+    uint32_t side;
+    uint64_t orderId;
+    uint64_t quantity;
+    uint64_t price;
+};
+
+class OrderReportCheckpoint
+{
+private:
+    static constexpr char MAGIC[8] = { 'O', 'R', 'A', 'C', 'K', 'P', 'T', '\0' };
+    static constexpr uint32_t VERSION = 9;
+    static constexpr uint32_t NO_SKETCH_INDEX = UINT32_MAX;
+
+    static bool ReadHeader(std::string_view data, CheckpointHeader& header);
+
+public:
+    static bool Save( const std::string&           checkpointFile,
+                      const OrderReportCollection& ordRptColl,
+                      const PendingOrderBuffer&    pendingOrders,
+                      const OrderStore&            liveOrders,
+                      const uint64_t               inputOffset,
+                      const uint64_t               inputFingerprint );
+    static bool LoadInputPosition(const std::string& checkpointFile, uint64_t& inputOffset, uint64_t& inputFingerprint);
+    static bool Load( const std::string&     checkpointFile,
+                      OrderReportCollection& ordRptColl,
+                      PendingOrderBuffer&    pendingOrders,
+                      OrderStore&            liveOrders,
+                      uint64_t&              inputOffset );
+};
+
+#endif
@@ -0,0 +1,251 @@
+/** @file OrderReportCollection.h
+ *  @brief Flat collection of Order Reports keyed by Security ID
+ *
+ *  Stores every Order Report in one contiguous array, in the order the Securities were
+ *  inserted. The hot Order Report counters are kept apart from the cold Security data
+ *  (ISIN & currency), which is only needed when outputting the report. Both arrays hold
+ *  fixed size, trivially copyable entries, so nothing is allocated per Security.
+ *
+ *  Security IDs are mapped to their slot in the array through an open addressing hash index
+ *  with linear probing. Each index entry holds the Security ID next to its slot, so a lookup
+ *  normally touches one index entry and then the Order Report itself.
+ *
+ *  Collections built separately, e.g. from different input files, can be merged into one.
+ *
+ *  Sketches of the distribution of each Security's order prices & quantities can be kept as well,
+ *  for reporting quantiles. They are only allocated for Securities that have Orders, and only when
+ *  enabled, as they are about 1KB each.
+ *
+ *  The resting & executed quantity of each Security's live Orders are kept alongside, in a third array,
+ *  for when Order Deletes, Modifies & Executes are tracked.
+ *
+ *  Orders can be added one at a time, or a batch at a time, grouped by Security so each Security is
+ *  only looked up once per batch (see OrderBatch.h).
+ *
+ *  Every value that can be reported on is read through GetColumn, whichever of the arrays it is kept in.
+ *
+ *  Changes to Order Reports can be marked, so that only the Securities that changed since the
+ *  last time the changes were cleared need to be looked at again.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERREPORTCOLLECTION_H
+#define ORDERREPORTCOLLECTION_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "OrderReport.h"
+
+class OrderBatch;
+
+class OrderReportCollection
+{
+private:
+    struct IndexEntry
+    {
+        int securityId;
+        int32_t slot;
+    };
+
+    static constexpr int32_t EMPTY_SLOT = -1;
+    static constexpr uint32_t NO_SKETCHES = UINT32_MAX;
+    static constexpr size_t MIN_INDEX_SIZE = 16;
+
+    std::vector<IndexEntry> index;
+    size_t indexMask;
+    std::vector<OrderReport> orderReports;
+    std::vector<SecurityInfo> securityInfos;
+    std::vector<uint8_t> slotChanged;
+    std::vector<uint32_t> changedSlots;
+    bool sketchesEnabled;
+    std::vector<uint32_t> sketchSlots;      // Position of each slot's sketches, or NO_SKETCHES
+    std::vector<OrderSketches> sketches;
+    std::vector<OrderActivity> activities;
+
+    size_t FindIndexPos(const int securityId) const;
+    void ResizeIndex(const size_t newIndexSize);
+    size_t AddSlot(const size_t indexPos, const int securityId);
+
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    OrderReportCollection();
+    ~OrderReportCollection();
+
+    size_t Find(const int securityId) const;
+    size_t Insert(const int securityId, std::string_view isin, std::string_view currency);
+    size_t FindOrInsert(const int securityId);
+    void Merge(const OrderReportCollection& other);
+    void Reserve(const size_t numSecurities);
+    void Clear();
+    size_t Size() const;
+
+    OrderReport& GetOrderReport(const size_t slot);
+    const OrderReport& GetOrderReport(const size_t slot) const;
+    const SecurityInfo& GetSecurityInfo(const size_t slot) const;
+    void AddOrderData(const size_t slot, const OrderAddData& ordData);
+    void AddOrderBatch(OrderBatch& batch);
+    void MergeSlot(const size_t slot, const OrderReportCollection& other, const size_t otherSlot);
+
+    void EnableSketches(const bool enable);
+    bool SketchesEnabled() const;
+    const OrderSketches* GetSketches(const size_t slot) const;
+    OrderSketches& GetOrCreateSketches(const size_t slot);
+
+    OrderActivity& GetActivity(const size_t slot);
+    const OrderActivity& GetActivity(const size_t slot) const;
+
+    template <ReportColumn Column>
+    auto GetColumn(const size_t slot) const;
+
+    void MarkChanged(const size_t slot);
+    const std::vector<uint32_t>& GetChangedSlots() const;
+    void ClearChanges();
+};
+
+
+/** @brief Finds the slot of a Security
+ * 
+ *  Defined in the header so the lookup can be inlined into the per order hot path.
+ *
+ *  @param securityId - Security ID to find
+ *  @return Slot of the Security, or NOT_FOUND if the Security isn't in the collection
+ */
+inline size_t OrderReportCollection::Find(const int securityId) const
+{
+    int32_t slot = index[FindIndexPos(securityId)].slot;
+    return (slot != EMPTY_SLOT) ? static_cast<size_t>(slot) : NOT_FOUND;
+}
+
+
+/** @brief Finds the position in the index of a Security
+ * 
+ *  Uses Fibonacci hashing to spread sequential Security IDs across the index, then probes
+ *  linearly until it finds either the Security or an empty entry.
+ *
+ *  @param securityId - Security ID to find
+ *  @return Position of the Security in the index, or of the empty entry it would be inserted into
+ */
+inline size_t OrderReportCollection::FindIndexPos(const int securityId) const
+{
+    size_t indexPos = static_cast<size_t>((static_cast<uint32_t>(securityId) * 0x9E3779B97F4A7C15ULL) >> 32) & indexMask;
+
+    while (index[indexPos].slot != EMPTY_SLOT && index[indexPos].securityId != securityId)
+        indexPos = (indexPos + 1) & indexMask;
+
+    return indexPos;
+}
+
+
+/** @brief Gets the Order Report in a slot
+ * 
+ *  @param slot - Slot of the Security
+ *  @return Order Report
+ */
+inline OrderReport& OrderReportCollection::GetOrderReport(const size_t slot)
+{
+    return orderReports[slot];
+}
+
+inline const OrderReport& OrderReportCollection::GetOrderReport(const size_t slot) const
+{
+    return orderReports[slot];
+}
+
+/** @brief Adds new Order Data to the Order Report in a slot
+ * 
+ *  Also adds it to the slot's sketches, when they are enabled.
+ *
+ *  @param slot    - Slot of the Security
+ *  @param ordData - The relevant data from the Order Add record
+ *  @return void
+ */
+inline void OrderReportCollection::AddOrderData(const size_t slot, const OrderAddData& ordData)
+{
+    orderReports[slot].AddOrderData(ordData);
+    if (sketchesEnabled)
+        GetOrCreateSketches(slot).AddOrderData(ordData);
+}
+
+
+/** @brief Gets the sketches of the Orders in a slot, creating them if there are none yet
+ * 
+ *  @param slot - Slot of the Security
+ *  @return Sketches of the Security
+ */
+inline OrderSketches& OrderReportCollection::GetOrCreateSketches(const size_t slot)
+{
+    if (sketchSlots[slot] == NO_SKETCHES)
+    {
+        sketchSlots[slot] = static_cast<uint32_t>(sketches.size());
+        sketches.emplace_back();
+    }
+    return sketches[sketchSlots[slot]];
+}
+
+
+/** @brief Gets the resting & executed quantity of the live Orders in a slot
+ * 
+ *  @param slot - Slot of the Security
+ *  @return Activity of the Security
+ */
+inline OrderActivity& OrderReportCollection::GetActivity(const size_t slot)
+{
+    return activities[slot];
+}
+
+inline const OrderActivity& OrderReportCollection::GetActivity(const size_t slot) const
+{
+    return activities[slot];
+}
+
+
+/** @brief Gets the value of a Report Column of the Security in a slot
+ * 
+ *  The column is chosen at compile time, so only the array the column is kept in is read.
+ *
+ *  @param slot - Slot of the Security
+ *  @return Value of the column; text for the ISIN & Currency, otherwise a number
+ */
+template <ReportColumn Column>
+inline auto OrderReportCollection::GetColumn(const size_t slot) const
+{
+    if constexpr (Column == ReportColumn::ISIN)
+        return securityInfos[slot].ISIN.View();
+    else if constexpr (Column == ReportColumn::Currency)
+        return securityInfos[slot].currency.View();
+    else if constexpr (Column >= ReportColumn::BuyPriceP50 && Column <= ReportColumn::SellQuantityP99)
+        return OrderSketches::GetColumn<Column>(GetSketches(slot));
+    else if constexpr (Column == ReportColumn::RestingBuyQuantity)
+        return activities[slot].restingBuyQuantity;
+    else if constexpr (Column == ReportColumn::RestingSellQuantity)
+        return activities[slot].restingSellQuantity;
+    else if constexpr (Column == ReportColumn::ExecutedBuyQuantity)
+        return activities[slot].executedBuyQuantity;
+    else if constexpr (Column == ReportColumn::ExecutedSellQuantity)
+        return activities[slot].executedSellQuantity;
+    else
+        return orderReports[slot].GetColumn<Column>();
+}
+
+
+/** @brief Marks the Order Report in a slot as changed
+ * 
+ *  Each slot is only recorded once until the changes are cleared.
+ *
+ *  @param slot - Slot of the Security
+ *  @return void
+ */
+inline void OrderReportCollection::MarkChanged(const size_t slot)
+{
+    if (slotChanged[slot] == 0)
+    {
+        slotChanged[slot] = 1;
+        changedSlots.push_back(static_cast<uint32_t>(slot));
+    }
+}
+
+#endif
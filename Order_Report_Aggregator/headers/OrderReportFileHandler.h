@@ -3,14 +3,60 @@
  *
  *  This contains the data and functions needed to produce an Order Report on a collection of Securities.
  *  
- *  It will read the input file one line at a time and search for the strings "msgType_":8" & "msgType_":12".
+ *  It will read the input file one line at a time and find the message type of each line. Each line is then passed
+ *  to the handler registered for its message type, if there is one. "msgType_":8 & "msgType_":12 are always handled.
  *
- *  It creates an Order Report object and inserts it into the map for Message Type 8. For Message Type 12 it will
- *  search the map, and if it finds a Security ID that matches then it will update the related Order Report object.
+ *  It creates an Order Report object and inserts it into the collection for Message Type 8. For Message Type 12 it will
+ *  search the collection, and if it finds a Security ID that matches then it will update the related Order Report object.
+ *  If the Security hasn't been referenced yet the order is held in the Pending Order Buffer, and replayed into the
+ *  Security's Order Report once its Security Reference Data arrives. Anything still pending at the end can be reported.
  * 
- *  When outputing the Order Report File it will loop through every Order Report object in the Order Report map,
+ *  The input file can also be read in parallel. It is split into chunks at line boundaries and each chunk is read
+ *  on a thread pool into its own partial Order Reports, which are merged into the Order Report collection at the end.
+ *  Each chunk also keeps where its Order Adds & Security Reference Data are. When the chunks are merged, in order, the
+ *  Orders of a Security that had Orders pending in a serial read are applied one by one, through the Pending Order Buffer,
+ *  so a parallel read gives the same reports and unresolved Orders as a serial read. The chunks can be submitted to a
+ *  thread pool shared with other files, with the merge done by whichever thread reads the last chunk.
+ * 
+ *  When following a growing input file, a snapshot of the Order Report File is written every so often. Each Security's
+ *  row is kept formatted between snapshots and only the rows of Securities that changed are formatted again, so the
+ *  cost of a snapshot depends on how much activity there has been rather than on how many Securities there are.
+ * 
+ *  A binary checkpoint of the Order Report collection, and how far through the input file it covers, can be saved
+ *  every so often while reading. After a restart the checkpoint is restored and reading carries on from that point.
+ * 
+ *  A copy of the Order Report collection can also be published every so often while reading, as a Report Snapshot
+ *  that other threads, such as the query server, read without taking a lock.
+ * 
+ *  The Securities can also be split into partitions by their Security ID, with each process of a sharded aggregation
+ *  reading the whole input file but only aggregating the Securities in its own partition. The Order Reports of every
+ *  partition are then merged back together, in the order a single process would have referenced the Securities in,
+ *  so the reports are the same as if the input file had been read by one process.
+ * 
+ *  Lines are counted in the Pipeline Stats by message type, along with Order Adds dropped because their Security is
+ *  unknown, and each stage of reading & writing is timed.
+ * 
+ *  When outputing the Order Report File it will loop through every Order Report object in the Order Report collection,
  *  outputting the required data in the specified format.
  *
+ *  Several reports can be written in a single pass by registering a Report Sink for each of them. Each Security is
+ *  formatted at most once per Report Format and the row is then written to every Report Sink whose filter accepts the
+ *  Security. Each Report Sink can report its own subset of the columns by giving the Report Format of a Report Schema.
+ *
+ *  Rollups of the Securities, e.g. totals per currency or per ISIN country, can be written in the same pass too. The group
+ *  of each Security is resolved as its Security Reference Data is read, and the groups' totals are built from the Order
+ *  Reports when the reports are written.
+ *
+ *  An interval report, of each Security's volume & VWAP per time interval, can be written in the same pass as the input
+ *  file is read. It needs the timestamp of every Order Add, so an input file is always read serially while it's open.
+ *
+ *  Live Orders can also be tracked, from the Order Delete ("msgType_":13), Order Modify ("msgType_":14) & Order Execute
+ *  ("msgType_":15) records, so that the resting & executed quantity of each Security can be reported as well as the
+ *  totals. Each Order Add is then kept in the Order Store until it's deleted or fully executed. The updates to an Order
+ *  have to be applied after its Order Add, so an input file is always read serially while Orders are tracked.
+ *  Updates to an Order whose Order Add is still in the Pending Order Buffer are applied to the pending order, and
+ *  replayed with it.
+ *
  *  @author Sean Griffin
  *  @bug No known bugs.
  */
@@ -18,28 +64,120 @@
 #ifndef ORDERREPORTFILEHANDLER_H
 #define ORDERREPORTFILEHANDLER_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <ostream>
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "InputFileHandler.h"
+#include "IntervalReport.h"
+#include "MappedFile.h"
 #include "OutputFileHandler.h"
-#include "OrderReport.h"
+#include "OrderReportCollection.h"
+#include "OrderReportShard.h"
+#include "OrderMessageParser.h"
+#include "OrderStore.h"
+#include "PendingOrderBuffer.h"
+#include "ReportSchema.h"
+#include "ReportSnapshot.h"
+#include "RollupReport.h"
 
-typedef std::unordered_map<int, OrderReport> OrderReportCollection;
+// Order Add read from a chunk of the input file
+//
+struct ChunkOrderAdd
+{
+    uint64_t offset;            // Offset of the line in the input file
+    uint32_t slot;              // Slot of the Security in the partial
+};
+
+struct OrderReportPartial
+{
+    OrderReportCollection orders;
+    std::vector<uint64_t> firstOrderAdds;           // Offset of the Order Add that gave each Security its slot, by slot.
+                                                    // UINT64_MAX if its Security Reference Data did.
+    std::vector<uint64_t> firstReferences;          // Offset that first referenced each Security in the chunk, by slot
+    std::vector<ChunkOrderAdd> orderAdds;
+    std::vector<SecurityRefData> securityRefs;
+    std::vector<uint64_t> securityRefOffsets;       // Offset of each Security Reference Data record
+};
+
+class ThreadPool;
+
+struct ReportSink
+{
+    std::string outputFile;
+    char delimiter;
+    std::function<bool(const OrderReport&)> filter;  // Securities to report on. Empty to report on every Security.
+    const ReportFormat* format = nullptr;            // Columns to report. nullptr for every column (OrderReportSchema).
+};
 
 class OrderReportFileHandler : public InputFileHandler, public OutputFileHandler
 {
 private:
-    const std::string MSG_TYPE_SECURITY_REF = "msgType_\":8";
-    const std::string MSG_TYPE_ORDER_ADD = "msgType_\":12";
+    typedef void (OrderReportFileHandler::*MessageHandler)(std::string_view inputLine);
+
+    // State shared by the tasks reading the chunks of the input file
+    //
+    struct ChunkedRead
+    {
+        MappedFile mappedFile;
+        std::vector<std::string_view> chunks;
+        std::vector<OrderReportPartial> partials;
+        std::atomic<size_t> chunksLeft;
+        bool timing;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static constexpr int MSG_TYPE_SECURITY_REF = 8;
+    static constexpr int MSG_TYPE_ORDER_ADD = 12;
+    static constexpr int MSG_TYPE_ORDER_DELETE = 13;
+    static constexpr int MSG_TYPE_ORDER_MODIFY = 14;
+    static constexpr int MSG_TYPE_ORDER_EXECUTE = 15;
+    static constexpr int MAX_MSG_TYPE = 63;
+
+    std::array<MessageHandler, MAX_MSG_TYPE + 1> messageHandlers;
     std::shared_ptr<OrderReportCollection> ordRptColl;
+    PendingOrderBuffer pendingOrders;
+    OrderStore liveOrders;
+    bool trackOrders;
+    IntervalReport intervalReport;
     char outputFileDelimiter;
     bool reportEmptyOrders;
+    const ReportFormat* reportFormat;
+    std::vector<std::string> formattedRows;
+    std::vector<ReportSink> reportSinks;
+    std::vector<RollupReport> rollups;
+    std::string checkpointFile;
+    size_t checkpointLines;
+    size_t linesSinceCheckpoint;
+    SnapshotPublisher* snapshotPublisher;
+    size_t publishLines;
+    size_t linesSincePublish;
+    size_t partition;
+    size_t numPartitions;                   // 0 when the Securities aren't partitioned
+    uint64_t linesRead;
+    std::vector<uint64_t> referenceLines;   // Line that first referenced each Security, when partitioned
+
+    void SetMessageHandler(const int msgType, MessageHandler handler);
+    bool InPartition(std::string_view inputLine) const;
+    void FindAndUpdateOrderReport(std::string_view inputLine);
+    void CreateOrderReport(std::string_view inputLine);
+    void InsertOrderReport(const SecurityRefData& refData);
+    void AddLiveOrder(const size_t slot, const OrderAddData& ordData);
+    void ReplayLiveOrder(const size_t slot, const OrderAddData& ordData, const PendingOrderState& state);
+    void DeleteLiveOrder(std::string_view inputLine);
+    void ModifyLiveOrder(std::string_view inputLine);
+    void ExecuteLiveOrder(std::string_view inputLine);
+    void ReadInputChunk(std::string_view inputChunk, std::string_view fileData, OrderReportPartial& partial) const;
+    void MergeInputChunks(std::string_view fileData, const std::vector<OrderReportPartial>& partials);
+    void OnInputSnapshot() override;
+    void WriteOutputData(OutputBuffer& outBuffer) const override;
 
-    void ReadInputData(const std::string& inputLine) override;
-    void FindAndUpdateOrderReport(const std::string& inputLine);
-    void CreateOrderReport(const std::string& inputLine);
-    void WriteOutputData(std::ofstream& outStream) const override;
+protected:
+    void ReadInputData(std::string_view inputLine) override;
 
 public:
     OrderReportFileHandler( const std::string& inputFile_,
@@ -50,6 +188,31 @@ public:
     ~OrderReportFileHandler();
     void SetOutputFileDelimiter(const char delim);
     void SetReportEmptyOrders(const bool rptEmptyOrds);
+    void SetReportFormat(const ReportFormat* format);
+    void SetPendingOrderLimit(const size_t memoryLimit);
+    const PendingOrderBuffer& GetPendingOrders() const;
+    void ReportUnresolvedOrders(std::ostream& output) const;
+    void SetOrderTracking(const bool enable);
+    bool OrderTrackingEnabled() const;
+    const OrderStore& GetLiveOrders() const;
+    bool OpenIntervalReport(const std::string& intervalFile, const std::chrono::nanoseconds interval);
+    void CloseIntervalReport();
+    const IntervalReport& GetIntervalReport() const;
+    void ReadInputFileParallel(const size_t numThreads);
+    void SubmitInputFile(ThreadPool& threadPool, const size_t numChunks, std::function<void()> onRead);
+    void WriteOutputSnapshot();
+    void AddReportSink(const ReportSink& sink);
+    void ClearReportSinks();
+    void AddRollup(const RollupReport& rollup);
+    void WriteReportSinks();
+    void SetCheckpoint(const std::string& checkpointFile_, const size_t checkpointLines_);
+    bool SaveCheckpoint() const;
+    bool RestoreCheckpoint();
+    void SetSnapshotPublisher(SnapshotPublisher* publisher, const size_t publishLines_);
+    void PublishSnapshot();
+    void SetPartition(const size_t partition_, const size_t numPartitions_);
+    bool WriteShardPartial(OutputBuffer& outBuffer) const;
+    void MergeShardPartials(const std::vector<ShardPartial>& partials);
 };
 
 #endif
\ No newline at end of file
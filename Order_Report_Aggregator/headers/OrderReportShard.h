@@ -0,0 +1,104 @@
+/** @file OrderReportShard.h
+ *  @brief Writes and reads the partial Order Reports of one shard of a sharded aggregation
+ *
+ *  In a sharded aggregation the Security IDs are split into partitions by their hash, and each
+ *  shard only aggregates the Securities in its own partition. Every Order Add for a Security goes
+ *  to the same shard, so each Security's Order Report is exactly what a single process would have
+ *  made. Each shard sends its Order Reports to a coordinator as a Shard Partial, and the coordinator
+ *  merges the Shard Partials of every shard into the final reports.
+ *
+ *  Along with each Order Report a Shard Partial holds the line of the input file that first
+ *  referenced the Security, so the coordinator can put the Securities of every shard back into the
+ *  order a single process would have had them in. The Orders still pending, and the number dropped,
+ *  are kept too so unresolved Orders are reported the same way.
+ *
+ *  A Shard Partial is laid out much like a checkpoint, as the structs are held in memory:
+ *    ShardPartialHeader | OrderReport[numSecurities] | SecurityInfo[numSecurities] | uint64_t referenceLine[numSecurities] |
+ *    OrderActivity[numActivities] | CheckpointPendingOrder[numPendingOrders] |
+ *    uint32_t sketchIndex[numSecurities] | OrderSketches[numSketches]
+ *  Activity is only kept when live Orders are tracked, so numActivities is either numSecurities or 0.
+ *  The sketch indexes and sketches are left out when there are no sketches. A Shard Partial is written
+ *  front to back in a single pass, so it can be streamed down a pipe as well as written to a file.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERREPORTSHARD_H
+#define ORDERREPORTSHARD_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "OrderReportCheckpoint.h"
+#include "OrderReportCollection.h"
+#include "OutputBuffer.h"
+#include "PendingOrderBuffer.h"
+
+struct alignas(64) ShardPartialHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t orderReportSize;
+    uint32_t securityInfoSize;
+    uint32_t orderSketchesSize;
+    uint32_t orderActivitySize;
+    uint32_t shard;
+    uint32_t numShards;
+    uint32_t ordersTracked;     // 1 if live Orders were tracked, so the pending orders have Order IDs & states
+    uint64_t numSecurities;
+    uint64_t numActivities;
+    uint64_t numPendingOrders;
+    uint64_t numDroppedOrders;
+    uint64_t numSketches;
+};
+
+struct ShardPartial
+{
+    uint32_t shard = 0;
+    uint32_t numShards = 0;
+    OrderReportCollection orders;
+    std::vector<uint64_t> referenceLines;   // Line of the input file that first referenced each Security
+    PendingOrderBuffer pendingOrders;
+};
+
+class OrderReportShard
+{
+private:
+    static constexpr char MAGIC[8] = { 'O', 'R', 'A', 'S', 'H', 'R', 'D', '\0' };
+    static constexpr uint32_t VERSION = 4;
+    static constexpr uint32_t NO_SKETCH_INDEX = UINT32_MAX;
+
+public:
+    static size_t ShardOf(const int securityId, const size_t numShards);
+    static bool Write( OutputBuffer&                outBuffer,
+                       const size_t                 shard,
+                       const size_t                 numShards,
+                       const OrderReportCollection& ordRptColl,
+                       const std::vector<uint64_t>& referenceLines,
+                       const PendingOrderBuffer&    pendingOrders,
+                       const bool                   writeActivity );
+    static bool Read(std::string_view data, ShardPartial& partial);
+    static bool ReadFile(const std::string& partialFile, ShardPartial& partial);
+    static bool IsComplete(const std::vector<ShardPartial>& partials);
+};
+
+
+/** @brief Finds the shard a Security belongs to
+ *
+ *  Hashes the Security ID with a different multiplier to the Order Report collection's index, so the
+ *  Securities of one shard still spread evenly across its index, then maps the hash onto the shards
+ *  with a multiply rather than a divide. Defined in the header as it's called for every Order Add.
+ *
+ *  @param securityId - Security ID
+ *  @param numShards  - Number of shards
+ *  @return Shard of the Security, from 0 to numShards - 1
+ */
+inline size_t OrderReportShard::ShardOf(const int securityId, const size_t numShards)
+{
+    uint64_t hash = (static_cast<uint32_t>(securityId) * 0xC2B2AE3D27D4EB4FULL) >> 32;
+    return static_cast<size_t>((hash * numShards) >> 32);
+}
+
+#endif
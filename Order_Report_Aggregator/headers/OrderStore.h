@@ -0,0 +1,168 @@
+/** @file OrderStore.h
+ *  @brief State of every live Order, keyed by Order ID
+ *
+ *  Order Deletes, Modifies & Executes only carry the Order ID, so the Security, side, price and
+ *  remaining quantity of every Order still resting on the book are kept here from its Order Add
+ *  until it's deleted or fully executed.
+ *
+ *  Orders are fixed size entries in a pool made of equal sized blocks. A block is never moved or
+ *  freed once allocated, and the entries of removed Orders go on a free list and are reused, so
+ *  tens of millions of live Orders cost a few large allocations rather than one each, and the
+ *  pool only grows to the largest number of Orders live at once.
+ *
+ *  Order IDs are mapped to their entry through an open addressing hash index with linear probing.
+ *  Each index entry holds the position of the Order's entry next to the top 32 bits of its Order
+ *  ID's hash, 8 bytes in all, so probing only reads the index and the pool is only touched once
+ *  the hash matches. That keeps an index three quarters full as cheap to search as a sparser one,
+ *  and lets the index be rebuilt, or entries shifted, without reading the pool at all. Removed
+ *  Orders are taken out of the index by shifting the entries after them back, so the index never
+ *  fills up with tombstones.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ORDERSTORE_H
+#define ORDERSTORE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "OrderReport.h"
+
+struct LiveOrder
+{
+    uint64_t orderId;
+    uint64_t quantity;      // Remaining quantity
+    uint64_t price;
+    uint32_t slot;          // Slot of the Security in the Order Report collection. The next free entry once removed.
+    Side side;
+};
+
+class OrderStore
+{
+private:
+    struct IndexEntry
+    {
+        uint32_t entry;
+        uint32_t hash;      // Top 32 bits of the Order ID's hash
+    };
+
+    static constexpr uint32_t EMPTY_ENTRY = UINT32_MAX;
+    static constexpr size_t BLOCK_BITS = 16;
+    static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_BITS;
+    static constexpr size_t MIN_INDEX_SIZE = 1024;
+
+    std::vector<std::unique_ptr<LiveOrder[]>> blocks;
+    uint32_t numEntries;        // Entries handed out from the blocks so far
+    uint32_t freeHead;
+    std::vector<IndexEntry> index;
+    size_t indexMask;
+    size_t numOrders;
+
+    LiveOrder& Entry(const uint32_t entry);
+    const LiveOrder& Entry(const uint32_t entry) const;
+    static uint32_t Hash(const uint64_t orderId);
+    size_t FindIndexPos(const uint64_t orderId, const uint32_t hash) const;
+    uint32_t AllocateEntry();
+    void ResizeIndex(const size_t newIndexSize);
+
+public:
+    OrderStore();
+    ~OrderStore();
+    OrderStore(const OrderStore&) = delete;
+    OrderStore& operator=(const OrderStore&) = delete;
+
+    LiveOrder* Find(const uint64_t orderId);
+    LiveOrder& Insert(const uint64_t orderId);
+    void Remove(const uint64_t orderId);
+    void Clear();
+
+    size_t Size() const;
+    size_t GetMemoryUsed() const;
+
+    template <typename OrderFunc>
+    void ForEachOrder(OrderFunc&& orderFunc) const;
+};
+
+
+/** @brief Gets an entry of the pool
+ *
+ *  @param entry - Position of the entry
+ *  @return The entry
+ */
+inline LiveOrder& OrderStore::Entry(const uint32_t entry)
+{
+    return blocks[entry >> BLOCK_BITS][entry & (BLOCK_SIZE - 1)];
+}
+
+inline const LiveOrder& OrderStore::Entry(const uint32_t entry) const
+{
+    return blocks[entry >> BLOCK_BITS][entry & (BLOCK_SIZE - 1)];
+}
+
+
+/** @brief Hashes an Order ID
+ *
+ *  Uses Fibonacci hashing, so sequential Order IDs are spread across the index. The low bits of
+ *  the hash are the position the Order's search starts from.
+ *
+ *  @param orderId - Order ID
+ *  @return Top 32 bits of the hash
+ */
+inline uint32_t OrderStore::Hash(const uint64_t orderId)
+{
+    return static_cast<uint32_t>((orderId * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+
+/** @brief Finds the position in the index of an Order
+ *
+ *  @param orderId - Order ID to find
+ *  @param hash    - Hash of the Order ID
+ *  @return Position of the Order in the index, or of the empty entry it would be inserted into
+ */
+inline size_t OrderStore::FindIndexPos(const uint64_t orderId, const uint32_t hash) const
+{
+    size_t indexPos = hash & indexMask;
+
+    while (index[indexPos].entry != EMPTY_ENTRY && (index[indexPos].hash != hash || Entry(index[indexPos].entry).orderId != orderId))
+        indexPos = (indexPos + 1) & indexMask;
+
+    return indexPos;
+}
+
+
+/** @brief Finds a live Order
+ *
+ *  Defined in the header so the lookup can be inlined into the per message hot path.
+ *  The Order stays where it is until it's removed, so the pointer can be held on to until then.
+ *
+ *  @param orderId - Order ID to find
+ *  @return The Order, or nullptr if there is no live Order with that ID
+ */
+inline LiveOrder* OrderStore::Find(const uint64_t orderId)
+{
+    uint32_t entry = index[FindIndexPos(orderId, Hash(orderId))].entry;
+    return (entry != EMPTY_ENTRY) ? &Entry(entry) : nullptr;
+}
+
+
+/** @brief Calls orderFunc for every live Order
+ *
+ *  The Orders are passed in no particular order.
+ *
+ *  @param orderFunc - Function to call with each live Order
+ *  @return void
+ */
+template <typename OrderFunc>
+void OrderStore::ForEachOrder(OrderFunc&& orderFunc) const
+{
+    for (const IndexEntry& indexEntry : index)
+    {
+        if (indexEntry.entry != EMPTY_ENTRY)
+            orderFunc(Entry(indexEntry.entry));
+    }
+}
+
+#endif
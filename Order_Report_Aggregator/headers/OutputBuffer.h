@@ -0,0 +1,117 @@
+/** @file OutputBuffer.h
+ *  @brief Buffered writer for output files
+ *
+ *  Collects text in a large reusable buffer and writes it to the output file in big
+ *  blocks, rather than going through a std::ofstream for every value. Numbers are
+ *  converted straight into the buffer with std::to_chars, which avoids the locale and
+ *  virtual stream buffer calls made by operator<< on every field.
+ *
+ *  Text that is already formatted elsewhere can be written without copying it into
+ *  the buffer at all, in a single writev call.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <charconv>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class OutputBuffer
+{
+private:
+    static constexpr size_t MAX_NUMBER_LENGTH = 20;
+
+    int fileDescriptor;
+    std::FILE* file;
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t used;
+
+    void WriteToFile(const char* data, size_t length);
+
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    OutputBuffer(const size_t capacity_ = DEFAULT_CAPACITY);
+    ~OutputBuffer();
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    bool Open(const std::string& fileName);
+    bool Attach(const int fileDescriptor_);
+    bool IsOpen() const;
+    void Close();
+    void Flush();
+    bool Sync();
+
+    void Append(std::string_view text);
+    void Append(const char character);
+    template <typename T>
+    void AppendNumber(const T number);
+    void AppendAll(const std::vector<std::string>& texts);
+};
+
+
+/** @brief Appends text to the buffer
+ * 
+ *  Text larger than the buffer is written straight to the file.
+ *
+ *  @param text - Text to append
+ *  @return void
+ */
+inline void OutputBuffer::Append(std::string_view text)
+{
+    if (used + text.size() > capacity)
+    {
+        Flush();
+        if (text.size() > capacity)
+        {
+            WriteToFile(text.data(), text.size());
+            return;
+        }
+    }
+
+    std::char_traits<char>::copy(buffer.get() + used, text.data(), text.size());
+    used += text.size();
+}
+
+
+/** @brief Appends a single character to the buffer
+ * 
+ *  @param character - Character to append
+ *  @return void
+ */
+inline void OutputBuffer::Append(const char character)
+{
+    if (used == capacity)
+        Flush();
+
+    buffer[used++] = character;
+}
+
+
+/** @brief Appends a number to the buffer as text
+ * 
+ *  Formats the number exactly as operator<< would in the default "C" locale.
+ *
+ *  @param number - Integer to append
+ *  @return void
+ */
+template <typename T>
+inline void OutputBuffer::AppendNumber(const T number)
+{
+    if (used + MAX_NUMBER_LENGTH > capacity)
+        Flush();
+
+    char* start = buffer.get() + used;
+    used += std::to_chars(start, start + MAX_NUMBER_LENGTH, number).ptr - start;
+}
+
+#endif
@@ -1,8 +1,8 @@
 /** @file OutputFileHandler.h
  *  @brief Base class to handle writing to output files
  *
- *  Base class for writing to an output file. Will create a stream to the output file
- *  before passing the stream to the virtual function WriteOutputData. This function 
+ *  Base class for writing to an output file. Will create an Output Buffer for the output file
+ *  before passing the buffer to the virtual function WriteOutputData. This function 
  *  should be overridden in the derived class to write the actual data that will go
  *  into the file.
  *
@@ -13,15 +13,15 @@
 #ifndef OUTPUTFILEHANDLER_H
 #define OUTPUTFILEHANDLER_H
 
-#include <fstream>
 #include <string>
+#include "OutputBuffer.h"
 
 class OutputFileHandler
 {
 protected:
     std::string outputFile;
     
-    virtual void WriteOutputData(std::ofstream &outStream) const = 0;
+    virtual void WriteOutputData(OutputBuffer& outBuffer) const = 0;
 
 public:
     OutputFileHandler(const std::string& outputFile_);
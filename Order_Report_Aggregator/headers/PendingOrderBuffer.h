@@ -0,0 +1,228 @@
+/** @file PendingOrderBuffer.h
+ *  @brief Holds Order Adds for Securities that haven't been referenced yet
+ *
+ *  An Order Add can appear in the input file before the Security Reference Data for its Security.
+ *  Rather than discarding it, the order is held here until the Security is referenced, and is then
+ *  replayed into the Security's new Order Report. This lets an out of order input file be read
+ *  correctly in a single pass.
+ *
+ *  Orders are stored as packed entries in a single arena, chained together per Security in the
+ *  order they arrived. Entries freed by a replay are reused, so the arena only grows to the largest
+ *  number of orders pending at once. A memory limit caps how big the buffer can get; orders that
+ *  would take it over the limit are dropped and counted.
+ *
+ *  When live Orders are tracked, the pending orders are also indexed by Order ID, so that an Order
+ *  Delete, Modify or Execute read while its Order Add is still pending is applied to the pending
+ *  order. Its resting & executed quantity are then replayed along with it. A pending order that is
+ *  deleted or fully executed leaves the index, so later updates of it are unknown, as they would be
+ *  for a live Order.
+ *
+ *  An entry only holds what every pending order needs. The Order ID & state of each entry, and its
+ *  timestamp, are kept in side arrays that are only filled while they are needed, i.e. while the
+ *  orders are indexed and while timestamps are kept for the interval report.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef PENDINGORDERBUFFER_H
+#define PENDINGORDERBUFFER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "OrderReport.h"
+
+// What is left of a pending order, once the Order Deletes, Modifies & Executes read while it was pending are applied
+//
+struct PendingOrderState
+{
+    uint64_t restingQuantity;   // 0 once it's deleted or fully executed
+    uint64_t restingPrice;
+    uint64_t executedQuantity;
+};
+
+class PendingOrderBuffer
+{
+private:
+    static constexpr int32_t END_OF_CHAIN = -1;
+
+    struct PendingOrder
+    {
+        size_t quantity;
+        size_t price;
+        int32_t next;
+        Side side;
+    };
+
+    // Order ID & state of an entry, kept beside it while the orders are indexed
+    //
+    struct TrackedOrder
+    {
+        uint64_t orderId;
+        PendingOrderState state;
+    };
+
+    struct PendingChain
+    {
+        int32_t head;
+        int32_t tail;
+        size_t numOrders;
+    };
+
+    // Rough cost of a chain in the hash map, on top of the chain itself
+    //
+    static constexpr size_t CHAIN_OVERHEAD = sizeof(PendingChain) + 4 * sizeof(void*);
+
+    // Rough cost of an order in the Order ID index
+    //
+    static constexpr size_t ORDER_INDEX_OVERHEAD = sizeof(uint64_t) + sizeof(int32_t) + 4 * sizeof(void*);
+
+    std::vector<PendingOrder> arena;
+    int32_t freeHead;
+    std::unordered_map<int, PendingChain> chains;
+    bool indexOrders;
+    std::vector<TrackedOrder> trackedOrders;                // One per entry, when indexed
+    std::unordered_map<uint64_t, int32_t> orderEntries;     // Entry of each resting pending order by Order ID, when indexed
+    bool keepTimestamps;
+    std::vector<uint64_t> timestamps;                       // One per entry, when kept
+    size_t numOrders;
+    size_t numDropped;
+    size_t memoryLimit;
+
+    size_t GetEntrySize() const;
+    OrderAddData GetOrderData(const int32_t entry) const;
+    PendingOrderState GetState(const int32_t entry) const;
+
+public:
+    PendingOrderBuffer();
+    ~PendingOrderBuffer();
+
+    void SetMemoryLimit(const size_t memoryLimit_);
+    size_t GetMemoryLimit() const;
+    size_t GetMemoryUsed() const;
+
+    void SetOrderIndex(const bool enable);
+    void SetTimestamps(const bool enable);
+    bool Add(const int securityId, const OrderAddData& ordData);
+    bool Add(const int securityId, const OrderAddData& ordData, const PendingOrderState& state);
+    PendingOrderState* FindOrder(const uint64_t orderId);
+    bool DeleteOrder(const uint64_t orderId);
+    template <typename OrderFunc>
+    size_t Replay(const int securityId, OrderFunc&& orderFunc);
+    void Clear();
+
+    bool Empty() const;
+    size_t Size() const;
+    size_t GetNumDropped() const;
+    void CountDropped(const size_t numOrders_);
+    std::vector<std::pair<int, size_t>> GetUnresolved() const;
+
+    template <typename OrderFunc>
+    void ForEachOrder(OrderFunc&& orderFunc) const;
+};
+
+
+/** @brief Checks whether any orders are pending
+ * 
+ *  Defined in the header so that the check on every new Security can be inlined.
+ *
+ *  @return true if no orders are pending
+ */
+inline bool PendingOrderBuffer::Empty() const
+{
+    return numOrders == 0;
+}
+
+
+/** @brief Gets the Order Data of an entry
+ * 
+ *  The Order ID & timestamp are 0 if they aren't kept.
+ *
+ *  @param entry - Entry in the arena
+ *  @return Order Data, as it was added
+ */
+inline OrderAddData PendingOrderBuffer::GetOrderData(const int32_t entry) const
+{
+    const PendingOrder& order = arena[entry];
+    return OrderAddData{ order.side,
+                         order.quantity,
+                         order.price,
+                         keepTimestamps ? timestamps[entry] : 0,
+                         indexOrders ? trackedOrders[entry].orderId : 0 };
+}
+
+
+/** @brief Gets the Pending Order State of an entry
+ * 
+ *  An order that isn't indexed can't have been updated, so all of it is still resting.
+ *
+ *  @param entry - Entry in the arena
+ *  @return What is left of the order
+ */
+inline PendingOrderState PendingOrderBuffer::GetState(const int32_t entry) const
+{
+    if (indexOrders)
+        return trackedOrders[entry].state;
+    return PendingOrderState{ arena[entry].quantity, arena[entry].price, 0 };
+}
+
+
+/** @brief Replays the pending orders of a Security
+ * 
+ *  The orders are passed to orderFunc in the order they arrived, and are then no longer pending.
+ *  Defined in the header so that orderFunc can be inlined.
+ *
+ *  @param securityId - Security ID
+ *  @param orderFunc  - Function to call with the Order Data & Pending Order State of each pending order
+ *  @return Number of orders replayed
+ */
+template <typename OrderFunc>
+size_t PendingOrderBuffer::Replay(const int securityId, OrderFunc&& orderFunc)
+{
+    auto chainIt = chains.find(securityId);
+    if (chainIt == chains.end())
+        return 0;
+
+    const PendingChain chain = chainIt->second;
+    for (int32_t entry = chain.head; entry != END_OF_CHAIN; entry = arena[entry].next)
+    {
+        if (indexOrders)
+        {
+            auto orderIt = orderEntries.find(trackedOrders[entry].orderId);
+            if (orderIt != orderEntries.end() && orderIt->second == entry)
+                orderEntries.erase(orderIt);
+        }
+        orderFunc(GetOrderData(entry), GetState(entry));
+    }
+
+    // The whole chain goes back on the free list in one go
+    //
+    arena[chain.tail].next = freeHead;
+    freeHead = chain.head;
+
+    numOrders -= chain.numOrders;
+    chains.erase(chainIt);
+    return chain.numOrders;
+}
+
+
+/** @brief Calls orderFunc for every pending order
+ * 
+ *  The orders of each Security are passed in the order they arrived.
+ *
+ *  @param orderFunc - Function to call with the Security ID, Order Data & Pending Order State of each pending order
+ *  @return void
+ */
+template <typename OrderFunc>
+void PendingOrderBuffer::ForEachOrder(OrderFunc&& orderFunc) const
+{
+    for (const auto& chain : chains)
+    {
+        for (int32_t entry = chain.second.head; entry != END_OF_CHAIN; entry = arena[entry].next)
+            orderFunc(chain.first, GetOrderData(entry), GetState(entry));
+    }
+}
+
+#endif
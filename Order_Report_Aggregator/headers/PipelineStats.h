@@ -0,0 +1,240 @@
+/** @file PipelineStats.h
+ *  @brief Counters, timers & latency histograms for the ingestion pipeline
+ *
+ *  Records how many lines were read, what they were classified as, how many orders were dropped
+ *  and how long each stage of the pipeline took, so it can be seen where the time goes.
+ *
+ *  Every thread records into its own block of stats, so the hot path never shares a cache line
+ *  with another thread or takes a lock. The blocks are only added together when the stats are
+ *  written out as JSON.
+ *
+ *  Stats are off by default. While they are off every call returns after a single check of the
+ *  enabled flag, so they can be left in the hot path. Latency histograms are enabled separately,
+ *  as timing every line costs a clock read per line.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef PIPELINESTATS_H
+#define PIPELINESTATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class StatCounter
+{
+    LinesRead,
+    BytesRead,
+    SecurityRefs,
+    OrderAdds,
+    IgnoredLines,
+    UnknownSecurityOrders,
+    PendingOrders,
+    ReplayedOrders,
+    LateIntervalOrders,
+    OrderDeletes,
+    OrderModifies,
+    OrderExecutes,
+    UnknownOrderUpdates,
+    ParseErrors,
+    RowsWritten,
+    QueriesServed,
+    Count
+};
+
+enum class StatTimer
+{
+    ReadInput,
+    Decompress,
+    ReadChunk,
+    MergeChunks,
+    MergeFiles,
+    WriteOutput,
+    Snapshot,
+    Checkpoint,
+    Publish,
+    Query,
+    ReadShards,
+    MergeShards,
+    Count
+};
+
+enum class StatHistogram
+{
+    LineLatency,
+    SnapshotLatency,
+    QueryLatency,
+    Count
+};
+
+class PipelineStats
+{
+private:
+    static constexpr size_t NUM_COUNTERS = static_cast<size_t>(StatCounter::Count);
+    static constexpr size_t NUM_TIMERS = static_cast<size_t>(StatTimer::Count);
+    static constexpr size_t NUM_HISTOGRAMS = static_cast<size_t>(StatHistogram::Count);
+    static constexpr size_t NUM_HISTOGRAM_BUCKETS = 64;   // Bucket n holds latencies below 2^n ns
+
+    // Only the owning thread writes to its stats, so the atomics are just there to let
+    // another thread read them while they are being updated; no read-modify-write is needed.
+    //
+    struct TimerStats
+    {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint64_t> maxNs;
+    };
+
+    struct alignas(64) ThreadStats
+    {
+        std::array<std::atomic<uint64_t>, NUM_COUNTERS> counters;
+        std::array<TimerStats, NUM_TIMERS> timers;
+        std::array<std::array<std::atomic<uint64_t>, NUM_HISTOGRAM_BUCKETS>, NUM_HISTOGRAMS> histograms;
+    };
+
+    static std::atomic<bool> enabled;
+    static std::atomic<bool> histogramsEnabled;
+    static std::chrono::steady_clock::time_point startTime;
+    static std::mutex threadStatsMutex;
+    static std::vector<ThreadStats*> allThreadStats;
+
+    static ThreadStats& GetThreadStats();
+    static void AddToCounter(const StatCounter counter, const uint64_t amount);
+    static void AddToTimer(const StatTimer timer, const uint64_t elapsedNs);
+    static void AddToHistogram(const StatHistogram histogram, const uint64_t latencyNs);
+
+public:
+    static void Enable(const bool enable, const bool enableHistograms = false);
+    static bool IsEnabled();
+    static bool HistogramsEnabled();
+
+    static void Count(const StatCounter counter, const uint64_t amount = 1);
+    static void RecordTime(const StatTimer timer, const uint64_t elapsedNs);
+    static void RecordLatency(const StatHistogram histogram, const uint64_t latencyNs);
+
+    static void WriteJson(std::ostream& output);
+    static bool WriteJsonFile(const std::string& statsFile);
+    static void WriteJsonOnSignal(const std::string& statsFile, const int signalNumber);
+};
+
+/** @brief Times a stage of the pipeline from construction to destruction
+ *
+ *  Nothing is timed if stats are disabled when the timer is constructed. If a histogram
+ *  is given, and histograms are enabled, the time is also recorded in the histogram.
+ */
+class ScopedStatTimer
+{
+private:
+    StatTimer timer;
+    StatHistogram histogram;
+    bool timing;
+    bool recordLatency;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    ScopedStatTimer(const StatTimer timer_);
+    ScopedStatTimer(const StatTimer timer_, const StatHistogram histogram_);
+    ~ScopedStatTimer();
+    ScopedStatTimer(const ScopedStatTimer&) = delete;
+    ScopedStatTimer& operator=(const ScopedStatTimer&) = delete;
+};
+
+
+/** @brief Checks whether stats are being recorded
+ * 
+ *  @return true if stats are enabled
+ */
+inline bool PipelineStats::IsEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+
+/** @brief Checks whether latency histograms are being recorded
+ * 
+ *  @return true if stats & histograms are enabled
+ */
+inline bool PipelineStats::HistogramsEnabled()
+{
+    return histogramsEnabled.load(std::memory_order_relaxed);
+}
+
+
+/** @brief Adds to a counter for the calling thread
+ * 
+ *  @param counter - Counter to add to
+ *  @param amount  - Amount to add
+ *  @return void
+ */
+inline void PipelineStats::Count(const StatCounter counter, const uint64_t amount)
+{
+    if (IsEnabled())
+        AddToCounter(counter, amount);
+}
+
+
+/** @brief Records the time taken by a stage for the calling thread
+ * 
+ *  @param timer     - Stage that was timed
+ *  @param elapsedNs - Time taken, in nanoseconds
+ *  @return void
+ */
+inline void PipelineStats::RecordTime(const StatTimer timer, const uint64_t elapsedNs)
+{
+    if (IsEnabled())
+        AddToTimer(timer, elapsedNs);
+}
+
+
+/** @brief Records a latency in a histogram for the calling thread
+ * 
+ *  @param histogram - Histogram to record the latency in
+ *  @param latencyNs - Latency, in nanoseconds
+ *  @return void
+ */
+inline void PipelineStats::RecordLatency(const StatHistogram histogram, const uint64_t latencyNs)
+{
+    if (HistogramsEnabled())
+        AddToHistogram(histogram, latencyNs);
+}
+
+
+inline ScopedStatTimer::ScopedStatTimer(const StatTimer timer_)
+    : timer(timer_),
+      histogram(StatHistogram::Count),
+      timing(PipelineStats::IsEnabled()),
+      recordLatency(false)
+{
+    if (timing)
+        start = std::chrono::steady_clock::now();
+}
+
+inline ScopedStatTimer::ScopedStatTimer(const StatTimer timer_, const StatHistogram histogram_)
+    : timer(timer_),
+      histogram(histogram_),
+      timing(PipelineStats::IsEnabled()),
+      recordLatency(PipelineStats::HistogramsEnabled())
+{
+    if (timing)
+        start = std::chrono::steady_clock::now();
+}
+
+inline ScopedStatTimer::~ScopedStatTimer()
+{
+    if (!timing)
+        return;
+
+    uint64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    PipelineStats::RecordTime(timer, elapsedNs);
+    if (recordLatency)
+        PipelineStats::RecordLatency(histogram, elapsedNs);
+}
+
+#endif
@@ -0,0 +1,103 @@
+/** @file QuantileSketch.h
+ *  @brief Fixed size, mergeable sketch of a distribution of values, for estimating quantiles
+ *
+ *  Counts values in log scale buckets, in the same way as an HDR histogram: each power of 2 is
+ *  split into 2^subBucketBits buckets of equal width, so every bucket is within a fixed relative
+ *  width of the values in it. Values below 2^subBucketBits each have a bucket of their own.
+ *
+ *  Only a window of NUM_BUCKETS consecutive buckets is held, positioned around the values seen so
+ *  far, so the memory used is fixed and nothing is ever allocated. When a value falls outside the
+ *  window the window is moved, if everything counted still fits, or otherwise the resolution is
+ *  halved by merging neighbouring buckets, which doubles the range the window covers. At the
+ *  starting resolution a quantile is estimated to within about 3% of the true value, and the
+ *  window covers a range of 16x. Each halving doubles the error, so values spread over a range
+ *  of 256x are still estimated to within about 6%, and 65536x to within about 12.5%.
+ *
+ *  The smallest & largest values are kept exactly, and estimates are clamped to them.
+ *
+ *  Sketches can be merged, e.g. the sketches built from different parts of the input file, at the
+ *  coarser of the two resolutions.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+class QuantileSketch
+{
+private:
+    static constexpr size_t NUM_BUCKETS = 64;
+    static constexpr uint32_t MAX_SUB_BUCKET_BITS = 4;
+
+    uint32_t counts[NUM_BUCKETS];
+    uint64_t totalCount;
+    uint64_t minValue;
+    uint64_t maxValue;
+    uint32_t windowStart;      // Bucket index of counts[0]
+    uint32_t subBucketBits;
+
+    static uint32_t BucketIndex(const uint64_t value, const uint32_t subBits);
+    static uint64_t BucketLowerBound(const uint32_t bucket, const uint32_t subBits);
+    static uint64_t BucketUpperBound(const uint32_t bucket, const uint32_t subBits);
+
+    void AddOutsideWindow(const uint64_t value, const uint64_t count);
+    bool MoveWindow(const uint32_t bucket);
+    void HalveResolution();
+
+public:
+    QuantileSketch();
+
+    void Add(const uint64_t value);
+    void Merge(const QuantileSketch& other);
+    uint64_t Quantile(const double fraction) const;
+    uint64_t GetCount() const;
+    bool IsValid() const;
+};
+
+
+/** @brief Finds the bucket a value is counted in
+ *
+ *  @param value   - Value
+ *  @param subBits - Resolution, as the log2 of the number of buckets per power of 2
+ *  @return Index of the bucket
+ */
+inline uint32_t QuantileSketch::BucketIndex(const uint64_t value, const uint32_t subBits)
+{
+    if (value < (uint64_t(1) << subBits))
+        return static_cast<uint32_t>(value);
+
+    uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+    uint32_t subBucket = static_cast<uint32_t>(value >> (exponent - subBits)) & ((1u << subBits) - 1);
+    return ((exponent - subBits + 1) << subBits) + subBucket;
+}
+
+
+/** @brief Adds a value to the sketch
+ *
+ *  Inlined, as it is called for every order. Values inside the window only cost a bucket
+ *  lookup and an increment.
+ *
+ *  @param value - Value to add
+ *  @return void
+ */
+inline void QuantileSketch::Add(const uint64_t value)
+{
+    minValue = (value < minValue) ? value : minValue;
+    maxValue = (value > maxValue) ? value : maxValue;
+
+    uint32_t windowPos = BucketIndex(value, subBucketBits) - windowStart;
+    if (windowPos < NUM_BUCKETS && totalCount > 0)
+    {
+        ++counts[windowPos];
+        ++totalCount;
+    }
+    else
+        AddOutsideWindow(value, 1);
+}
+
+#endif
@@ -0,0 +1,92 @@
+/** @file QueryServer.h
+ *  @brief Answers queries on the Order Reports over a Unix domain socket, while the input file is read
+ *
+ *  Runs on a thread of its own, alongside the thread reading the input file, and answers queries
+ *  from the latest Report Snapshot published by it. Snapshots are read without taking a lock, so
+ *  answering a query never holds up the Order Adds being aggregated, and a query is never held up
+ *  by them either.
+ *
+ *  Each query is a line of text, and each answer is the heading row of the report followed by one
+ *  row per Security, in the Report Format given, and ends with an empty line:
+ *    ISIN <isin>         - The Security with that ISIN.
+ *    SECURITY <id>       - The Security with that Security ID.
+ *    TOP <n>             - The n Securities with the largest total quantity, largest first.
+ *    DUMP                - Every Security, in the order they were referenced.
+ *    STATUS              - The sequence number & input file offset of the snapshot, and its number of Securities.
+ *  A Security that isn't found gives no rows. A query that can't be answered gets "ERROR <reason>"
+ *  and an empty line. Any number of clients can be connected at once, and each can send several
+ *  queries without waiting for the answers.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ReportRow.h"
+#include "ReportSchema.h"
+#include "ReportSnapshot.h"
+
+class QueryServer
+{
+private:
+    struct Client
+    {
+        int socket;
+        std::string requests;       // Bytes received that haven't been answered yet
+        std::string response;       // Answers still to be sent
+        size_t responseSent;
+        bool closing;               // The client has stopped sending, so close once everything is sent
+    };
+
+    static constexpr size_t MAX_REQUEST_LENGTH = 1024;
+    static constexpr size_t RECEIVE_SIZE = 4096;
+
+    SnapshotPublisher& publisher;
+    const ReportFormat* format;
+    char delimiter;
+    size_t reader;
+    std::string socketPath;
+    int listenSocket;
+    int wakePipe[2];
+    std::atomic<bool> stopping;
+    std::thread serverThread;
+
+    // Only touched by the server thread
+    //
+    std::vector<Client> clients;
+    std::unordered_map<std::string, uint32_t> isinSlots;
+    size_t indexedSlots;
+    std::vector<uint32_t> rankedSlots;
+    ReportRow row;
+
+    void Serve();
+    void AcceptClients();
+    bool ReceiveRequests(Client& client);
+    bool SendResponse(Client& client);
+    void AnswerRequests(Client& client);
+    void AnswerQuery(std::string_view request, const ReportSnapshot* snapshot, std::string& response);
+    void AppendRow(const OrderReportCollection& orders, const size_t slot, std::string& response);
+    void AppendTopSlots(const OrderReportCollection& orders, const size_t numSlots, std::string& response);
+    size_t FindIsin(const OrderReportCollection& orders, std::string_view isin);
+    void CloseSockets();
+
+public:
+    QueryServer(SnapshotPublisher& publisher_, const ReportFormat* format_, const char delim);
+    ~QueryServer();
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    bool Start(const std::string& socketPath_);
+    void Stop();
+    bool IsRunning() const;
+};
+
+#endif
@@ -0,0 +1,44 @@
+/** @file ReportRow.h
+ *  @brief A row of a report, formatted once and written with any delimiter
+ *
+ *  Holds the fields of one row of a report. Numbers are converted to text as they are
+ *  added, with std::to_chars, into a buffer inside the row, so building a row never
+ *  allocates. The same row can then be appended to any number of outputs, each with its
+ *  own delimiter, without formatting it again.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef REPORTROW_H
+#define REPORTROW_H
+
+#include <string>
+#include <string_view>
+#include "OutputBuffer.h"
+
+class ReportRow
+{
+public:
+    static constexpr size_t MAX_FIELDS = 32;
+
+private:
+    static constexpr size_t MAX_NUMBER_LENGTH = 20;
+
+    std::string_view fields[MAX_FIELDS];
+    char numberBuffer[MAX_FIELDS * MAX_NUMBER_LENGTH];
+    size_t numFields;
+    size_t numberBufferUsed;
+
+public:
+    ReportRow();
+
+    void Clear();
+    void AddField(std::string_view field);
+    void AddField(const size_t number);
+    void AddField(const int number);
+    void AppendTo(std::string& output, const char delim) const;
+    void AppendTo(OutputBuffer& output, const char delim) const;
+};
+
+#endif
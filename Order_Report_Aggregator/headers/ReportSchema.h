@@ -0,0 +1,280 @@
+/** @file ReportSchema.h
+ *  @brief Compile time list of the columns in an Order Report
+ *
+ *  A Report Schema is the list of Report Columns a report holds, in order, given as template
+ *  arguments. The heading row and every data row are both written from that one list, so they
+ *  can't disagree, and adding or removing a column means changing a single list.
+ *
+ *  The columns are expanded at compile time, so writing a row is a straight run of appends with
+ *  no loop, lookup or branch per column. Whether Securities with no Orders are reported is also
+ *  a template argument, so only the rows of a report that leaves them out pay for the check.
+ *
+ *  A Report Format holds pointers to a schema's functions, so a report's schema can still be chosen
+ *  at runtime, e.g. per Report Sink, at the cost of one indirect call per row.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef REPORTSCHEMA_H
+#define REPORTSCHEMA_H
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "OrderReport.h"
+#include "OrderReportCollection.h"
+#include "OutputBuffer.h"
+#include "ReportRow.h"
+
+/** @brief Gets the heading of a Report Column
+ *
+ *  @param column - Report Column
+ *  @return Heading of the column in the heading row
+ */
+constexpr std::string_view GetColumnHeading(const ReportColumn column)
+{
+    switch (column)
+    {
+        case ReportColumn::ISIN:                 return "ISIN";
+        case ReportColumn::Currency:             return "Currency";
+        case ReportColumn::BuyCount:             return "Total Buy Count";
+        case ReportColumn::SellCount:            return "Total Sell Count";
+        case ReportColumn::BuyQuantity:          return "Total Buy Quantity";
+        case ReportColumn::SellQuantity:         return "Total Sell Quantity";
+        case ReportColumn::WeightedAvgBuyPrice:  return "Weighted Average Buy Price";
+        case ReportColumn::WeightedAvgSellPrice: return "Weighted Average Sell Price";
+        case ReportColumn::MaxBuyPrice:          return "Max Buy Price";
+        case ReportColumn::MinSellPrice:         return "Min Sell Price";
+        case ReportColumn::BuyPriceP50:          return "Buy Price P50";
+        case ReportColumn::BuyPriceP95:          return "Buy Price P95";
+        case ReportColumn::BuyPriceP99:          return "Buy Price P99";
+        case ReportColumn::SellPriceP50:         return "Sell Price P50";
+        case ReportColumn::SellPriceP95:         return "Sell Price P95";
+        case ReportColumn::SellPriceP99:         return "Sell Price P99";
+        case ReportColumn::BuyQuantityP50:       return "Buy Quantity P50";
+        case ReportColumn::BuyQuantityP95:       return "Buy Quantity P95";
+        case ReportColumn::BuyQuantityP99:       return "Buy Quantity P99";
+        case ReportColumn::SellQuantityP50:      return "Sell Quantity P50";
+        case ReportColumn::SellQuantityP95:      return "Sell Quantity P95";
+        case ReportColumn::SellQuantityP99:      return "Sell Quantity P99";
+        case ReportColumn::RestingBuyQuantity:   return "Resting Buy Quantity";
+        case ReportColumn::RestingSellQuantity:  return "Resting Sell Quantity";
+        case ReportColumn::ExecutedBuyQuantity:  return "Executed Buy Quantity";
+        case ReportColumn::ExecutedSellQuantity: return "Executed Sell Quantity";
+    }
+    return "";
+}
+
+struct ReportFormat
+{
+    void (*writeHeader)(OutputBuffer& outBuffer, const char delim);
+    void (*appendHeader)(std::string& output, const char delim);
+    void (*formatRow)(ReportRow& row, const OrderReportCollection& ordRptColl, const size_t slot);
+};
+
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+class ReportSchema
+{
+private:
+    template <ReportColumn Column>
+    static void AppendColumn(OutputBuffer& outBuffer, const OrderReportCollection& ordRptColl, const size_t slot);
+
+public:
+    static constexpr size_t NUM_COLUMNS = 1 + sizeof...(OtherColumns);
+    static_assert(NUM_COLUMNS <= ReportRow::MAX_FIELDS, "Every column must fit in a Report Row");
+
+    static void WriteHeader(OutputBuffer& outBuffer, const char delim);
+    static void AppendHeader(std::string& output, const char delim);
+    static void WriteRow(OutputBuffer& outBuffer, const OrderReportCollection& ordRptColl, const size_t slot, const char delim);
+    static void FormatRow(ReportRow& row, const OrderReportCollection& ordRptColl, const size_t slot);
+
+    template <bool ReportEmptyOrders>
+    static void WriteRows(OutputBuffer& outBuffer, const OrderReportCollection& ordRptColl, const char delim);
+
+    static constexpr ReportFormat FORMAT = { &WriteHeader, &AppendHeader, &FormatRow };
+};
+
+// Every column, as written to the Order Report Files
+//
+using OrderReportSchema = ReportSchema< ReportColumn::ISIN,
+                                        ReportColumn::Currency,
+                                        ReportColumn::BuyCount,
+                                        ReportColumn::SellCount,
+                                        ReportColumn::BuyQuantity,
+                                        ReportColumn::SellQuantity,
+                                        ReportColumn::WeightedAvgBuyPrice,
+                                        ReportColumn::WeightedAvgSellPrice,
+                                        ReportColumn::MaxBuyPrice,
+                                        ReportColumn::MinSellPrice >;
+
+// Only the buy side of each Security
+//
+using BuyReportSchema = ReportSchema< ReportColumn::ISIN,
+                                      ReportColumn::Currency,
+                                      ReportColumn::BuyCount,
+                                      ReportColumn::BuyQuantity,
+                                      ReportColumn::WeightedAvgBuyPrice,
+                                      ReportColumn::MaxBuyPrice >;
+
+// Only the sell side of each Security
+//
+using SellReportSchema = ReportSchema< ReportColumn::ISIN,
+                                       ReportColumn::Currency,
+                                       ReportColumn::SellCount,
+                                       ReportColumn::SellQuantity,
+                                       ReportColumn::WeightedAvgSellPrice,
+                                       ReportColumn::MinSellPrice >;
+
+// Every column, followed by the quantiles of each side's prices & quantities.
+// Needs the collection to keep sketches.
+//
+using QuantileReportSchema = ReportSchema< ReportColumn::ISIN,
+                                           ReportColumn::Currency,
+                                           ReportColumn::BuyCount,
+                                           ReportColumn::SellCount,
+                                           ReportColumn::BuyQuantity,
+                                           ReportColumn::SellQuantity,
+                                           ReportColumn::WeightedAvgBuyPrice,
+                                           ReportColumn::WeightedAvgSellPrice,
+                                           ReportColumn::MaxBuyPrice,
+                                           ReportColumn::MinSellPrice,
+                                           ReportColumn::BuyPriceP50,
+                                           ReportColumn::BuyPriceP95,
+                                           ReportColumn::BuyPriceP99,
+                                           ReportColumn::SellPriceP50,
+                                           ReportColumn::SellPriceP95,
+                                           ReportColumn::SellPriceP99,
+                                           ReportColumn::BuyQuantityP50,
+                                           ReportColumn::BuyQuantityP95,
+                                           ReportColumn::BuyQuantityP99,
+                                           ReportColumn::SellQuantityP50,
+                                           ReportColumn::SellQuantityP95,
+                                           ReportColumn::SellQuantityP99 >;
+
+// Every column, followed by the resting & executed quantity of each side.
+// Needs live Orders to be tracked.
+//
+using ActivityReportSchema = ReportSchema< ReportColumn::ISIN,
+                                           ReportColumn::Currency,
+                                           ReportColumn::BuyCount,
+                                           ReportColumn::SellCount,
+                                           ReportColumn::BuyQuantity,
+                                           ReportColumn::SellQuantity,
+                                           ReportColumn::WeightedAvgBuyPrice,
+                                           ReportColumn::WeightedAvgSellPrice,
+                                           ReportColumn::MaxBuyPrice,
+                                           ReportColumn::MinSellPrice,
+                                           ReportColumn::RestingBuyQuantity,
+                                           ReportColumn::RestingSellQuantity,
+                                           ReportColumn::ExecutedBuyQuantity,
+                                           ReportColumn::ExecutedSellQuantity >;
+
+
+/** @brief Appends the value of one column of a row
+ *
+ *  @param outBuffer  - The buffer to append the value to
+ *  @param ordRptColl - Collection of Order Reports
+ *  @param slot       - Slot of the Security
+ *  @return void
+ */
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+template <ReportColumn Column>
+inline void ReportSchema<FirstColumn, OtherColumns...>::AppendColumn(OutputBuffer& outBuffer, const OrderReportCollection& ordRptColl, const size_t slot)
+{
+    auto value = ordRptColl.GetColumn<Column>(slot);
+    if constexpr (std::is_same_v<decltype(value), std::string_view>)
+        outBuffer.Append(value);
+    else
+        outBuffer.AppendNumber(value);
+}
+
+
+/** @brief Writes the heading row
+ *
+ *  @param outBuffer - The buffer for the report
+ *  @param delim     - The delimiter that will seperate each heading
+ *  @return void
+ */
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+inline void ReportSchema<FirstColumn, OtherColumns...>::WriteHeader(OutputBuffer& outBuffer, const char delim)
+{
+    outBuffer.Append(GetColumnHeading(FirstColumn));
+    ((outBuffer.Append(delim), outBuffer.Append(GetColumnHeading(OtherColumns))), ...);
+    outBuffer.Append('\n');
+}
+
+
+/** @brief Appends the heading row to a string
+ *
+ *  @param output - The string to append the heading row to
+ *  @param delim  - The delimiter that will seperate each heading
+ *  @return void
+ */
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+inline void ReportSchema<FirstColumn, OtherColumns...>::AppendHeader(std::string& output, const char delim)
+{
+    output += GetColumnHeading(FirstColumn);
+    ((output += delim, output += GetColumnHeading(OtherColumns)), ...);
+    output += '\n';
+}
+
+
+/** @brief Writes the row of a Security
+ *
+ *  @param outBuffer  - The buffer for the report
+ *  @param ordRptColl - Collection of Order Reports
+ *  @param slot       - Slot of the Security
+ *  @param delim      - The delimiter that will seperate each value
+ *  @return void
+ */
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+inline void ReportSchema<FirstColumn, OtherColumns...>::WriteRow(OutputBuffer& outBuffer, const OrderReportCollection& ordRptColl, const size_t slot, const char delim)
+{
+    AppendColumn<FirstColumn>(outBuffer, ordRptColl, slot);
+    ((outBuffer.Append(delim), AppendColumn<OtherColumns>(outBuffer, ordRptColl, slot)), ...);
+    outBuffer.Append('\n');
+}
+
+
+/** @brief Formats the row of a Security
+ *
+ *  Formatting into a row lets the same values be written to several reports at once.
+ *
+ *  @param row        - The row to format the Order Report into. Any existing fields are removed.
+ *  @param ordRptColl - Collection of Order Reports
+ *  @param slot       - Slot of the Security
+ *  @return void
+ */
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+inline void ReportSchema<FirstColumn, OtherColumns...>::FormatRow(ReportRow& row, const OrderReportCollection& ordRptColl, const size_t slot)
+{
+    row.Clear();
+    row.AddField(ordRptColl.GetColumn<FirstColumn>(slot));
+    (row.AddField(ordRptColl.GetColumn<OtherColumns>(slot)), ...);
+}
+
+
+/** @brief Writes the row of every Security in a collection
+ *
+ *  @param outBuffer  - The buffer for the report
+ *  @param ordRptColl - Collection of Order Reports
+ *  @param delim      - The delimiter that will seperate each value
+ *  @return void
+ */
+template <ReportColumn FirstColumn, ReportColumn... OtherColumns>
+template <bool ReportEmptyOrders>
+inline void ReportSchema<FirstColumn, OtherColumns...>::WriteRows(OutputBuffer& outBuffer, const OrderReportCollection& ordRptColl, const char delim)
+{
+    for (size_t slot = 0; slot < ordRptColl.Size(); ++slot)
+    {
+        if constexpr (!ReportEmptyOrders)
+        {
+            if (!ordRptColl.GetOrderReport(slot).HasOrders())
+                continue;
+        }
+        WriteRow(outBuffer, ordRptColl, slot, delim);
+    }
+}
+
+#endif
@@ -0,0 +1,136 @@
+/** @file ReportSnapshot.h
+ *  @brief Read-only copies of the Order Report collection, published for other threads to read
+ *
+ *  The thread reading the input file publishes a Report Snapshot every so often: a copy of the
+ *  Order Report collection as it stood at that point. Other threads, e.g. the query server, read
+ *  the latest snapshot without taking any lock, so a reader never holds up the Order Adds being
+ *  aggregated, and publishing never waits for a reader.
+ *
+ *  Snapshots are reclaimed with epochs. A reader announces the epoch it started reading in before
+ *  it picks up the latest snapshot, and clears it once it's done. A snapshot that has been replaced
+ *  is only reused once every reader is either idle or started reading after it was replaced, so
+ *  it can't be overwritten while anyone could still be reading it. Reused snapshots keep the
+ *  memory of their vectors, so once there are enough of them publishing doesn't allocate.
+ *
+ *  Only one thread may publish. Each reading thread registers once, up to MAX_READERS of them.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef REPORTSNAPSHOT_H
+#define REPORTSNAPSHOT_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "OrderReportCollection.h"
+
+struct ReportSnapshot
+{
+    OrderReportCollection orders;
+    uint64_t sequence;      // Snapshots published before this one, plus 1
+    size_t inputOffset;     // How far through the input file the snapshot covers
+};
+
+class SnapshotPublisher
+{
+public:
+    static constexpr size_t MAX_READERS = 16;
+    static constexpr size_t NO_READER = SIZE_MAX;
+
+private:
+    static constexpr uint64_t IDLE_EPOCH = 0;
+
+    // Each reader's epoch has a cache line of its own, so readers don't slow each other down
+    //
+    struct alignas(64) ReaderEpoch
+    {
+        std::atomic<uint64_t> epoch;
+    };
+
+    struct RetiredSnapshot
+    {
+        ReportSnapshot* snapshot;
+        uint64_t retireEpoch;       // Readers that started in this epoch or later can't be reading it
+    };
+
+    std::atomic<ReportSnapshot*> current;
+    std::atomic<uint64_t> globalEpoch;
+    std::array<ReaderEpoch, MAX_READERS> readerEpochs;
+    std::atomic<size_t> numReaders;
+
+    // Only touched by the publishing thread
+    //
+    std::vector<std::unique_ptr<ReportSnapshot>> snapshots;
+    std::vector<RetiredSnapshot> retired;
+    std::vector<ReportSnapshot*> spare;
+    uint64_t numPublished;
+
+    void ReclaimSnapshots();
+
+public:
+    SnapshotPublisher();
+    ~SnapshotPublisher();
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    void Publish(const OrderReportCollection& ordRptColl, const size_t inputOffset);
+    uint64_t GetNumPublished() const;
+    size_t GetNumSnapshots() const;
+
+    size_t RegisterReader();
+    const ReportSnapshot* Acquire(const size_t reader);
+    void Release(const size_t reader);
+};
+
+/** @brief Reads the latest Report Snapshot from construction to destruction
+ *
+ *  The snapshot can't be reused until the Scoped Snapshot is destroyed, so it should only be held
+ *  for as long as it takes to answer a query.
+ */
+class ScopedSnapshot
+{
+private:
+    SnapshotPublisher& publisher;
+    size_t reader;
+    const ReportSnapshot* snapshot;
+
+public:
+    ScopedSnapshot(SnapshotPublisher& publisher_, const size_t reader_);
+    ~ScopedSnapshot();
+    ScopedSnapshot(const ScopedSnapshot&) = delete;
+    ScopedSnapshot& operator=(const ScopedSnapshot&) = delete;
+
+    const ReportSnapshot* Get() const;
+};
+
+
+/** @brief Starts reading the latest snapshot
+ *
+ *  Never blocks. The epoch is announced before the snapshot is picked up, so a snapshot that is
+ *  replaced in between is still protected by the earlier epoch.
+ *
+ *  @param reader - Reader registered by the calling thread
+ *  @return The latest snapshot, or nullptr if none has been published yet
+ */
+inline const ReportSnapshot* SnapshotPublisher::Acquire(const size_t reader)
+{
+    readerEpochs[reader].epoch.store(globalEpoch.load());
+    return current.load();
+}
+
+
+/** @brief Finishes reading the snapshot returned by Acquire
+ *
+ *  @param reader - Reader registered by the calling thread
+ *  @return void
+ */
+inline void SnapshotPublisher::Release(const size_t reader)
+{
+    readerEpochs[reader].epoch.store(IDLE_EPOCH, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,71 @@
+/** @file RollupReport.h
+ *  @brief Totals of the Order Reports of groups of Securities, e.g. per currency or per ISIN country
+ *
+ *  A rollup groups the Securities by a Rollup Dimension: their currency, the country prefix of their
+ *  ISIN (its first two letters), or both. Each group is held as one slot of its own Order Report
+ *  collection, so it is written with the same Report Formats as the Securities are. The ISIN & currency
+ *  columns of a group's row hold its key, and are left empty when they aren't part of the key.
+ *
+ *  The group of each Security is resolved once, when it is first mapped, normally as its Security
+ *  Reference Data is read, and kept by slot. The groups' totals are then built by merging the Order
+ *  Report of each Security into its group, which gives the same totals as adding every Order to the
+ *  group as it is read. Building them from the Order Reports, rather than as each Order is read, costs
+ *  nothing per Order and works however the Order Reports were produced, e.g. read in parallel,
+ *  restored from a checkpoint or merged from shards.
+ *
+ *  Groups are written in the order their first Security was inserted, including groups with no Orders.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef ROLLUPREPORT_H
+#define ROLLUPREPORT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "OrderReport.h"
+#include "OrderReportCollection.h"
+#include "ReportSchema.h"
+
+enum class RollupDimension
+{
+    Currency,
+    Country,
+    CountryCurrency
+};
+
+class RollupReport
+{
+private:
+    static constexpr size_t COUNTRY_PREFIX_LENGTH = 2;
+
+    RollupDimension dimension;
+    std::string outputFile;
+    const ReportFormat* format;
+    std::unordered_map<std::string, uint32_t> groupSlots;   // Slot of each group, by key
+    std::vector<SecurityInfo> groupKeys;
+    std::vector<uint32_t> securityGroups;                   // Group of each Security, by slot
+    OrderReportCollection groups;
+
+    SecurityInfo GetGroupKey(const SecurityInfo& secInfo) const;
+
+public:
+    RollupReport(const RollupDimension dimension_, const std::string& outputFile_, const ReportFormat* format_);
+    ~RollupReport();
+
+    static bool ParseDimension(std::string_view name, RollupDimension& dimension);
+    static std::string_view GetDimensionName(const RollupDimension dimension);
+
+    RollupDimension GetDimension() const;
+    const std::string& GetOutputFile() const;
+    void MapSecurities(const OrderReportCollection& ordRptColl);
+    void Build(const OrderReportCollection& ordRptColl);
+    const OrderReportCollection& GetGroups() const;
+    void Write(const char delim) const;
+};
+
+#endif
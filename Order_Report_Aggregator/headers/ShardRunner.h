@@ -0,0 +1,33 @@
+/** @file ShardRunner.h
+ *  @brief Runs each shard of a sharded aggregation in a worker process of its own
+ *
+ *  Forks one worker process per shard. Each worker runs the shard function, which writes its results
+ *  to an Output Buffer on the write end of a pipe, and then exits. The coordinating process reads every
+ *  worker's results back from its pipe, standing in for the network between the hosts a sharded
+ *  aggregation would otherwise run on. The workers share nothing but the input file, so they don't
+ *  slow each other down the way threads sharing a heap & Order Report collection would.
+ *
+ *  Only supported where processes can be forked.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef SHARDRUNNER_H
+#define SHARDRUNNER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "OutputBuffer.h"
+
+class ShardRunner
+{
+public:
+    typedef std::function<bool(const size_t shard, OutputBuffer& outBuffer)> ShardFunc;
+
+    static bool IsSupported();
+    static bool Run(const size_t numShards, const ShardFunc& runShard, std::vector<std::string>& shardResults);
+};
+
+#endif
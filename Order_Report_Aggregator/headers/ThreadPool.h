@@ -0,0 +1,62 @@
+/** @file ThreadPool.h
+ *  @brief Fixed size pool of worker threads that steal work from each other
+ *
+ *  Runs submitted tasks on a fixed number of worker threads. Each worker has its own queue of
+ *  tasks. Tasks submitted from outside the pool are handed to the workers' queues in turn, while
+ *  a task that submits more work from a worker thread adds it to that worker's own queue. A worker
+ *  runs the newest task in its own queue first, and once that is empty steals the oldest task from
+ *  another worker's queue, so no worker sits idle while any work is left.
+ *
+ *  Wait() blocks until every submitted task has finished, including any tasks they submitted, so
+ *  the pool can be reused for several batches of work.
+ *
+ *  @author Sean Griffin
+ *  @bug No known bugs.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::mutex tasksMutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable tasksFinished;
+    size_t queuedTasks;    // Tasks in the queues that no worker has claimed yet
+    size_t activeTasks;    // Tasks submitted that haven't finished yet
+    std::atomic<size_t> nextQueue;
+    bool stopping;
+
+    void RunWorker(const size_t workerIndex);
+    std::function<void()> TakeTask(const size_t workerIndex);
+
+public:
+    ThreadPool(const size_t numThreads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> task);
+    void Wait();
+    size_t GetNumThreads() const;
+};
+
+#endif
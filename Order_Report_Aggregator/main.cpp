@@ -5,47 +5,456 @@
  *  One report contains Securities that have Orders against them, while the other contains every
  *  recorded Security, regardless of whether it has an Order against it or not.
  *
+ *  Usage: Order_Report_Aggregator [--input FILE] [--batch PATH] [--merge] [--read-method METHOD] [--threads N] [--follow]
+ *                                 [--snapshot-seconds N] [--snapshot-messages N] [--checkpoint FILE] [--checkpoint-messages N]
+ *                                 [--stats FILE] [--stats-histograms] [--pending-order-mb N] [--report-columns COLUMNS]
+ *                                 [--interval-seconds N] [--query-socket PATH] [--publish-messages N]
+ *                                 [--shards N] [--shard K --partial-output FILE] [--merge-partials FILES]
+ *                                 [--rollups DIMENSIONS]
+ *    --input FILE          - Input File Name/Path. Defaults to pretrade_current.txt. May be gzip or zstd compressed.
+ *    --batch PATH          - Read every file in the directory PATH, or matching the glob pattern PATH, instead of the input file.
+ *                            Files are read --threads at a time, with large files split across threads. The two reports
+ *                            are written to Output_Files for each file, named after it, e.g. venue1_order_report.txt.
+ *                            --follow & --checkpoint are ignored.
+ *    --merge               - In batch mode, merge every file into the two usual reports rather than writing them per file.
+ *    --read-method METHOD  - How to read the input file: auto (memory map, the default), stream (std::getline)
+ *                            or async (io_uring with several reads in flight, or pread where io_uring isn't available).
+ *    --threads N           - Read the input file in parallel on N threads. 0 uses every available core.
+ *    --follow              - Keep reading the input file as it grows, until interrupted (Ctrl+C / SIGTERM).
+ *                            A snapshot of the report on Securities with Orders is written periodically.
+ *    --snapshot-seconds N  - Seconds between snapshots when following. Defaults to 10.
+ *    --snapshot-messages N - Messages read between snapshots when following. Off by default.
+ *    --checkpoint FILE     - Restore from FILE if it exists and carry on reading from where it left off.
+ *                            FILE is ignored if the input file has since been replaced, rewritten or truncated.
+ *                            A checkpoint is saved to FILE periodically and once the input file has been read.
+ *    --checkpoint-messages N - Messages read between checkpoints. Defaults to 10,000,000.
+ *    --stats FILE          - Record pipeline stats and write them to FILE as JSON at exit, and whenever SIGUSR1 is received.
+ *    --stats-histograms    - Also record latency histograms. Each line is timed, which slows reading down a little.
+ *    --pending-order-mb N  - Memory, in MB, for Order Adds that arrive before their Security is referenced. Defaults to 256.
+ *                            0 discards them instead. Orders still pending at the end are reported on stderr.
+ *    --report-columns COLUMNS - Columns of the reports: all (the default), buy (ISIN, currency & the buy side only),
+ *                            sell (ISIN, currency & the sell side only), quantiles (every column, then the
+ *                            p50, p95 & p99 of each side's order prices & quantities) or activity (every column,
+ *                            then each side's resting & executed quantity, from the Order Delete, Modify &
+ *                            Execute messages). activity reads the input file on one thread.
+ *    --interval-seconds N  - Also write the volume & VWAP of each Security in every N second interval to
+ *                            Output_Files/interval_report.txt, as the input file is read. Off by default.
+ *                            The input file is then read on one thread.
+ *    --query-socket PATH   - Answer queries on the Order Reports over a Unix domain socket at PATH while the input file
+ *                            is read, from a snapshot published every --publish-messages lines. See QueryServer.h for
+ *                            the queries. The server stops once the reports have been written. Ignored in batch mode.
+ *    --publish-messages N  - Messages read between the snapshots queries are answered from. Defaults to 100,000.
+ *                            A parallel read only publishes once every chunk has been merged.
+ *    --shards N            - Aggregate in N worker processes, each reading the whole input file but only aggregating the
+ *                            Securities whose Security ID hashes to its shard. Each worker sends its partial Order Reports
+ *                            back down a pipe, and they are merged into the same two reports a serial read gives.
+ *                            The --pending-order-mb limit applies to each worker, so if it's reached the Orders dropped,
+ *                            and so the reports, can differ from a serial read. --threads, --follow, --checkpoint,
+ *                            --interval-seconds & --query-socket are ignored.
+ *    --shard K             - With --shards N & --partial-output, only aggregate shard K (0 to N-1), in this process.
+ *    --partial-output FILE - Write shard K's partial Order Reports to FILE, instead of writing the reports.
+ *    --merge-partials FILES - Merge the comma separated partial Order Report files written for every shard by
+ *                            --partial-output into the two usual reports, instead of reading the input file.
+ *    --rollups DIMENSIONS  - Also write the totals of groups of Securities, in the columns of the reports, for each of the
+ *                            comma separated dimensions: currency, country (the first two letters of the ISIN) or
+ *                            country-currency. Each is written to Output_Files/order_report_by_<dimension>.txt,
+ *                            e.g. order_report_by_country_currency.txt, alongside the two usual reports.
+ *
  *  @author Sean Griffin
  *  @bug No known bugs.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iostream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include "CompressedInputReader.h"
+#include "OrderReportBatch.h"
 #include "OrderReportFileHandler.h"
+#include "PipelineStats.h"
+#include "QueryServer.h"
+#include "ShardRunner.h"
+
+static std::atomic<bool> stopFollowing(false);
+
+static void StopFollowing(int)
+{
+    stopFollowing.store(true);
+}
+
+/** @brief Checks that this build can read an input file
+ *
+ *  @param inputFile - Input File Name/Path
+ *  @return true if the input file isn't compressed, or is in a format this build can decompress
+ */
+static bool CanReadInputFile(const std::string& inputFile)
+{
+    CompressionFormat inputFormat = CompressedInputReader::DetectFormat(inputFile);
+    if (inputFormat != CompressionFormat::None && !CompressedInputReader::IsSupported(inputFormat))
+    {
+        std::cerr << inputFile << " is compressed in a format this build can't read" << std::endl;
+        return false;
+    }
+    return true;
+}
 
-int main()
+int main(int argc, char* argv[])
 {
-    const std::string INPUT_FILE  = "pretrade_current.txt";
+    const std::string OUTPUT_DIRECTORY = "Output_Files";
     const std::string OUTPUT_FILE = "Output_Files/order_report.txt";
     const std::string OUTPUT_FILE_EMPTY_ORDERS = "Output_Files/order_report_including_empty_securities.txt";
+    const std::string INTERVAL_FILE = "Output_Files/interval_report.txt";
+
+    std::string inputFile = "pretrade_current.txt";
+    std::string batchPath;
+    bool mergeBatch = false;
+    InputReadMethod readMethod = InputReadMethod::Auto;
+    size_t numThreads = 1;
+    bool follow = false;
+    std::string checkpointFile;
+    size_t checkpointLines = 10000000;
+    std::string statsFile;
+    bool statsHistograms = false;
+    size_t pendingOrderMB = 256;
+    const ReportFormat* reportFormat = &OrderReportSchema::FORMAT;
+    bool quantileSketches = false;
+    bool trackOrders = false;
+    size_t intervalSeconds = 0;
+    std::string querySocket;
+    size_t publishLines = 100000;
+    size_t numShards = 0;
+    size_t shard = 0;
+    bool singleShard = false;
+    std::string partialOutput;
+    std::string mergePartials;
+    std::vector<RollupDimension> rollupDimensions;
+    FollowSettings followSettings = { std::chrono::seconds(10),       // Snapshot Interval
+                                      0,                              // Snapshot Lines
+                                      std::chrono::milliseconds(200), // Poll Interval
+                                      &stopFollowing };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc)
+            inputFile = argv[++i];
+        else if (arg == "--batch" && i + 1 < argc)
+            batchPath = argv[++i];
+        else if (arg == "--merge")
+            mergeBatch = true;
+        else if (arg == "--read-method" && i + 1 < argc)
+        {
+            std::string method = argv[++i];
+            if (method == "stream")
+                readMethod = InputReadMethod::Stream;
+            else if (method == "async")
+                readMethod = InputReadMethod::AsyncRead;
+            else
+                readMethod = InputReadMethod::Auto;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            numThreads = std::stoul(argv[++i]);
+            if (numThreads == 0)
+                numThreads = std::thread::hardware_concurrency();
+        }
+        else if (arg == "--follow")
+            follow = true;
+        else if (arg == "--snapshot-seconds" && i + 1 < argc)
+            followSettings.snapshotInterval = std::chrono::seconds(std::stoul(argv[++i]));
+        else if (arg == "--snapshot-messages" && i + 1 < argc)
+            followSettings.snapshotLines = std::stoul(argv[++i]);
+        else if (arg == "--checkpoint" && i + 1 < argc)
+            checkpointFile = argv[++i];
+        else if (arg == "--checkpoint-messages" && i + 1 < argc)
+            checkpointLines = std::stoul(argv[++i]);
+        else if (arg == "--stats" && i + 1 < argc)
+            statsFile = argv[++i];
+        else if (arg == "--stats-histograms")
+            statsHistograms = true;
+        else if (arg == "--pending-order-mb" && i + 1 < argc)
+            pendingOrderMB = std::stoul(argv[++i]);
+        else if (arg == "--report-columns" && i + 1 < argc)
+        {
+            std::string columns = argv[++i];
+            if (columns == "buy")
+                reportFormat = &BuyReportSchema::FORMAT;
+            else if (columns == "sell")
+                reportFormat = &SellReportSchema::FORMAT;
+            else if (columns == "quantiles")
+                reportFormat = &QuantileReportSchema::FORMAT;
+            else if (columns == "activity")
+                reportFormat = &ActivityReportSchema::FORMAT;
+            else
+                reportFormat = &OrderReportSchema::FORMAT;
+            quantileSketches = (reportFormat == &QuantileReportSchema::FORMAT);
+            trackOrders = (reportFormat == &ActivityReportSchema::FORMAT);
+        }
+        else if (arg == "--interval-seconds" && i + 1 < argc)
+            intervalSeconds = std::stoul(argv[++i]);
+        else if (arg == "--query-socket" && i + 1 < argc)
+            querySocket = argv[++i];
+        else if (arg == "--publish-messages" && i + 1 < argc)
+            publishLines = std::stoul(argv[++i]);
+        else if (arg == "--shards" && i + 1 < argc)
+            numShards = std::stoul(argv[++i]);
+        else if (arg == "--shard" && i + 1 < argc)
+        {
+            shard = std::stoul(argv[++i]);
+            singleShard = true;
+        }
+        else if (arg == "--partial-output" && i + 1 < argc)
+            partialOutput = argv[++i];
+        else if (arg == "--merge-partials" && i + 1 < argc)
+            mergePartials = argv[++i];
+        else if (arg == "--rollups" && i + 1 < argc)
+        {
+            std::string_view dimensions = argv[++i];
+            for (size_t start = 0, end = 0; start <= dimensions.size(); start = end + 1)
+            {
+                end = std::min(dimensions.find(',', start), dimensions.size());
+                RollupDimension dimension;
+                if (RollupReport::ParseDimension(dimensions.substr(start, end - start), dimension))
+                    rollupDimensions.push_back(dimension);
+            }
+        }
+    }
+
+    // Must be set up before any other thread is started, so that they all leave SIGUSR1 to the stats thread
+    //
+    if (!statsFile.empty())
+    {
+        PipelineStats::Enable(true, statsHistograms);
+        PipelineStats::WriteJsonOnSignal(statsFile, SIGUSR1);
+    }
+
+    // Rollups of the Securities, written alongside the two usual reports
+    //
+    auto addRollups = [&](OrderReportFileHandler& fileHandler)
+    {
+        for (RollupDimension dimension : rollupDimensions)
+        {
+            std::string rollupFile = OUTPUT_DIRECTORY + "/order_report_by_" + std::string(RollupReport::GetDimensionName(dimension)) + ".txt";
+            fileHandler.AddRollup(RollupReport(dimension, rollupFile, reportFormat));
+        }
+    };
+
+    // Batch mode reads every file in one pass over a shared thread pool, then writes the reports
+    // on each file, or on every file merged together
+    //
+    if (!batchPath.empty())
+    {
+        std::vector<std::string> inputFiles = OrderReportBatch::FindInputFiles(batchPath);
+        if (inputFiles.empty())
+        {
+            std::cerr << "No input files found at " << batchPath << std::endl;
+            return 1;
+        }
+        if (!std::all_of(inputFiles.begin(), inputFiles.end(), CanReadInputFile))
+            return 1;
+
+        OrderReportBatch ordRptBatch(inputFiles);
+        ordRptBatch.SetInputReadMethod(readMethod);
+        ordRptBatch.SetPendingOrderLimit(pendingOrderMB << 20);
+        ordRptBatch.SetReportFormat(reportFormat);
+        ordRptBatch.SetQuantileSketches(quantileSketches);
+        ordRptBatch.SetOrderTracking(trackOrders);
+        ordRptBatch.SetRollups(rollupDimensions);
+        ordRptBatch.ReadInputFiles(numThreads, mergeBatch ? "" : OUTPUT_DIRECTORY);
+        ordRptBatch.ReportUnresolvedOrders(std::cerr);
+
+        if (mergeBatch)
+        {
+            std::shared_ptr<OrderReportCollection> mergedColl = std::make_shared<OrderReportCollection>();
+            ordRptBatch.MergeOrderReports(*mergedColl);
+
+            OrderReportFileHandler mergedFH("", OUTPUT_FILE, mergedColl, '\t', false);
+            mergedFH.AddReportSink({ OUTPUT_FILE, '\t', &OrderReport::HasOrders, reportFormat });
+            mergedFH.AddReportSink({ OUTPUT_FILE_EMPTY_ORDERS, '\t', nullptr, reportFormat });
+            addRollups(mergedFH);
+            mergedFH.WriteReportSinks();
+        }
+
+        if (!statsFile.empty())
+            PipelineStats::WriteJsonFile(statsFile);
+
+        return 0;
+    }
+
+    // Sharded mode aggregates each shard's Securities separately, in worker processes or one shard per run,
+    // and the coordinator merges the shards' partial Order Reports into the reports
+    //
+    auto readShard = [&](const size_t shardToRead, OutputBuffer& outBuffer)
+    {
+        std::shared_ptr<OrderReportCollection> shardColl = std::make_shared<OrderReportCollection>();
+        shardColl->EnableSketches(quantileSketches);
+        OrderReportFileHandler shardFH(inputFile, "", shardColl, '\t', false);
+        shardFH.SetInputReadMethod(readMethod);
+        shardFH.SetPendingOrderLimit(pendingOrderMB << 20);
+        shardFH.SetOrderTracking(trackOrders);
+        shardFH.SetPartition(shardToRead, numShards);
+        shardFH.ReadInputFile();
+        return shardFH.WriteShardPartial(outBuffer);
+    };
+
+    auto writeMergedReports = [&](const std::vector<ShardPartial>& partials)
+    {
+        std::shared_ptr<OrderReportCollection> mergedColl = std::make_shared<OrderReportCollection>();
+        mergedColl->EnableSketches(quantileSketches);
+        OrderReportFileHandler mergedFH("", OUTPUT_FILE, mergedColl, '\t', false);
+        mergedFH.MergeShardPartials(partials);
+        mergedFH.ReportUnresolvedOrders(std::cerr);
+        mergedFH.AddReportSink({ OUTPUT_FILE, '\t', &OrderReport::HasOrders, reportFormat });
+        mergedFH.AddReportSink({ OUTPUT_FILE_EMPTY_ORDERS, '\t', nullptr, reportFormat });
+        addRollups(mergedFH);
+        mergedFH.WriteReportSinks();
+
+        if (!statsFile.empty())
+            PipelineStats::WriteJsonFile(statsFile);
+    };
+
+    if (!mergePartials.empty())
+    {
+        std::vector<std::string> partialFiles;
+        for (size_t start = 0, end = 0; start <= mergePartials.size(); start = end + 1)
+        {
+            end = std::min(mergePartials.find(',', start), mergePartials.size());
+            partialFiles.push_back(mergePartials.substr(start, end - start));
+        }
+
+        std::vector<ShardPartial> partials(partialFiles.size());
+        for (size_t i = 0; i < partialFiles.size(); ++i)
+        {
+            if (!OrderReportShard::ReadFile(partialFiles[i], partials[i]))
+            {
+                std::cerr << "Unable to read the partial Order Reports in " << partialFiles[i] << std::endl;
+                return 1;
+            }
+        }
+        if (!OrderReportShard::IsComplete(partials))
+        {
+            std::cerr << "The partial Order Reports must be of every shard, once each" << std::endl;
+            return 1;
+        }
+
+        writeMergedReports(partials);
+        return 0;
+    }
+
+    if (numShards > 0)
+    {
+        if (!CanReadInputFile(inputFile))
+            return 1;
+
+        if (singleShard)
+        {
+            OutputBuffer outBuffer;
+            if (shard >= numShards || partialOutput.empty() || !outBuffer.Open(partialOutput) || !readShard(shard, outBuffer))
+            {
+                std::cerr << "Unable to write the partial Order Reports of shard " << shard << " to " << partialOutput << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+
+        std::vector<std::string> shardResults;
+        std::vector<ShardPartial> partials(numShards);
+        bool succeeded = ShardRunner::IsSupported() && ShardRunner::Run(numShards, readShard, shardResults);
+        for (size_t i = 0; succeeded && i < numShards; ++i)
+            succeeded = OrderReportShard::Read(shardResults[i], partials[i]);
+        if (!succeeded || !OrderReportShard::IsComplete(partials))
+        {
+            std::cerr << "Unable to aggregate the input file in " << numShards << " shards" << std::endl;
+            return 1;
+        }
+
+        writeMergedReports(partials);
+        return 0;
+    }
+
+    if (!CanReadInputFile(inputFile))
+        return 1;
 
     std::shared_ptr<OrderReportCollection> ordRptColl = std::make_shared<OrderReportCollection>();
-    OrderReportFileHandler ordRptFH( INPUT_FILE,    // Input File
+    ordRptColl->EnableSketches(quantileSketches);
+    OrderReportFileHandler ordRptFH( inputFile,     // Input File
                                      OUTPUT_FILE,   // Output File
-                                     ordRptColl,    // Map of Order Reports
+                                     ordRptColl,    // Collection of Order Reports
                                      '\t',          // Output File Delimiter
                                      false );       // Only print Securities that have Orders
+    ordRptFH.SetInputReadMethod(readMethod);
+    ordRptFH.SetPendingOrderLimit(pendingOrderMB << 20);
+    ordRptFH.SetOrderTracking(trackOrders);
+    ordRptFH.SetReportFormat(reportFormat);
+    addRollups(ordRptFH);
 
-    // Read the file defined in INPUT_FILE
+    // Per interval volume & VWAP, from the lines read in this run
+    // Opened before restoring the checkpoint, so that the pending orders it restores keep their timestamps
     //
-    ordRptFH.ReadInputFile();
+    if (intervalSeconds > 0 && !ordRptFH.OpenIntervalReport(INTERVAL_FILE, std::chrono::seconds(intervalSeconds)))
+    {
+        std::cerr << "Unable to open " << INTERVAL_FILE << std::endl;
+        return 1;
+    }
 
-    // Write to the file OUTPUT_FILE
-    // This file will only include Securities that have Orders
+    // Carry on from the last checkpoint, if there is one
     //
-    ordRptFH.WriteOutputFile();
+    if (!checkpointFile.empty())
+    {
+        ordRptFH.SetCheckpoint(checkpointFile, checkpointLines);
+        ordRptFH.RestoreCheckpoint();
+    }
 
-    // Set the OrderReportFileHandler to generate a report on Securities that have no Orders as well
+    // Answer queries from snapshots published as the input file is read, starting with what the checkpoint restored
     //
-    ordRptFH.SetReportEmptyOrders(true);
+    SnapshotPublisher snapshotPublisher;
+    QueryServer queryServer(snapshotPublisher, reportFormat, '\t');
+    if (!querySocket.empty())
+    {
+        ordRptFH.SetSnapshotPublisher(&snapshotPublisher, publishLines);
+        ordRptFH.PublishSnapshot();
+        if (!queryServer.Start(querySocket))
+        {
+            std::cerr << "Unable to listen for queries on " << querySocket << std::endl;
+            return 1;
+        }
+    }
 
-    // Set a different Ouput file as we don't want to override our existing file
+    // Read the Input File
+    // When following, snapshots are written to OUTPUT_FILE until we're told to stop
     //
-    ordRptFH.SetOutputFile(OUTPUT_FILE_EMPTY_ORDERS);
+    if (follow)
+    {
+        std::signal(SIGINT, StopFollowing);
+        std::signal(SIGTERM, StopFollowing);
+        ordRptFH.FollowInputFile(followSettings);
+    }
+    else if (numThreads > 1)
+        ordRptFH.ReadInputFileParallel(numThreads);
+    else
+        ordRptFH.ReadInputFile();
 
-    // Write to OUTPUT_FILE_EMPTY_ORDERS/
-    // This will include Securities that have no Orders as well
+    ordRptFH.PublishSnapshot();
+
+    if (!checkpointFile.empty())
+        ordRptFH.SaveCheckpoint();
+
+    ordRptFH.ReportUnresolvedOrders(std::cerr);
+
+    // Write to OUTPUT_FILE & OUTPUT_FILE_EMPTY_ORDERS, and any rollups, in a single pass
+    // OUTPUT_FILE will only include Securities that have Orders
+    // OUTPUT_FILE_EMPTY_ORDERS will include Securities that have no Orders as well
     //
-    ordRptFH.WriteOutputFile();
+    ordRptFH.AddReportSink({ OUTPUT_FILE, '\t', &OrderReport::HasOrders, reportFormat });
+    ordRptFH.AddReportSink({ OUTPUT_FILE_EMPTY_ORDERS, '\t', nullptr, reportFormat });
+    ordRptFH.WriteReportSinks();
+    ordRptFH.CloseIntervalReport();
+
+    if (!statsFile.empty())
+        PipelineStats::WriteJsonFile(statsFile);
 
     return 0;
 }